@@ -0,0 +1,554 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+
+#if X265_ARCH_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+using namespace X265_NS;
+
+namespace {
+// anonymous file-static namespace
+
+typedef void (*anyfunc_t)();
+
+/* cpu levels in increasing order, each level enables its own instruction set
+ * flags and those of all the levels before it */
+struct TuneLevel
+{
+    const char* name;
+    uint32_t    flags;
+};
+
+const TuneLevel tuneLevels[] =
+{
+    { "C",      0 },
+#if X265_ARCH_X86
+    { "SSE2",   X265_CPU_CMOV | X265_CPU_MMX | X265_CPU_MMX2 | X265_CPU_SSE | X265_CPU_SSE2 },
+    { "SSSE3",  X265_CPU_SSE3 | X265_CPU_SSSE3 },
+    { "SSE4",   X265_CPU_SSE4 | X265_CPU_SSE42 },
+    { "AVX",    X265_CPU_AVX | X265_CPU_XOP | X265_CPU_FMA4 | X265_CPU_FMA3 },
+    { "AVX2",   X265_CPU_AVX2 | X265_CPU_LZCNT | X265_CPU_BMI1 | X265_CPU_BMI2 },
+    { "AVX512", X265_CPU_AVX512 },
+#elif X265_ARCH_ARM
+    { "ARMv6",  X265_CPU_ARMV6 },
+    { "NEON",   X265_CPU_NEON | X265_CPU_FAST_NEON_MRC },
+#endif
+};
+
+const int MAX_TUNE_LEVELS = sizeof(tuneLevels) / sizeof(tuneLevels[0]);
+
+const char* const tunePartNames[NUM_PU_SIZES] =
+{
+    "4x4", "8x8", "16x16", "32x32", "64x64",
+    "8x4", "4x8", "16x8", "8x16", "32x16", "16x32", "64x32", "32x64",
+    "16x12", "12x16", "16x4", "4x16", "32x24", "24x32", "32x8", "8x32",
+    "64x48", "48x64", "64x16", "16x64"
+};
+
+enum
+{
+    TUNE_STRIDE = 192,     // stride of the reference plane
+    TUNE_ROWS   = 80,      // 64 rows plus margins for the interpolation taps
+    TUNE_CALLS  = 8,       // calls per timed round
+    TUNE_ROUNDS = 8,       // the fastest round is kept
+    MAX_TUNE_SLOTS = 256
+};
+
+/* synthetic buffers shared by all the benchmarks */
+struct TuneData
+{
+    pixel*   fenc;          // 64x64 block, FENC_STRIDE
+    pixel*   ref;           // inside a TUNE_STRIDE plane
+    pixel*   dst;           // 64x64 block, FENC_STRIDE
+    int16_t* resi;          // 64x64 block, FENC_STRIDE
+    int16_t* coef;          // 32x32 coefficients
+    int16_t* qcoef;
+    int32_t* quantCoeff;
+    int32_t* deltaU;
+    int32_t  res[8];
+};
+
+typedef void (*tunebench_t)(anyfunc_t func, TuneData& d);
+
+/* each benchmark makes TUNE_CALLS calls, with varying source alignment or
+ * filter phase like the motion search and motion compensation */
+
+void benchCmp(anyfunc_t func, TuneData& d)
+{
+    pixelcmp_t f = (pixelcmp_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        d.res[0] += f(d.fenc, FENC_STRIDE, d.ref + i, TUNE_STRIDE);
+}
+
+void benchSse(anyfunc_t func, TuneData& d)
+{
+    pixel_sse_t f = (pixel_sse_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        d.res[0] += (int32_t)f(d.fenc, FENC_STRIDE, d.ref + i, TUNE_STRIDE);
+}
+
+void benchCmpX3(anyfunc_t func, TuneData& d)
+{
+    pixelcmp_x3_t f = (pixelcmp_x3_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        f(d.fenc, d.ref + i, d.ref + i + 1, d.ref + i + TUNE_STRIDE, TUNE_STRIDE, d.res);
+}
+
+void benchCmpX4(anyfunc_t func, TuneData& d)
+{
+    pixelcmp_x4_t f = (pixelcmp_x4_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        f(d.fenc, d.ref + i, d.ref + i + 1, d.ref + i + TUNE_STRIDE, d.ref + i + TUNE_STRIDE + 1, TUNE_STRIDE, d.res);
+}
+
+void benchCmpX8(anyfunc_t func, TuneData& d)
+{
+    pixelcmp_x8_t f = (pixelcmp_x8_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+    {
+        const pixel* fref[8];
+        for (int j = 0; j < 8; j++)
+            fref[j] = d.ref + i + (j & 1) + (j >> 1) * TUNE_STRIDE;
+        f(d.fenc, fref, TUNE_STRIDE, d.res);
+    }
+}
+
+void benchFilter(anyfunc_t func, TuneData& d)
+{
+    filter_pp_t f = (filter_pp_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        f(d.ref + i, TUNE_STRIDE, d.dst, FENC_STRIDE, 1 + i % 3);
+}
+
+void benchFilterHV(anyfunc_t func, TuneData& d)
+{
+    filter_hv_pp_t f = (filter_hv_pp_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        f(d.ref + i, TUNE_STRIDE, d.dst, FENC_STRIDE, 1 + i % 3, 1 + (i + 1) % 3);
+}
+
+void benchAvg(anyfunc_t func, TuneData& d)
+{
+    pixelavg_pp_t f = (pixelavg_pp_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        f(d.dst, FENC_STRIDE, d.ref + i, TUNE_STRIDE, d.fenc, FENC_STRIDE, 32);
+}
+
+void benchResidual(anyfunc_t func, TuneData& d)
+{
+    calcresidual_t f = (calcresidual_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        f(d.fenc, d.dst + i, d.resi, FENC_STRIDE);
+}
+
+void benchDct(anyfunc_t func, TuneData& d)
+{
+    dct_t f = (dct_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        f(d.resi, d.coef, FENC_STRIDE);
+}
+
+void benchIdct(anyfunc_t func, TuneData& d)
+{
+    idct_t f = (idct_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        f(d.coef, d.resi, FENC_STRIDE);
+}
+
+/* a 16x16 TU at a mid range QP */
+void benchQuant(anyfunc_t func, TuneData& d)
+{
+    quant_t f = (quant_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        d.res[0] += f(d.coef, d.quantCoeff, d.deltaU, d.qcoef, 19, 1 << 18, 256);
+}
+
+void benchNquant(anyfunc_t func, TuneData& d)
+{
+    nquant_t f = (nquant_t)func;
+    for (int i = 0; i < TUNE_CALLS; i++)
+        d.res[0] += f(d.coef, d.quantCoeff, d.qcoef, 19, 1 << 18, 256);
+}
+
+inline uint64_t tuneTimer()
+{
+#if X265_ARCH_X86
+    return __rdtsc();
+#else
+    return (uint64_t)x265_mdate();
+#endif
+}
+
+struct TuneSlot
+{
+    char        name[24];
+    size_t      offset;     // of the function pointer within EncoderPrimitives
+    tunebench_t bench;
+};
+
+class PrimitiveTuner
+{
+public:
+
+    EncoderPrimitives* tables;          // one table per enabled cpu level
+    const char*        levelNames[MAX_TUNE_LEVELS];
+    int                numLevels;
+
+    TuneSlot           slots[MAX_TUNE_SLOTS];
+    int                numSlots;
+
+    /* level of each slot's function in the tuned and in the default table.
+     * A function is named after the lowest level which provides it */
+    int                choice[MAX_TUNE_SLOTS];
+    int                defLevel[MAX_TUNE_SLOTS];
+
+    PrimitiveTuner() : tables(NULL), numLevels(0), numSlots(0) {}
+
+    ~PrimitiveTuner() { X265_FREE(tables); }
+
+    bool init(int cpuid);
+    void addSlot(const EncoderPrimitives& p, const void* member, tunebench_t bench, const char* name, const char* size);
+
+    anyfunc_t func(int level, int slot) const
+    {
+        return *(const anyfunc_t*)((const char*)&tables[level] + slots[slot].offset);
+    }
+
+    int lowestLevel(int level, int slot) const
+    {
+        anyfunc_t f = func(level, slot);
+        while (level && func(level - 1, slot) == f)
+            level--;
+        return level;
+    }
+
+    int  calibrate();
+    bool load(const char* fileName, const char* header);
+    void save(const char* fileName, const char* header) const;
+};
+
+bool PrimitiveTuner::init(int cpuid)
+{
+    uint32_t isaFlags = 0;
+    for (int i = 0; i < MAX_TUNE_LEVELS; i++)
+        isaFlags |= tuneLevels[i].flags;
+
+    int  masks[MAX_TUNE_LEVELS];
+    uint32_t levelFlags = 0;
+    for (int i = 0; i < MAX_TUNE_LEVELS; i++)
+    {
+        /* skip the levels the cpu (or the --asm mask) does not enable */
+        if (i && !(cpuid & tuneLevels[i].flags))
+            continue;
+        levelFlags |= tuneLevels[i].flags;
+        masks[numLevels] = i ? cpuid & ~(isaFlags & ~levelFlags) : 0;
+        levelNames[numLevels++] = tuneLevels[i].name;
+    }
+
+    tables = X265_MALLOC(EncoderPrimitives, numLevels);
+    if (!tables)
+        return false;
+
+    for (int i = 0; i < numLevels; i++)
+    {
+        memset(&tables[i], 0, sizeof(EncoderPrimitives));
+        setupPrimitives(tables[i], masks[i]);
+    }
+
+    /* the most used leaf primitives of motion search, motion compensation
+     * and the transform path. Composed primitives like dct_quant call through
+     * the primitive table and follow the choices made for their parts */
+    const EncoderPrimitives& p = tables[0];
+    for (int i = 0; i < NUM_PU_SIZES; i++)
+    {
+        addSlot(p, &p.pu[i].sad, benchCmp, "sad", tunePartNames[i]);
+        addSlot(p, &p.pu[i].sad_x3, benchCmpX3, "sad_x3", tunePartNames[i]);
+        addSlot(p, &p.pu[i].sad_x4, benchCmpX4, "sad_x4", tunePartNames[i]);
+        addSlot(p, &p.pu[i].sad_x8, benchCmpX8, "sad_x8", tunePartNames[i]);
+        addSlot(p, &p.pu[i].satd, benchCmp, "satd", tunePartNames[i]);
+        addSlot(p, &p.pu[i].luma_hpp, benchFilter, "luma_hpp", tunePartNames[i]);
+        addSlot(p, &p.pu[i].luma_vpp, benchFilter, "luma_vpp", tunePartNames[i]);
+        addSlot(p, &p.pu[i].luma_hvpp, benchFilterHV, "luma_hvpp", tunePartNames[i]);
+        addSlot(p, &p.pu[i].pixelavg_pp, benchAvg, "pixelavg_pp", tunePartNames[i]);
+    }
+    for (int i = 0; i < NUM_CU_SIZES; i++)
+    {
+        addSlot(p, &p.cu[i].sse_pp, benchSse, "sse_pp", tunePartNames[i]);
+        addSlot(p, &p.cu[i].sa8d, benchCmp, "sa8d", tunePartNames[i]);
+        if (i < NUM_TR_SIZE)
+        {
+            addSlot(p, &p.cu[i].calcresidual, benchResidual, "calcresidual", tunePartNames[i]);
+            addSlot(p, &p.cu[i].dct, benchDct, "dct", tunePartNames[i]);
+            addSlot(p, &p.cu[i].idct, benchIdct, "idct", tunePartNames[i]);
+        }
+    }
+    addSlot(p, &p.dst4x4, benchDct, "dst", "4x4");
+    addSlot(p, &p.idst4x4, benchIdct, "idst", "4x4");
+    addSlot(p, &p.quant, benchQuant, "quant", NULL);
+    addSlot(p, &p.nquant, benchNquant, "nquant", NULL);
+
+    for (int s = 0; s < numSlots; s++)
+        defLevel[s] = choice[s] = lowestLevel(numLevels - 1, s);
+
+    return true;
+}
+
+void PrimitiveTuner::addSlot(const EncoderPrimitives& p, const void* member, tunebench_t bench, const char* name, const char* size)
+{
+    X265_CHECK(numSlots < MAX_TUNE_SLOTS, "too many autotune slots\n");
+
+    TuneSlot& slot = slots[numSlots];
+    slot.offset = (const char*)member - (const char*)&p;
+    slot.bench = bench;
+    if (size)
+        sprintf(slot.name, "%s[%s]", name, size);
+    else
+        sprintf(slot.name, "%s", name);
+
+    /* slots without a C primitive are not used by the encoder */
+    if (func(0, numSlots))
+        numSlots++;
+}
+
+uint64_t timeFunction(anyfunc_t f, tunebench_t bench, TuneData& d)
+{
+    bench(f, d); // warm up caches and branch predictors
+
+    uint64_t best = (uint64_t)-1;
+    for (int r = 0; r < TUNE_ROUNDS; r++)
+    {
+        uint64_t start = tuneTimer();
+        bench(f, d);
+        uint64_t elapsed = tuneTimer() - start;
+        best = X265_MIN(best, elapsed);
+    }
+
+    return best;
+}
+
+/* time every distinct function of each slot, returns the number of slots
+ * which had more than one function to choose from. A function must be at
+ * least 5% faster than the default to replace it, so timing noise does not
+ * change the table from run to run */
+int PrimitiveTuner::calibrate()
+{
+    TuneData d;
+    pixel* refPlane = X265_MALLOC(pixel, TUNE_STRIDE * TUNE_ROWS);
+    d.fenc = X265_MALLOC(pixel, 64 * FENC_STRIDE);
+    d.dst = X265_MALLOC(pixel, 64 * FENC_STRIDE);
+    d.resi = X265_MALLOC(int16_t, 64 * FENC_STRIDE);
+    d.coef = X265_MALLOC(int16_t, 32 * 32);
+    d.qcoef = X265_MALLOC(int16_t, 32 * 32);
+    d.quantCoeff = X265_MALLOC(int32_t, 32 * 32);
+    d.deltaU = X265_MALLOC(int32_t, 32 * 32);
+
+    int tuned = 0;
+    if (refPlane && d.fenc && d.dst && d.resi && d.coef && d.qcoef && d.quantCoeff && d.deltaU)
+    {
+        uint32_t seed = 0x2c9277b5;
+        const int pixelMax = (1 << X265_DEPTH) - 1;
+        for (int i = 0; i < TUNE_STRIDE * TUNE_ROWS; i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            refPlane[i] = (pixel)((seed >> 16) & pixelMax);
+        }
+        for (int i = 0; i < 64 * FENC_STRIDE; i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            d.fenc[i] = (pixel)((seed >> 16) & pixelMax);
+            d.dst[i] = (pixel)((seed >> 8) & pixelMax);
+            d.resi[i] = (int16_t)(d.fenc[i] - d.dst[i]);
+        }
+        for (int i = 0; i < 32 * 32; i++)
+        {
+            d.coef[i] = 0;
+            d.quantCoeff[i] = 16384;
+        }
+        d.ref = refPlane + 8 * TUNE_STRIDE + 16;
+        memset(d.res, 0, sizeof(d.res));
+
+        for (int s = 0; s < numSlots; s++)
+        {
+            anyfunc_t def = func(choice[s], s);
+            uint64_t defCost = 0, bestCost = 0;
+            bool timed = false;
+
+            for (int level = 0; level < numLevels; level++)
+            {
+                anyfunc_t f = func(level, s);
+                if (!f || f == def || lowestLevel(level, s) != level)
+                    continue;
+
+                if (!timed)
+                {
+                    defCost = bestCost = timeFunction(def, slots[s].bench, d);
+                    timed = true;
+                }
+
+                uint64_t cost = timeFunction(f, slots[s].bench, d);
+                if (cost * 20 < defCost * 19 && cost < bestCost)
+                {
+                    bestCost = cost;
+                    choice[s] = level;
+                }
+            }
+
+            tuned += timed;
+        }
+    }
+
+    X265_FREE(refPlane);
+    X265_FREE(d.fenc);
+    X265_FREE(d.dst);
+    X265_FREE(d.resi);
+    X265_FREE(d.coef);
+    X265_FREE(d.qcoef);
+    X265_FREE(d.quantCoeff);
+    X265_FREE(d.deltaU);
+
+    return tuned;
+}
+
+/* the cache file holds a header line identifying the build, bit depth and
+ * cpu flags, then one line per slot with the cpu level of its function. It
+ * is only used if it matches this build and cpu and lists every slot */
+bool PrimitiveTuner::load(const char* fileName, const char* header)
+{
+    FILE* f = x265_fopen(fileName, "r");
+    if (!f)
+        return false;
+
+    char line[256];
+    bool ok = fgets(line, sizeof(line), f) && !strcmp(line, header);
+    int  count = 0;
+    while (ok && fgets(line, sizeof(line), f))
+    {
+        char name[32], levelName[32];
+        if (sscanf(line, "%31s %31s", name, levelName) != 2)
+        {
+            ok = false;
+            break;
+        }
+
+        int s = 0, level = 0;
+        while (s < numSlots && strcmp(slots[s].name, name))
+            s++;
+        while (level < numLevels && strcmp(levelNames[level], levelName))
+            level++;
+        if (s == numSlots || level == numLevels || !func(level, s))
+        {
+            ok = false;
+            break;
+        }
+
+        choice[s] = lowestLevel(level, s);
+        count++;
+    }
+    fclose(f);
+
+    if (!ok || count != numSlots)
+    {
+        for (int s = 0; s < numSlots; s++)
+            choice[s] = defLevel[s];
+        return false;
+    }
+
+    return true;
+}
+
+void PrimitiveTuner::save(const char* fileName, const char* header) const
+{
+    FILE* f = x265_fopen(fileName, "w");
+    if (!f)
+    {
+        x265_log(NULL, X265_LOG_WARNING, "unable to write primitive autotune file %s\n", fileName);
+        return;
+    }
+
+    fputs(header, f);
+    for (int s = 0; s < numSlots; s++)
+        fprintf(f, "%s %s\n", slots[s].name, levelNames[lowestLevel(choice[s], s)]);
+    fclose(f);
+}
+
+} // end anonymous namespace
+
+namespace X265_NS {
+// x265 private namespace
+
+void autotunePrimitives(EncoderPrimitives &p, const x265_param* param)
+{
+    PrimitiveTuner tuner;
+    if (!tuner.init(param->cpuid))
+        return;
+
+    char header[256];
+    sprintf(header, "# x265 %s %dbit primitive autotune, cpu 0x%08x\n",
+             PFX(version_str), X265_DEPTH, (uint32_t)param->cpuid);
+
+    const char* fileName = param->asmAutotuneFile;
+    if (fileName && tuner.load(fileName, header))
+        x265_log(param, X265_LOG_INFO, "primitive autotune: %d functions loaded from %s\n", tuner.numSlots, fileName);
+    else
+    {
+        int64_t start = x265_mdate();
+        int tuned = tuner.calibrate();
+        x265_log(param, X265_LOG_INFO, "primitive autotune: timed %d of %d functions in %.1f ms\n",
+                 tuned, tuner.numSlots, (x265_mdate() - start) / 1000.0);
+        if (fileName)
+            tuner.save(fileName, header);
+    }
+
+    /* log the functions which differ from the default table, so the table
+     * which was used can be reproduced */
+    char buf[128];
+    int  len = 0, changed = 0;
+    for (int s = 0; s < tuner.numSlots; s++)
+    {
+        if (tuner.choice[s] == tuner.defLevel[s])
+            continue;
+
+        *(anyfunc_t*)((char*)&p + tuner.slots[s].offset) = tuner.func(tuner.choice[s], s);
+        changed++;
+
+        char item[48];
+        int  itemLen = sprintf(item, " %s=%s", tuner.slots[s].name, tuner.levelNames[tuner.choice[s]]);
+        if (len && len + itemLen >= 100)
+        {
+            x265_log(param, X265_LOG_INFO, "primitive autotune:%s\n", buf);
+            len = 0;
+        }
+        strcpy(buf + len, item);
+        len += itemLen;
+    }
+    if (len)
+        x265_log(param, X265_LOG_INFO, "primitive autotune:%s\n", buf);
+    x265_log(param, X265_LOG_INFO, "primitive autotune: %d functions differ from the default table\n", changed);
+}
+}
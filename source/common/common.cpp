@@ -34,6 +34,9 @@
 #else
 #include <sys/time.h>
 #endif
+#if __linux__
+#include <sys/mman.h>
+#endif
 
 namespace X265_NS {
 
@@ -91,6 +94,121 @@ void x265_free(void *ptr)
 
 #endif // if _WIN32
 
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* kilobytes currently allocated by x265_malloc_huge(), by page backing */
+static int32_t s_hugePageKBytes[HUGE_PAGE_BACKINGS];
+
+#if __linux__ && defined(MADV_HUGEPAGE)
+
+/* stored at the start of each x265_malloc_huge() mapping */
+struct HugePageHeader
+{
+    size_t mapSize;
+    int    backing;
+};
+
+static bool transparentHugePagesAllowed()
+{
+    static int allowed = -1;
+    if (allowed < 0)
+    {
+        /* madvise() is ignored when the mode is [never] */
+        char mode[128] = { 0 };
+        FILE* f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (f)
+        {
+            if (!fgets(mode, sizeof(mode), f))
+                mode[0] = 0;
+            fclose(f);
+        }
+        allowed = !strstr(mode, "[never]");
+    }
+    return !!allowed;
+}
+
+void *x265_malloc_huge(size_t size)
+{
+    size_t mapSize;
+    int backing;
+    void* base = MAP_FAILED;
+
+    if (size + X265_ALIGNBYTES < HUGE_PAGE_SIZE / 2)
+    {
+        /* too small to be worth rounding up to a huge page */
+        mapSize = (size + X265_ALIGNBYTES + 4095) & ~(size_t)4095;
+        base = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED)
+            return NULL;
+        backing = HUGE_PAGES_NONE;
+    }
+    else
+    {
+        mapSize = (size + X265_ALIGNBYTES + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+        backing = HUGE_PAGES_EXPLICIT;
+#ifdef MAP_HUGETLB
+        base = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (base == MAP_FAILED)
+        {
+            /* no reserved huge pages are available. Map an extra huge page so
+             * the mapping can be trimmed to a 2MB boundary, then ask for
+             * transparent huge pages */
+            uint8_t* raw = (uint8_t*)mmap(NULL, mapSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == (uint8_t*)MAP_FAILED)
+                return NULL;
+            uint8_t* aligned = (uint8_t*)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+            if (aligned > raw)
+                munmap(raw, aligned - raw);
+            if (raw + HUGE_PAGE_SIZE > aligned)
+                munmap(aligned + mapSize, raw + HUGE_PAGE_SIZE - aligned);
+            base = aligned;
+
+            if (transparentHugePagesAllowed() && !madvise(base, mapSize, MADV_HUGEPAGE))
+                backing = HUGE_PAGES_TRANSPARENT;
+            else
+                backing = HUGE_PAGES_NONE;
+        }
+    }
+
+    HugePageHeader* header = (HugePageHeader*)base;
+    header->mapSize = mapSize;
+    header->backing = backing;
+    ATOMIC_ADD(&s_hugePageKBytes[backing], (int32_t)(mapSize >> 10));
+
+    return (uint8_t*)base + X265_ALIGNBYTES;
+}
+
+void x265_free_huge(void *ptr)
+{
+    if (ptr)
+    {
+        HugePageHeader* header = (HugePageHeader*)((uint8_t*)ptr - X265_ALIGNBYTES);
+        ATOMIC_ADD(&s_hugePageKBytes[header->backing], -(int32_t)(header->mapSize >> 10));
+        munmap(header, header->mapSize);
+    }
+}
+
+#else // no huge page support, the encoder disables param->bHugePages
+
+void *x265_malloc_huge(size_t size)
+{
+    return x265_malloc(size);
+}
+
+void x265_free_huge(void *ptr)
+{
+    x265_free(ptr);
+}
+
+#endif
+
+void x265_huge_page_usage(int32_t kbytes[HUGE_PAGE_BACKINGS])
+{
+    for (int i = 0; i < HUGE_PAGE_BACKINGS; i++)
+        kbytes[i] = s_hugePageKBytes[i];
+}
+
 /* Not a general-purpose function; multiplies input by -1/6 to convert
  * qp to qscale. */
 int x265_exp2fix8(double x)
@@ -225,6 +225,16 @@ typedef int16_t  coeff_t;      // transform coefficient
             goto fail; \
         } \
     }
+#define CHECKED_MALLOC_HUGE(var, type, count, bHuge) \
+    { \
+        var = (type*)((bHuge) ? x265_malloc_huge(sizeof(type) * (count)) : x265_malloc(sizeof(type) * (count))); \
+        if (!var) \
+        { \
+            x265_log(NULL, X265_LOG_ERROR, "malloc of size %d failed\n", sizeof(type) * (count)); \
+            goto fail; \
+        } \
+    }
+#define X265_FREE_HUGE(ptr, bHuge)  ((bHuge) ? x265_free_huge(ptr) : x265_free(ptr))
 #define CHECKED_MALLOC_ZERO(var, type, count) \
     { \
         var = (type*)x265_malloc(sizeof(type) * (count)); \
@@ -428,6 +438,21 @@ uint32_t x265_picturePlaneSize(int csp, int width, int height, int plane);
 
 void*    x265_malloc(size_t size);
 void     x265_free(void *ptr);
+
+/* page backing of x265_malloc_huge() allocations */
+enum HugePageBacking
+{
+    HUGE_PAGES_NONE,        // regular 4KB pages
+    HUGE_PAGES_TRANSPARENT, // transparent huge pages requested with madvise()
+    HUGE_PAGES_EXPLICIT,    // reserved huge pages, MAP_HUGETLB
+    HUGE_PAGE_BACKINGS
+};
+
+/* allocations in their own 2MB aligned mappings, backed by huge pages where
+ * possible. Must be released with x265_free_huge() */
+void*    x265_malloc_huge(size_t size);
+void     x265_free_huge(void *ptr);
+void     x265_huge_page_usage(int32_t kbytes[HUGE_PAGE_BACKINGS]);
 char*    x265_slurp_file(const char *filename);
 
 /* located in primitives.cpp */
@@ -80,6 +80,7 @@ const cpu_name_t cpu_names[] =
     { "FMA4",        AVX | X265_CPU_FMA4 },
     { "AVX2",        AVX | X265_CPU_AVX2 },
     { "FMA3",        AVX | X265_CPU_FMA3 },
+    { "AVX512",      AVX | X265_CPU_AVX2 | X265_CPU_AVX512 },
 #undef AVX
 #undef SSE2
 #undef MMX2
@@ -121,6 +122,7 @@ uint32_t cpu_detect(void)
     uint32_t cpu = 0;
 
     uint32_t eax, ebx, ecx, edx;
+    uint32_t xcr0 = 0;
     uint32_t vendor[4] = { 0 };
     uint32_t max_extended_cap, max_basic_cap;
 
@@ -160,6 +162,7 @@ uint32_t cpu_detect(void)
     {
         /* Check for OS support */
         PFX(cpu_xgetbv)(0, &eax, &edx);
+        xcr0 = eax;
         if ((eax & 0x6) == 0x6)
         {
             cpu |= X265_CPU_AVX;
@@ -174,6 +177,9 @@ uint32_t cpu_detect(void)
         /* AVX2 requires OS support, but BMI1/2 don't. */
         if ((cpu & X265_CPU_AVX) && (ebx & 0x00000020))
             cpu |= X265_CPU_AVX2;
+        /* AVX-512 F, DQ, CD, BW and VL, with the OS saving opmask and ZMM state */
+        if ((cpu & X265_CPU_AVX2) && (ebx & 0xD0030000) == 0xD0030000 && (xcr0 & 0xE6) == 0xE6)
+            cpu |= X265_CPU_AVX512;
         if (ebx & 0x00000008)
         {
             cpu |= X265_CPU_BMI1;
@@ -367,9 +367,9 @@ struct CUDataMemPool
 
     void destroy()
     {
-        X265_FREE(trCoeffMemBlock);
-        X265_FREE(mvMemBlock);
-        X265_FREE(charMemBlock);
+        X265_FREE_ZERO(trCoeffMemBlock);
+        X265_FREE_ZERO(mvMemBlock);
+        X265_FREE_ZERO(charMemBlock);
     }
 };
 }
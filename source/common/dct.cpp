@@ -685,6 +685,56 @@ static uint32_t quant_c(const int16_t* coef, const int32_t* quantCoeff, int32_t*
     return numSig;
 }
 
+/* C references of the fused transform primitives. The DCT coefficients are
+ * output since sign hiding needs their signs */
+template<int log2TrSize>
+static uint32_t dct_quant_c(const int16_t* residual, intptr_t resiStride, int16_t* coef, const int32_t* quantCoeff, int32_t* deltaU, int16_t* qCoef, int qBits, int add)
+{
+    static const dct_t dct[NUM_TR_SIZE] = { dct4_c, dct8_c, dct16_c, dct32_c };
+
+    dct[log2TrSize - 2](residual, coef, resiStride);
+    return quant_c(coef, quantCoeff, deltaU, qCoef, qBits, add, 1 << (log2TrSize * 2));
+}
+
+template<int log2TrSize>
+static void dequant_idct_c(const int16_t* quantCoef, int16_t* residual, intptr_t resiStride, int scale, int shift)
+{
+    static const idct_t idct[NUM_TR_SIZE] = { idct4_c, idct8_c, idct16_c, idct32_c };
+    ALIGN_VAR_32(int16_t, coef[1 << (log2TrSize * 2)]);
+
+    dequant_normal_c(quantCoef, coef, 1 << (log2TrSize * 2), scale, shift);
+    idct[log2TrSize - 2](coef, residual, resiStride);
+}
+
+/* the encoder's versions for the sizes without a fused kernel, composed from
+ * the separate primitives of the active table so they cost no more than the
+ * separate calls */
+template<int log2TrSize>
+static uint32_t dct_quant_composed(const int16_t* residual, intptr_t resiStride, int16_t* coef, const int32_t* quantCoeff, int32_t* deltaU, int16_t* qCoef, int qBits, int add)
+{
+    primitives.cu[log2TrSize - 2].dct(residual, coef, resiStride);
+    return primitives.quant(coef, quantCoeff, deltaU, qCoef, qBits, add, 1 << (log2TrSize * 2));
+}
+
+template<int log2TrSize>
+static void dequant_idct_composed(const int16_t* quantCoef, int16_t* residual, intptr_t resiStride, int scale, int shift)
+{
+    ALIGN_VAR_32(int16_t, coef[1 << (log2TrSize * 2)]);
+
+    primitives.dequant_normal(quantCoef, coef, 1 << (log2TrSize * 2), scale, shift);
+    primitives.cu[log2TrSize - 2].idct(coef, residual, resiStride);
+}
+
+static const dct_quant_t s_dctQuantC[NUM_TR_SIZE] =
+{
+    dct_quant_c<2>, dct_quant_c<3>, dct_quant_c<4>, dct_quant_c<5>
+};
+
+static const dequant_idct_t s_dequantIdctC[NUM_TR_SIZE] =
+{
+    dequant_idct_c<2>, dequant_idct_c<3>, dequant_idct_c<4>, dequant_idct_c<5>
+};
+
 static uint32_t nquant_c(const int16_t* coef, const int32_t* quantCoeff, int16_t* qCoef, int qBits, int add, int numCoeff)
 {
     X265_CHECK((numCoeff % 16) == 0, "number of quant coeff is not multiple of 4x4\n");
@@ -931,6 +981,39 @@ static uint32_t costCoeffRemain_c(uint16_t *absCoeff, int numNonZero, int idx)
 }
 
 
+/* RDOQ cost of leaving a 4x4 coefficient group uncoded: the distortion of each
+ * coefficient less the psy-rdoq bonus of its predicted value. The costs are
+ * written at the coefficient positions, the sum of the group is returned */
+static int64_t rdoqCgCost_c(const int16_t *resiCoeff, const int16_t *fencCoeff, int64_t *costUncoded, intptr_t trSize, int scaleBits, int64_t psyScale, int psyShift)
+{
+    int64_t sum = 0;
+
+    for (int y = 0; y < MLS_CG_SIZE; y++)
+    {
+        for (int x = 0; x < MLS_CG_SIZE; x++)
+        {
+            int signCoef = resiCoeff[x];
+            int64_t cost = ((int64_t)signCoef * signCoef) << scaleBits;
+
+            if (psyScale)
+            {
+                /* when no residual coefficient is coded, predicted coef == recon coef */
+                int predictedCoef = fencCoeff[x] - signCoef;
+                cost -= (psyScale * predictedCoef) >> psyShift;
+            }
+
+            costUncoded[x] = cost;
+            sum += cost;
+        }
+
+        resiCoeff += trSize;
+        fencCoeff += trSize;
+        costUncoded += trSize;
+    }
+
+    return sum;
+}
+
 static uint32_t costC1C2Flag_c(uint16_t *absCoeff, intptr_t numC1Flag, uint8_t *baseCtxMod, intptr_t ctxOffset)
 {
     uint32_t sum = 0;
@@ -1004,6 +1087,12 @@ void setupDCTPrimitives_c(EncoderPrimitives& p)
     p.cu[BLOCK_16x16].idct = idct16_c;
     p.cu[BLOCK_32x32].idct = idct32_c;
     p.denoiseDct = denoiseDct_c;
+    for (int i = 0; i < NUM_TR_SIZE; i++)
+    {
+        p.cu[i].dct_quant = s_dctQuantC[i];
+        p.cu[i].dequant_idct = s_dequantIdctC[i];
+    }
+
     p.cu[BLOCK_4x4].count_nonzero = count_nonzero_c<4>;
     p.cu[BLOCK_8x8].count_nonzero = count_nonzero_c<8>;
     p.cu[BLOCK_16x16].count_nonzero = count_nonzero_c<16>;
@@ -1019,5 +1108,28 @@ void setupDCTPrimitives_c(EncoderPrimitives& p)
     p.costCoeffNxN = costCoeffNxN_c;
     p.costCoeffRemain = costCoeffRemain_c;
     p.costC1C2Flag = costC1C2Flag_c;
+    p.rdoq_cg_cost = rdoqCgCost_c;
+}
+
+/* replace the C references of the fused transform primitives which remain in
+ * the encoder's table by the versions composed from its separate primitives */
+void setupComposedDCTPrimitives(EncoderPrimitives& p)
+{
+    static const dct_quant_t dctQuant[NUM_TR_SIZE] =
+    {
+        dct_quant_composed<2>, dct_quant_composed<3>, dct_quant_composed<4>, dct_quant_composed<5>
+    };
+    static const dequant_idct_t dequantIdct[NUM_TR_SIZE] =
+    {
+        dequant_idct_composed<2>, dequant_idct_composed<3>, dequant_idct_composed<4>, dequant_idct_composed<5>
+    };
+
+    for (int i = 0; i < NUM_TR_SIZE; i++)
+    {
+        if (p.cu[i].dct_quant == s_dctQuantC[i])
+            p.cu[i].dct_quant = dctQuant[i];
+        if (p.cu[i].dequant_idct == s_dequantIdctC[i])
+            p.cu[i].dequant_idct = dequantIdct[i];
+    }
 }
 }
@@ -32,10 +32,14 @@ Frame::Frame()
 {
     m_bChromaExtended = false;
     m_lowresInit = false;
+    m_lowresInitBusy = false;
     m_reconRowCount.set(0);
     m_reconColCount = NULL;
     m_countRefEncoders = 0;
     m_encData = NULL;
+    m_fencPic = NULL;
+    m_releaseInput = NULL;
+    m_releaseOpaque = NULL;
     m_reconPic = NULL;
     m_quantOffsets = NULL;
     m_next = NULL;
@@ -49,12 +53,18 @@ Frame::Frame()
 
 bool Frame::create(x265_param *param, float* quantOffsets)
 {
-    m_fencPic = new PicYuv;
     m_param = param;
     CHECKED_MALLOC_ZERO(m_rcData, RcStats, 1);
 
-    if (m_fencPic->create(param->sourceWidth, param->sourceHeight, param->internalCsp) &&
-        m_lowres.create(m_fencPic, param->bframes, !!param->rc.aqMode))
+    /* the source picture may already have been taken from a shared frame pool */
+    if (!m_fencPic)
+    {
+        m_fencPic = new PicYuv;
+        if (!m_fencPic->create(param->sourceWidth, param->sourceHeight, param->internalCsp, !!param->bHugePages))
+            return false;
+    }
+
+    if (m_lowres.create(m_fencPic, param->bframes, !!param->rc.aqMode))
     {
         X265_CHECK((m_reconColCount == NULL), "m_reconColCount was initialized");
         m_numRows = (m_fencPic->m_picHeight + g_maxCUSize - 1)  / g_maxCUSize;
@@ -78,7 +88,9 @@ bool Frame::allocEncodeData(x265_param *param, const SPS& sps)
     m_reconPic = new PicYuv;
     m_param = param;
     m_encData->m_reconPic = m_reconPic;
-    bool ok = m_encData->create(*param, sps, m_fencPic->m_picCsp) && m_reconPic->create(param->sourceWidth, param->sourceHeight, param->internalCsp);
+    /* non-referenced frames are never motion searched, they need no sub-pel planes */
+    bool ok = m_encData->create(*param, sps, m_fencPic->m_picCsp) && m_reconPic->create(param->sourceWidth, param->sourceHeight, param->internalCsp, !!param->bHugePages) &&
+              (!IS_REFERENCED(this) || m_reconPic->createSubpelPlanes(param->subpelPlanes));
     if (ok)
     {
         /* initialize right border of m_reconpicYuv as SAO may read beyond the
@@ -111,8 +123,23 @@ void Frame::reinit(const SPS& sps)
     m_encData->reinit(sps);
 }
 
+/* give the planes of a zero-copy input picture back to the caller once the
+ * source picture is no longer needed for analysis or weight estimation */
+void Frame::releaseInput()
+{
+    if (m_releaseInput)
+    {
+        m_fencPic->restorePlanes();
+        m_releaseInput(m_releaseOpaque);
+        m_releaseInput = NULL;
+        m_releaseOpaque = NULL;
+    }
+}
+
 void Frame::destroy()
 {
+    releaseInput();
+
     if (m_encData)
     {
         m_encData->destroy();
@@ -79,9 +79,12 @@ public:
     int64_t                m_dts;
     int32_t                m_forceqp;            // Force to use the qp specified in qp file
     void*                  m_userData;           // user provided pointer passed in with this picture
+    void                   (*m_releaseInput)(void*); // m_fencPic uses the planes of the input picture, see releaseInput()
+    void*                  m_releaseOpaque;
 
     Lowres                 m_lowres;
     bool                   m_lowresInit;         // lowres init complete (pre-analysis)
+    bool                   m_lowresInitBusy;     // pre-analysis claimed by a lookahead thread
     bool                   m_bChromaExtended;    // orig chroma planes motion extended for weight analysis
 
     float*                 m_quantOffsets;       // points to quantOffsets in x265_picture
@@ -103,6 +106,7 @@ public:
     bool create(x265_param *param, float* quantOffsets);
     bool allocEncodeData(x265_param *param, const SPS& sps);
     void reinit(const SPS& sps);
+    void releaseInput();
     void destroy();
 };
 }
@@ -33,6 +33,7 @@ namespace X265_NS {
 
 class PicYuv;
 class JobProvider;
+class ThreadPool;
 
 #define INTER_MODES 4 // 2Nx2N, 2NxN, Nx2N, AMP modes
 #define INTRA_MODES 3 // DC, Planar, Angular modes
@@ -102,6 +103,7 @@ public:
     bool           m_bHasReferences;   /* used during DPB/RPS updates */
     int            m_frameEncoderID;   /* the ID of the FrameEncoder encoding this frame */
     JobProvider*   m_jobProvider;
+    const ThreadPool* m_allocPool;     /* pool whose NUMA node(s) this data was allocated on */
 
     CUDataMemPool  m_cuMemPool;
     CUData*        m_picCTU;
@@ -0,0 +1,161 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com
+ *****************************************************************************/
+
+#include "common.h"
+#include "framepool.h"
+#include "framedata.h"
+#include "picyuv.h"
+
+using namespace X265_NS;
+
+static int64_t pictureBytes(const PicYuv* pic)
+{
+    int64_t bytes = pic->m_stride * (pic->m_picHeight + 2 * pic->m_lumaMarginY);
+    if (pic->m_subpelBuf)
+        bytes += bytes * (pic->m_subpelPlanes == 1 ? 3 : 15);
+    if (pic->m_picBuf[1])
+        bytes += 2 * pic->m_strideC * ((pic->m_picHeight >> pic->m_vChromaShift) + 2 * pic->m_chromaMarginY);
+    return bytes * sizeof(pixel);
+}
+
+FramePool::~FramePool()
+{
+    trim();
+    while (m_buckets)
+    {
+        Bucket* next = m_buckets->next;
+        delete m_buckets;
+        m_buckets = next;
+    }
+}
+
+/* must be called with m_lock held */
+FramePool::Bucket* FramePool::findBucket(uint32_t width, uint32_t height, int csp, bool bCreate)
+{
+    for (Bucket* b = m_buckets; b; b = b->next)
+        if (b->width == width && b->height == height && b->csp == csp)
+            return b;
+
+    if (!bCreate)
+        return NULL;
+
+    Bucket* b = new Bucket;
+    b->width = width;
+    b->height = height;
+    b->csp = csp;
+    b->pictures = NULL;
+    b->frameData = NULL;
+    b->next = m_buckets;
+    m_buckets = b;
+    return b;
+}
+
+PicYuv* FramePool::takePicture(uint32_t width, uint32_t height, int csp)
+{
+    ScopedLock lock(m_lock);
+    Bucket* b = findBucket(width, height, csp, false);
+    PicYuv* pic = b ? b->pictures : NULL;
+    if (pic)
+    {
+        b->pictures = pic->m_freeListNext;
+        pic->m_freeListNext = NULL;
+    }
+    return pic;
+}
+
+FrameData* FramePool::takeFrameData(uint32_t width, uint32_t height, int csp)
+{
+    ScopedLock lock(m_lock);
+    Bucket* b = findBucket(width, height, csp, false);
+    FrameData* encData = b ? b->frameData : NULL;
+    if (encData)
+    {
+        b->frameData = encData->m_freeListNext;
+        encData->m_freeListNext = NULL;
+    }
+    return encData;
+}
+
+void FramePool::returnPicture(PicYuv* pic)
+{
+    ScopedLock lock(m_lock);
+    Bucket* b = findBucket(pic->m_picWidth, pic->m_picHeight, pic->m_picCsp, true);
+    pic->m_freeListNext = b->pictures;
+    b->pictures = pic;
+}
+
+void FramePool::returnFrameData(FrameData* encData)
+{
+    ScopedLock lock(m_lock);
+    PicYuv* recon = encData->m_reconPic;
+    Bucket* b = findBucket(recon->m_picWidth, recon->m_picHeight, recon->m_picCsp, true);
+    encData->m_freeListNext = b->frameData;
+    b->frameData = encData;
+}
+
+int64_t FramePool::trim()
+{
+    /* unlink the idle buffers under the lock, release them without it */
+    PicYuv* pictures = NULL;
+    FrameData* frameData = NULL;
+    {
+        ScopedLock lock(m_lock);
+        for (Bucket* b = m_buckets; b; b = b->next)
+        {
+            while (b->pictures)
+            {
+                PicYuv* pic = b->pictures;
+                b->pictures = pic->m_freeListNext;
+                pic->m_freeListNext = pictures;
+                pictures = pic;
+            }
+            while (b->frameData)
+            {
+                FrameData* encData = b->frameData;
+                b->frameData = encData->m_freeListNext;
+                encData->m_freeListNext = frameData;
+                frameData = encData;
+            }
+        }
+    }
+
+    int64_t bytes = 0;
+    while (pictures)
+    {
+        PicYuv* next = pictures->m_freeListNext;
+        bytes += pictureBytes(pictures);
+        pictures->destroy();
+        delete pictures;
+        pictures = next;
+    }
+    while (frameData)
+    {
+        FrameData* next = frameData->m_freeListNext;
+        bytes += pictureBytes(frameData->m_reconPic);
+        frameData->m_reconPic->destroy();
+        delete frameData->m_reconPic;
+        frameData->destroy();
+        delete frameData;
+        frameData = next;
+    }
+
+    return bytes;
+}
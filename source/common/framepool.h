@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com
+ *****************************************************************************/
+
+#ifndef X265_FRAMEPOOL_H
+#define X265_FRAMEPOOL_H
+
+#include "common.h"
+#include "threading.h"
+
+struct x265_frame_pool {};
+
+namespace X265_NS {
+// private namespace
+
+class PicYuv;
+class FrameData;
+
+/* The picture buffers behind an x265_frame_pool handle. Encoders attached to
+ * the pool return the source pictures and the FrameData (with its recon
+ * picture) of frames they no longer reference, instead of keeping them on
+ * their own DPB free lists, and take idle ones before allocating new ones.
+ * Idle buffers are kept per picture format; bit depth and CTU size are fixed
+ * for all encoders of one build and process, so size and color space are
+ * enough to tell formats apart. */
+class FramePool : public x265_frame_pool
+{
+public:
+
+    struct Bucket
+    {
+        uint32_t   width;
+        uint32_t   height;
+        int        csp;
+        PicYuv*    pictures;    // idle source pictures, linked by m_freeListNext
+        FrameData* frameData;   // idle FrameData with recon pictures, linked by m_freeListNext
+        Bucket*    next;
+    };
+
+    Bucket*       m_buckets;
+    Lock          m_lock;
+
+    FramePool() : m_buckets(NULL) {}
+    ~FramePool();
+
+    /* return NULL if no idle buffer of the given format is available */
+    PicYuv*    takePicture(uint32_t width, uint32_t height, int csp);
+    FrameData* takeFrameData(uint32_t width, uint32_t height, int csp);
+
+    void       returnPicture(PicYuv* pic);
+    void       returnFrameData(FrameData* encData);
+
+    /* release all idle buffers, returns the number of bytes of picture planes released */
+    int64_t    trim();
+
+protected:
+
+    Bucket*    findBucket(uint32_t width, uint32_t height, int csp, bool bCreate);
+};
+}
+
+#endif // ifndef X265_FRAMEPOOL_H
@@ -56,8 +56,10 @@ bool Lowres::create(PicYuv *origPic, int _bframes, bool bAQEnabled)
     }
     CHECKED_MALLOC(propagateCost, uint16_t, cuCount);
 
-    /* allocate lowres buffers */
-    CHECKED_MALLOC_ZERO(buffer[0], pixel, 4 * planesize);
+    /* allocate lowres buffers, with the page backing of the full resolution picture */
+    bHugePages = origPic->m_bHugePages;
+    CHECKED_MALLOC_HUGE(buffer[0], pixel, 4 * planesize, bHugePages);
+    memset(buffer[0], 0, sizeof(pixel) * 4 * planesize);
 
     buffer[1] = buffer[0] + planesize;
     buffer[2] = buffer[1] + planesize;
@@ -96,7 +98,7 @@ fail:
 
 void Lowres::destroy()
 {
-    X265_FREE(buffer[0]);
+    X265_FREE_HUGE(buffer[0], bHugePages);
     X265_FREE(intraCost);
     X265_FREE(intraMode);
 
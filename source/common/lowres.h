@@ -38,6 +38,7 @@ struct ReferencePlanes
 
     pixel*   fpelPlane[3];
     pixel*   lowresPlane[4];
+    pixel*   subpelPlane[16]; // luma, by (yFrac << 2) | xFrac, see PicYuv::m_subpelOrg
     PicYuv*  reconPic;
 
     bool     isWeighted;
@@ -107,6 +108,7 @@ struct ReferencePlanes
 struct Lowres : public ReferencePlanes
 {
     pixel *buffer[4];
+    bool   bHugePages;       // buffer[0] allocated by x265_malloc_huge()
 
     int    frameNum;         // Presentation frame number
     int    sliceType;        // Slice type decided by lookahead
@@ -107,6 +107,14 @@ void x265_param_default(x265_param* param)
     param->cpuid = X265_NS::cpu_detect();
     param->bEnableWavefront = 1;
     param->frameNumThreads = 0;
+    param->bAdaptiveThreading = 0;
+    param->pool = NULL;
+    param->poolPriority = 0;
+    param->bHugePages = 0;
+    param->maxMemory = 0;
+    param->bAsmAutotune = 0;
+    param->asmAutotuneFile = NULL;
+    param->framePool = NULL;
 
     param->logLevel = X265_LOG_INFO;
     param->csvfn = NULL;
@@ -158,6 +166,13 @@ void x265_param_default(x265_param* param)
     param->searchMethod = X265_HEX_SEARCH;
     param->subpelRefine = 2;
     param->searchRange = 57;
+    param->subpelPlanes = 0;
+    param->bLowresMvSeed = 0;
+    param->tzRaster = 3;
+    param->tzStarDist = 48;
+    param->tzEarlyExit = 4;
+    param->bEnableMECache = 0;
+    param->bCacheAffinity = 0;
     param->maxNumMergeCand = 2;
     param->limitReferences = 3;
     param->limitModes = 0;
@@ -563,6 +578,12 @@ int x265_param_parse(x265_param* p, const char* name, const char* value)
         else
             p->cpuid = parseCpuName(value, bError);
     }
+    OPT("asm-autotune") p->bAsmAutotune = atobool(value);
+    OPT("asm-autotune-file")
+    {
+        p->asmAutotuneFile = strdup(value);
+        p->bAsmAutotune = 1;
+    }
     OPT("fps")
     {
         if (sscanf(value, "%u/%u", &p->fpsNum, &p->fpsDenom) == 2)
@@ -585,6 +606,10 @@ int x265_param_parse(x265_param* p, const char* name, const char* value)
     OPT("frame-threads") p->frameNumThreads = atoi(value);
     OPT("pmode") p->bDistributeModeAnalysis = atobool(value);
     OPT("pme") p->bDistributeMotionEstimation = atobool(value);
+    OPT("adaptive-threading") p->bAdaptiveThreading = atobool(value);
+    OPT("pool-priority") p->poolPriority = atoi(value);
+    OPT("huge-pages") p->bHugePages = atobool(value);
+    OPT("max-memory") p->maxMemory = atoi(value);
     OPT2("level-idc", "level")
     {
         /* allow "5.1" or "51", both converted to integer 51 */
@@ -620,6 +645,13 @@ int x265_param_parse(x265_param* p, const char* name, const char* value)
     OPT("max-tu-size") p->maxTUSize = (uint32_t)atoi(value);
     OPT("subme") p->subpelRefine = atoi(value);
     OPT("merange") p->searchRange = atoi(value);
+    OPT("subpel-planes") p->subpelPlanes = atoi(value);
+    OPT("lowres-mv-seed") p->bLowresMvSeed = atobool(value);
+    OPT("tz-raster") p->tzRaster = atoi(value);
+    OPT("tz-star-dist") p->tzStarDist = atoi(value);
+    OPT("tz-early-exit") p->tzEarlyExit = atoi(value);
+    OPT("me-cache") p->bEnableMECache = atobool(value);
+    OPT("cache-affinity") p->bCacheAffinity = atobool(value);
     OPT("rect") p->bEnableRectInter = atobool(value);
     OPT("amp") p->bEnableAMP = atobool(value);
     OPT("max-merge") p->maxNumMergeCand = (uint32_t)atoi(value);
@@ -957,10 +989,24 @@ int parseCpuName(const char* value, bool& bError)
     {
         char *buf = strdup(value);
         char *tok, *saveptr = NULL, *init;
+        int noFlags = 0;
         bError = 0;
         cpu = 0;
         for (init = buf; (tok = strtok_r(init, ",", &saveptr)); init = NULL)
         {
+            /* "auto" and "noavx512" allow the detected flags to be trimmed,
+             * ie: --asm auto,noavx512 on parts which downclock on 512bit loads */
+            if (!strcasecmp(tok, "auto"))
+            {
+                cpu |= X265_NS::cpu_detect();
+                continue;
+            }
+            if (!strcasecmp(tok, "noavx512"))
+            {
+                noFlags |= X265_CPU_AVX512;
+                continue;
+            }
+
             int i;
             for (i = 0; X265_NS::cpu_names[i].flags && strcasecmp(tok, X265_NS::cpu_names[i].name); i++)
             {
@@ -972,6 +1018,7 @@ int parseCpuName(const char* value, bool& bError)
         }
 
         free(buf);
+        cpu &= ~noFlags;
         if ((cpu & X265_CPU_SSSE3) && !(cpu & X265_CPU_SSE2_IS_SLOW))
             cpu |= X265_CPU_SSE2_IS_FAST;
     }
@@ -1068,8 +1115,14 @@ int x265_check_params(x265_param* param)
           "Frame rate numerator and denominator must be specified");
     CHECK(param->interlaceMode < 0 || param->interlaceMode > 2,
           "Interlace mode must be 0 (progressive) 1 (top-field first) or 2 (bottom field first)");
-    CHECK(param->searchMethod<0 || param->searchMethod> X265_FULL_SEARCH,
-          "Search method is not supported value (0:DIA 1:HEX 2:UMH 3:HM 5:FULL)");
+    CHECK(param->searchMethod<0 || param->searchMethod> X265_TZ_SEARCH,
+          "Search method is not supported value (0:DIA 1:HEX 2:UMH 3:HM 4:FULL 5:TZ)");
+    CHECK(param->tzRaster < 0,
+          "tz-raster must be greater than or equal to 0");
+    CHECK(param->tzStarDist < 1,
+          "tz-star-dist must be greater than 0");
+    CHECK(param->tzEarlyExit < 1,
+          "tz-early-exit must be greater than 0");
     CHECK(param->searchRange < 0,
           "Search Range must be more than 0");
     CHECK(param->searchRange >= 32768,
@@ -1078,12 +1131,18 @@ int x265_check_params(x265_param* param)
           "subme must be less than or equal to X265_MAX_SUBPEL_LEVEL (7)");
     CHECK(param->subpelRefine < 0,
           "subme must be greater than or equal to 0");
+    CHECK(param->subpelPlanes < 0 || param->subpelPlanes > 2,
+          "subpel-planes must be 0, 1 or 2");
     CHECK(param->limitReferences > 3,
           "limitReferences must be 0, 1, 2 or 3");
     CHECK(param->limitModes > 1,
           "limitRectAmp must be 0, 1");
     CHECK(param->frameNumThreads < 0 || param->frameNumThreads > X265_MAX_FRAME_THREADS,
           "frameNumThreads (--frame-threads) must be [0 .. X265_MAX_FRAME_THREADS)");
+    CHECK(param->maxMemory < 0,
+          "Memory budget (--max-memory) must be 0 (unlimited) or a positive number of megabytes");
+    CHECK(param->poolPriority < -8 || param->poolPriority > 8,
+          "poolPriority must be between -8 and 8");
     CHECK(param->cbQpOffset < -12, "Min. Chroma Cb QP Offset is -12");
     CHECK(param->cbQpOffset >  12, "Max. Chroma Cb QP Offset is  12");
     CHECK(param->crQpOffset < -12, "Min. Chroma Cr QP Offset is -12");
@@ -1410,6 +1469,10 @@ char *x265_param2string(x265_param* p)
     s += sprintf(s, " fps=%u/%u", p->fpsNum, p->fpsDenom);
     s += sprintf(s, " bitdepth=%d", p->internalBitDepth);
     BOOL(p->bEnableWavefront, "wpp");
+    BOOL(p->bAdaptiveThreading, "adaptive-threading");
+    BOOL(p->bHugePages, "huge-pages");
+    BOOL(p->bCacheAffinity, "cache-affinity");
+    s += sprintf(s, " max-memory=%d", p->maxMemory);
     s += sprintf(s, " ctu=%d", p->maxCUSize);
     s += sprintf(s, " min-cu-size=%d", p->minCUSize);
     s += sprintf(s, " max-tu-size=%d", p->maxTUSize);
@@ -1418,6 +1481,10 @@ char *x265_param2string(x265_param* p)
     s += sprintf(s, " me=%d", p->searchMethod);
     s += sprintf(s, " subme=%d", p->subpelRefine);
     s += sprintf(s, " merange=%d", p->searchRange);
+    BOOL(p->bLowresMvSeed, "lowres-mv-seed");
+    if (p->searchMethod == X265_TZ_SEARCH)
+        s += sprintf(s, " tz-raster=%d tz-star-dist=%d tz-early-exit=%d", p->tzRaster, p->tzStarDist, p->tzEarlyExit);
+    BOOL(p->bEnableMECache, "me-cache");
     BOOL(p->bEnableRectInter, "rect");
     BOOL(p->bEnableAMP, "amp");
     s += sprintf(s, " max-merge=%d", p->maxNumMergeCand);
@@ -34,6 +34,11 @@ PicYuv::PicYuv()
     m_picBuf[0] = NULL;
     m_picBuf[1] = NULL;
     m_picBuf[2] = NULL;
+    m_bHugePages = false;
+
+    m_subpelBuf = NULL;
+    memset(m_subpelOrg, 0, sizeof(m_subpelOrg));
+    m_subpelPlanes = 0;
 
     m_picOrg[0] = NULL;
     m_picOrg[1] = NULL;
@@ -50,50 +55,93 @@ PicYuv::PicYuv()
     m_strideC = 0;
     m_hChromaShift = 0;
     m_vChromaShift = 0;
+    m_freeListNext = NULL;
+}
+
+/* the layout of the planes allocated by create(), in pixels: the row stride,
+ * the offset of the first sample from the start of the buffer, and the size
+ * of the buffer. Chroma strides and sizes are zero for 4:0:0 */
+void PicYuv::planeLayout(uint32_t picWidth, uint32_t picHeight, uint32_t picCsp, intptr_t stride[3], intptr_t offset[3], size_t size[3])
+{
+    uint32_t numCuInWidth = (picWidth + g_maxCUSize - 1)  / g_maxCUSize;
+    uint32_t numCuInHeight = (picHeight + g_maxCUSize - 1) / g_maxCUSize;
+
+    uint32_t lumaMarginX = g_maxCUSize + 32; // search margin and 8-tap filter half-length, padded for 32-byte alignment
+    uint32_t lumaMarginY = g_maxCUSize + 16; // margin for 8-tap filter and infinite padding
+    stride[0] = (numCuInWidth * g_maxCUSize) + (lumaMarginX << 1);
+
+    int maxHeight = numCuInHeight * g_maxCUSize;
+    offset[0] = lumaMarginY * stride[0] + lumaMarginX;
+    size[0] = stride[0] * (maxHeight + (lumaMarginY * 2));
+
+    if (picCsp != X265_CSP_I400)
+    {
+        uint32_t chromaMarginX = lumaMarginX;  // keep 16-byte alignment for chroma CTUs
+        uint32_t chromaMarginY = lumaMarginY >> CHROMA_V_SHIFT(picCsp);
+        stride[1] = stride[2] = ((numCuInWidth * g_maxCUSize) >> CHROMA_H_SHIFT(picCsp)) + (chromaMarginX * 2);
+        offset[1] = offset[2] = chromaMarginY * stride[1] + chromaMarginX;
+        size[1] = size[2] = stride[1] * ((maxHeight >> CHROMA_V_SHIFT(picCsp)) + (chromaMarginY * 2));
+    }
+    else
+    {
+        stride[1] = stride[2] = 0;
+        offset[1] = offset[2] = 0;
+        size[1] = size[2] = 0;
+    }
 }
 
-bool PicYuv::create(uint32_t picWidth, uint32_t picHeight, uint32_t picCsp)
+bool PicYuv::create(uint32_t picWidth, uint32_t picHeight, uint32_t picCsp, bool bHugePages)
 {
+    m_bHugePages = bHugePages;
     m_picWidth  = picWidth;
     m_picHeight = picHeight;
     m_hChromaShift = CHROMA_H_SHIFT(picCsp);
     m_vChromaShift = CHROMA_V_SHIFT(picCsp);
     m_picCsp = picCsp;
 
-    uint32_t numCuInWidth = (m_picWidth + g_maxCUSize - 1)  / g_maxCUSize;
-    uint32_t numCuInHeight = (m_picHeight + g_maxCUSize - 1) / g_maxCUSize;
+    intptr_t stride[3], offset[3];
+    size_t size[3];
+    planeLayout(picWidth, picHeight, picCsp, stride, offset, size);
 
-    m_lumaMarginX = g_maxCUSize + 32; // search margin and 8-tap filter half-length, padded for 32-byte alignment
-    m_lumaMarginY = g_maxCUSize + 16; // margin for 8-tap filter and infinite padding
-    m_stride = (numCuInWidth * g_maxCUSize) + (m_lumaMarginX << 1);
+    m_stride = stride[0];
+    m_lumaMarginX = (uint32_t)(offset[0] % m_stride);
+    m_lumaMarginY = (uint32_t)(offset[0] / m_stride);
 
-    int maxHeight = numCuInHeight * g_maxCUSize;
-    CHECKED_MALLOC(m_picBuf[0], pixel, m_stride * (maxHeight + (m_lumaMarginY * 2)));
-    m_picOrg[0] = m_picBuf[0] + m_lumaMarginY * m_stride + m_lumaMarginX;
+    CHECKED_MALLOC_HUGE(m_picBuf[0], pixel, size[0], bHugePages);
 
     if (picCsp != X265_CSP_I400)
     {
-        m_chromaMarginX = m_lumaMarginX;  // keep 16-byte alignment for chroma CTUs
-        m_chromaMarginY = m_lumaMarginY >> m_vChromaShift;
-        m_strideC = ((numCuInWidth * g_maxCUSize) >> m_hChromaShift) + (m_chromaMarginX * 2);
+        m_strideC = stride[1];
+        m_chromaMarginX = (uint32_t)(offset[1] % m_strideC);
+        m_chromaMarginY = (uint32_t)(offset[1] / m_strideC);
 
-        CHECKED_MALLOC(m_picBuf[1], pixel, m_strideC * ((maxHeight >> m_vChromaShift) + (m_chromaMarginY * 2)));
-        CHECKED_MALLOC(m_picBuf[2], pixel, m_strideC * ((maxHeight >> m_vChromaShift) + (m_chromaMarginY * 2)));
-
-        m_picOrg[1] = m_picBuf[1] + m_chromaMarginY * m_strideC + m_chromaMarginX;
-        m_picOrg[2] = m_picBuf[2] + m_chromaMarginY * m_strideC + m_chromaMarginX;
+        CHECKED_MALLOC_HUGE(m_picBuf[1], pixel, size[1], bHugePages);
+        CHECKED_MALLOC_HUGE(m_picBuf[2], pixel, size[2], bHugePages);
     }
     else
-    {
         m_picBuf[1] = m_picBuf[2] = NULL;
-        m_picOrg[1] = m_picOrg[2] = NULL;
-    }
+
+    restorePlanes();
     return true;
 
 fail:
     return false;
 }
 
+/* point m_picOrg back at the planes allocated by create(), after the planes
+ * of an input picture were used in place */
+void PicYuv::restorePlanes()
+{
+    m_picOrg[0] = m_picBuf[0] + m_lumaMarginY * m_stride + m_lumaMarginX;
+    if (m_picBuf[1])
+    {
+        m_picOrg[1] = m_picBuf[1] + m_chromaMarginY * m_strideC + m_chromaMarginX;
+        m_picOrg[2] = m_picBuf[2] + m_chromaMarginY * m_strideC + m_chromaMarginX;
+    }
+    else
+        m_picOrg[1] = m_picOrg[2] = NULL;
+}
+
 /* the first picture allocated by the encoder will be asked to generate these
  * offset arrays. Once generated, they will be provided to all future PicYuv
  * allocated by the same encoder. */
@@ -145,30 +193,95 @@ fail:
     return false;
 }
 
+/* (re)allocate the sub-pel luma planes for param->subpelPlanes, 1 for the
+ * three half-pel phases and 2 for all fifteen quarter-pel phases. A recon
+ * picture taken from a pool may carry the planes of another setting. On
+ * failure the picture is left without planes, and motion search interpolates
+ * as it would without them */
+bool PicYuv::createSubpelPlanes(int subpelPlanes)
+{
+    if (subpelPlanes == m_subpelPlanes)
+        return true;
+
+    X265_FREE_HUGE(m_subpelBuf, m_bHugePages);
+    m_subpelBuf = NULL;
+    memset(m_subpelOrg, 0, sizeof(m_subpelOrg));
+    m_subpelPlanes = 0;
+    if (!subpelPlanes)
+        return true;
+
+    intptr_t stride[3], offset[3];
+    size_t size[3];
+    planeLayout(m_picWidth, m_picHeight, m_picCsp, stride, offset, size);
+
+    static const int halfPel[] = { 2, 8, 10 };
+    int numPlanes = subpelPlanes == 1 ? 3 : 15;
+    CHECKED_MALLOC_HUGE(m_subpelBuf, pixel, size[0] * numPlanes, m_bHugePages);
+
+    for (int i = 0; i < numPlanes; i++)
+        m_subpelOrg[subpelPlanes == 1 ? halfPel[i] : i + 1] = m_subpelBuf + size[0] * i + offset[0];
+    m_subpelPlanes = subpelPlanes;
+    return true;
+
+fail:
+    return false;
+}
+
 void PicYuv::destroy()
 {
-    X265_FREE(m_picBuf[0]);
-    X265_FREE(m_picBuf[1]);
-    X265_FREE(m_picBuf[2]);
+    X265_FREE_HUGE(m_picBuf[0], m_bHugePages);
+    X265_FREE_HUGE(m_picBuf[1], m_bHugePages);
+    X265_FREE_HUGE(m_picBuf[2], m_bHugePages);
+    X265_FREE_HUGE(m_subpelBuf, m_bHugePages);
 }
 
-/* Copy pixels from an x265_picture into internal PicYuv instance.
- * Shift pixels as necessary, mask off bits above X265_DEPTH for safety. */
-void PicYuv::copyFromPicture(const x265_picture& pic, const x265_param& param, int padx, int pady)
+/* interpolate luma rows [startY, endY) of the sub-pel planes from the full-pel
+ * plane, which must be final (filtered and border extended) from startY - 3 to
+ * endY + 3. The width covers the margins but for the filter half-length, and
+ * rows are processed in blocks of 8 with the motion compensation primitives,
+ * so every sample equals the prediction of a block at that position */
+void PicYuv::interpSubpelRows(int startY, int endY)
 {
-    /* m_picWidth is the width that is being encoded, padx indicates how many
-     * of those pixels are padding to reach multiple of MinCU(4) size.
-     *
-     * Internally, we need to extend rows out to a multiple of 16 for lowres
-     * downscale and other operations. But those padding pixels are never
-     * encoded.
-     *
-     * The same applies to m_picHeight and pady */
+    X265_CHECK(!((endY - startY) & 7), "sub-pel rows must be a multiple of 8\n");
 
-    /* width and height - without padsize (input picture raw width and height) */
-    int width = m_picWidth - padx;
-    int height = m_picHeight - pady;
+    const int startX = -(int)m_lumaMarginX + 4;
+    const int endX = (int)(m_stride - m_lumaMarginX) - 4;
+
+    for (int idx = 1; idx < 16; idx++)
+    {
+        if (!m_subpelOrg[idx])
+            continue;
+
+        int xFrac = idx & 3, yFrac = idx >> 2;
+        for (int y = startY; y < endY; y += 8)
+        {
+            const pixel* src = m_picOrg[0] + y * m_stride;
+            pixel* dst = m_subpelOrg[idx] + y * m_stride;
+            for (int x = startX; x < endX;)
+            {
+                int part = endX - x >= 32 ? LUMA_32x8 : endX - x >= 16 ? LUMA_16x8 : LUMA_8x8;
+                if (!yFrac)
+                    primitives.pu[part].luma_hpp(src + x, m_stride, dst + x, m_stride, xFrac);
+                else if (!xFrac)
+                    primitives.pu[part].luma_vpp(src + x, m_stride, dst + x, m_stride, yFrac);
+                else
+                    primitives.pu[part].luma_hvpp(src + x, m_stride, dst + x, m_stride, xFrac, yFrac);
+                x += part == LUMA_32x8 ? 32 : part == LUMA_16x8 ? 16 : 8;
+            }
+        }
+    }
+}
 
+/* m_picWidth is the width that is being encoded, padx indicates how many
+ * of those pixels are padding to reach multiple of MinCU(4) size.
+ *
+ * Internally, we need to extend rows out to a multiple of 16 for lowres
+ * downscale and other operations. But those padding pixels are never
+ * encoded.
+ *
+ * The same applies to m_picHeight and pady */
+static void internalPadding(int width, int height, int& padx, int& pady)
+{
     /* internal pad to multiple of 16x16 blocks */
     uint8_t rem = width & 15;
 
@@ -180,157 +293,175 @@ void PicYuv::copyFromPicture(const x265_picture& pic, const x265_param& param, i
      * warnings from valgrind about using uninitialized pixels */
     padx++;
     pady++;
+}
+
+/* Copy pixels from an x265_picture into internal PicYuv instance.
+ * Shift pixels as necessary, mask off bits above X265_DEPTH for safety.
+ * Each row is converted, clipped and extended to the right in one pass */
+void PicYuv::copyFromPicture(const x265_picture& pic, const x265_param& param, int padx, int pady)
+{
+    /* width and height - without padsize (input picture raw width and height) */
+    int width = m_picWidth - padx;
+    int height = m_picHeight - pady;
+
+    internalPadding(width, height, padx, pady);
     m_picCsp = pic.colorSpace;
 
+    int widthC = width >> m_hChromaShift;
+    int heightC = height >> m_vChromaShift;
+    int padxC = padx >> m_hChromaShift;
+
     X265_CHECK(pic.bitDepth >= 8, "pic.bitDepth check failure");
 
+#if HIGH_BIT_DEPTH
+    bool calcHDRParams = !!param.minLuma || (param.maxLuma != PIXEL_MAX);
+#else
+    bool calcHDRParams = false;
+#endif
+    bool bLumaClipped = false;
+
     if (pic.bitDepth == 8)
     {
-#if (X265_DEPTH > 8)
-        {
-            pixel *yPixel = m_picOrg[0];
-
-            uint8_t *yChar = (uint8_t*)pic.planes[0];
-            int shift = (X265_DEPTH - 8);
+        /* shift left to the internal depth, if it is higher */
+        int shift = (X265_DEPTH - 8);
 
-            primitives.planecopy_cp(yChar, pic.stride[0] / sizeof(*yChar), yPixel, m_stride, width, height, shift);
+        primitives.planecopy_cp_pad((uint8_t*)pic.planes[0], pic.stride[0], m_picOrg[0], m_stride, width, height, shift, calcHDRParams ? 0 : padx);
 
-            if (param.internalCsp != X265_CSP_I400)
-            {
-                pixel *uPixel = m_picOrg[1];
-                pixel *vPixel = m_picOrg[2];
-
-                uint8_t *uChar = (uint8_t*)pic.planes[1];
-                uint8_t *vChar = (uint8_t*)pic.planes[2];
-
-                primitives.planecopy_cp(uChar, pic.stride[1] / sizeof(*uChar), uPixel, m_strideC, width >> m_hChromaShift, height >> m_vChromaShift, shift);
-                primitives.planecopy_cp(vChar, pic.stride[2] / sizeof(*vChar), vPixel, m_strideC, width >> m_hChromaShift, height >> m_vChromaShift, shift);
-            }
-        }
-#else /* Case for (X265_DEPTH == 8) */
-        // TODO: Does we need this path? may merge into above in future
+        if (param.internalCsp != X265_CSP_I400)
         {
-            pixel *yPixel = m_picOrg[0];
-            uint8_t *yChar = (uint8_t*)pic.planes[0];
-
-            for (int r = 0; r < height; r++)
-            {
-                memcpy(yPixel, yChar, width * sizeof(pixel));
-
-                yPixel += m_stride;
-                yChar += pic.stride[0] / sizeof(*yChar);
-            }
-
-            if (param.internalCsp != X265_CSP_I400)
-            {
-                pixel *uPixel = m_picOrg[1];
-                pixel *vPixel = m_picOrg[2];
-
-                uint8_t *uChar = (uint8_t*)pic.planes[1];
-                uint8_t *vChar = (uint8_t*)pic.planes[2];
-
-                for (int r = 0; r < height >> m_vChromaShift; r++)
-                {
-                    memcpy(uPixel, uChar, (width >> m_hChromaShift) * sizeof(pixel));
-                    memcpy(vPixel, vChar, (width >> m_hChromaShift) * sizeof(pixel));
-
-                    uPixel += m_strideC;
-                    vPixel += m_strideC;
-                    uChar += pic.stride[1] / sizeof(*uChar);
-                    vChar += pic.stride[2] / sizeof(*vChar);
-                }
-            }
+            primitives.planecopy_cp_pad((uint8_t*)pic.planes[1], pic.stride[1], m_picOrg[1], m_strideC, widthC, heightC, shift, padxC);
+            primitives.planecopy_cp_pad((uint8_t*)pic.planes[2], pic.stride[2], m_picOrg[2], m_strideC, widthC, heightC, shift, padxC);
         }
-#endif /* (X265_DEPTH > 8) */
     }
     else /* pic.bitDepth > 8 */
     {
         /* defensive programming, mask off bits that are supposed to be zero */
         uint16_t mask = (1 << X265_DEPTH) - 1;
         int shift = abs(pic.bitDepth - X265_DEPTH);
-        pixel *yPixel = m_picOrg[0];
 
-        uint16_t *yShort = (uint16_t*)pic.planes[0];
+        /* shift right or left and mask pixels to final size */
+        planecopy_sp_pad_t copy = pic.bitDepth > X265_DEPTH ? primitives.planecopy_sp_pad : primitives.planecopy_sp_shl_pad;
 
-        if (pic.bitDepth > X265_DEPTH)
-        {
-            /* shift right and mask pixels to final size */
-            primitives.planecopy_sp(yShort, pic.stride[0] / sizeof(*yShort), yPixel, m_stride, width, height, shift, mask);
-        }
-        else /* Case for (pic.bitDepth <= X265_DEPTH) */
+#if HIGH_BIT_DEPTH
+        if (calcHDRParams && pic.bitDepth == X265_DEPTH)
         {
-            /* shift left and mask pixels to final size */
-            primitives.planecopy_sp_shl(yShort, pic.stride[0] / sizeof(*yShort), yPixel, m_stride, width, height, shift, mask);
+            /* Apply min/max luma bounds for HDR pixel manipulations while copying */
+            uint64_t sumLuma;
+            m_maxLumaLevel = primitives.planecopy_sp_clip((uint16_t*)pic.planes[0], pic.stride[0] / sizeof(uint16_t), m_picOrg[0], m_stride, width, height, padx,
+                                                          &sumLuma, (pixel)param.minLuma, (pixel)param.maxLuma);
+            m_avgLumaLevel = (double)sumLuma / (m_picHeight * m_picWidth);
+            bLumaClipped = true;
         }
+        else
+#endif
+            copy((uint16_t*)pic.planes[0], pic.stride[0] / sizeof(uint16_t), m_picOrg[0], m_stride, width, height, shift, mask, calcHDRParams ? 0 : padx);
 
         if (param.internalCsp != X265_CSP_I400)
         {
-            pixel *uPixel = m_picOrg[1];
-            pixel *vPixel = m_picOrg[2];
+            copy((uint16_t*)pic.planes[1], pic.stride[1] / sizeof(uint16_t), m_picOrg[1], m_strideC, widthC, heightC, shift, mask, padxC);
+            copy((uint16_t*)pic.planes[2], pic.stride[2] / sizeof(uint16_t), m_picOrg[2], m_strideC, widthC, heightC, shift, mask, padxC);
+        }
+    }
 
-            uint16_t *uShort = (uint16_t*)pic.planes[1];
-            uint16_t *vShort = (uint16_t*)pic.planes[2];
+    if (calcHDRParams && !bLumaClipped)
+    {
+        /* the luma of this input could not be clipped while it was copied */
+        clipLuma(param, width, height);
+        extendRight(m_picOrg[0], m_stride, width, height, padx);
+    }
 
-            if (pic.bitDepth > X265_DEPTH)
-            {
-                primitives.planecopy_sp(uShort, pic.stride[1] / sizeof(*uShort), uPixel, m_strideC, width >> m_hChromaShift, height >> m_vChromaShift, shift, mask);
-                primitives.planecopy_sp(vShort, pic.stride[2] / sizeof(*vShort), vPixel, m_strideC, width >> m_hChromaShift, height >> m_vChromaShift, shift, mask);
-            }
-            else /* Case for (pic.bitDepth <= X265_DEPTH) */
-            {
-                primitives.planecopy_sp_shl(uShort, pic.stride[1] / sizeof(*uShort), uPixel, m_strideC, width >> m_hChromaShift, height >> m_vChromaShift, shift, mask);
-                primitives.planecopy_sp_shl(vShort, pic.stride[2] / sizeof(*vShort), vPixel, m_strideC, width >> m_hChromaShift, height >> m_vChromaShift, shift, mask);
-            }
-        }
+    extendBottom(width, height, padx, pady);
+}
+
+/* Use the planes of an x265_picture in place, see x265_picture.release. The
+ * caller has checked the layout with canReference(); the planes stay in use
+ * until restorePlanes() is called */
+void PicYuv::referencePicture(const x265_picture& pic, const x265_param& param, int padx, int pady)
+{
+    for (int i = 0; i < 3; i++)
+        m_picOrg[i] = m_picBuf[i] ? (pixel*)pic.planes[i] : NULL;
+
+    int width = m_picWidth - padx;
+    int height = m_picHeight - pady;
+
+    internalPadding(width, height, padx, pady);
+
+    clipLuma(param, width, height);
+
+    extendRight(m_picOrg[0], m_stride, width, height, padx);
+    if (param.internalCsp != X265_CSP_I400)
+    {
+        extendRight(m_picOrg[1], m_strideC, width >> m_hChromaShift, height >> m_vChromaShift, padx >> m_hChromaShift);
+        extendRight(m_picOrg[2], m_strideC, width >> m_hChromaShift, height >> m_vChromaShift, padx >> m_hChromaShift);
+    }
+
+    extendBottom(width, height, padx, pady);
+}
+
+/* true if the planes of pic have the layout of this picture, so they can be
+ * used in place rather than copied */
+bool PicYuv::canReference(const x265_picture& pic) const
+{
+    if (pic.bitDepth != X265_DEPTH || (uint32_t)pic.colorSpace != m_picCsp)
+        return false;
+
+    int numPlanes = m_picBuf[1] ? 3 : 1;
+    for (int i = 0; i < numPlanes; i++)
+    {
+        intptr_t stride = i ? m_strideC : m_stride;
+        intptr_t offset = i ? m_chromaMarginY * m_strideC + m_chromaMarginX : m_lumaMarginY * m_stride + m_lumaMarginX;
+        if (!pic.planes[i] || pic.stride[i] != (int)(stride * sizeof(pixel)))
+            return false;
+
+        /* same alignment as our own planes, which the primitives rely on */
+        if ((((uintptr_t)pic.planes[i] - offset * sizeof(pixel)) & 31) != 0)
+            return false;
     }
 
-    pixel *Y = m_picOrg[0];
-    pixel *U = m_picOrg[1];
-    pixel *V = m_picOrg[2];
+    return true;
+}
 
+/* Apply min/max luma bounds for HDR pixel manipulations, in place */
+void PicYuv::clipLuma(const x265_param& param, int width, int height)
+{
 #if HIGH_BIT_DEPTH
     bool calcHDRParams = !!param.minLuma || (param.maxLuma != PIXEL_MAX);
-    /* Apply min/max luma bounds for HDR pixel manipulations */
     if (calcHDRParams)
     {
-        X265_CHECK(pic.bitDepth == 10, "HDR stats can be applied/calculated only for 10bpp content");
+        X265_CHECK(X265_DEPTH == 10, "HDR stats can be applied/calculated only for 10bpp content");
         uint64_t sumLuma;
-        m_maxLumaLevel = primitives.planeClipAndMax(Y, m_stride, width, height, &sumLuma, (pixel)param.minLuma, (pixel)param.maxLuma);
+        m_maxLumaLevel = primitives.planeClipAndMax(m_picOrg[0], m_stride, width, height, &sumLuma, (pixel)param.minLuma, (pixel)param.maxLuma);
         m_avgLumaLevel = (double) sumLuma / (m_picHeight * m_picWidth);
     }
 #else
-    (void) param;
+    (void)param;
+    (void)width;
+    (void)height;
 #endif
+}
 
-    /* extend the right edge if width was not multiple of the minimum CU size */
+/* extend the right edge if width was not multiple of the minimum CU size */
+void PicYuv::extendRight(pixel* plane, intptr_t stride, int width, int height, int padx)
+{
     for (int r = 0; r < height; r++)
     {
         for (int x = 0; x < padx; x++)
-            Y[width + x] = Y[width - 1];
-        Y += m_stride;
+            plane[width + x] = plane[width - 1];
+        plane += stride;
     }
+}
 
-    /* extend the bottom if height was not multiple of the minimum CU size */
-    Y = m_picOrg[0] + (height - 1) * m_stride;
+/* extend the bottom if height was not multiple of the minimum CU size */
+void PicYuv::extendBottom(int width, int height, int padx, int pady)
+{
+    pixel *Y = m_picOrg[0] + (height - 1) * m_stride;
     for (int i = 1; i <= pady; i++)
         memcpy(Y + i * m_stride, Y, (width + padx) * sizeof(pixel));
 
-    if (param.internalCsp != X265_CSP_I400)
+    if (m_picBuf[1])
     {
-        for (int r = 0; r < height >> m_vChromaShift; r++)
-        {
-            for (int x = 0; x < padx >> m_hChromaShift; x++)
-            {
-                U[(width >> m_hChromaShift) + x] = U[(width >> m_hChromaShift) - 1];
-                V[(width >> m_hChromaShift) + x] = V[(width >> m_hChromaShift) - 1];
-            }
-
-            U += m_strideC;
-            V += m_strideC;
-        }
-
-        U = m_picOrg[1] + ((height >> m_vChromaShift) - 1) * m_strideC;
-        V = m_picOrg[2] + ((height >> m_vChromaShift) - 1) * m_strideC;
+        pixel *U = m_picOrg[1] + ((height >> m_vChromaShift) - 1) * m_strideC;
+        pixel *V = m_picOrg[2] + ((height >> m_vChromaShift) - 1) * m_strideC;
 
         for (int j = 1; j <= pady >> m_vChromaShift; j++)
         {
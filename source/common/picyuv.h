@@ -40,6 +40,11 @@ public:
 
     pixel*   m_picBuf[3];  // full allocated buffers, including margins
     pixel*   m_picOrg[3];  // pointers to plane starts
+    bool     m_bHugePages; // m_picBuf allocated by x265_malloc_huge()
+
+    pixel*   m_subpelBuf;      // interpolated luma planes, see createSubpelPlanes()
+    pixel*   m_subpelOrg[16];  // sub-pel plane starts indexed by (yFrac << 2) | xFrac, NULL if absent
+    int      m_subpelPlanes;   // param->subpelPlanes of m_subpelBuf
 
     uint32_t m_picWidth;
     uint32_t m_picHeight;
@@ -63,13 +68,27 @@ public:
     pixel m_maxLumaLevel;
     double   m_avgLumaLevel;
 
+    PicYuv*  m_freeListNext; // next idle picture of a FramePool bucket
+
     PicYuv();
 
-    bool  create(uint32_t picWidth, uint32_t picHeight, uint32_t csp);
+    static void planeLayout(uint32_t picWidth, uint32_t picHeight, uint32_t csp, intptr_t stride[3], intptr_t offset[3], size_t size[3]);
+
+    bool  create(uint32_t picWidth, uint32_t picHeight, uint32_t csp, bool bHugePages);
     bool  createOffsets(const SPS& sps);
+    bool  createSubpelPlanes(int subpelPlanes);
     void  destroy();
 
+    void  interpSubpelRows(int startY, int endY);
+
     void  copyFromPicture(const x265_picture&, const x265_param& param, int padx, int pady);
+    bool  canReference(const x265_picture&) const;
+    void  referencePicture(const x265_picture&, const x265_param& param, int padx, int pady);
+    void  restorePlanes();
+
+    void  clipLuma(const x265_param& param, int width, int height);
+    void  extendBottom(int width, int height, int padx, int pady);
+    static void extendRight(pixel* plane, intptr_t stride, int width, int height, int padx);
 
     intptr_t getChromaAddrOffset(uint32_t ctuAddr, uint32_t absPartIdx) const { return m_cuOffsetC[ctuAddr] + m_buOffsetC[absPartIdx]; }
 
@@ -117,6 +117,24 @@ void sad_x4(const pixel* pix1, const pixel* pix2, const pixel* pix3, const pixel
     }
 }
 
+template<int lx, int ly>
+void sad_x8(const pixel* pix1, const pixel* const* fref, intptr_t frefstride, int32_t* res)
+{
+    for (int i = 0; i < 8; i++)
+        res[i] = 0;
+    for (int y = 0; y < ly; y++)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            const pixel* pix2 = fref[i] + y * frefstride;
+            for (int x = 0; x < lx; x++)
+                res[i] += abs(pix1[x] - pix2[x]);
+        }
+
+        pix1 += FENC_STRIDE;
+    }
+}
+
 template<int lx, int ly, class T1, class T2>
 sse_t sse(const T1* pix1, intptr_t stride_pix1, const T2* pix2, intptr_t stride_pix2)
 {
@@ -842,6 +860,83 @@ static void planecopy_sp_shl_c(const uint16_t* src, intptr_t srcStride, pixel* d
     }
 }
 
+static void planecopy_cp_pad_c(const uint8_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, int padx)
+{
+    for (int r = 0; r < height; r++)
+    {
+        if (sizeof(pixel) == 1 && !shift)
+            memcpy(dst, src, width);
+        else
+        {
+            for (int c = 0; c < width; c++)
+                dst[c] = ((pixel)src[c]) << shift;
+        }
+        for (int x = 0; x < padx; x++)
+            dst[width + x] = dst[width - 1];
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+static void planecopy_sp_pad_c(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask, int padx)
+{
+    for (int r = 0; r < height; r++)
+    {
+        for (int c = 0; c < width; c++)
+            dst[c] = (pixel)((src[c] >> shift) & mask);
+        for (int x = 0; x < padx; x++)
+            dst[width + x] = dst[width - 1];
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+static void planecopy_sp_shl_pad_c(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask, int padx)
+{
+    for (int r = 0; r < height; r++)
+    {
+        for (int c = 0; c < width; c++)
+            dst[c] = (pixel)((src[c] << shift) & mask);
+        for (int x = 0; x < padx; x++)
+            dst[width + x] = dst[width - 1];
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+/* output sample x is the Q14 weighted sum of taps samples starting at pos[x] */
+template<typename T>
+static void resample_h_c(const T* src, int16_t* dst, int width, const int32_t* pos, const int16_t* coef, int taps, int shift)
+{
+    int offset = 1 << (shift - 1);
+
+    for (int x = 0; x < width; x++, coef += taps)
+    {
+        const T* s = src + pos[x];
+        int sum = 0;
+        for (int k = 0; k < taps; k++)
+            sum += s[k] * coef[k];
+        dst[x] = (int16_t)((sum + offset) >> shift);
+    }
+}
+
+template<typename T>
+static void resample_v_c(const int16_t* src, intptr_t srcStride, T* dst, int width, const int16_t* coef, int taps, int shift, int maxVal)
+{
+    int offset = 1 << (shift - 1);
+
+    for (int x = 0; x < width; x++)
+    {
+        int sum = 0;
+        for (int k = 0; k < taps; k++)
+            sum += src[k * srcStride + x] * coef[k];
+        dst[x] = (T)x265_clip3(0, maxVal, (sum + offset) >> shift);
+    }
+}
+
 /* Estimate the total amount of influence on future quality that could be had if we
  * were to improve the reference samples used to inter predict any given CU. */
 static void estimateCUPropagateCost(int* dst, const uint16_t* propagateIn, const int32_t* intraCosts, const uint16_t* interCosts,
@@ -910,6 +1005,31 @@ static pixel planeClipAndMax_c(pixel *src, intptr_t stride, int width, int heigh
     return maxLumaLevel;
 }
 
+/* planecopy_sp_pad with no shift, fused with planeClipAndMax */
+static pixel planecopy_sp_clip_c(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int padx,
+                                 uint64_t *outsum, const pixel minPix, const pixel maxPix)
+{
+    pixel maxLumaLevel = 0;
+    uint64_t sumLuma = 0;
+
+    for (int r = 0; r < height; r++)
+    {
+        for (int c = 0; c < width; c++)
+        {
+            dst[c] = x265_clip3((pixel)minPix, (pixel)maxPix, (pixel)(src[c] & ((1 << X265_DEPTH) - 1)));
+            maxLumaLevel = X265_MAX(dst[c], maxLumaLevel);
+            sumLuma += dst[c];
+        }
+        for (int x = 0; x < padx; x++)
+            dst[width + x] = dst[width - 1];
+
+        dst += dstStride;
+        src += srcStride;
+    }
+    *outsum = sumLuma;
+    return maxLumaLevel;
+}
+
 #endif
 }  // end anonymous namespace
 
@@ -944,6 +1064,7 @@ void setupPixelPrimitives_c(EncoderPrimitives &p)
     p.pu[LUMA_ ## W ## x ## H].sad = sad<W, H>; \
     p.pu[LUMA_ ## W ## x ## H].sad_x3 = sad_x3<W, H>; \
     p.pu[LUMA_ ## W ## x ## H].sad_x4 = sad_x4<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_x8 = sad_x8<W, H>; \
     p.pu[LUMA_ ## W ## x ## H].pixelavg_pp = pixelavg_pp<W, H>;
 
 #define LUMA_CU(W, H) \
@@ -1195,9 +1316,17 @@ void setupPixelPrimitives_c(EncoderPrimitives &p)
     p.planecopy_cp = planecopy_cp_c;
     p.planecopy_sp = planecopy_sp_c;
     p.planecopy_sp_shl = planecopy_sp_shl_c;
+    p.planecopy_cp_pad = planecopy_cp_pad_c;
+    p.planecopy_sp_pad = planecopy_sp_pad_c;
+    p.planecopy_sp_shl_pad = planecopy_sp_shl_pad_c;
 #if HIGH_BIT_DEPTH
     p.planeClipAndMax = planeClipAndMax_c;
+    p.planecopy_sp_clip = planecopy_sp_clip_c;
 #endif
+    p.resample_h_cs = resample_h_c<uint8_t>;
+    p.resample_h_ss = resample_h_c<uint16_t>;
+    p.resample_v_sc = resample_v_c<uint8_t>;
+    p.resample_v_ss = resample_v_c<uint16_t>;
     p.propagateCost = estimateCUPropagateCost;
     p.fix8Unpack = cuTreeFix8Unpack;
     p.fix8Pack = cuTreeFix8Pack;
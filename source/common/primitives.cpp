@@ -57,6 +57,7 @@ void setupFilterPrimitives_c(EncoderPrimitives &p);
 void setupIntraPrimitives_c(EncoderPrimitives &p);
 void setupLoopFilterPrimitives_c(EncoderPrimitives &p);
 void setupSaoPrimitives_c(EncoderPrimitives &p);
+void setupComposedDCTPrimitives(EncoderPrimitives &p);
 
 void setupCPrimitives(EncoderPrimitives &p)
 {
@@ -188,6 +189,32 @@ void setupAliasPrimitives(EncoderPrimitives &p)
     p.chroma[X265_CSP_I422].cu[BLOCK_422_2x4].sse_pp = NULL;
 }
 
+/* Fill the table with the C primitives, overridden by the intrinsic and
+ * assembly primitives enabled by cpuMask. Aliases are not set up */
+void setupPrimitives(EncoderPrimitives &p, int cpuMask)
+{
+    setupCPrimitives(p);
+
+    /* We do not want the encoder to use the un-optimized intra all-angles
+     * C references. It is better to call the individual angle functions
+     * instead. We must check for NULL before using this primitive */
+    for (int i = 0; i < NUM_TR_SIZE; i++)
+        p.cu[i].intra_pred_allangs = NULL;
+
+#if X265_ARCH_X86
+    /* the intrinsic primitives are built without assembly too */
+    setupInstrinsicPrimitives(p, cpuMask);
+#endif
+#if ENABLE_ASSEMBLY
+    setupAssemblyPrimitives(p, cpuMask);
+#endif
+#if X265_ARCH_X86
+    /* there is no AVX-512 assembly, these intrinsics replace the AVX2 assembly */
+    setupInstrinsicPrimitives_avx512(p, cpuMask);
+#endif
+    (void)cpuMask;
+}
+
 void x265_report_simd(x265_param* param)
 {
     if (param->logLevel >= X265_LOG_INFO)
@@ -229,22 +256,13 @@ void x265_setup_primitives(x265_param *param)
 {
     if (!primitives.pu[0].sad)
     {
-        setupCPrimitives(primitives);
-
-        /* We do not want the encoder to use the un-optimized intra all-angles
-         * C references. It is better to call the individual angle functions
-         * instead. We must check for NULL before using this primitive */
-        for (int i = 0; i < NUM_TR_SIZE; i++)
-            primitives.cu[i].intra_pred_allangs = NULL;
+        setupPrimitives(primitives, param->cpuid);
 
-#if ENABLE_ASSEMBLY
-#if X265_ARCH_X86
-        setupInstrinsicPrimitives(primitives, param->cpuid);
-#endif
-        setupAssemblyPrimitives(primitives, param->cpuid);
-#endif
+        if (param->bAsmAutotune)
+            autotunePrimitives(primitives, param);
 
         setupAliasPrimitives(primitives);
+        setupComposedDCTPrimitives(primitives); // dct.cpp
     }
 
     x265_report_simd(param);
@@ -254,6 +272,44 @@ void x265_setup_primitives(x265_param *param)
 #if ENABLE_ASSEMBLY && X265_ARCH_X86
 /* these functions are implemented in assembly. When assembly is not being
  * compiled, they are unnecessary and can be NOPs */
+#elif X265_ARCH_X86
+/* Without assembly, the cpu is detected with the compiler's cpuid and xgetbv
+ * intrinsics so the intrinsic primitives can be used */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+extern "C" {
+int PFX(cpu_cpuid_test)(void) { return 1; }
+void PFX(cpu_emms)(void) {}
+void PFX(cpu_cpuid)(uint32_t op, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, op, 0);
+    *eax = regs[0];
+    *ebx = regs[1];
+    *ecx = regs[2];
+    *edx = regs[3];
+#else
+    __cpuid_count(op, 0, *eax, *ebx, *ecx, *edx);
+#endif
+}
+
+void PFX(cpu_xgetbv)(uint32_t op, uint32_t *eax, uint32_t *edx)
+{
+#if defined(_MSC_VER)
+    uint64_t xcr = _xgetbv(op);
+    *eax = (uint32_t)xcr;
+    *edx = (uint32_t)(xcr >> 32);
+#else
+    __asm__ volatile("xgetbv" : "=a"(*eax), "=d"(*edx) : "c"(op));
+#endif
+}
+}
 #else
 extern "C" {
 int PFX(cpu_cpuid_test)(void) { return 0; }
@@ -117,6 +117,7 @@ typedef sse_t (*pixel_sse_ss_t)(const int16_t* fenc, intptr_t fencstride, const
 typedef sse_t (*pixel_ssd_s_t)(const int16_t* fenc, intptr_t fencstride);
 typedef void (*pixelcmp_x4_t)(const pixel* fenc, const pixel* fref0, const pixel* fref1, const pixel* fref2, const pixel* fref3, intptr_t frefstride, int32_t* res);
 typedef void (*pixelcmp_x3_t)(const pixel* fenc, const pixel* fref0, const pixel* fref1, const pixel* fref2, intptr_t frefstride, int32_t* res);
+typedef void (*pixelcmp_x8_t)(const pixel* fenc, const pixel* const* fref, intptr_t frefstride, int32_t* res);
 typedef void (*blockfill_s_t)(int16_t* dst, intptr_t dstride, int16_t val);
 
 typedef void (*intra_pred_t)(pixel* dst, intptr_t dstStride, const pixel *srcPix, int dirMode, int bFilter);
@@ -139,6 +140,8 @@ typedef uint32_t (*quant_t)(const int16_t* coef, const int32_t* quantCoeff, int3
 typedef uint32_t (*nquant_t)(const int16_t* coef, const int32_t* quantCoeff, int16_t* qCoef, int qBits, int add, int numCoeff);
 typedef void (*dequant_scaling_t)(const int16_t* src, const int32_t* dequantCoef, int16_t* dst, int num, int mcqp_miper, int shift);
 typedef void (*dequant_normal_t)(const int16_t* quantCoef, int16_t* coef, int num, int scale, int shift);
+typedef uint32_t (*dct_quant_t)(const int16_t* residual, intptr_t resiStride, int16_t* coef, const int32_t* quantCoeff, int32_t* deltaU, int16_t* qCoef, int qBits, int add);
+typedef void (*dequant_idct_t)(const int16_t* quantCoef, int16_t* residual, intptr_t resiStride, int scale, int shift);
 typedef int(*count_nonzero_t)(const int16_t* quantCoeff);
 typedef void (*weightp_pp_t)(const pixel* src, pixel* dst, intptr_t stride, int width, int height, int w0, int round, int shift, int offset);
 typedef void (*weightp_sp_t)(const int16_t* src, pixel* dst, intptr_t srcStride, intptr_t dstStride, int width, int height, int w0, int round, int shift, int offset);
@@ -186,6 +189,13 @@ typedef void (*sign_t)(int8_t *dst, const pixel *src1, const pixel *src2, const
 typedef void (*planecopy_cp_t) (const uint8_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift);
 typedef void (*planecopy_sp_t) (const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask);
 typedef pixel (*planeClipAndMax_t)(pixel *src, intptr_t stride, int width, int height, uint64_t *outsum, const pixel minPix, const pixel maxPix);
+typedef void (*planecopy_cp_pad_t) (const uint8_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, int padx);
+typedef void (*planecopy_sp_pad_t) (const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask, int padx);
+typedef pixel (*planecopy_sp_clip_t)(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int padx, uint64_t *outsum, const pixel minPix, const pixel maxPix);
+typedef void (*resample_h_cs_t)(const uint8_t* src, int16_t* dst, int width, const int32_t* pos, const int16_t* coef, int taps, int shift);
+typedef void (*resample_h_ss_t)(const uint16_t* src, int16_t* dst, int width, const int32_t* pos, const int16_t* coef, int taps, int shift);
+typedef void (*resample_v_sc_t)(const int16_t* src, intptr_t srcStride, uint8_t* dst, int width, const int16_t* coef, int taps, int shift, int maxVal);
+typedef void (*resample_v_ss_t)(const int16_t* src, intptr_t srcStride, uint16_t* dst, int width, const int16_t* coef, int taps, int shift, int maxVal);
 
 typedef void (*cutree_propagate_cost) (int* dst, const uint16_t* propagateIn, const int32_t* intraCosts, const uint16_t* interCosts, const int32_t* invQscales, const double* fpsFactor, int len);
 
@@ -198,6 +208,7 @@ typedef uint32_t (*findPosFirstLast_t)(const int16_t *dstCoeff, const intptr_t t
 typedef uint32_t (*costCoeffNxN_t)(const uint16_t *scan, const coeff_t *coeff, intptr_t trSize, uint16_t *absCoeff, const uint8_t *tabSigCtx, uint32_t scanFlagMask, uint8_t *baseCtx, int offset, int scanPosSigOff, int subPosBase);
 typedef uint32_t (*costCoeffRemain_t)(uint16_t *absCoeff, int numNonZero, int idx);
 typedef uint32_t (*costC1C2Flag_t)(uint16_t *absCoeff, intptr_t numC1Flag, uint8_t *baseCtxMod, intptr_t ctxOffset);
+typedef int64_t (*rdoqCgCost_t)(const int16_t *resiCoeff, const int16_t *fencCoeff, int64_t *costUncoded, intptr_t trSize, int scaleBits, int64_t psyScale, int psyShift);
 
 typedef void (*pelFilterLumaStrong_t)(pixel* src, intptr_t srcStep, intptr_t offset, int32_t tcP, int32_t tcQ);
 typedef void (*pelFilterChroma_t)(pixel* src, intptr_t srcStep, intptr_t offset, int32_t tc, int32_t maskP, int32_t maskQ);
@@ -217,6 +228,7 @@ struct EncoderPrimitives
         pixelcmp_t     sad;         // Sum of Absolute Differences
         pixelcmp_x3_t  sad_x3;      // Sum of Absolute Differences, 3 mv offsets at once
         pixelcmp_x4_t  sad_x4;      // Sum of Absolute Differences, 4 mv offsets at once
+        pixelcmp_x8_t  sad_x8;      // Sum of Absolute Differences, 8 mv offsets at once
         pixelcmp_t     satd;        // Sum of Absolute Transformed Differences (4x4 Hadamard)
 
         filter_pp_t    luma_hpp;    // 8-tap luma motion compensation interpolation filters
@@ -245,6 +257,8 @@ struct EncoderPrimitives
     {
         dct_t           dct;
         idct_t          idct;
+        dct_quant_t     dct_quant;     // dct then quant in one pass
+        dequant_idct_t  dequant_idct;  // dequant_normal then idct
         calcresidual_t  calcresidual;
         pixel_sub_ps_t  sub_ps;
         pixel_add_ps_t  add_ps;
@@ -326,6 +340,22 @@ struct EncoderPrimitives
     planecopy_sp_t        planecopy_sp_shl;
     planeClipAndMax_t     planeClipAndMax;
 
+    /* input picture conversion in a single pass: convert each row as the
+     * planecopy primitives do, then replicate its last pixel padx times */
+    planecopy_cp_pad_t    planecopy_cp_pad;
+    planecopy_sp_pad_t    planecopy_sp_pad;
+    planecopy_sp_pad_t    planecopy_sp_shl_pad;
+    planecopy_sp_clip_t   planecopy_sp_clip;    // masked copy with planeClipAndMax, HIGH_BIT_DEPTH only
+
+    /* polyphase resampling of input pictures (see Scaler), independent of
+     * the pixel type: one row of the horizontal pass from 8bit or 16bit
+     * samples to int16 intermediates, or one row of the vertical pass from
+     * taps intermediate rows back to samples clipped to [0, maxVal] */
+    resample_h_cs_t       resample_h_cs;
+    resample_h_ss_t       resample_h_ss;
+    resample_v_sc_t       resample_v_sc;
+    resample_v_ss_t       resample_v_ss;
+
     weightp_sp_t          weight_sp;
     weightp_pp_t          weight_pp;
 
@@ -336,6 +366,7 @@ struct EncoderPrimitives
     costCoeffNxN_t        costCoeffNxN;
     costCoeffRemain_t     costCoeffRemain;
     costC1C2Flag_t        costC1C2Flag;
+    rdoqCgCost_t          rdoq_cg_cost;      // uncoded RDOQ cost of one 4x4 coeff group
 
     pelFilterLumaStrong_t pelFilterLumaStrong[2]; // EDGE_VER = 0, EDGE_HOR = 1
     pelFilterChroma_t     pelFilterChroma[2];     // EDGE_VER = 0, EDGE_HOR = 1
@@ -411,7 +442,13 @@ inline int partitionFromLog2Size(int log2Size)
 void setupCPrimitives(EncoderPrimitives &p);
 void setupInstrinsicPrimitives(EncoderPrimitives &p, int cpuMask);
 void setupAssemblyPrimitives(EncoderPrimitives &p, int cpuMask);
+void setupInstrinsicPrimitives_avx512(EncoderPrimitives &p, int cpuMask);
 void setupAliasPrimitives(EncoderPrimitives &p);
+void setupPrimitives(EncoderPrimitives &p, int cpuMask);
+
+/* Time the implementations of the hottest primitives at each cpu level enabled
+ * by param->cpuid and install the fastest in p (autotune.cpp) */
+void autotunePrimitives(EncoderPrimitives &p, const x265_param* param);
 }
 
 #if !EXPORT_C_API
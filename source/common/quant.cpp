@@ -406,9 +406,15 @@ uint32_t Quant::transformNxN(const CUData& cu, const pixel* fenc, uint32_t fencS
     }
 
     bool isLuma  = ttype == TEXT_LUMA;
+    bool isIntra = cu.isIntra(absPartIdx);
     bool usePsy  = m_psyRdoqScale && isLuma && !useTransformSkip;
     int transformShift = MAX_TR_DYNAMIC_RANGE - X265_DEPTH - log2TrSize; // Represents scaling through forward transform
 
+    /* without RDOQ or noise reduction the DCT and quant are performed in one
+     * pass by the dct_quant primitive */
+    bool useDST = !sizeIdx && isLuma && isIntra;
+    bool fuseQuant = !m_rdoqLevel && !useTransformSkip && !useDST && !(m_nr && m_nr->offset);
+
     X265_CHECK((cu.m_slice->m_sps->quadtreeTULog2MaxSize >= log2TrSize), "transform size too large\n");
     if (useTransformSkip)
     {
@@ -422,11 +428,9 @@ uint32_t Quant::transformNxN(const CUData& cu, const pixel* fenc, uint32_t fencS
             primitives.cu[sizeIdx].cpy2Dto1D_shr(m_resiDctCoeff, residual, resiStride, -transformShift);
 #endif
     }
-    else
+    else if (!fuseQuant)
     {
-        bool isIntra = cu.isIntra(absPartIdx);
-
-        if (!sizeIdx && isLuma && isIntra)
+        if (useDST)
             primitives.dst4x4(residual, m_resiDctCoeff, resiStride);
         else
             primitives.cu[sizeIdx].dct(residual, m_resiDctCoeff, resiStride);
@@ -457,7 +461,7 @@ uint32_t Quant::transformNxN(const CUData& cu, const pixel* fenc, uint32_t fencS
     {
         int deltaU[32 * 32];
 
-        int scalingListType = (cu.isIntra(absPartIdx) ? 0 : 3) + ttype;
+        int scalingListType = (isIntra ? 0 : 3) + ttype;
         int rem = m_qpParam[ttype].rem;
         int per = m_qpParam[ttype].per;
         const int32_t* quantCoeff = m_scalingList->m_quantCoef[log2TrSize - 2][scalingListType][rem];
@@ -466,7 +470,11 @@ uint32_t Quant::transformNxN(const CUData& cu, const pixel* fenc, uint32_t fencS
         int add = (cu.m_slice->m_sliceType == I_SLICE ? 171 : 85) << (qbits - 9);
         int numCoeff = 1 << (log2TrSize * 2);
 
-        uint32_t numSig = primitives.quant(m_resiDctCoeff, quantCoeff, deltaU, coeff, qbits, add, numCoeff);
+        uint32_t numSig;
+        if (fuseQuant)
+            numSig = primitives.cu[sizeIdx].dct_quant(residual, resiStride, m_resiDctCoeff, quantCoeff, deltaU, coeff, qbits, add);
+        else
+            numSig = primitives.quant(m_resiDctCoeff, quantCoeff, deltaU, coeff, qbits, add, numCoeff);
 
         if (numSig >= 2 && cu.m_slice->m_pps->bSignHideEnabled)
         {
@@ -496,6 +504,16 @@ void Quant::invtransformNxN(const CUData& cu, int16_t* residual, uint32_t resiSt
     int transformShift = MAX_TR_DYNAMIC_RANGE - X265_DEPTH - log2TrSize;
     int shift = QUANT_IQUANT_SHIFT - QUANT_SHIFT - transformShift;
     int numCoeff = 1 << (log2TrSize * 2);
+    int useDST = !sizeIdx && ttype == TEXT_LUMA && bIntra;
+
+    /* flat dequant followed by a full inverse DCT, performed in one pass */
+    if (!m_scalingList->m_bEnabled && !useTransformSkip && !useDST && !(numSig == 1 && coeff[0] != 0))
+    {
+        X265_CHECK((int)numSig == primitives.cu[log2TrSize - 2].count_nonzero(coeff), "numSig differ\n");
+        int scale = m_scalingList->s_invQuantScales[rem] << per;
+        primitives.cu[sizeIdx].dequant_idct(coeff, residual, resiStride, scale, shift);
+        return;
+    }
 
     if (m_scalingList->m_bEnabled)
     {
@@ -523,7 +541,6 @@ void Quant::invtransformNxN(const CUData& cu, int16_t* residual, uint32_t resiSt
     }
     else
     {
-        int useDST = !sizeIdx && ttype == TEXT_LUMA && bIntra;
         X265_CHECK((int)numSig == primitives.cu[log2TrSize - 2].count_nonzero(coeff), "numSig differ\n");
         // DC only
         if (numSig == 1 && coeff[0] != 0 && !useDST)
@@ -585,6 +602,10 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
 #define RDCOST(d, bits) ((((int64_t)d * d) << scaleBits) + SIGCOST(bits))
 #define PSYVALUE(rec)   ((psyScale * (rec)) >> X265_MAX(0, (2 * transformShift + 1)))
 
+    /* arguments of the uncoded coeff group cost primitive, psy is disabled by a zero scale */
+    const int64_t cgPsyScale = usePsyMask ? psyScale : 0;
+    const int psyShift = X265_MAX(0, (2 * transformShift + 1));
+
     int64_t costCoeff[trSize * trSize];   /* d*d + lambda * bits */
     int64_t costUncoded[trSize * trSize]; /* d*d + lambda * 0    */
     int64_t costSig[trSize * trSize];     /* lambda * bits       */
@@ -642,59 +663,16 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
 
     /* sum zero coeff (uncodec) cost */
 
-    // TODO: does we need these cost?
-    if (usePsyMask)
+    for (int cgScanPos = cgLastScanPos + 1; cgScanPos < (int)cgNum ; cgScanPos++)
     {
-        for (int cgScanPos = cgLastScanPos + 1; cgScanPos < (int)cgNum ; cgScanPos++)
-        {
-            X265_CHECK(coeffNum[cgScanPos] == 0, "count of coeff failure\n");
-
-            uint32_t scanPosBase = (cgScanPos << MLS_CG_SIZE);
-            uint32_t blkPos      = codeParams.scan[scanPosBase];
-
-            // TODO: we can't SIMD optimize because PSYVALUE need 64-bits multiplication, convert to Double can work faster by FMA
-            for (int y = 0; y < MLS_CG_SIZE; y++)
-            {
-                for (int x = 0; x < MLS_CG_SIZE; x++)
-                {
-                    int signCoef         = m_resiDctCoeff[blkPos + x];            /* pre-quantization DCT coeff */
-                    int predictedCoef    = m_fencDctCoeff[blkPos + x] - signCoef; /* predicted DCT = source DCT - residual DCT*/
-
-                    costUncoded[blkPos + x] = ((int64_t)signCoef * signCoef) << scaleBits;
+        X265_CHECK(coeffNum[cgScanPos] == 0, "count of coeff failure\n");
 
-                    /* when no residual coefficient is coded, predicted coef == recon coef */
-                    costUncoded[blkPos + x] -= PSYVALUE(predictedCoef);
+        uint32_t scanPosBase = (cgScanPos << MLS_CG_SIZE);
+        uint32_t blkPos      = codeParams.scan[scanPosBase];
 
-                    totalUncodedCost += costUncoded[blkPos + x];
-                    totalRdCost += costUncoded[blkPos + x];
-                }
-                blkPos += trSize;
-            }
-        }
-    }
-    else
-    {
-        // non-psy path
-        for (int cgScanPos = cgLastScanPos + 1; cgScanPos < (int)cgNum ; cgScanPos++)
-        {
-            X265_CHECK(coeffNum[cgScanPos] == 0, "count of coeff failure\n");
-
-            uint32_t scanPosBase = (cgScanPos << MLS_CG_SIZE);
-            uint32_t blkPos      = codeParams.scan[scanPosBase];
-
-            for (int y = 0; y < MLS_CG_SIZE; y++)
-            {
-                for (int x = 0; x < MLS_CG_SIZE; x++)
-                {
-                    int signCoef = m_resiDctCoeff[blkPos + x];            /* pre-quantization DCT coeff */
-                    costUncoded[blkPos + x] = ((int64_t)signCoef * signCoef) << scaleBits;
-
-                    totalUncodedCost += costUncoded[blkPos + x];
-                    totalRdCost += costUncoded[blkPos + x];
-                }
-                blkPos += trSize;
-            }
-        }
+        int64_t cgCost = primitives.rdoq_cg_cost(m_resiDctCoeff + blkPos, m_fencDctCoeff + blkPos, costUncoded + blkPos, trSize, scaleBits, cgPsyScale, psyShift);
+        totalUncodedCost += cgCost;
+        totalRdCost += cgCost;
     }
 
     static const uint8_t table_cnt[5][SCAN_SET_SIZE] =
@@ -757,60 +735,24 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
             const uint32_t scanPosBase = (cgScanPos << MLS_CG_SIZE);
             uint32_t blkPos = codeParams.scan[scanPosBase];
 
-            if (usePsyMask)
-            {
-                // TODO: we can't SIMD optimize because PSYVALUE need 64-bits multiplication, convert to Double can work faster by FMA
-                for (int y = 0; y < MLS_CG_SIZE; y++)
-                {
-                    for (int x = 0; x < MLS_CG_SIZE; x++)
-                    {
-                        int signCoef         = m_resiDctCoeff[blkPos + x];            /* pre-quantization DCT coeff */
-                        int predictedCoef    = m_fencDctCoeff[blkPos + x] - signCoef; /* predicted DCT = source DCT - residual DCT*/
-
-                        costUncoded[blkPos + x] = ((int64_t)signCoef * signCoef) << scaleBits;
+            int64_t cgCost = primitives.rdoq_cg_cost(m_resiDctCoeff + blkPos, m_fencDctCoeff + blkPos, costUncoded + blkPos, trSize, scaleBits, cgPsyScale, psyShift);
+            totalUncodedCost += cgCost;
+            totalRdCost += cgCost;
 
-                        /* when no residual coefficient is coded, predicted coef == recon coef */
-                        costUncoded[blkPos + x] -= PSYVALUE(predictedCoef);
-
-                        totalUncodedCost += costUncoded[blkPos + x];
-                        totalRdCost += costUncoded[blkPos + x];
-
-                        const uint32_t scanPosOffset =  y * MLS_CG_SIZE + x;
-                        const uint32_t ctxSig = table_cnt[patternSigCtx][g_scan4x4[codeParams.scanType][scanPosOffset]] + ctxSigOffset;
-                        X265_CHECK(trSize > 4, "trSize check failure\n");
-                        X265_CHECK(ctxSig == getSigCtxInc(patternSigCtx, log2TrSize, trSize, codeParams.scan[scanPosBase + scanPosOffset], bIsLuma, codeParams.firstSignificanceMapContext), "sigCtx check failure\n");
-
-                        costSig[scanPosBase + scanPosOffset] = SIGCOST(estBitsSbac.significantBits[0][ctxSig]);
-                        costCoeff[scanPosBase + scanPosOffset] = costUncoded[blkPos + x];
-                        sigRateDelta[blkPos + x] = estBitsSbac.significantBits[1][ctxSig] - estBitsSbac.significantBits[0][ctxSig];
-                    }
-                    blkPos += trSize;
-                }
-            }
-            else
+            for (int y = 0; y < MLS_CG_SIZE; y++)
             {
-                // non-psy path
-                for (int y = 0; y < MLS_CG_SIZE; y++)
+                for (int x = 0; x < MLS_CG_SIZE; x++)
                 {
-                    for (int x = 0; x < MLS_CG_SIZE; x++)
-                    {
-                        int signCoef = m_resiDctCoeff[blkPos + x];            /* pre-quantization DCT coeff */
-                        costUncoded[blkPos + x] = ((int64_t)signCoef * signCoef) << scaleBits;
-
-                        totalUncodedCost += costUncoded[blkPos + x];
-                        totalRdCost += costUncoded[blkPos + x];
-
-                        const uint32_t scanPosOffset =  y * MLS_CG_SIZE + x;
-                        const uint32_t ctxSig = table_cnt[patternSigCtx][g_scan4x4[codeParams.scanType][scanPosOffset]] + ctxSigOffset;
-                        X265_CHECK(trSize > 4, "trSize check failure\n");
-                        X265_CHECK(ctxSig == getSigCtxInc(patternSigCtx, log2TrSize, trSize, codeParams.scan[scanPosBase + scanPosOffset], bIsLuma, codeParams.firstSignificanceMapContext), "sigCtx check failure\n");
-
-                        costSig[scanPosBase + scanPosOffset] = SIGCOST(estBitsSbac.significantBits[0][ctxSig]);
-                        costCoeff[scanPosBase + scanPosOffset] = costUncoded[blkPos + x];
-                        sigRateDelta[blkPos + x] = estBitsSbac.significantBits[1][ctxSig] - estBitsSbac.significantBits[0][ctxSig];
-                    }
-                    blkPos += trSize;
+                    const uint32_t scanPosOffset =  y * MLS_CG_SIZE + x;
+                    const uint32_t ctxSig = table_cnt[patternSigCtx][g_scan4x4[codeParams.scanType][scanPosOffset]] + ctxSigOffset;
+                    X265_CHECK(trSize > 4, "trSize check failure\n");
+                    X265_CHECK(ctxSig == getSigCtxInc(patternSigCtx, log2TrSize, trSize, codeParams.scan[scanPosBase + scanPosOffset], bIsLuma, codeParams.firstSignificanceMapContext), "sigCtx check failure\n");
+
+                    costSig[scanPosBase + scanPosOffset] = SIGCOST(estBitsSbac.significantBits[0][ctxSig]);
+                    costCoeff[scanPosBase + scanPosOffset] = costUncoded[blkPos + x];
+                    sigRateDelta[blkPos + x] = estBitsSbac.significantBits[1][ctxSig] - estBitsSbac.significantBits[0][ctxSig];
                 }
+                blkPos += trSize;
             }
 
             /* there were no coded coefficients in this coefficient group */
@@ -831,6 +773,21 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
         uint32_t levelThreshold = 3;
         uint32_t c1Idx       = 0;
         uint32_t c2Idx       = 0;
+
+        /* cost of not coding each coefficient (all distortion, no signal bits) */
+        {
+            const uint32_t blkPos = codeParams.scan[cgScanPos << MLS_CG_SIZE];
+            totalUncodedCost += primitives.rdoq_cg_cost(m_resiDctCoeff + blkPos, m_fencDctCoeff + blkPos, costUncoded + blkPos, trSize, scaleBits, cgPsyScale, psyShift);
+
+            /* psy-rdoq is not applied to the DC coefficient */
+            if (usePsyMask && !cgScanPos)
+            {
+                int64_t costDC = ((int64_t)m_resiDctCoeff[0] * m_resiDctCoeff[0]) << scaleBits;
+                totalUncodedCost += costDC - costUncoded[0];
+                costUncoded[0] = costDC;
+            }
+        }
+
         /* iterate over coefficients in each group in reverse scan order */
         for (int scanPosinCG = cgSize - 1; scanPosinCG >= 0; scanPosinCG--)
         {
@@ -843,15 +800,7 @@ uint32_t Quant::rdoQuant(const CUData& cu, int16_t* dstCoeff, TextType ttype, ui
             /* RDOQ measures distortion as the squared difference between the unquantized coded level
              * and the original DCT coefficient. The result is shifted scaleBits to account for the
              * FIX15 nature of the CABAC cost tables minus the forward transform scale */
-
-            /* cost of not coding this coefficient (all distortion, no signal bits) */
-            costUncoded[blkPos] = ((int64_t)signCoef * signCoef) << scaleBits;
             X265_CHECK((!!scanPos ^ !!blkPos) == 0, "failed on (blkPos=0 && scanPos!=0)\n");
-            if (usePsyMask & scanPos)
-                /* when no residual coefficient is coded, predicted coef == recon coef */
-                costUncoded[blkPos] -= PSYVALUE(predictedCoef);
-
-            totalUncodedCost += costUncoded[blkPos];
 
             // coefficient level estimation
             const int* greaterOneBits = estBitsSbac.greaterOneBits[4 * ctxSet + c1];
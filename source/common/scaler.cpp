@@ -0,0 +1,338 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include "scaler.h"
+
+#include <math.h>
+
+using namespace X265_NS;
+
+namespace {
+// Keys bicubic kernel, a = -0.5
+double cubic(double x)
+{
+    x = fabs(x);
+    if (x < 1)
+        return (1.5 * x - 2.5) * x * x + 1;
+    if (x < 2)
+        return ((-0.5 * x + 2.5) * x - 4) * x + 2;
+    return 0;
+}
+}
+
+bool ScaleFilter::init(int srcSize, int dstSize)
+{
+    double ratio = (double)srcSize / dstSize;
+    double stretch = X265_MAX(ratio, 1.0);   /* widen the kernel to low-pass when downscaling */
+    double support = 2 * stretch;
+
+    taps = ((int)ceil(2 * support) + 7) & ~7;
+    if (taps > srcSize)
+        return false;
+
+    pos = X265_MALLOC(int32_t, dstSize);
+    coef = X265_MALLOC(int16_t, dstSize * taps);
+    double* weight = X265_MALLOC(double, taps);
+    if (!pos || !coef || !weight)
+    {
+        X265_FREE(weight);
+        return false;
+    }
+
+    for (int i = 0; i < dstSize; i++)
+    {
+        /* sample centers are aligned, as for the lowres and chroma planes */
+        double center = (i + 0.5) * ratio - 0.5;
+        int left = (int)floor(center - support) + 1;
+        int start = x265_clip3(0, srcSize - taps, left);
+
+        double sum = 0;
+        for (int k = 0; k < taps; k++)
+            weight[k] = 0;
+        for (int k = 0; k < taps; k++)
+        {
+            double w = cubic((left + k - center) / stretch);
+            weight[x265_clip3(0, srcSize - 1, left + k) - start] += w;
+            sum += w;
+        }
+
+        /* quantize the running total so the weights sum to exactly 1.0 in Q14 */
+        double acc = 0;
+        int prev = 0;
+        pos[i] = start;
+        for (int k = 0; k < taps; k++)
+        {
+            acc += weight[k];
+            int q = (int)floor(acc * (1 << 14) / sum + 0.5);
+            coef[i * taps + k] = (int16_t)(q - prev);
+            prev = q;
+        }
+    }
+
+    X265_FREE(weight);
+    return true;
+}
+
+Scaler::Scaler()
+{
+    m_outputs = NULL;
+    m_tasks = NULL;
+    m_tmp = NULL;
+    m_pool = NULL;
+    m_src = NULL;
+    m_numOutputs = m_numTasks = m_numTmp = 0;
+    m_srcWidth = m_srcHeight = 0;
+    m_csp = X265_CSP_I420;
+    m_bitDepth = 8;
+}
+
+Scaler::~Scaler()
+{
+    for (int i = 0; i < m_numOutputs; i++)
+        X265_FREE(m_outputs[i].buf);
+    delete [] m_outputs;
+    X265_FREE(m_tasks);
+    if (m_tmp)
+    {
+        for (int i = 0; i < m_numTmp; i++)
+            X265_FREE(m_tmp[i]);
+        X265_FREE(m_tmp);
+    }
+}
+
+bool Scaler::create(x265_param* param, x265_pool* pool, int srcWidth, int srcHeight, int csp, int bitDepth,
+                    int numOutputs, const int* widths, const int* heights)
+{
+    if (csp < X265_CSP_I400 || csp >= X265_CSP_COUNT || bitDepth < 8 || bitDepth > 14 ||
+        srcWidth <= 0 || srcHeight <= 0 || numOutputs < 1)
+    {
+        x265_log(param, X265_LOG_ERROR, "scaler: unsupported source format\n");
+        return false;
+    }
+
+    /* the encoders normally do this when they are opened */
+    if (!primitives.pu[0].sad)
+        x265_setup_primitives(param);
+
+    const x265_cli_csp& c = x265_cli_csps[csp];
+    m_srcWidth = srcWidth;
+    m_srcHeight = srcHeight;
+    m_csp = csp;
+    m_bitDepth = bitDepth;
+    m_outputs = new Output[numOutputs];
+    m_numOutputs = numOutputs;
+
+    int bytes = bitDepth > 8 ? 2 : 1;
+    int hMask = (1 << c.width[1]) - 1;
+    int vMask = (1 << c.height[1]) - 1;
+    size_t tmpSize = 0;
+
+    for (int o = 0; o < numOutputs; o++)
+    {
+        Output& out = m_outputs[o];
+        out.width = widths[o];
+        out.height = heights[o];
+        out.buf = NULL;
+
+        if (out.width <= 0 || out.height <= 0 || (out.width & hMask) || (out.height & vMask))
+        {
+            x265_log(param, X265_LOG_ERROR, "scaler: invalid output size %dx%d\n", out.width, out.height);
+            return false;
+        }
+
+        size_t size = 0;
+        for (int i = 0; i < c.planes; i++)
+        {
+            int w = out.width >> c.width[i];
+            int h = out.height >> c.height[i];
+            out.stride[i] = w * bytes;
+            out.offset[i] = size;
+            size += (size_t)out.stride[i] * h;
+        }
+        for (int i = 0; i < (c.planes > 1 ? 2 : 1); i++)
+        {
+            if (!out.hfilter[i].init(srcWidth >> c.width[i], out.width >> c.width[i]) ||
+                !out.vfilter[i].init(srcHeight >> c.height[i], out.height >> c.height[i]))
+            {
+                x265_log(param, X265_LOG_ERROR, "scaler: source %dx%d too small to resample to %dx%d\n",
+                         srcWidth, srcHeight, out.width, out.height);
+                return false;
+            }
+        }
+        out.buf = X265_MALLOC(uint8_t, size);
+        if (!out.buf)
+            return false;
+
+        /* the largest intermediate buffer any band of this output needs */
+        for (int row = 0; row < out.height; row += BAND_ROWS)
+        {
+            for (int i = 0; i < c.planes; i++)
+            {
+                const ScaleFilter& vf = out.vfilter[!!i];
+                int first = row >> c.height[i];
+                int last = X265_MIN(row + BAND_ROWS, out.height) - 1;
+                last >>= c.height[i];
+                size_t rows = vf.pos[last] + vf.taps - vf.pos[first];
+                tmpSize = X265_MAX(tmpSize, rows * (((out.width >> c.width[i]) + 7) & ~7));
+            }
+            m_numTasks++;
+        }
+    }
+
+    m_tasks = X265_MALLOC(Task, m_numTasks);
+    if (!m_tasks)
+        return false;
+    for (int o = 0, t = 0; o < numOutputs; o++)
+    {
+        for (int row = 0; row < m_outputs[o].height; row += BAND_ROWS, t++)
+        {
+            m_tasks[t].output = o;
+            m_tasks[t].row = row;
+        }
+    }
+
+    /* bands are spread over the workers of the first pool, so its worker IDs
+     * index the intermediate buffers */
+    if (pool)
+        m_pool = static_cast<SharedThreadPool*>(pool)->m_pools;
+    m_numTmp = m_pool ? m_pool->m_numWorkers + 1 : 1;
+    m_tmp = X265_MALLOC(int16_t*, m_numTmp);
+    if (!m_tmp)
+        return false;
+    for (int i = 0; i < m_numTmp; i++)
+        m_tmp[i] = NULL;
+    for (int i = 0; i < m_numTmp; i++)
+    {
+        m_tmp[i] = X265_MALLOC(int16_t, tmpSize);
+        if (!m_tmp[i])
+            return false;
+    }
+
+    return true;
+}
+
+int Scaler::scale(const x265_picture& in, x265_picture* out)
+{
+    if (in.colorSpace != m_csp || in.bitDepth != m_bitDepth)
+    {
+        x265_log(NULL, X265_LOG_ERROR, "scaler: picture format does not match the scaler\n");
+        return -1;
+    }
+
+    m_src = &in;
+    m_jobTotal = m_numTasks;
+    m_jobAcquired = 0;
+    if (m_pool && m_numTasks > 1)
+        tryBondPeers(*m_pool, m_numTasks - 1);
+    processTasks(-1);
+    waitForExit();
+    m_src = NULL;
+
+    const x265_cli_csp& c = x265_cli_csps[m_csp];
+    for (int o = 0; o < m_numOutputs; o++)
+    {
+        Output& op = m_outputs[o];
+        x265_picture& pic = out[o];
+
+        pic.pts = in.pts;
+        pic.poc = in.poc;
+        pic.sliceType = in.sliceType;
+        pic.forceqp = in.forceqp;
+        pic.userData = in.userData;
+        pic.bitDepth = m_bitDepth;
+        pic.colorSpace = m_csp;
+        pic.height = op.height;
+        pic.framesize = 0;
+        for (int i = 0; i < c.planes; i++)
+        {
+            pic.planes[i] = op.buf + op.offset[i];
+            pic.stride[i] = op.stride[i];
+            pic.framesize += (uint64_t)op.stride[i] * (op.height >> c.height[i]);
+        }
+    }
+
+    return 0;
+}
+
+void Scaler::processTasks(int workerThreadId)
+{
+    int16_t* tmp = m_tmp[workerThreadId + 1];
+
+    m_lock.acquire();
+    while (m_jobAcquired < m_jobTotal)
+    {
+        int i = m_jobAcquired++;
+        m_lock.release();
+
+        ProfileScopeEvent(scaleBand);
+        scaleBand(m_tasks[i], tmp);
+
+        m_lock.acquire();
+    }
+    m_lock.release();
+}
+
+void Scaler::scaleBand(const Task& task, int16_t* tmp)
+{
+    const Output& out = m_outputs[task.output];
+    const x265_cli_csp& c = x265_cli_csps[m_csp];
+
+    /* intermediates are samples scaled to 14 bits, with headroom for the
+     * overshoot of the negative kernel lobes */
+    int hshift = m_bitDepth;
+    int vshift = 28 - m_bitDepth;
+    int maxVal = (1 << m_bitDepth) - 1;
+
+    for (int i = 0; i < c.planes; i++)
+    {
+        const ScaleFilter& hf = out.hfilter[!!i];
+        const ScaleFilter& vf = out.vfilter[!!i];
+        int width = out.width >> c.width[i];
+        int height = out.height >> c.height[i];
+        int row = task.row >> c.height[i];
+        int rows = X265_MIN(BAND_ROWS >> c.height[i], height - row);
+        int first = vf.pos[row];
+        int count = vf.pos[row + rows - 1] + vf.taps - first;
+        intptr_t tmpStride = (width + 7) & ~7;
+
+        const uint8_t* src = (const uint8_t*)m_src->planes[i] + (intptr_t)first * m_src->stride[i];
+        for (int y = 0; y < count; y++, src += m_src->stride[i])
+        {
+            if (m_bitDepth > 8)
+                primitives.resample_h_ss((const uint16_t*)src, tmp + y * tmpStride, width, hf.pos, hf.coef, hf.taps, hshift);
+            else
+                primitives.resample_h_cs(src, tmp + y * tmpStride, width, hf.pos, hf.coef, hf.taps, hshift);
+        }
+
+        uint8_t* dst = out.buf + out.offset[i] + (intptr_t)row * out.stride[i];
+        for (int y = row; y < row + rows; y++, dst += out.stride[i])
+        {
+            const int16_t* t = tmp + (vf.pos[y] - first) * tmpStride;
+            const int16_t* coef = vf.coef + y * vf.taps;
+            if (m_bitDepth > 8)
+                primitives.resample_v_ss(t, tmpStride, (uint16_t*)dst, width, coef, vf.taps, vshift, maxVal);
+            else
+                primitives.resample_v_sc(t, tmpStride, dst, width, coef, vf.taps, vshift, maxVal);
+        }
+    }
+}
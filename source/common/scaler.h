@@ -0,0 +1,108 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com
+ *****************************************************************************/
+
+#ifndef X265_SCALER_H
+#define X265_SCALER_H
+
+#include "common.h"
+#include "threadpool.h"
+
+struct x265_scaler {};
+
+namespace X265_NS {
+// private namespace
+
+/* Polyphase filter of one dimension of one plane. Output sample i is the Q14
+ * weighted sum of the taps input samples starting at pos[i], with weights
+ * coef[i * taps] onwards. Windows are shifted inside the input and the
+ * weights of samples beyond its edges folded onto the edge samples, so no
+ * input padding is needed; taps is a multiple of 8 for the SIMD kernels */
+struct ScaleFilter
+{
+    int32_t*  pos;
+    int16_t*  coef;
+    int       taps;
+
+    ScaleFilter() : pos(NULL), coef(NULL), taps(0) {}
+    ~ScaleFilter() { X265_FREE(pos); X265_FREE(coef); }
+
+    bool init(int srcSize, int dstSize);
+};
+
+/* The multi-resolution input stage behind an x265_scaler handle. Each source
+ * picture is resampled to every output size in bands of output rows, which
+ * idle worker threads of the first pool of a shared thread pool help with.
+ * A band runs the horizontal pass over the source rows it needs into a per
+ * thread intermediate buffer of int16 samples scaled to 14 bits, then the
+ * vertical pass from there into the output planes */
+class Scaler : public x265_scaler, public BondedTaskGroup
+{
+public:
+
+    enum { BAND_ROWS = 32 };   // luma output rows per task
+
+    struct Output
+    {
+        int         width;
+        int         height;
+        uint8_t*    buf;                // planes one after another, as in a raw file
+        int         stride[3];          // in bytes
+        size_t      offset[3];          // in bytes
+        ScaleFilter hfilter[2];         // luma and chroma
+        ScaleFilter vfilter[2];
+    };
+
+    struct Task
+    {
+        int         output;
+        int         row;                // first luma output row of the band
+    };
+
+    Output*         m_outputs;
+    Task*           m_tasks;
+    int16_t**       m_tmp;              // intermediate buffer of each thread, worker ID + 1
+    ThreadPool*     m_pool;
+    const x265_picture* m_src;
+    int             m_numOutputs;
+    int             m_numTasks;
+    int             m_numTmp;
+    int             m_srcWidth;
+    int             m_srcHeight;
+    int             m_csp;
+    int             m_bitDepth;
+
+    Scaler();
+    virtual ~Scaler();
+
+    bool create(x265_param* param, x265_pool* pool, int srcWidth, int srcHeight, int csp, int bitDepth,
+                int numOutputs, const int* widths, const int* heights);
+
+    int  scale(const x265_picture& in, x265_picture* out);
+
+    void processTasks(int workerThreadId);
+
+protected:
+
+    void scaleBand(const Task& task, int16_t* tmp);
+};
+}
+
+#endif // ifndef X265_SCALER_H
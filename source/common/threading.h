@@ -121,6 +121,12 @@ public:
         EnterCriticalSection(&this->handle);
     }
 
+    /* returns true if the lock was acquired, never blocks */
+    bool tryAcquire()
+    {
+        return !!TryEnterCriticalSection(&this->handle);
+    }
+
     void release()
     {
         LeaveCriticalSection(&this->handle);
@@ -268,6 +274,12 @@ public:
         pthread_mutex_lock(&this->handle);
     }
 
+    /* returns true if the lock was acquired, never blocks */
+    bool tryAcquire()
+    {
+        return !pthread_mutex_trylock(&this->handle);
+    }
+
     void release()
     {
         pthread_mutex_unlock(&this->handle);
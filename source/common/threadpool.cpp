@@ -63,6 +63,10 @@
 #endif
 #if HAVE_LIBNUMA
 #include <numa.h>
+#include <numaif.h>
+#endif
+#if __linux__
+#include <sched.h>
 #endif
 #if defined(_MSC_VER)
 # define strcasecmp _stricmp
@@ -100,8 +104,9 @@ public:
 
     JobProvider*     m_curJobProvider;
     BondedTaskGroup* m_bondMaster;
+    volatile uint32_t m_passCount; // incremented after each scan of the job provider table
 
-    WorkerThread(ThreadPool& pool, int id) : m_pool(pool), m_id(id) {}
+    WorkerThread(ThreadPool& pool, int id) : m_pool(pool), m_id(id), m_passCount(0) {}
     virtual ~WorkerThread() {}
 
     void threadMain();
@@ -119,6 +124,7 @@ void WorkerThread::threadMain()
 #endif
 
     m_pool.setCurrentThreadAffinity();
+    m_pool.setWorkerCacheAffinity(m_id);
 
     sleepbitmap_t idBit = (sleepbitmap_t)1 << m_id;
     m_curJobProvider = m_pool.m_jpTable[0];
@@ -145,16 +151,15 @@ void WorkerThread::threadMain()
             /* if the current job provider still wants help, only switch to a
              * higher priority provider (lower slice type). Else take the first
              * available job provider with the highest priority */
-            int curPriority = (m_curJobProvider->m_helpWanted) ? m_curJobProvider->m_sliceType :
-                                                                 INVALID_SLICE_PRIORITY + 1;
+            int curPriority = (m_curJobProvider->m_helpWanted) ? m_curJobProvider->schedulingRank() : INT_MAX;
             int nextProvider = -1;
             for (int i = 0; i < m_pool.m_numProviders; i++)
             {
                 if (m_pool.m_jpTable[i]->m_helpWanted &&
-                    m_pool.m_jpTable[i]->m_sliceType < curPriority)
+                    m_pool.m_jpTable[i]->schedulingRank() < curPriority)
                 {
                     nextProvider = i;
-                    curPriority = m_pool.m_jpTable[i]->m_sliceType;
+                    curPriority = m_pool.m_jpTable[i]->schedulingRank();
                 }
             }
             if (nextProvider != -1 && m_curJobProvider != m_pool.m_jpTable[nextProvider])
@@ -163,6 +168,7 @@ void WorkerThread::threadMain()
                 m_curJobProvider = m_pool.m_jpTable[nextProvider];
                 SLEEPBITMAP_OR(&m_curJobProvider->m_ownerBitmap, idBit);
             }
+            m_passCount++;
         }
         while (m_curJobProvider->m_helpWanted);
 
@@ -176,9 +182,21 @@ void WorkerThread::threadMain()
     SLEEPBITMAP_OR(&m_pool.m_sleepBitmap, idBit);
 }
 
+/* Occupies the job provider table slots of a shared pool which are not in use
+ * by any encoder. It never has work */
+class IdleJobProvider : public JobProvider
+{
+public:
+
+    void findJob(int) {}
+};
+
 void JobProvider::tryWakeOne()
 {
-    int id = m_pool->tryAcquireSleepingThread(m_ownerBitmap, ALL_POOL_THREADS);
+    /* prefer threads which share this provider's last level cache */
+    int id = m_pool->tryAcquireSleepingThread(m_ownerBitmap & m_cacheDomainBitmap, m_cacheDomainBitmap);
+    if (id < 0 && m_cacheDomainBitmap != ALL_POOL_THREADS)
+        id = m_pool->tryAcquireSleepingThread(m_ownerBitmap, ALL_POOL_THREADS);
     if (id < 0)
     {
         m_helpWanted = true;
@@ -227,12 +245,12 @@ int ThreadPool::tryAcquireSleepingThread(sleepbitmap_t firstTryBitmap, sleepbitm
     return -1;
 }
 
-int ThreadPool::tryBondPeers(int maxPeers, sleepbitmap_t peerBitmap, BondedTaskGroup& master)
+int ThreadPool::tryBondPeers(int maxPeers, sleepbitmap_t peerBitmap, sleepbitmap_t preferBitmap, BondedTaskGroup& master)
 {
     int bondCount = 0;
     do
     {
-        int id = tryAcquireSleepingThread(peerBitmap, 0);
+        int id = tryAcquireSleepingThread(peerBitmap & preferBitmap, peerBitmap);
         if (id < 0)
             return bondCount;
 
@@ -245,7 +263,9 @@ int ThreadPool::tryBondPeers(int maxPeers, sleepbitmap_t peerBitmap, BondedTaskG
     return bondCount;
 }
 
-ThreadPool* ThreadPool::allocThreadPools(x265_param* p, int& numPools)
+/* If sharedEncoders is non-zero the pools are created for x265_pool_create()
+ * and are sized to hold the job providers of that many encoders */
+ThreadPool* ThreadPool::allocThreadPools(x265_param* p, int& numPools, int sharedEncoders)
 {
     enum { MAX_NODE_NUM = 127 };
     int cpusPerNode[MAX_NODE_NUM + 1];
@@ -392,7 +412,7 @@ ThreadPool* ThreadPool::allocThreadPools(x265_param* p, int& numPools)
     if (!numPools)
         return NULL;
 
-    if (numPools > p->frameNumThreads)
+    if (!sharedEncoders && numPools > p->frameNumThreads)
     {
         x265_log(p, X265_LOG_DEBUG, "Reducing number of thread pools for frame thread count\n");
         numPools = X265_MAX(p->frameNumThreads / 2, 1);
@@ -402,29 +422,26 @@ ThreadPool* ThreadPool::allocThreadPools(x265_param* p, int& numPools)
     if (pools)
     {
         int maxProviders = (p->frameNumThreads + numPools - 1) / numPools + 1; /* +1 is Lookahead, always assigned to threadpool 0 */
+        if (sharedEncoders)
+            maxProviders = sharedEncoders * (X265_MAX_FRAME_THREADS + 1) + 1; /* +1 is the idle provider */
         int node = 0;
         for (int i = 0; i < numPools; i++)
         {
             while (!threadsPerPool[node])
                 node++;
             int numThreads = X265_MIN(MAX_POOL_THREADS, threadsPerPool[node]);
-            if (!pools[i].create(numThreads, maxProviders, nodeMaskPerPool[node]))
+            if (!pools[i].create(numThreads, maxProviders, nodeMaskPerPool[node], !!p->bCacheAffinity))
             {
                 X265_FREE(pools);
                 numPools = 0;
                 return NULL;
             }
-            if (numNumaNodes > 1)
+            if (sharedEncoders)
             {
-                char *nodesstr = new char[64 * strlen(",63") + 1];
-                int len = 0;
-                for (int j = 0; j < 64; j++)
-                    if ((nodeMaskPerPool[node] >> j) & 1)
-                        len += sprintf(nodesstr + len, ",%d", j);
-                x265_log(p, X265_LOG_INFO, "Thread pool %d using %d threads on numa nodes %s\n", i, numThreads, nodesstr + 1);
+                /* worker threads start out attached to m_jpTable[0] */
+                pools[i].m_idleProvider = new IdleJobProvider;
+                pools[i].addProvider(*pools[i].m_idleProvider);
             }
-            else
-                x265_log(p, X265_LOG_INFO, "Thread pool created using %d threads\n", numThreads);
             threadsPerPool[node] -= numThreads;
         }
     }
@@ -433,12 +450,65 @@ ThreadPool* ThreadPool::allocThreadPools(x265_param* p, int& numPools)
     return pools;
 }
 
+/* Log the layout of allocated pools; separate from allocThreadPools() so an
+ * encoder which resizes its pools while planning memory logs them only once */
+void ThreadPool::logThreadPools(x265_param* p, ThreadPool* pools, int numPools)
+{
+    bool bMultiNode = getNumaNodeCount() > 1;
+    for (int i = 0; i < numPools; i++)
+    {
+        int numThreads = pools[i].m_numWorkers;
+        if (bMultiNode)
+        {
+            char *nodesstr = new char[64 * strlen(",63") + 1];
+            int len = 0;
+            for (int j = 0; j < 64; j++)
+                if ((pools[i].m_nodeMask >> j) & 1)
+                    len += sprintf(nodesstr + len, ",%d", j);
+            x265_log(p, X265_LOG_INFO, "Thread pool %d using %d threads on numa nodes %s\n", i, numThreads, nodesstr + 1);
+            delete [] nodesstr;
+        }
+        else
+            x265_log(p, X265_LOG_INFO, "Thread pool created using %d threads\n", numThreads);
+        if (pools[i].m_numCacheDomains > 1)
+        {
+            char domainstr[MAX_POOL_THREADS * 4 + 1];
+            int len = 0;
+            for (int d = 0; d < pools[i].m_numCacheDomains; d++)
+            {
+                int workers = 0;
+                for (int w = 0; w < numThreads; w++)
+                    workers += (pools[i].m_cacheDomainBitmap[d] >> w) & 1;
+                len += sprintf(domainstr + len, ",%d", workers);
+            }
+            x265_log(p, X265_LOG_INFO, "Thread pool %d workers grouped by last level cache: %s\n", i, domainstr + 1);
+        }
+    }
+}
+
 ThreadPool::ThreadPool()
+    : m_sleepBitmap(0)
+    , m_numCacheDomains(1)
+    , m_nextCacheDomain(0)
+    , m_cacheDomainCpus(NULL)
+    , m_numProviders(0)
+    , m_maxProviders(0)
+    , m_numWorkers(0)
+    , m_numaMask(NULL)
+    , m_nodeMask(0)
+    , m_isActive(false)
+    , m_jpTable(NULL)
+    , m_idleProvider(NULL)
+    , m_workers(NULL)
 {
-    memset(this, 0, sizeof(*this));
+    for (int i = 0; i < MAX_POOL_THREADS; i++)
+        m_cacheDomainBitmap[i] = ALL_POOL_THREADS;
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= _WIN32_WINNT_WIN7 
+    memset(&m_groupAffinity, 0, sizeof(GROUP_AFFINITY));
+#endif
 }
 
-bool ThreadPool::create(int numThreads, int maxProviders, uint64_t nodeMask)
+bool ThreadPool::create(int numThreads, int maxProviders, uint64_t nodeMask, bool bCacheAffinity)
 {
     X265_CHECK(numThreads <= MAX_POOL_THREADS, "a single thread pool cannot have more than MAX_POOL_THREADS threads\n");
 
@@ -468,6 +538,7 @@ bool ThreadPool::create(int numThreads, int maxProviders, uint64_t nodeMask)
     (void)nodeMask;
 #endif
 
+    m_nodeMask = nodeMask;
     m_numWorkers = numThreads;
 
     m_workers = X265_MALLOC(WorkerThread, numThreads);
@@ -478,6 +549,10 @@ bool ThreadPool::create(int numThreads, int maxProviders, uint64_t nodeMask)
 
     m_jpTable = X265_MALLOC(JobProvider*, maxProviders);
     m_numProviders = 0;
+    m_maxProviders = maxProviders;
+
+    if (bCacheAffinity)
+        initCacheDomains(nodeMask);
 
     return m_workers && m_jpTable;
 }
@@ -496,6 +571,27 @@ bool ThreadPool::start()
     return true;
 }
 
+/* Keep only the first numThreads workers of a pool which has not been started.
+ * The pool keeps its NUMA nodes, and its workers are grouped by last level
+ * cache again */
+void ThreadPool::removeWorkers(int numThreads)
+{
+    X265_CHECK(!m_isActive && numThreads > 0 && numThreads <= m_numWorkers, "cannot remove workers of a started pool\n");
+
+    for (int i = numThreads; i < m_numWorkers; i++)
+        m_workers[i].~WorkerThread();
+    m_numWorkers = numThreads;
+
+    if (m_numCacheDomains > 1)
+    {
+        X265_FREE(m_cacheDomainCpus);
+        m_cacheDomainCpus = NULL;
+        for (int i = 0; i < MAX_POOL_THREADS; i++)
+            m_cacheDomainBitmap[i] = ALL_POOL_THREADS;
+        initCacheDomains(m_nodeMask);
+    }
+}
+
 void ThreadPool::stopWorkers()
 {
     if (m_workers)
@@ -511,6 +607,84 @@ void ThreadPool::stopWorkers()
     }
 }
 
+/* Add a job provider to the table scanned by idle worker threads. In a shared
+ * pool, slots vacated by removeProviders() are reused */
+void ThreadPool::addProvider(JobProvider& jp)
+{
+    ScopedLock lock(m_providerLock);
+
+    jp.m_pool = this;
+    if (m_numCacheDomains > 1)
+        jp.m_cacheDomainBitmap = m_cacheDomainBitmap[m_nextCacheDomain++ % m_numCacheDomains];
+    for (int i = 0; i < m_numProviders; i++)
+    {
+        if (m_idleProvider && m_jpTable[i] == m_idleProvider)
+        {
+            m_jpTable[i] = &jp;
+            return;
+        }
+    }
+
+    X265_CHECK(m_numProviders < m_maxProviders, "thread pool job provider table overflow\n");
+    m_jpTable[m_numProviders] = &jp;
+    ATOMIC_INC(&m_numProviders); /* publish the slot only after it is written */
+}
+
+/* Remove job providers which have no more work from a shared pool. When this
+ * function returns, no worker thread references any of them and they may be
+ * destroyed while the workers continue to serve the pool's other providers */
+void ThreadPool::removeProviders(JobProvider** providers, int count)
+{
+    X265_CHECK(m_idleProvider, "job providers may only be removed from shared pools\n");
+    ScopedLock lock(m_providerLock);
+
+    for (int i = 0; i < count; i++)
+    {
+        providers[i]->m_helpWanted = false;
+        for (int j = 0; j < m_numProviders; j++)
+        {
+            if (m_jpTable[j] == providers[i])
+                m_jpTable[j] = m_idleProvider;
+        }
+    }
+
+    /* a worker which was scanning the table may have read a removed provider;
+     * wait until each worker is asleep or has started a new scan */
+    for (int id = 0; id < m_numWorkers; id++)
+    {
+        sleepbitmap_t bit = (sleepbitmap_t)1 << id;
+        uint32_t passCount = m_workers[id].m_passCount;
+        while (!(m_sleepBitmap & bit) && m_workers[id].m_passCount == passCount)
+            GIVE_UP_TIME();
+    }
+
+    /* workers keep their last job provider while they sleep. Once such a
+     * worker is asleep, take its sleep bit so it can be given the idle
+     * provider, then let it go back to sleep */
+    for (int id = 0; id < m_numWorkers; id++)
+    {
+        WorkerThread& worker = m_workers[id];
+        sleepbitmap_t bit = (sleepbitmap_t)1 << id;
+        for (;;)
+        {
+            bool bRemoved = false;
+            for (int i = 0; i < count; i++)
+                bRemoved |= worker.m_curJobProvider == providers[i];
+            if (!bRemoved)
+                break;
+
+            if (tryAcquireSleepingThread(bit, 0) == id)
+            {
+                worker.m_curJobProvider = m_idleProvider;
+                SLEEPBITMAP_OR(&m_idleProvider->m_ownerBitmap, bit);
+                worker.awaken();
+                break;
+            }
+            GIVE_UP_TIME();
+        }
+    }
+}
+
 ThreadPool::~ThreadPool()
 {
     if (m_workers)
@@ -521,6 +695,8 @@ ThreadPool::~ThreadPool()
 
     X265_FREE(m_workers);
     X265_FREE(m_jpTable);
+    X265_FREE(m_cacheDomainCpus);
+    delete m_idleProvider;
 
 #if HAVE_LIBNUMA
     if(m_numaMask)
@@ -561,6 +737,219 @@ void ThreadPool::setThreadNodeAffinity(void *numaMask)
     return;
 }
 
+ScopedNumaPolicy::ScopedNumaPolicy(const ThreadPool* pool)
+    : m_savedMode(0)
+    , m_bActive(false)
+{
+#if HAVE_LIBNUMA
+    if (!pool || !pool->m_numaMask || numa_available() < 0)
+        return;
+
+    struct bitmask* nodes = (struct bitmask*)pool->m_numaMask;
+    int numNodes = numa_bitmask_weight(nodes);
+    if (!numNodes || numNodes >= numa_num_configured_nodes())
+        return;
+
+    if (get_mempolicy(&m_savedMode, m_savedMask, sizeof(m_savedMask) * 8, NULL, 0))
+        return;
+    int mode = numNodes == 1 ? MPOL_PREFERRED : MPOL_INTERLEAVE;
+    m_bActive = !set_mempolicy(mode, nodes->maskp, nodes->size + 1);
+#else
+    (void)pool;
+#endif
+}
+
+ScopedNumaPolicy::~ScopedNumaPolicy()
+{
+#if HAVE_LIBNUMA
+    if (m_bActive)
+        set_mempolicy(m_savedMode, m_savedMask, sizeof(m_savedMask) * 8);
+#endif
+}
+
+SharedThreadPool::~SharedThreadPool()
+{
+    X265_CHECK(!m_numEncoders, "shared thread pool released while in use\n");
+    for (int i = 0; i < m_numPools; i++)
+        m_pools[i].stopWorkers();
+    delete [] m_pools;
+}
+
+bool SharedThreadPool::create(x265_param* p, int maxEncoders)
+{
+    m_maxEncoders = maxEncoders;
+    m_pools = ThreadPool::allocThreadPools(p, m_numPools, maxEncoders);
+    ThreadPool::logThreadPools(p, m_pools, m_numPools);
+    for (int i = 0; i < m_numPools; i++)
+        m_pools[i].start();
+    return m_numPools > 0;
+}
+
+bool SharedThreadPool::attachEncoder()
+{
+    ScopedLock lock(m_lock);
+    if (m_numEncoders >= m_maxEncoders)
+        return false;
+    m_numEncoders++;
+    return true;
+}
+
+void SharedThreadPool::detachEncoder()
+{
+    ScopedLock lock(m_lock);
+    m_numEncoders--;
+}
+
+#if __linux__
+/* Returns the lowest numbered CPU which shares the last level cache of the
+ * given CPU, as described by sysfs, or -1 if the cache topology is unknown */
+static int getLastLevelCacheId(int cpu)
+{
+    int lastLevel = 0, cacheId = -1;
+    for (int index = 0;; index++)
+    {
+        char path[96], type[32] = "";
+        int level = 0, firstCpu = -1;
+
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        FILE* f = fopen(path, "r");
+        if (!f)
+            break;
+        if (fscanf(f, "%d", &level) != 1)
+            level = 0;
+        fclose(f);
+
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, index);
+        f = fopen(path, "r");
+        if (f)
+        {
+            if (fscanf(f, "%31s", type) != 1)
+                type[0] = 0;
+            fclose(f);
+        }
+        if (level <= lastLevel || !strcmp(type, "Instruction"))
+            continue;
+
+        /* shared_cpu_list is ascending, ie: "0-7,64-71" */
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+        f = fopen(path, "r");
+        if (f)
+        {
+            if (fscanf(f, "%d", &firstCpu) != 1)
+                firstCpu = -1;
+            fclose(f);
+        }
+        if (firstCpu >= 0)
+        {
+            lastLevel = level;
+            cacheId = firstCpu;
+        }
+    }
+
+    return cacheId;
+}
+#endif
+
+/* Group the pool's workers by the last level cache of the CPUs they may run
+ * on. Workers are packed into as few cache domains as possible, and each
+ * job provider added to the pool prefers the workers of one domain, so the
+ * rows of a frame encoder tend to be processed by threads sharing a cache */
+void ThreadPool::initCacheDomains(uint64_t nodeMask)
+{
+    m_numCacheDomains = 1;
+#if __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed))
+        return;
+
+    /* CPUs usable by this pool, sorted by cache domain */
+    int cpus[CPU_SETSIZE], cacheIds[CPU_SETSIZE];
+    int numCpus = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+#if HAVE_LIBNUMA
+        if (numa_available() >= 0)
+        {
+            int node = numa_node_of_cpu(cpu);
+            if (node < 0 || node >= 64 || !((nodeMask >> node) & 1))
+                continue;
+        }
+#endif
+        int cacheId = getLastLevelCacheId(cpu);
+        if (cacheId < 0)
+            return;
+
+        int pos = numCpus++;
+        while (pos && cacheIds[pos - 1] > cacheId)
+        {
+            cpus[pos] = cpus[pos - 1];
+            cacheIds[pos] = cacheIds[pos - 1];
+            pos--;
+        }
+        cpus[pos] = cpu;
+        cacheIds[pos] = cacheId;
+    }
+    if (!numCpus || cacheIds[0] == cacheIds[numCpus - 1])
+        return;
+
+    cpu_set_t* domainCpus = X265_MALLOC(cpu_set_t, MAX_POOL_THREADS);
+    if (!domainCpus)
+        return;
+
+    /* worker w runs on the domain of the w'th CPU in cache order */
+    int used = X265_MIN(m_numWorkers, numCpus);
+    int domainOf[MAX_POOL_THREADS];
+    int numDomains = 0;
+    for (int i = 0; i < used; i++)
+    {
+        if (!i || cacheIds[i] != cacheIds[i - 1])
+        {
+            CPU_ZERO(&domainCpus[numDomains]);
+            for (int j = 0; j < numCpus; j++)
+            {
+                if (cacheIds[j] == cacheIds[i])
+                    CPU_SET(cpus[j], &domainCpus[numDomains]);
+            }
+            m_cacheDomainBitmap[numDomains++] = 0;
+        }
+        domainOf[i] = numDomains - 1;
+    }
+    for (int w = 0; w < m_numWorkers; w++)
+        m_cacheDomainBitmap[domainOf[w % used]] |= (sleepbitmap_t)1 << w;
+
+    if (numDomains < 2)
+    {
+        m_cacheDomainBitmap[0] = ALL_POOL_THREADS;
+        X265_FREE(domainCpus);
+        return;
+    }
+
+    m_numCacheDomains = numDomains;
+    m_cacheDomainCpus = domainCpus;
+#else
+    (void)nodeMask;
+#endif
+}
+
+void ThreadPool::setWorkerCacheAffinity(int workerId)
+{
+#if __linux__
+    for (int d = 0; d < m_numCacheDomains && m_cacheDomainCpus; d++)
+    {
+        if ((m_cacheDomainBitmap[d] >> workerId) & 1)
+        {
+            if (sched_setaffinity(0, sizeof(cpu_set_t), &((cpu_set_t*)m_cacheDomainCpus)[d]))
+                x265_log(NULL, X265_LOG_WARNING, "unable to set thread affinity for cache domain %d\n", d);
+            return;
+        }
+    }
+#else
+    (void)workerId;
+#endif
+}
+
 /* static */
 int ThreadPool::getNumaNodeCount()
 {
@@ -27,6 +27,8 @@
 #include "common.h"
 #include "threading.h"
 
+struct x265_pool {};
+
 namespace X265_NS {
 // x265 private namespace
 
@@ -52,16 +54,20 @@ public:
 
     ThreadPool*   m_pool;
     sleepbitmap_t m_ownerBitmap;
+    sleepbitmap_t m_cacheDomainBitmap; /* workers of the cache domain this provider prefers */
     int           m_jpId;
     int           m_sliceType;
+    int           m_poolPriority;   /* param->poolPriority of the owning encoder */
     bool          m_helpWanted;
     bool          m_isFrameEncoder; /* rather ugly hack, but nothing better presents itself */
 
     JobProvider()
         : m_pool(NULL)
         , m_ownerBitmap(0)
+        , m_cacheDomainBitmap(ALL_POOL_THREADS)
         , m_jpId(-1)
         , m_sliceType(INVALID_SLICE_PRIORITY)
+        , m_poolPriority(0)
         , m_helpWanted(false)
         , m_isFrameEncoder(false)
     {}
@@ -74,6 +80,10 @@ public:
     // Will awaken one idle thread, preferring a thread which most recently
     // performed work for this provider.
     void tryWakeOne();
+
+    // Lower values are served first by idle worker threads; the encoder's
+    // pool priority outranks the slice type of the frame being worked on
+    int schedulingRank() const { return m_sliceType - m_poolPriority * (INVALID_SLICE_PRIORITY + 1); }
 };
 
 class ThreadPool
@@ -81,34 +91,94 @@ class ThreadPool
 public:
 
     sleepbitmap_t m_sleepBitmap;
+    sleepbitmap_t m_cacheDomainBitmap[MAX_POOL_THREADS]; // workers sharing each last level cache
+    int           m_numCacheDomains;
+    int           m_nextCacheDomain;  // cache domain given to the next job provider
+    void*         m_cacheDomainCpus;  // cpu set of each cache domain in linux
     int           m_numProviders;
+    int           m_maxProviders;
     int           m_numWorkers;
     void*         m_numaMask; // node mask in linux, cpu mask in windows
+    uint64_t      m_nodeMask; // numa nodes the workers run on
 #if defined(_WIN32_WINNT) && _WIN32_WINNT >= _WIN32_WINNT_WIN7 
     GROUP_AFFINITY m_groupAffinity;
 #endif
     bool          m_isActive;
 
     JobProvider** m_jpTable;
+    JobProvider*  m_idleProvider;   // occupies unused m_jpTable slots of shared pools
     WorkerThread* m_workers;
+    Lock          m_providerLock;   // serializes addProvider() and removeProviders()
 
     ThreadPool();
     ~ThreadPool();
 
-    bool create(int numThreads, int maxProviders, uint64_t nodeMask);
+    bool create(int numThreads, int maxProviders, uint64_t nodeMask, bool bCacheAffinity);
     bool start();
     void stopWorkers();
+    void addProvider(JobProvider& jp);
+    void removeProviders(JobProvider** providers, int count);
+    void removeWorkers(int numThreads);
     void setCurrentThreadAffinity();
     void setThreadNodeAffinity(void *numaMask);
+    void setWorkerCacheAffinity(int workerId);
+    void initCacheDomains(uint64_t nodeMask);
     int  tryAcquireSleepingThread(sleepbitmap_t firstTryBitmap, sleepbitmap_t secondTryBitmap);
-    int  tryBondPeers(int maxPeers, sleepbitmap_t peerBitmap, BondedTaskGroup& master);
+    int  tryBondPeers(int maxPeers, sleepbitmap_t peerBitmap, sleepbitmap_t preferBitmap, BondedTaskGroup& master);
 
-    static ThreadPool* allocThreadPools(x265_param* p, int& numPools);
+    static ThreadPool* allocThreadPools(x265_param* p, int& numPools, int sharedEncoders = 0);
+    static void logThreadPools(x265_param* p, ThreadPool* pools, int numPools);
 
     static int  getCpuCount();
     static int  getNumaNodeCount();
 };
 
+/* While an instance is in scope, memory first touched by the calling thread
+ * is placed on the NUMA node(s) of the given pool (preferred for a single
+ * node, interleaved for several). Used when the API thread allocates and
+ * clears buffers which are later used by the pool's worker threads. Does
+ * nothing if pool is NULL, the pool spans every node, or the platform has
+ * no NUMA memory policy support */
+class ScopedNumaPolicy
+{
+public:
+
+    ScopedNumaPolicy(const ThreadPool* pool);
+    ~ScopedNumaPolicy();
+
+protected:
+
+    unsigned long m_savedMask[16];
+    int           m_savedMode;
+    bool          m_bActive;
+};
+
+/* The thread pools behind an x265_pool handle, created once by the application
+ * and used by up to m_maxEncoders encoders at a time. Each encoder adds its
+ * frame encoders and lookahead to these pools when it is created and removes
+ * them when it is closed, so job providers of every attached encoder are
+ * scheduled together by the same worker threads */
+class SharedThreadPool : public x265_pool
+{
+public:
+
+    ThreadPool*   m_pools;
+    int           m_numPools;
+    int           m_maxEncoders;
+    int           m_numEncoders;
+    Lock          m_lock;
+
+    SharedThreadPool() : m_pools(NULL), m_numPools(0), m_maxEncoders(0), m_numEncoders(0) {}
+    ~SharedThreadPool();
+
+    bool create(x265_param* p, int maxEncoders);
+
+    /* reserve (or release) job provider slots for one encoder, returns false
+     * if m_maxEncoders encoders are already attached */
+    bool attachEncoder();
+    void detachEncoder();
+};
+
 /* Any worker thread may enlist the help of idle worker threads from the same
  * job provider. They must derive from this class and implement the
  * processTasks() method.  To use, an instance must be instantiated by a worker
@@ -137,10 +207,11 @@ public:
 
     /* Try to enlist the help of idle worker threads on most recently associated
      * with the given job provider and "bond" them to work on your tasks. Up to
-     * maxPeers worker threads will call your processTasks() method. */
+     * maxPeers worker threads will call your processTasks() method. Threads in
+     * the job provider's cache domain are preferred */
     int tryBondPeers(JobProvider& jp, int maxPeers)
     {
-        int count = jp.m_pool->tryBondPeers(maxPeers, jp.m_ownerBitmap, *this);
+        int count = jp.m_pool->tryBondPeers(maxPeers, jp.m_ownerBitmap, jp.m_cacheDomainBitmap, *this);
         m_bondedPeerCount += count;
         return count;
     }
@@ -150,7 +221,7 @@ public:
      * processTasks() method. */
     int tryBondPeers(ThreadPool& pool, int maxPeers)
     {
-        int count = pool.tryBondPeers(maxPeers, ALL_POOL_THREADS, *this);
+        int count = pool.tryBondPeers(maxPeers, ALL_POOL_THREADS, ALL_POOL_THREADS, *this);
         m_bondedPeerCount += count;
         return count;
     }
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include <immintrin.h> // AVX2
+
+using namespace X265_NS;
+
+namespace {
+// anonymous file-static namespace
+
+static inline uint32_t horizontalSum(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 8));
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 4));
+    return (uint32_t)_mm_cvtsi128_si32(s);
+}
+
+/* the in-lane pack of two vectors of 8 int32 levels leaves the 64-bit
+ * quarters out of order */
+static inline __m256i packLevels(__m256i lo, __m256i hi)
+{
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+
+uint32_t quant_avx2(const int16_t* coef, const int32_t* quantCoeff, int32_t* deltaU, int16_t* qCoef, int qBits, int add, int numCoeff)
+{
+    X265_CHECK(qBits >= 8, "qBits less than 8\n");
+    X265_CHECK((numCoeff % 16) == 0, "numCoeff must be multiple of 16\n");
+
+    __m256i vadd = _mm256_set1_epi32(add);
+    __m128i vqBits = _mm_cvtsi32_si128(qBits);
+    __m128i vqBits8 = _mm_cvtsi32_si128(qBits - 8);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i numZero = zero;
+
+    for (int n = 0; n < numCoeff; n += 16)
+    {
+        __m256i level[2];
+        for (int i = 0; i < 2; i++)
+        {
+            __m256i c = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(coef + n + 8 * i)));
+            __m256i tmp = _mm256_mullo_epi32(_mm256_abs_epi32(c), _mm256_loadu_si256((const __m256i*)(quantCoeff + n + 8 * i)));
+            __m256i l = _mm256_sra_epi32(_mm256_add_epi32(tmp, vadd), vqBits);
+            _mm256_storeu_si256((__m256i*)(deltaU + n + 8 * i), _mm256_sra_epi32(_mm256_sub_epi32(tmp, _mm256_sll_epi32(l, vqBits)), vqBits8));
+            numZero = _mm256_sub_epi32(numZero, _mm256_cmpeq_epi32(l, zero));
+            level[i] = _mm256_sign_epi32(l, c);
+        }
+        _mm256_storeu_si256((__m256i*)(qCoef + n), packLevels(level[0], level[1]));
+    }
+
+    return numCoeff - horizontalSum(numZero);
+}
+
+uint32_t nquant_avx2(const int16_t* coef, const int32_t* quantCoeff, int16_t* qCoef, int qBits, int add, int numCoeff)
+{
+    X265_CHECK((numCoeff % 16) == 0, "number of quant coeff is not multiple of 4x4\n");
+
+    __m256i vadd = _mm256_set1_epi32(add);
+    __m128i vqBits = _mm_cvtsi32_si128(qBits);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i numZero = zero;
+
+    for (int n = 0; n < numCoeff; n += 16)
+    {
+        __m256i level[2];
+        for (int i = 0; i < 2; i++)
+        {
+            __m256i c = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(coef + n + 8 * i)));
+            __m256i tmp = _mm256_mullo_epi32(_mm256_abs_epi32(c), _mm256_loadu_si256((const __m256i*)(quantCoeff + n + 8 * i)));
+            __m256i l = _mm256_sra_epi32(_mm256_add_epi32(tmp, vadd), vqBits);
+            numZero = _mm256_sub_epi32(numZero, _mm256_cmpeq_epi32(l, zero));
+            level[i] = _mm256_sign_epi32(l, c);
+        }
+
+        /* the C reference clips the signed level before taking its absolute
+         * value, so a clipped -32768 stays -32768 */
+        _mm256_storeu_si256((__m256i*)(qCoef + n), _mm256_abs_epi16(packLevels(level[0], level[1])));
+    }
+
+    return numCoeff - horizontalSum(numZero);
+}
+
+} // end anonymous namespace
+
+namespace X265_NS {
+void setupIntrinsicDCT_avx2(EncoderPrimitives &p)
+{
+    p.quant = quant_avx2;
+    p.nquant = nquant_avx2;
+}
+}
@@ -0,0 +1,287 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#if defined(__GNUC__) && !defined(__clang__)
+/* gcc's headers pass self-initialized _mm512_undefined_*() vectors as the
+ * merge source of unmasked intrinsics */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h> // AVX-512
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+using namespace X265_NS;
+
+namespace {
+// anonymous file-static namespace
+
+uint32_t quant_avx512(const int16_t* coef, const int32_t* quantCoeff, int32_t* deltaU, int16_t* qCoef, int qBits, int add, int numCoeff)
+{
+    X265_CHECK(qBits >= 8, "qBits less than 8\n");
+    X265_CHECK((numCoeff % 16) == 0, "numCoeff must be multiple of 16\n");
+
+    __m512i vadd = _mm512_set1_epi32(add);
+    __m128i vqBits = _mm_cvtsi32_si128(qBits);
+    __m128i vqBits8 = _mm_cvtsi32_si128(qBits - 8);
+    __m512i zero = _mm512_setzero_si512();
+    uint32_t numSig = 0;
+
+    for (int n = 0; n < numCoeff; n += 16)
+    {
+        __m512i level = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(coef + n)));
+        __mmask16 neg = _mm512_cmplt_epi32_mask(level, zero);
+
+        __m512i tmplevel = _mm512_mullo_epi32(_mm512_abs_epi32(level), _mm512_loadu_si512(quantCoeff + n));
+        level = _mm512_sra_epi32(_mm512_add_epi32(tmplevel, vadd), vqBits);
+        __m512i delta = _mm512_sub_epi32(tmplevel, _mm512_sll_epi32(level, vqBits));
+        _mm512_storeu_si512(deltaU + n, _mm512_sra_epi32(delta, vqBits8));
+
+        numSig += _mm_popcnt_u32(_mm512_test_epi32_mask(level, level));
+
+        level = _mm512_mask_sub_epi32(level, neg, zero, level);
+        _mm256_storeu_si256((__m256i*)(qCoef + n), _mm512_cvtsepi32_epi16(level));
+    }
+
+    return numSig;
+}
+
+uint32_t nquant_avx512(const int16_t* coef, const int32_t* quantCoeff, int16_t* qCoef, int qBits, int add, int numCoeff)
+{
+    X265_CHECK((numCoeff % 16) == 0, "number of quant coeff is not multiple of 4x4\n");
+
+    __m512i vadd = _mm512_set1_epi32(add);
+    __m128i vqBits = _mm_cvtsi32_si128(qBits);
+    __m512i zero = _mm512_setzero_si512();
+    uint32_t numSig = 0;
+
+    for (int n = 0; n < numCoeff; n += 16)
+    {
+        __m512i level = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(coef + n)));
+        __mmask16 neg = _mm512_cmplt_epi32_mask(level, zero);
+
+        __m512i tmplevel = _mm512_mullo_epi32(_mm512_abs_epi32(level), _mm512_loadu_si512(quantCoeff + n));
+        level = _mm512_sra_epi32(_mm512_add_epi32(tmplevel, vadd), vqBits);
+
+        numSig += _mm_popcnt_u32(_mm512_test_epi32_mask(level, level));
+
+        /* the C reference clips the signed level before taking its absolute
+         * value, so a clipped -32768 stays -32768 */
+        level = _mm512_mask_sub_epi32(level, neg, zero, level);
+        __m256i q = _mm512_cvtsepi32_epi16(level);
+        _mm256_storeu_si256((__m256i*)(qCoef + n), _mm256_abs_epi16(q));
+    }
+
+    return numSig;
+}
+
+int64_t rdoqCgCost_avx512(const int16_t *resiCoeff, const int16_t *fencCoeff, int64_t *costUncoded, intptr_t trSize, int scaleBits, int64_t psyScale, int psyShift)
+{
+    /* gather the four rows of the coeff group into one register */
+    __m128i r01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)resiCoeff), _mm_loadl_epi64((const __m128i*)(resiCoeff + trSize)));
+    __m128i r23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(resiCoeff + 2 * trSize)), _mm_loadl_epi64((const __m128i*)(resiCoeff + 3 * trSize)));
+    __m512i resi = _mm512_cvtepi16_epi32(_mm256_inserti128_si256(_mm256_castsi128_si256(r01), r23, 1));
+
+    __m128i vScale = _mm_cvtsi32_si128(scaleBits);
+    __m512i sq = _mm512_mullo_epi32(resi, resi);
+    __m512i cost0 = _mm512_sll_epi64(_mm512_cvtepu32_epi64(_mm512_castsi512_si256(sq)), vScale);
+    __m512i cost1 = _mm512_sll_epi64(_mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(sq, 1)), vScale);
+
+    if (psyScale)
+    {
+        __m128i f01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)fencCoeff), _mm_loadl_epi64((const __m128i*)(fencCoeff + trSize)));
+        __m128i f23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(fencCoeff + 2 * trSize)), _mm_loadl_epi64((const __m128i*)(fencCoeff + 3 * trSize)));
+        __m512i pred = _mm512_sub_epi32(_mm512_cvtepi16_epi32(_mm256_inserti128_si256(_mm256_castsi128_si256(f01), f23, 1)), resi);
+
+        __m512i vPsy = _mm512_set1_epi64(psyScale);
+        __m128i vPsyShift = _mm_cvtsi32_si128(psyShift);
+        __m512i psy0 = _mm512_mullo_epi64(_mm512_cvtepi32_epi64(_mm512_castsi512_si256(pred)), vPsy);
+        __m512i psy1 = _mm512_mullo_epi64(_mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(pred, 1)), vPsy);
+        cost0 = _mm512_sub_epi64(cost0, _mm512_sra_epi64(psy0, vPsyShift));
+        cost1 = _mm512_sub_epi64(cost1, _mm512_sra_epi64(psy1, vPsyShift));
+    }
+
+    _mm256_storeu_si256((__m256i*)costUncoded, _mm512_castsi512_si256(cost0));
+    _mm256_storeu_si256((__m256i*)(costUncoded + trSize), _mm512_extracti64x4_epi64(cost0, 1));
+    _mm256_storeu_si256((__m256i*)(costUncoded + 2 * trSize), _mm512_castsi512_si256(cost1));
+    _mm256_storeu_si256((__m256i*)(costUncoded + 3 * trSize), _mm512_extracti64x4_epi64(cost1, 1));
+
+    return _mm512_reduce_add_epi64(_mm512_add_epi64(cost0, cost1));
+}
+
+/* the transform matrices with their coefficients paired along the summed
+ * dimension, one dword per output index, for use with madd:
+ *   s_fwdPairs[p][k] = (g_tN[k][2p], g_tN[k][2p + 1])
+ *   s_invPairs[p][k] = (g_tN[2p][k], g_tN[2p + 1][k]) */
+int32_t s_fwdPairs16[8][16];
+int32_t s_invPairs16[8][16];
+int32_t s_fwdPairs32[16][32];
+int32_t s_invPairs32[16][32];
+
+inline int32_t pairOf(int16_t lo, int16_t hi)
+{
+    return (int32_t)((uint16_t)lo | ((uint32_t)(uint16_t)hi << 16));
+}
+
+template<int N>
+void initPairs(const int16_t (*t)[N], int32_t (*fwd)[N], int32_t (*inv)[N])
+{
+    for (int p = 0; p < N / 2; p++)
+    {
+        for (int k = 0; k < N; k++)
+        {
+            fwd[p][k] = pairOf(t[k][2 * p], t[k][2 * p + 1]);
+            inv[p][k] = pairOf(t[2 * p][k], t[2 * p + 1][k]);
+        }
+    }
+}
+
+/* two adjacent coefficients broadcast to every dword */
+inline __m512i broadcastPair(const int16_t* p)
+{
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return _mm512_set1_epi32(v);
+}
+
+/* Both passes are full matrix products, 16 outputs per madd chain. The first
+ * pass takes a residual row at a time and yields a column of the intermediate
+ * block; the second multiplies interleaved pairs of those columns by one
+ * broadcast coefficient pair per output row, so neither pass transposes */
+template<int N>
+void dct_avx512(const int16_t* src, int16_t* dst, intptr_t srcStride)
+{
+    enum { P = N / 2, V = N / 16 };
+    const int shift1 = (N == 16 ? 3 : 4) + X265_DEPTH - 8;
+    const int shift2 = N == 16 ? 10 : 11;
+    const int32_t* fwd = N == 16 ? &s_fwdPairs16[0][0] : &s_fwdPairs32[0][0];
+
+    const __m512i add1 = _mm512_set1_epi32(1 << (shift1 - 1));
+    const __m512i add2 = _mm512_set1_epi32(1 << (shift2 - 1));
+
+    /* pairs[p][v] lane r holds (block[r][2p], block[r][2p + 1]) */
+    __m512i pairs[P][V];
+    for (int p = 0; p < P; p++)
+    {
+        const int16_t* r0 = src + 2 * p * srcStride;
+        const int16_t* r1 = r0 + srcStride;
+        for (int v = 0; v < V; v++)
+        {
+            __m512i sum0 = _mm512_setzero_si512(), sum1 = _mm512_setzero_si512();
+            for (int n = 0; n < P; n++)
+            {
+                __m512i c = _mm512_loadu_si512(fwd + n * N + 16 * v);
+                sum0 = _mm512_add_epi32(sum0, _mm512_madd_epi16(broadcastPair(r0 + 2 * n), c));
+                sum1 = _mm512_add_epi32(sum1, _mm512_madd_epi16(broadcastPair(r1 + 2 * n), c));
+            }
+            sum0 = _mm512_srai_epi32(_mm512_add_epi32(sum0, add1), shift1);
+            sum1 = _mm512_srai_epi32(_mm512_add_epi32(sum1, add1), shift1);
+            pairs[p][v] = _mm512_mask_blend_epi16(0xAAAAAAAA, sum0, _mm512_slli_epi32(sum1, 16));
+        }
+    }
+
+    for (int k = 0; k < N; k++)
+    {
+        for (int v = 0; v < V; v++)
+        {
+            __m512i sum = _mm512_setzero_si512();
+            for (int p = 0; p < P; p++)
+                sum = _mm512_add_epi32(sum, _mm512_madd_epi16(pairs[p][v], _mm512_set1_epi32(fwd[p * N + k])));
+            sum = _mm512_srai_epi32(_mm512_add_epi32(sum, add2), shift2);
+            _mm256_storeu_si256((__m256i*)(dst + k * N + 16 * v), _mm512_cvtepi32_epi16(sum));
+        }
+    }
+}
+
+/* The same products in the other order: the first pass interleaves pairs of
+ * coefficient rows and yields the intermediate block transposed, whose rows
+ * the second pass broadcasts a pair at a time */
+template<int N>
+void idct_avx512(const int16_t* src, int16_t* dst, intptr_t dstStride)
+{
+    enum { P = N / 2, V = N / 16 };
+    const int shift1 = 7;
+    const int shift2 = 12 - (X265_DEPTH - 8);
+    const int32_t* inv = N == 16 ? &s_invPairs16[0][0] : &s_invPairs32[0][0];
+
+    const __m512i add1 = _mm512_set1_epi32(1 << (shift1 - 1));
+    const __m512i add2 = _mm512_set1_epi32(1 << (shift2 - 1));
+
+    /* pairs[p][v] lane j holds (src[2p][j], src[2p + 1][j]) */
+    __m512i pairs[P][V];
+    for (int p = 0; p < P; p++)
+    {
+        for (int v = 0; v < V; v++)
+        {
+            __m512i r0 = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(src + 2 * p * N + 16 * v)));
+            __m512i r1 = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(src + (2 * p + 1) * N + 16 * v)));
+            pairs[p][v] = _mm512_or_si512(r0, _mm512_slli_epi32(r1, 16));
+        }
+    }
+
+    /* tmp[k][j] is the intermediate block at row j, column k */
+    ALIGN_VAR_32(int16_t, tmp[N * N]);
+    for (int k = 0; k < N; k++)
+    {
+        for (int v = 0; v < V; v++)
+        {
+            __m512i sum = _mm512_setzero_si512();
+            for (int p = 0; p < P; p++)
+                sum = _mm512_add_epi32(sum, _mm512_madd_epi16(pairs[p][v], _mm512_set1_epi32(inv[p * N + k])));
+            sum = _mm512_srai_epi32(_mm512_add_epi32(sum, add1), shift1);
+            _mm256_store_si256((__m256i*)(tmp + k * N + 16 * v), _mm512_cvtsepi32_epi16(sum));
+        }
+    }
+
+    for (int j = 0; j < N; j++)
+    {
+        for (int v = 0; v < V; v++)
+        {
+            __m512i sum = _mm512_setzero_si512();
+            for (int p = 0; p < P; p++)
+                sum = _mm512_add_epi32(sum, _mm512_madd_epi16(broadcastPair(tmp + j * N + 2 * p), _mm512_loadu_si512(inv + p * N + 16 * v)));
+            sum = _mm512_srai_epi32(_mm512_add_epi32(sum, add2), shift2);
+            _mm256_storeu_si256((__m256i*)(dst + j * dstStride + 16 * v), _mm512_cvtsepi32_epi16(sum));
+        }
+    }
+}
+
+} // end anonymous namespace
+
+namespace X265_NS {
+void setupIntrinsicDCT_avx512(EncoderPrimitives &p)
+{
+    p.quant = quant_avx512;
+    p.nquant = nquant_avx512;
+    p.rdoq_cg_cost = rdoqCgCost_avx512;
+
+    initPairs<16>(g_t16, s_fwdPairs16, s_invPairs16);
+    initPairs<32>(g_t32, s_fwdPairs32, s_invPairs32);
+    p.cu[BLOCK_16x16].dct = dct_avx512<16>;
+    p.cu[BLOCK_32x32].dct = dct_avx512<32>;
+    p.cu[BLOCK_16x16].idct = idct_avx512<16>;
+    p.cu[BLOCK_32x32].idct = idct_avx512<32>;
+}
+}
@@ -100,9 +100,342 @@ static void dequant_scaling(const int16_t* quantCoef, const int32_t *deQuantCoef
     }
 }
 
+/* SSE has no 64bit multiply or arithmetic shift. psyScale is split into 31bit
+ * halves so the signed 32x32 multiply forms the exact product, and the shift
+ * is made logical by biasing the sign bit */
+static int64_t rdoqCgCost(const int16_t *resiCoeff, const int16_t *fencCoeff, int64_t *costUncoded, intptr_t trSize, int scaleBits, int64_t psyScale, int psyShift)
+{
+    __m128i vScale = _mm_cvtsi32_si128(scaleBits);
+    __m128i vPsyShift = _mm_cvtsi32_si128(psyShift);
+    __m128i psyLo = _mm_set1_epi32((int32_t)(psyScale & 0x7FFFFFFF));
+    __m128i psyHi = _mm_set1_epi32((int32_t)(psyScale >> 31));
+    __m128i signBias = _mm_set1_epi64x((int64_t)1 << 63);
+    __m128i signBiasShifted = _mm_srl_epi64(signBias, vPsyShift);
+    __m128i sum = _mm_setzero_si128();
+
+    for (int y = 0; y < MLS_CG_SIZE; y++)
+    {
+        __m128i resi = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)resiCoeff));
+        __m128i sq = _mm_mullo_epi32(resi, resi);
+        __m128i cost0 = _mm_sll_epi64(_mm_cvtepu32_epi64(sq), vScale);
+        __m128i cost1 = _mm_sll_epi64(_mm_cvtepu32_epi64(_mm_srli_si128(sq, 8)), vScale);
+
+        if (psyScale)
+        {
+            __m128i pred = _mm_sub_epi32(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)fencCoeff)), resi);
+            __m128i pred0 = _mm_cvtepi32_epi64(pred);
+            __m128i pred1 = _mm_cvtepi32_epi64(_mm_srli_si128(pred, 8));
+
+            __m128i prod0 = _mm_add_epi64(_mm_mul_epi32(pred0, psyLo), _mm_slli_epi64(_mm_mul_epi32(pred0, psyHi), 31));
+            __m128i prod1 = _mm_add_epi64(_mm_mul_epi32(pred1, psyLo), _mm_slli_epi64(_mm_mul_epi32(pred1, psyHi), 31));
+            prod0 = _mm_sub_epi64(_mm_srl_epi64(_mm_xor_si128(prod0, signBias), vPsyShift), signBiasShifted);
+            prod1 = _mm_sub_epi64(_mm_srl_epi64(_mm_xor_si128(prod1, signBias), vPsyShift), signBiasShifted);
+
+            cost0 = _mm_sub_epi64(cost0, prod0);
+            cost1 = _mm_sub_epi64(cost1, prod1);
+        }
+
+        _mm_storeu_si128((__m128i*)costUncoded, cost0);
+        _mm_storeu_si128((__m128i*)(costUncoded + 2), cost1);
+        sum = _mm_add_epi64(sum, _mm_add_epi64(cost0, cost1));
+
+        resiCoeff += trSize;
+        fencCoeff += trSize;
+        costUncoded += trSize;
+    }
+
+    sum = _mm_add_epi64(sum, _mm_srli_si128(sum, 8));
+    int64_t ret;
+    _mm_storel_epi64((__m128i*)&ret, sum);
+    return ret;
+}
+
+/* Fused transform kernels for 4x4 and 8x8 TUs. Each transform pass computes
+ * out[k][j] = sum(m[k][i] * in[i][j]) with pmaddwd on interleaved rows of the
+ * input, so a row of the output is formed per register. The pass inputs are
+ * transposed in registers, nothing is spilled to memory between the passes */
+
+/* pmaddwd coefficient pairs { m[k][2p], m[k][2p + 1] } */
+#define PAIR(a, b) (int32_t)(((uint32_t)(uint16_t)(b) << 16) | (uint16_t)(a))
+
+/* forward, m = T */
+static const int32_t s_dct4Pairs[4][2] =
+{
+    { PAIR(64, 64),  PAIR(64, 64) },
+    { PAIR(83, 36),  PAIR(-36, -83) },
+    { PAIR(64, -64), PAIR(-64, 64) },
+    { PAIR(36, -83), PAIR(83, -36) }
+};
+
+/* inverse, m = transpose(T) */
+static const int32_t s_idct4Pairs[4][2] =
+{
+    { PAIR(64, 83),  PAIR(64, 36) },
+    { PAIR(64, 36),  PAIR(-64, -83) },
+    { PAIR(64, -36), PAIR(-64, 83) },
+    { PAIR(64, -83), PAIR(64, -36) }
+};
+
+static const int32_t s_dct8Pairs[8][4] =
+{
+    { PAIR(64, 64),  PAIR(64, 64),   PAIR(64, 64),   PAIR(64, 64) },
+    { PAIR(89, 75),  PAIR(50, 18),   PAIR(-18, -50), PAIR(-75, -89) },
+    { PAIR(83, 36),  PAIR(-36, -83), PAIR(-83, -36), PAIR(36, 83) },
+    { PAIR(75, -18), PAIR(-89, -50), PAIR(50, 89),   PAIR(18, -75) },
+    { PAIR(64, -64), PAIR(-64, 64),  PAIR(64, -64),  PAIR(-64, 64) },
+    { PAIR(50, -89), PAIR(18, 75),   PAIR(-75, -18), PAIR(89, -50) },
+    { PAIR(36, -83), PAIR(83, -36),  PAIR(-36, 83),  PAIR(-83, 36) },
+    { PAIR(18, -50), PAIR(75, -89),  PAIR(89, -75),  PAIR(50, -18) }
+};
+
+static const int32_t s_idct8Pairs[8][4] =
+{
+    { PAIR(64, 89), PAIR(83, 75),   PAIR(64, 50),   PAIR(36, 18) },
+    { PAIR(64, 75), PAIR(36, -18),  PAIR(-64, -89), PAIR(-83, -50) },
+    { PAIR(64, 50), PAIR(-36, -89), PAIR(-64, 18),  PAIR(83, 75) },
+    { PAIR(64, 18), PAIR(-83, -50), PAIR(64, 75),   PAIR(-36, -89) },
+    { PAIR(64, -18), PAIR(-83, 50), PAIR(64, -75),  PAIR(-36, 89) },
+    { PAIR(64, -50), PAIR(-36, 89), PAIR(-64, -18), PAIR(83, -75) },
+    { PAIR(64, -75), PAIR(36, 18),  PAIR(-64, 89),  PAIR(-83, 50) },
+    { PAIR(64, -89), PAIR(83, -75), PAIR(64, -50),  PAIR(36, -18) }
+};
+
+#undef PAIR
+
+/* one transform pass over N rows of N int16 coefficients (the low half of
+ * each register when N is 4), rounded, shifted and saturated to int16 */
+template<int N>
+static inline void transformPass(const __m128i* in, const int32_t (*pairs)[N / 2], int shift, __m128i* out)
+{
+    __m128i lo[N / 2], hi[N / 2];
+    for (int p = 0; p < N / 2; p++)
+    {
+        lo[p] = _mm_unpacklo_epi16(in[2 * p], in[2 * p + 1]);
+        if (N == 8)
+            hi[p] = _mm_unpackhi_epi16(in[2 * p], in[2 * p + 1]);
+    }
+
+    __m128i round = _mm_set1_epi32(1 << (shift - 1));
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    for (int k = 0; k < N; k++)
+    {
+        __m128i accLo = round, accHi = round;
+        for (int p = 0; p < N / 2; p++)
+        {
+            __m128i m = _mm_set1_epi32(pairs[k][p]);
+            accLo = _mm_add_epi32(accLo, _mm_madd_epi16(lo[p], m));
+            if (N == 8)
+                accHi = _mm_add_epi32(accHi, _mm_madd_epi16(hi[p], m));
+        }
+        accLo = _mm_sra_epi32(accLo, vshift);
+        accHi = N == 8 ? _mm_sra_epi32(accHi, vshift) : _mm_setzero_si128();
+        out[k] = _mm_packs_epi32(accLo, accHi);
+    }
+}
+
+template<int N>
+static inline void transpose(const __m128i* in, __m128i* out)
+{
+    if (N == 4)
+    {
+        __m128i t0 = _mm_unpacklo_epi16(in[0], in[1]);
+        __m128i t1 = _mm_unpacklo_epi16(in[2], in[3]);
+        __m128i c01 = _mm_unpacklo_epi32(t0, t1);
+        __m128i c23 = _mm_unpackhi_epi32(t0, t1);
+        out[0] = c01;
+        out[1] = _mm_srli_si128(c01, 8);
+        out[2] = c23;
+        out[3] = _mm_srli_si128(c23, 8);
+    }
+    else
+    {
+        __m128i a0 = _mm_unpacklo_epi16(in[0], in[1]);
+        __m128i a1 = _mm_unpackhi_epi16(in[0], in[1]);
+        __m128i a2 = _mm_unpacklo_epi16(in[2], in[3]);
+        __m128i a3 = _mm_unpackhi_epi16(in[2], in[3]);
+        __m128i a4 = _mm_unpacklo_epi16(in[4], in[5]);
+        __m128i a5 = _mm_unpackhi_epi16(in[4], in[5]);
+        __m128i a6 = _mm_unpacklo_epi16(in[6], in[7]);
+        __m128i a7 = _mm_unpackhi_epi16(in[6], in[7]);
+
+        __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+        __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+        __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+        __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+        __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+        __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+        __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+        __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+        out[0] = _mm_unpacklo_epi64(b0, b4);
+        out[1] = _mm_unpackhi_epi64(b0, b4);
+        out[2] = _mm_unpacklo_epi64(b1, b5);
+        out[3] = _mm_unpackhi_epi64(b1, b5);
+        out[4] = _mm_unpacklo_epi64(b2, b6);
+        out[5] = _mm_unpackhi_epi64(b2, b6);
+        out[6] = _mm_unpacklo_epi64(b3, b7);
+        out[7] = _mm_unpackhi_epi64(b3, b7);
+    }
+}
+
+template<int N>
+static inline __m128i loadRow(const int16_t* src)
+{
+    return N == 4 ? _mm_loadl_epi64((const __m128i*)src) : _mm_loadu_si128((const __m128i*)src);
+}
+
+template<int N>
+static inline void storeRow(int16_t* dst, __m128i row)
+{
+    if (N == 4)
+        _mm_storel_epi64((__m128i*)dst, row);
+    else
+        _mm_storeu_si128((__m128i*)dst, row);
+}
+
+/* quant of four coefficients, matches quant_c */
+/* counts the zero levels, an overflowed level may be negative and the C
+ * reference counts every nonzero level as significant */
+static inline __m128i quant4(__m128i coef, const int32_t* quantCoeff, int32_t* deltaU, __m128i add, __m128i qBits, __m128i qBits8, __m128i& numZero)
+{
+    __m128i tmp = _mm_mullo_epi32(_mm_abs_epi32(coef), _mm_loadu_si128((const __m128i*)quantCoeff));
+    __m128i level = _mm_sra_epi32(_mm_add_epi32(tmp, add), qBits);
+    _mm_storeu_si128((__m128i*)deltaU, _mm_sra_epi32(_mm_sub_epi32(tmp, _mm_sll_epi32(level, qBits)), qBits8));
+    numZero = _mm_sub_epi32(numZero, _mm_cmpeq_epi32(level, _mm_setzero_si128()));
+    return _mm_sign_epi32(level, coef);
+}
+
+static uint32_t quant(const int16_t* coef, const int32_t* quantCoeff, int32_t* deltaU, int16_t* qCoef, int qBits, int add, int numCoeff)
+{
+    X265_CHECK(qBits >= 8, "qBits less than 8\n");
+    X265_CHECK((numCoeff % 16) == 0, "numCoeff must be multiple of 16\n");
+
+    __m128i vadd = _mm_set1_epi32(add);
+    __m128i vqBits = _mm_cvtsi32_si128(qBits);
+    __m128i vqBits8 = _mm_cvtsi32_si128(qBits - 8);
+    __m128i numZero = _mm_setzero_si128();
+
+    for (int n = 0; n < numCoeff; n += 8)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i*)(coef + n));
+        __m128i lo = quant4(_mm_cvtepi16_epi32(c), quantCoeff + n, deltaU + n, vadd, vqBits, vqBits8, numZero);
+        __m128i hi = quant4(_mm_cvtepi16_epi32(_mm_srli_si128(c, 8)), quantCoeff + n + 4, deltaU + n + 4, vadd, vqBits, vqBits8, numZero);
+        _mm_storeu_si128((__m128i*)(qCoef + n), _mm_packs_epi32(lo, hi));
+    }
+
+    numZero = _mm_add_epi32(numZero, _mm_srli_si128(numZero, 8));
+    numZero = _mm_add_epi32(numZero, _mm_srli_si128(numZero, 4));
+    return numCoeff - _mm_cvtsi128_si32(numZero);
+}
+
+static uint32_t nquant(const int16_t* coef, const int32_t* quantCoeff, int16_t* qCoef, int qBits, int add, int numCoeff)
+{
+    X265_CHECK((numCoeff % 16) == 0, "number of quant coeff is not multiple of 4x4\n");
+
+    __m128i vadd = _mm_set1_epi32(add);
+    __m128i vqBits = _mm_cvtsi32_si128(qBits);
+    __m128i zero = _mm_setzero_si128();
+    __m128i numZero = zero;
+
+    for (int n = 0; n < numCoeff; n += 8)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i*)(coef + n));
+        __m128i lo = _mm_cvtepi16_epi32(c);
+        __m128i hi = _mm_cvtepi16_epi32(_mm_srli_si128(c, 8));
+        lo = _mm_sra_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_abs_epi32(lo), _mm_loadu_si128((const __m128i*)(quantCoeff + n))), vadd), vqBits);
+        hi = _mm_sra_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_abs_epi32(hi), _mm_loadu_si128((const __m128i*)(quantCoeff + n + 4))), vadd), vqBits);
+        numZero = _mm_sub_epi32(numZero, _mm_add_epi32(_mm_cmpeq_epi32(lo, zero), _mm_cmpeq_epi32(hi, zero)));
+
+        /* the C reference clips the signed level before taking its absolute
+         * value, so a clipped -32768 stays -32768 */
+        __m128i q = _mm_packs_epi32(_mm_sign_epi32(lo, _mm_cvtepi16_epi32(c)), _mm_sign_epi32(hi, _mm_cvtepi16_epi32(_mm_srli_si128(c, 8))));
+        _mm_storeu_si128((__m128i*)(qCoef + n), _mm_abs_epi16(q));
+    }
+
+    numZero = _mm_add_epi32(numZero, _mm_srli_si128(numZero, 8));
+    numZero = _mm_add_epi32(numZero, _mm_srli_si128(numZero, 4));
+    return numCoeff - _mm_cvtsi128_si32(numZero);
+}
+
+template<int log2TrSize>
+static uint32_t dct_quant(const int16_t* residual, intptr_t resiStride, int16_t* coef, const int32_t* quantCoeff, int32_t* deltaU, int16_t* qCoef, int qBits, int add)
+{
+    enum { N = 1 << log2TrSize };
+    const int shift_1st = log2TrSize - 1 + X265_DEPTH - 8;
+    const int shift_2nd = log2TrSize + 6;
+    const int32_t (*pairs)[N / 2] = (const int32_t (*)[N / 2])(N == 4 ? &s_dct4Pairs[0][0] : &s_dct8Pairs[0][0]);
+
+    __m128i rows[N], cols[N];
+    for (int j = 0; j < N; j++)
+        rows[j] = loadRow<N>(residual + j * resiStride);
+
+    transpose<N>(rows, cols);
+    transformPass<N>(cols, pairs, shift_1st, rows);
+    transpose<N>(rows, cols);
+    transformPass<N>(cols, pairs, shift_2nd, rows);
+
+    __m128i vadd = _mm_set1_epi32(add);
+    __m128i vqBits = _mm_cvtsi32_si128(qBits);
+    __m128i vqBits8 = _mm_cvtsi32_si128(qBits - 8);
+    __m128i numZero = _mm_setzero_si128();
+
+    /* rows[k] holds row k of the DCT coefficients */
+    for (int k = 0; k < N; k++)
+    {
+        storeRow<N>(coef + k * N, rows[k]);
+
+        __m128i lo = quant4(_mm_cvtepi16_epi32(rows[k]), quantCoeff + k * N, deltaU + k * N, vadd, vqBits, vqBits8, numZero);
+        __m128i hi = N == 8 ? quant4(_mm_cvtepi16_epi32(_mm_srli_si128(rows[k], 8)), quantCoeff + k * N + 4, deltaU + k * N + 4, vadd, vqBits, vqBits8, numZero) : _mm_setzero_si128();
+        storeRow<N>(qCoef + k * N, _mm_packs_epi32(lo, hi));
+    }
+
+    numZero = _mm_add_epi32(numZero, _mm_srli_si128(numZero, 8));
+    numZero = _mm_add_epi32(numZero, _mm_srli_si128(numZero, 4));
+    return N * N - _mm_cvtsi128_si32(numZero);
+}
+
+template<int log2TrSize>
+static void dequant_idct(const int16_t* quantCoef, int16_t* residual, intptr_t resiStride, int scale, int shift)
+{
+    enum { N = 1 << log2TrSize };
+    const int shift_2nd = 12 - (X265_DEPTH - 8);
+    const int32_t (*pairs)[N / 2] = (const int32_t (*)[N / 2])(N == 4 ? &s_idct4Pairs[0][0] : &s_idct8Pairs[0][0]);
+
+    __m128i vscale = _mm_set1_epi32(scale);
+    __m128i vadd = _mm_set1_epi32(1 << (shift - 1));
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+
+    /* dequant_normal, rows[k] holds row k of the dequantized coefficients */
+    __m128i rows[N], cols[N];
+    for (int k = 0; k < N; k++)
+    {
+        __m128i q = loadRow<N>(quantCoef + k * N);
+        __m128i lo = _mm_sra_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_cvtepi16_epi32(q), vscale), vadd), vshift);
+        __m128i hi = N == 8 ? _mm_sra_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_cvtepi16_epi32(_mm_srli_si128(q, 8)), vscale), vadd), vshift) : _mm_setzero_si128();
+        rows[k] = _mm_packs_epi32(lo, hi);
+    }
+
+    /* each pass outputs the columns of its result */
+    transformPass<N>(rows, pairs, 7, cols);
+    transpose<N>(cols, rows);
+    transformPass<N>(rows, pairs, shift_2nd, cols);
+    transpose<N>(cols, rows);
+
+    for (int j = 0; j < N; j++)
+        storeRow<N>(residual + j * resiStride, rows[j]);
+}
+
 namespace X265_NS {
 void setupIntrinsicDCT_sse41(EncoderPrimitives &p)
 {
     p.dequant_scaling = dequant_scaling;
+    p.rdoq_cg_cost = rdoqCgCost;
+    p.quant = quant;
+    p.nquant = nquant;
+
+    p.cu[BLOCK_4x4].dct_quant = dct_quant<2>;
+    p.cu[BLOCK_8x8].dct_quant = dct_quant<3>;
+    p.cu[BLOCK_4x4].dequant_idct = dequant_idct<2>;
+    p.cu[BLOCK_8x8].dequant_idct = dequant_idct<3>;
 }
 }
@@ -0,0 +1,378 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include <immintrin.h> // AVX2
+
+using namespace X265_NS;
+
+namespace {
+// anonymous file-static namespace
+
+#if !HIGH_BIT_DEPTH
+
+/* two 16 byte loads into the low and high 128-bit lanes */
+static inline __m256i load2x128(const pixel* lo, const pixel* hi)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)lo)),
+                                   _mm_loadu_si128((const __m128i*)hi), 1);
+}
+
+/* 32 pixels of a strip of width w: one row of a 32 wide strip or two rows
+ * of a 16 wide strip */
+template<int w>
+static inline __m256i loadStrip(const pixel* p, intptr_t stride)
+{
+    if (w == 32)
+        return _mm256_loadu_si256((const __m256i*)p);
+    else
+        return load2x128(p, p + stride);
+}
+
+template<int w, int ly, int N>
+static inline void sadStrip(const pixel* fenc, intptr_t fencstride, const pixel* const* fref, int x, intptr_t frefstride, __m256i* sum)
+{
+    for (int y = 0; y < ly; y += 32 / w)
+    {
+        __m256i e = loadStrip<w>(fenc + y * fencstride + x, fencstride);
+        for (int i = 0; i < N; i++)
+            sum[i] = _mm256_add_epi32(sum[i], _mm256_sad_epu8(e, loadStrip<w>(fref[i] + y * frefstride + x, frefstride)));
+    }
+}
+
+/* SADs of one block, 16 48 or 64 wide, against N references */
+template<int lx, int ly, int N>
+static inline void sadBlock(const pixel* fenc, intptr_t fencstride, const pixel* const* fref, intptr_t frefstride, int32_t* res)
+{
+    __m256i sum[N];
+    for (int i = 0; i < N; i++)
+        sum[i] = _mm256_setzero_si256();
+
+    for (int x = 0; x + 32 <= lx; x += 32)
+        sadStrip<32, ly, N>(fenc, fencstride, fref, x, frefstride, sum);
+    if (lx & 16)
+        sadStrip<16, ly, N>(fenc, fencstride, fref, lx & ~31, frefstride, sum);
+
+    for (int i = 0; i < N; i++)
+    {
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum[i]), _mm256_extracti128_si256(sum[i], 1));
+        res[i] = _mm_cvtsi128_si32(s) + _mm_extract_epi32(s, 2);
+    }
+}
+
+template<int lx, int ly>
+int sad_avx2(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    int32_t res;
+    sadBlock<lx, ly, 1>(fenc, fencstride, &fref, frefstride, &res);
+    return res;
+}
+
+template<int lx, int ly>
+void sad_x3_avx2(const pixel* fenc, const pixel* fref0, const pixel* fref1, const pixel* fref2, intptr_t frefstride, int32_t* res)
+{
+    const pixel* fref[3] = { fref0, fref1, fref2 };
+    sadBlock<lx, ly, 3>(fenc, FENC_STRIDE, fref, frefstride, res);
+}
+
+template<int lx, int ly>
+void sad_x4_avx2(const pixel* fenc, const pixel* fref0, const pixel* fref1, const pixel* fref2, const pixel* fref3, intptr_t frefstride, int32_t* res)
+{
+    const pixel* fref[4] = { fref0, fref1, fref2, fref3 };
+    sadBlock<lx, ly, 4>(fenc, FENC_STRIDE, fref, frefstride, res);
+}
+
+template<int lx, int ly>
+void sad_x8_avx2(const pixel* fenc, const pixel* const* fref, intptr_t frefstride, int32_t* res)
+{
+    sadBlock<lx, ly, 8>(fenc, FENC_STRIDE, fref, frefstride, res);
+}
+
+static inline void butterfly(__m256i& a, __m256i& b)
+{
+    __m256i t = a;
+    a = _mm256_add_epi16(t, b);
+    b = _mm256_sub_epi16(t, b);
+}
+
+static inline void hadamard4(__m256i* v)
+{
+    butterfly(v[0], v[1]);
+    butterfly(v[2], v[3]);
+    butterfly(v[0], v[2]);
+    butterfly(v[1], v[3]);
+}
+
+/* residual of 16 pixels as int16, pixels 0-7 in the low lane */
+static inline __m256i diff16(const pixel* fenc, const pixel* fref)
+{
+    return _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)fenc)),
+                            _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)fref)));
+}
+
+static inline int horizontalSum(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 8));
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 4));
+    return _mm_cvtsi128_si32(s);
+}
+
+/* sum of the absolute 4x4 Hadamard coefficients of the residual of a 16x4
+ * block, each 128-bit lane transforms one 8x4 half like the SSE4.1 version */
+static inline __m256i satdSum16x4(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m256i d[4], t[4];
+    for (int i = 0; i < 4; i++)
+        d[i] = diff16(fenc + i * fencstride, fref + i * frefstride);
+    hadamard4(d);
+
+    __m256i a0 = _mm256_unpacklo_epi16(d[0], d[1]);
+    __m256i a1 = _mm256_unpackhi_epi16(d[0], d[1]);
+    __m256i a2 = _mm256_unpacklo_epi16(d[2], d[3]);
+    __m256i a3 = _mm256_unpackhi_epi16(d[2], d[3]);
+    __m256i b0 = _mm256_unpacklo_epi32(a0, a2);
+    __m256i b1 = _mm256_unpackhi_epi32(a0, a2);
+    __m256i b2 = _mm256_unpacklo_epi32(a1, a3);
+    __m256i b3 = _mm256_unpackhi_epi32(a1, a3);
+    t[0] = _mm256_unpacklo_epi64(b0, b2);
+    t[1] = _mm256_unpackhi_epi64(b0, b2);
+    t[2] = _mm256_unpacklo_epi64(b1, b3);
+    t[3] = _mm256_unpackhi_epi64(b1, b3);
+    hadamard4(t);
+
+    __m256i s = _mm256_add_epi16(_mm256_add_epi16(_mm256_abs_epi16(t[0]), _mm256_abs_epi16(t[1])),
+                                 _mm256_add_epi16(_mm256_abs_epi16(t[2]), _mm256_abs_epi16(t[3])));
+    return _mm256_madd_epi16(s, _mm256_set1_epi16(1));
+}
+
+/* the sum of each 4x4 block is even, so the whole block is halved once */
+template<int lx, int ly>
+int satd_avx2(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m256i sum = _mm256_setzero_si256();
+    for (int y = 0; y < ly; y += 4)
+        for (int x = 0; x < lx; x += 16)
+            sum = _mm256_add_epi32(sum, satdSum16x4(fenc + y * fencstride + x, fencstride, fref + y * frefstride + x, frefstride));
+
+    return horizontalSum(sum) >> 1;
+}
+
+/* sum of the absolute 8x8 Hadamard coefficients of the residual of the two
+ * 8x8 blocks of a 16x8 block, one per 128-bit lane */
+static inline __m256i sa8dSum16x8(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m256i d[8], t[8];
+    for (int i = 0; i < 8; i++)
+        d[i] = diff16(fenc + i * fencstride, fref + i * frefstride);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        hadamard4(d);
+        hadamard4(d + 4);
+        for (int i = 0; i < 4; i++)
+            butterfly(d[i], d[i + 4]);
+
+        if (pass)
+            break;
+
+        __m256i a[8], b[8];
+        for (int i = 0; i < 4; i++)
+        {
+            a[2 * i] = _mm256_unpacklo_epi16(d[2 * i], d[2 * i + 1]);
+            a[2 * i + 1] = _mm256_unpackhi_epi16(d[2 * i], d[2 * i + 1]);
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            b[4 * i + 0] = _mm256_unpacklo_epi32(a[4 * i + 0], a[4 * i + 2]);
+            b[4 * i + 1] = _mm256_unpackhi_epi32(a[4 * i + 0], a[4 * i + 2]);
+            b[4 * i + 2] = _mm256_unpacklo_epi32(a[4 * i + 1], a[4 * i + 3]);
+            b[4 * i + 3] = _mm256_unpackhi_epi32(a[4 * i + 1], a[4 * i + 3]);
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            t[2 * i] = _mm256_unpacklo_epi64(b[i], b[i + 4]);
+            t[2 * i + 1] = _mm256_unpackhi_epi64(b[i], b[i + 4]);
+        }
+        for (int i = 0; i < 8; i++)
+            d[i] = t[i];
+    }
+
+    __m256i one = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < 8; i++)
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_abs_epi16(d[i]), one));
+
+    return sum;
+}
+
+/* rounded once per 16x16 block, like the C reference */
+template<int size>
+int sa8d_avx2(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    int cost = 0;
+    for (int y = 0; y < size; y += 16)
+    {
+        for (int x = 0; x < size; x += 16)
+        {
+            const pixel* e = fenc + y * fencstride + x;
+            const pixel* r = fref + y * frefstride + x;
+            __m256i sum = _mm256_add_epi32(sa8dSum16x8(e, fencstride, r, frefstride),
+                                           sa8dSum16x8(e + 8 * fencstride, fencstride, r + 8 * frefstride, frefstride));
+            cost += (horizontalSum(sum) + 2) >> 2;
+        }
+    }
+
+    return cost;
+}
+
+/* Byte shuffles pairing each of 8 output positions of a 128-bit lane with the
+ * source samples of one pair of filter taps, for use with maddubs */
+static const int8_t s_tapPairs[4][16] =
+{
+    { 0, 1, 1, 2, 2, 3, 3, 4, 4, 5,  5,  6,  6,  7,  7,  8 },
+    { 2, 3, 3, 4, 4, 5, 5, 6, 6, 7,  7,  8,  8,  9,  9, 10 },
+    { 4, 5, 5, 6, 6, 7, 7, 8, 8, 9,  9, 10, 10, 11, 11, 12 },
+    { 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14 },
+};
+
+static inline __m256i tapPair(const int16_t* coeff, int k)
+{
+    return _mm256_set1_epi16((int16_t)((coeff[k + 1] << 8) | (uint8_t)coeff[k]));
+}
+
+/* rounded and clipped 8-tap sums of 16 outputs, 8 per 128-bit lane */
+static inline __m128i filterRow16(__m256i src, const __m256i shuf[4], const __m256i c[4], __m256i offset)
+{
+    __m256i sum = _mm256_maddubs_epi16(_mm256_shuffle_epi8(src, shuf[0]), c[0]);
+    sum = _mm256_add_epi16(sum, _mm256_maddubs_epi16(_mm256_shuffle_epi8(src, shuf[1]), c[1]));
+    sum = _mm256_add_epi16(sum, _mm256_maddubs_epi16(_mm256_shuffle_epi8(src, shuf[2]), c[2]));
+    sum = _mm256_add_epi16(sum, _mm256_maddubs_epi16(_mm256_shuffle_epi8(src, shuf[3]), c[3]));
+    sum = _mm256_srai_epi16(_mm256_add_epi16(sum, offset), IF_FILTER_PREC);
+    return _mm_packus_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+}
+
+/* like the assembly, the last load of a row may read 5 pixels past the last
+ * source sample of the C reference, which lie in the picture margin */
+template<int width, int height>
+void interp_horiz_pp_avx2(const pixel* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int coeffIdx)
+{
+    const int16_t* coeff = g_lumaFilter[coeffIdx];
+    __m256i shuf[4], c[4];
+    for (int k = 0; k < 4; k++)
+    {
+        shuf[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)s_tapPairs[k]));
+        c[k] = tapPair(coeff, 2 * k);
+    }
+    const __m256i offset = _mm256_set1_epi16(1 << (IF_FILTER_PREC - 1));
+
+    src -= 3;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x += 16)
+            _mm_storeu_si128((__m128i*)(dst + x), filterRow16(load2x128(src + x, src + x + 8), shuf, c, offset));
+
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+template<int width, int height>
+void interp_vert_pp_avx2(const pixel* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int coeffIdx)
+{
+    const int16_t* coeff = g_lumaFilter[coeffIdx];
+    const __m256i c[4] = { tapPair(coeff, 0), tapPair(coeff, 2), tapPair(coeff, 4), tapPair(coeff, 6) };
+    const __m256i offset = _mm256_set1_epi16(1 << (IF_FILTER_PREC - 1));
+
+    src -= 3 * srcStride;
+    for (int y = 0; y < height; y++)
+    {
+        int x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            /* the in-lane unpacks and pack keep the outputs in order */
+            __m256i lo = _mm256_setzero_si256();
+            __m256i hi = _mm256_setzero_si256();
+            for (int k = 0; k < 8; k += 2)
+            {
+                __m256i r0 = _mm256_loadu_si256((const __m256i*)(src + k * srcStride + x));
+                __m256i r1 = _mm256_loadu_si256((const __m256i*)(src + (k + 1) * srcStride + x));
+                lo = _mm256_add_epi16(lo, _mm256_maddubs_epi16(_mm256_unpacklo_epi8(r0, r1), c[k >> 1]));
+                hi = _mm256_add_epi16(hi, _mm256_maddubs_epi16(_mm256_unpackhi_epi8(r0, r1), c[k >> 1]));
+            }
+            lo = _mm256_srai_epi16(_mm256_add_epi16(lo, offset), IF_FILTER_PREC);
+            hi = _mm256_srai_epi16(_mm256_add_epi16(hi, offset), IF_FILTER_PREC);
+            _mm256_storeu_si256((__m256i*)(dst + x), _mm256_packus_epi16(lo, hi));
+        }
+        if (width & 16)
+        {
+            /* columns 0-7 from the low lane, 8-15 from the high lane */
+            __m256i sum = _mm256_setzero_si256();
+            for (int k = 0; k < 8; k += 2)
+            {
+                __m128i r0 = _mm_loadu_si128((const __m128i*)(src + k * srcStride + x));
+                __m128i r1 = _mm_loadu_si128((const __m128i*)(src + (k + 1) * srcStride + x));
+                __m256i pairs = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(r0, r1)), _mm_unpackhi_epi8(r0, r1), 1);
+                sum = _mm256_add_epi16(sum, _mm256_maddubs_epi16(pairs, c[k >> 1]));
+            }
+            sum = _mm256_srai_epi16(_mm256_add_epi16(sum, offset), IF_FILTER_PREC);
+            _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)));
+        }
+
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+#endif // !HIGH_BIT_DEPTH
+
+} // end anonymous namespace
+
+namespace X265_NS {
+void setupIntrinsicPixel_avx2(EncoderPrimitives &p)
+{
+#if !HIGH_BIT_DEPTH
+    /* the blocks which are a multiple of 16 pixels wide, narrower blocks keep
+     * the SSE4.1 primitives */
+#define LUMA_PU(W, H) \
+    p.pu[LUMA_ ## W ## x ## H].sad = sad_avx2<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_x3 = sad_x3_avx2<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_x4 = sad_x4_avx2<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_x8 = sad_x8_avx2<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].satd = satd_avx2<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].luma_hpp = interp_horiz_pp_avx2<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].luma_vpp = interp_vert_pp_avx2<W, H>
+
+    LUMA_PU(16, 4);  LUMA_PU(16, 8);  LUMA_PU(16, 12); LUMA_PU(16, 16); LUMA_PU(16, 32); LUMA_PU(16, 64);
+    LUMA_PU(32, 8);  LUMA_PU(32, 16); LUMA_PU(32, 24); LUMA_PU(32, 32); LUMA_PU(32, 64);
+    LUMA_PU(48, 64);
+    LUMA_PU(64, 16); LUMA_PU(64, 32); LUMA_PU(64, 48); LUMA_PU(64, 64);
+#undef LUMA_PU
+
+    p.cu[BLOCK_16x16].sa8d = sa8d_avx2<16>;
+    p.cu[BLOCK_32x32].sa8d = sa8d_avx2<32>;
+    p.cu[BLOCK_64x64].sa8d = sa8d_avx2<64>;
+#else
+    (void)p;
+#endif
+}
+}
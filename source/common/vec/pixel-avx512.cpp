@@ -0,0 +1,934 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#if defined(__GNUC__) && !defined(__clang__)
+/* gcc's headers pass self-initialized _mm512_undefined_*() vectors as the
+ * merge source of unmasked intrinsics */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h> // AVX-512
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+using namespace X265_NS;
+
+namespace {
+// anonymous file-static namespace
+
+#if !HIGH_BIT_DEPTH
+
+/* mask of the first n byte (or word) lanes of a vector, n may exceed 64 */
+static inline __mmask64 firstLanes(int n)
+{
+    return n >= 64 ? ~(__mmask64)0 : n <= 0 ? 0 : ((__mmask64)1 << n) - 1;
+}
+
+/* 64 pixels of a 64 or 48 wide block row, or 2 rows of a 32 wide block, or
+ * 4 rows of a 16 wide block */
+template<int lx>
+static inline __m512i loadRows(const pixel* p, intptr_t stride)
+{
+    if (lx == 64)
+        return _mm512_loadu_si512(p);
+    else if (lx == 48)
+        return _mm512_maskz_loadu_epi8(firstLanes(48), p);
+    else if (lx == 32)
+        return _mm512_inserti64x4(_mm512_castsi256_si512(_mm256_loadu_si256((const __m256i*)p)),
+                                  _mm256_loadu_si256((const __m256i*)(p + stride)), 1);
+    else
+    {
+        __m512i v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)p));
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + stride)), 1);
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + 2 * stride)), 2);
+        return _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*)(p + 3 * stride)), 3);
+    }
+}
+
+template<int lx, int ly>
+int sad_avx512(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    const int rows = lx == 32 ? 2 : lx == 16 ? 4 : 1;
+    __m512i sum = _mm512_setzero_si512();
+
+    for (int y = 0; y < ly; y += rows)
+    {
+        __m512i e = loadRows<lx>(fenc, fencstride);
+        sum = _mm512_add_epi64(sum, _mm512_sad_epu8(e, loadRows<lx>(fref, frefstride)));
+        fenc += rows * fencstride;
+        fref += rows * frefstride;
+    }
+
+    return (int)_mm512_reduce_add_epi64(sum);
+}
+
+template<int lx, int ly>
+void sad_x3_avx512(const pixel* fenc, const pixel* fref0, const pixel* fref1, const pixel* fref2, intptr_t frefstride, int32_t* res)
+{
+    const int rows = lx == 32 ? 2 : lx == 16 ? 4 : 1;
+    __m512i sum0 = _mm512_setzero_si512();
+    __m512i sum1 = _mm512_setzero_si512();
+    __m512i sum2 = _mm512_setzero_si512();
+
+    for (int y = 0; y < ly; y += rows)
+    {
+        __m512i e = loadRows<lx>(fenc, FENC_STRIDE);
+        sum0 = _mm512_add_epi64(sum0, _mm512_sad_epu8(e, loadRows<lx>(fref0, frefstride)));
+        sum1 = _mm512_add_epi64(sum1, _mm512_sad_epu8(e, loadRows<lx>(fref1, frefstride)));
+        sum2 = _mm512_add_epi64(sum2, _mm512_sad_epu8(e, loadRows<lx>(fref2, frefstride)));
+        fenc += rows * FENC_STRIDE;
+        fref0 += rows * frefstride;
+        fref1 += rows * frefstride;
+        fref2 += rows * frefstride;
+    }
+
+    res[0] = (int32_t)_mm512_reduce_add_epi64(sum0);
+    res[1] = (int32_t)_mm512_reduce_add_epi64(sum1);
+    res[2] = (int32_t)_mm512_reduce_add_epi64(sum2);
+}
+
+template<int lx, int ly>
+void sad_x4_avx512(const pixel* fenc, const pixel* fref0, const pixel* fref1, const pixel* fref2, const pixel* fref3, intptr_t frefstride, int32_t* res)
+{
+    const int rows = lx == 32 ? 2 : lx == 16 ? 4 : 1;
+    __m512i sum0 = _mm512_setzero_si512();
+    __m512i sum1 = _mm512_setzero_si512();
+    __m512i sum2 = _mm512_setzero_si512();
+    __m512i sum3 = _mm512_setzero_si512();
+
+    for (int y = 0; y < ly; y += rows)
+    {
+        __m512i e = loadRows<lx>(fenc, FENC_STRIDE);
+        sum0 = _mm512_add_epi64(sum0, _mm512_sad_epu8(e, loadRows<lx>(fref0, frefstride)));
+        sum1 = _mm512_add_epi64(sum1, _mm512_sad_epu8(e, loadRows<lx>(fref1, frefstride)));
+        sum2 = _mm512_add_epi64(sum2, _mm512_sad_epu8(e, loadRows<lx>(fref2, frefstride)));
+        sum3 = _mm512_add_epi64(sum3, _mm512_sad_epu8(e, loadRows<lx>(fref3, frefstride)));
+        fenc += rows * FENC_STRIDE;
+        fref0 += rows * frefstride;
+        fref1 += rows * frefstride;
+        fref2 += rows * frefstride;
+        fref3 += rows * frefstride;
+    }
+
+    res[0] = (int32_t)_mm512_reduce_add_epi64(sum0);
+    res[1] = (int32_t)_mm512_reduce_add_epi64(sum1);
+    res[2] = (int32_t)_mm512_reduce_add_epi64(sum2);
+    res[3] = (int32_t)_mm512_reduce_add_epi64(sum3);
+}
+
+/* Hadamard transform of the 4x4 blocks held in four rows of 32 differences,
+ * returns the absolute coefficients summed in pairs. The order and signs of
+ * the coefficients differ from the C reference, their absolute sum does not */
+static inline __m512i hadamard4x4(__m512i d0, __m512i d1, __m512i d2, __m512i d3)
+{
+    __m512i a0 = _mm512_add_epi16(d0, d1);
+    __m512i a1 = _mm512_sub_epi16(d0, d1);
+    __m512i a2 = _mm512_add_epi16(d2, d3);
+    __m512i a3 = _mm512_sub_epi16(d2, d3);
+    __m512i b[4] = { _mm512_add_epi16(a0, a2), _mm512_sub_epi16(a0, a2), _mm512_add_epi16(a1, a3), _mm512_sub_epi16(a1, a3) };
+    __m512i sum = _mm512_setzero_si512();
+
+    for (int i = 0; i < 4; i++)
+    {
+        /* butterflies between adjacent columns, then columns two apart */
+        __m512i s = _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(b[i], 0xB1), 0xB1);
+        __m512i t = _mm512_mask_sub_epi16(_mm512_add_epi16(b[i], s), 0xAAAAAAAA, s, b[i]);
+        s = _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(t, 0x4E), 0x4E);
+        t = _mm512_mask_sub_epi16(_mm512_add_epi16(t, s), 0xCCCCCCCC, s, t);
+        sum = _mm512_add_epi16(sum, _mm512_abs_epi16(t));
+    }
+
+    return _mm512_madd_epi16(sum, _mm512_set1_epi16(1));
+}
+
+static inline __m512i diff32(const pixel* fenc, const pixel* fref)
+{
+    __m512i e = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)fenc));
+    __m512i r = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)fref));
+    return _mm512_sub_epi16(e, r);
+}
+
+/* differences of a 16 pixel row and of the row gap rows below it */
+template<int gap>
+static inline __m512i diff16x2(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m256i e = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)fenc)),
+                                        _mm_loadu_si128((const __m128i*)(fenc + gap * fencstride)), 1);
+    __m256i r = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)fref)),
+                                        _mm_loadu_si128((const __m128i*)(fref + gap * frefstride)), 1);
+    return _mm512_sub_epi16(_mm512_cvtepu8_epi16(e), _mm512_cvtepu8_epi16(r));
+}
+
+/* every 4x4 Hadamard coefficient has the parity of the sum of the block, so
+ * the absolute sums are even and halving the total matches the C reference
+ * which halves per 4x4 or 8x4 block */
+template<int lx, int ly>
+int satd_avx512(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m512i sum = _mm512_setzero_si512();
+
+    if (lx == 16)
+    {
+        for (int y = 0; y < ly; y += 8)
+        {
+            __m512i d0 = diff16x2<4>(fenc, fencstride, fref, frefstride);
+            __m512i d1 = diff16x2<4>(fenc + fencstride, fencstride, fref + frefstride, frefstride);
+            __m512i d2 = diff16x2<4>(fenc + 2 * fencstride, fencstride, fref + 2 * frefstride, frefstride);
+            __m512i d3 = diff16x2<4>(fenc + 3 * fencstride, fencstride, fref + 3 * frefstride, frefstride);
+            sum = _mm512_add_epi32(sum, hadamard4x4(d0, d1, d2, d3));
+            fenc += 8 * fencstride;
+            fref += 8 * frefstride;
+        }
+    }
+    else
+    {
+        for (int y = 0; y < ly; y += 4)
+        {
+            for (int x = 0; x < lx; x += 32)
+            {
+                __m512i d0 = diff32(fenc + x, fref + x);
+                __m512i d1 = diff32(fenc + fencstride + x, fref + frefstride + x);
+                __m512i d2 = diff32(fenc + 2 * fencstride + x, fref + 2 * frefstride + x);
+                __m512i d3 = diff32(fenc + 3 * fencstride + x, fref + 3 * frefstride + x);
+                sum = _mm512_add_epi32(sum, hadamard4x4(d0, d1, d2, d3));
+            }
+            fenc += 4 * fencstride;
+            fref += 4 * frefstride;
+        }
+    }
+
+    return _mm512_reduce_add_epi32(sum) >> 1;
+}
+
+static inline void butterfly(__m512i& a, __m512i& b)
+{
+    __m512i t = a;
+    a = _mm512_add_epi16(t, b);
+    b = _mm512_sub_epi16(t, b);
+}
+
+/* sums of the absolute 8x8 Hadamard coefficients of the four 8x8 blocks held
+ * in eight rows of 32 differences, one block per 128-bit lane */
+static inline __m512i hadamard8x8(__m512i* d)
+{
+    for (int pass = 0; pass < 2; pass++)
+    {
+        butterfly(d[0], d[1]);
+        butterfly(d[2], d[3]);
+        butterfly(d[4], d[5]);
+        butterfly(d[6], d[7]);
+        butterfly(d[0], d[2]);
+        butterfly(d[1], d[3]);
+        butterfly(d[4], d[6]);
+        butterfly(d[5], d[7]);
+        for (int i = 0; i < 4; i++)
+            butterfly(d[i], d[i + 4]);
+
+        if (pass)
+            break;
+
+        /* transpose the 8x8 block of each 128-bit lane */
+        __m512i a[8], b[8];
+        for (int i = 0; i < 4; i++)
+        {
+            a[2 * i] = _mm512_unpacklo_epi16(d[2 * i], d[2 * i + 1]);
+            a[2 * i + 1] = _mm512_unpackhi_epi16(d[2 * i], d[2 * i + 1]);
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            b[4 * i + 0] = _mm512_unpacklo_epi32(a[4 * i + 0], a[4 * i + 2]);
+            b[4 * i + 1] = _mm512_unpackhi_epi32(a[4 * i + 0], a[4 * i + 2]);
+            b[4 * i + 2] = _mm512_unpacklo_epi32(a[4 * i + 1], a[4 * i + 3]);
+            b[4 * i + 3] = _mm512_unpackhi_epi32(a[4 * i + 1], a[4 * i + 3]);
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            d[2 * i] = _mm512_unpacklo_epi64(b[i], b[i + 4]);
+            d[2 * i + 1] = _mm512_unpackhi_epi64(b[i], b[i + 4]);
+        }
+    }
+
+    /* a coefficient fits 15 bits, so two of them may be added before
+     * widening */
+    const __m512i ones = _mm512_set1_epi16(1);
+    __m512i sum = _mm512_setzero_si512();
+    for (int i = 0; i < 8; i += 2)
+        sum = _mm512_add_epi32(sum, _mm512_madd_epi16(_mm512_add_epi16(_mm512_abs_epi16(d[i]), _mm512_abs_epi16(d[i + 1])), ones));
+
+    return sum;
+}
+
+/* rounded once per 16x16 block, like the C reference. A 16 wide block keeps
+ * rows 8 to 15 in the upper half of each vector */
+template<int size>
+int sa8d_avx512(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m512i d[8];
+
+    if (size == 16)
+    {
+        for (int i = 0; i < 8; i++)
+            d[i] = diff16x2<8>(fenc + i * fencstride, fencstride, fref + i * frefstride, frefstride);
+        return (_mm512_reduce_add_epi32(hadamard8x8(d)) + 2) >> 2;
+    }
+
+    int cost = 0;
+    for (int y = 0; y < size; y += 16)
+    {
+        for (int x = 0; x < size; x += 32)
+        {
+            for (int i = 0; i < 8; i++)
+                d[i] = diff32(fenc + i * fencstride + x, fref + i * frefstride + x);
+            __m512i sum = hadamard8x8(d);
+            for (int i = 0; i < 8; i++)
+                d[i] = diff32(fenc + (i + 8) * fencstride + x, fref + (i + 8) * frefstride + x);
+            sum = _mm512_add_epi32(sum, hadamard8x8(d));
+
+            cost += (_mm512_mask_reduce_add_epi32(0x00FF, sum) + 2) >> 2;
+            cost += (_mm512_mask_reduce_add_epi32(0xFF00, sum) + 2) >> 2;
+        }
+        fenc += 16 * fencstride;
+        fref += 16 * frefstride;
+    }
+
+    return cost;
+}
+
+/* Byte shuffles pairing each of 8 output positions of a 128-bit lane with the
+ * source samples of one pair of filter taps, for use with maddubs */
+static const int8_t s_tapPairs[4][16] =
+{
+    { 0, 1, 1, 2, 2, 3, 3, 4, 4, 5,  5,  6,  6,  7,  7,  8 },
+    { 2, 3, 3, 4, 4, 5, 5, 6, 6, 7,  7,  8,  8,  9,  9, 10 },
+    { 4, 5, 5, 6, 6, 7, 7, 8, 8, 9,  9, 10, 10, 11, 11, 12 },
+    { 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14 },
+};
+
+static inline __m512i tapPair(const int16_t* coeff, int k)
+{
+    return _mm512_set1_epi16((int16_t)((coeff[k + 1] << 8) | (uint8_t)coeff[k]));
+}
+
+/* 8-tap horizontal filter sums, as int16, of 8 outputs per 128-bit lane. The
+ * lanes of src hold the 15 source samples of each group of outputs */
+static inline __m512i filterRow8(__m512i src, const __m512i shuf[4], const __m512i c[4])
+{
+    __m512i sum = _mm512_maddubs_epi16(_mm512_shuffle_epi8(src, shuf[0]), c[0]);
+    sum = _mm512_add_epi16(sum, _mm512_maddubs_epi16(_mm512_shuffle_epi8(src, shuf[1]), c[1]));
+    sum = _mm512_add_epi16(sum, _mm512_maddubs_epi16(_mm512_shuffle_epi8(src, shuf[2]), c[2]));
+    return _mm512_add_epi16(sum, _mm512_maddubs_epi16(_mm512_shuffle_epi8(src, shuf[3]), c[3]));
+}
+
+/* Horizontal filter sums of up to 64 outputs starting at src + 3, returned as
+ * outputs 16j..16j+7 (lo) and 16j+8..16j+15 (hi) in lane j. Only the source
+ * samples the C reference reads are loaded */
+static inline void filterRowH(const pixel* src, int n, const __m512i shuf[4], const __m512i c[4], __m512i& lo, __m512i& hi)
+{
+    lo = filterRow8(_mm512_maskz_loadu_epi8(firstLanes(n + 7), src), shuf, c);
+    hi = filterRow8(_mm512_maskz_loadu_epi8(firstLanes(n - 1), src + 8), shuf, c);
+}
+
+static inline void setupFilterH(int coeffIdx, __m512i shuf[4], __m512i c[4])
+{
+    const int16_t* coeff = g_lumaFilter[coeffIdx];
+    for (int k = 0; k < 4; k++)
+    {
+        shuf[k] = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)s_tapPairs[k]));
+        c[k] = tapPair(coeff, 2 * k);
+    }
+}
+
+template<int width, int height>
+void interp_horiz_pp_avx512(const pixel* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int coeffIdx)
+{
+    __m512i shuf[4], c[4];
+    setupFilterH(coeffIdx, shuf, c);
+    const __m512i offset = _mm512_set1_epi16(1 << (IF_FILTER_PREC - 1));
+
+    src -= 3;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x += 64)
+        {
+            int n = X265_MIN(64, width - x);
+            __m512i lo, hi;
+            filterRowH(src + x, n, shuf, c, lo, hi);
+            lo = _mm512_srai_epi16(_mm512_add_epi16(lo, offset), IF_FILTER_PREC);
+            hi = _mm512_srai_epi16(_mm512_add_epi16(hi, offset), IF_FILTER_PREC);
+            _mm512_mask_storeu_epi8(dst + x, firstLanes(n), _mm512_packus_epi16(lo, hi));
+        }
+
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+template<int width, int height>
+void interp_vert_pp_avx512(const pixel* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int coeffIdx)
+{
+    const int16_t* coeff = g_lumaFilter[coeffIdx];
+    const __m512i c[4] = { tapPair(coeff, 0), tapPair(coeff, 2), tapPair(coeff, 4), tapPair(coeff, 6) };
+    const __m512i offset = _mm512_set1_epi16(1 << (IF_FILTER_PREC - 1));
+
+    src -= 3 * srcStride;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x += 64)
+        {
+            __mmask64 m = firstLanes(width - x);
+            __m512i lo = _mm512_setzero_si512();
+            __m512i hi = _mm512_setzero_si512();
+            for (int k = 0; k < 8; k += 2)
+            {
+                __m512i r0 = _mm512_maskz_loadu_epi8(m, src + k * srcStride + x);
+                __m512i r1 = _mm512_maskz_loadu_epi8(m, src + (k + 1) * srcStride + x);
+                lo = _mm512_add_epi16(lo, _mm512_maddubs_epi16(_mm512_unpacklo_epi8(r0, r1), c[k >> 1]));
+                hi = _mm512_add_epi16(hi, _mm512_maddubs_epi16(_mm512_unpackhi_epi8(r0, r1), c[k >> 1]));
+            }
+            lo = _mm512_srai_epi16(_mm512_add_epi16(lo, offset), IF_FILTER_PREC);
+            hi = _mm512_srai_epi16(_mm512_add_epi16(hi, offset), IF_FILTER_PREC);
+            _mm512_mask_storeu_epi8(dst + x, m, _mm512_packus_epi16(lo, hi));
+        }
+
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+/* horizontal then vertical filtering through an int16 intermediate, the same
+ * arithmetic as interp_horiz_ps followed by filterVertical_sp */
+template<int width, int height>
+void interp_hv_pp_avx512(const pixel* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int idxX, int idxY)
+{
+    ALIGN_VAR_32(int16_t, immed[(height + 7) * 64]);
+
+    __m512i shuf[4], c[4];
+    setupFilterH(idxX, shuf, c);
+    const __m512i internalOffset = _mm512_set1_epi16(IF_INTERNAL_OFFS);
+    const __m512i order0 = _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0);
+    const __m512i order1 = _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4);
+
+    /* for 8-bit pixels the horizontal pass has no shift, only the offset */
+    src -= 3 * srcStride + 3;
+    for (int y = 0; y < height + 7; y++)
+    {
+        for (int x = 0; x < width; x += 64)
+        {
+            int n = X265_MIN(64, width - x);
+            __m512i lo, hi;
+            filterRowH(src + x, n, shuf, c, lo, hi);
+            lo = _mm512_sub_epi16(lo, internalOffset);
+            hi = _mm512_sub_epi16(hi, internalOffset);
+            _mm512_mask_storeu_epi16(immed + y * 64 + x, (__mmask32)firstLanes(n), _mm512_permutex2var_epi64(lo, order0, hi));
+            if (n > 32)
+                _mm512_mask_storeu_epi16(immed + y * 64 + x + 32, (__mmask32)firstLanes(n - 32), _mm512_permutex2var_epi64(lo, order1, hi));
+        }
+        src += srcStride;
+    }
+
+    const int16_t* coeff = g_lumaFilter[idxY];
+    __m512i cv[4];
+    for (int k = 0; k < 4; k++)
+        cv[k] = _mm512_set1_epi32((coeff[2 * k + 1] << 16) | (uint16_t)coeff[2 * k]);
+    const int shift = IF_FILTER_PREC + IF_INTERNAL_PREC - X265_DEPTH;
+    const __m512i offset = _mm512_set1_epi32((1 << (shift - 1)) + (IF_INTERNAL_OFFS << IF_FILTER_PREC));
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x += 32)
+        {
+            const int16_t* t = immed + y * 64 + x;
+            __m512i lo = offset;
+            __m512i hi = offset;
+            for (int k = 0; k < 8; k += 2)
+            {
+                __m512i r0 = _mm512_loadu_si512(t + k * 64);
+                __m512i r1 = _mm512_loadu_si512(t + (k + 1) * 64);
+                lo = _mm512_add_epi32(lo, _mm512_madd_epi16(_mm512_unpacklo_epi16(r0, r1), cv[k >> 1]));
+                hi = _mm512_add_epi32(hi, _mm512_madd_epi16(_mm512_unpackhi_epi16(r0, r1), cv[k >> 1]));
+            }
+            __m512i v = _mm512_packs_epi32(_mm512_srai_epi32(lo, shift), _mm512_srai_epi32(hi, shift));
+            v = _mm512_max_epi16(v, _mm512_setzero_si512());
+            _mm256_mask_storeu_epi8(dst + x, (__mmask32)firstLanes(width - x), _mm512_cvtusepi16_epi8(v));
+        }
+        dst += dstStride;
+    }
+}
+
+/* SAO::s_eoTable, the edge class of each edge type */
+static const int s_eoTable[5] = { 1, 2, 0, 3, 4 };
+
+/* add the diffs and counts of one row of up to 64 samples per edge type */
+static inline void saoEdgeStats(__m512i edgeType, __mmask64 m, const int16_t* diff, __m512i stats[5], int32_t count[5])
+{
+    __m512i d0 = _mm512_maskz_loadu_epi16((__mmask32)m, diff);
+    __m512i d1 = _mm512_maskz_loadu_epi16((__mmask32)(m >> 32), diff + 32);
+    const __m512i ones = _mm512_set1_epi16(1);
+
+    for (int i = 0; i < 5; i++)
+    {
+        __mmask64 mt = _mm512_mask_cmpeq_epi8_mask(m, edgeType, _mm512_set1_epi8((char)i));
+        __m512i d = _mm512_add_epi16(_mm512_maskz_mov_epi16((__mmask32)mt, d0), _mm512_maskz_mov_epi16((__mmask32)(mt >> 32), d1));
+        stats[i] = _mm512_add_epi32(stats[i], _mm512_madd_epi16(d, ones));
+        count[i] += _mm_popcnt_u32((uint32_t)mt) + _mm_popcnt_u32((uint32_t)(mt >> 32));
+    }
+}
+
+/* adds 1 where a > b and subtracts 1 where a < b */
+static inline __m512i addSign(__m512i v, __m512i a, __m512i b)
+{
+    const __m512i one = _mm512_set1_epi8(1);
+    v = _mm512_mask_add_epi8(v, _mm512_cmpgt_epu8_mask(a, b), v, one);
+    return _mm512_mask_sub_epi8(v, _mm512_cmplt_epu8_mask(a, b), v, one);
+}
+
+static inline void saoFinish(const __m512i tmpStats[5], const int32_t tmpCount[5], int32_t* stats, int32_t* count)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        stats[s_eoTable[i]] += _mm512_reduce_add_epi32(tmpStats[i]);
+        count[s_eoTable[i]] += tmpCount[i];
+    }
+}
+
+void saoCuStatsE0_avx512(const int16_t *diff, const pixel *rec, intptr_t stride, int endX, int endY, int32_t *stats, int32_t *count)
+{
+    X265_CHECK(endX <= MAX_CU_SIZE, "endX too big\n");
+
+    __m512i tmpStats[5];
+    int32_t tmpCount[5] = { 0 };
+    for (int i = 0; i < 5; i++)
+        tmpStats[i] = _mm512_setzero_si512();
+
+    __mmask64 m = firstLanes(endX);
+    for (int y = 0; y < endY; y++)
+    {
+        __m512i r = _mm512_maskz_loadu_epi8(m, rec);
+        __m512i edgeType = addSign(_mm512_set1_epi8(2), r, _mm512_maskz_loadu_epi8(m, rec - 1));
+        edgeType = addSign(edgeType, r, _mm512_maskz_loadu_epi8(m, rec + 1));
+        saoEdgeStats(edgeType, m, diff, tmpStats, tmpCount);
+
+        diff += MAX_CU_SIZE;
+        rec += stride;
+    }
+
+    saoFinish(tmpStats, tmpCount, stats, count);
+}
+
+void saoCuStatsE1_avx512(const int16_t *diff, const pixel *rec, intptr_t stride, int8_t *upBuff1, int endX, int endY, int32_t *stats, int32_t *count)
+{
+    X265_CHECK(endX <= MAX_CU_SIZE, "endX check failure\n");
+    X265_CHECK(endY <= MAX_CU_SIZE, "endY check failure\n");
+
+    __m512i tmpStats[5];
+    int32_t tmpCount[5] = { 0 };
+    for (int i = 0; i < 5; i++)
+        tmpStats[i] = _mm512_setzero_si512();
+
+    __mmask64 m = firstLanes(endX);
+    __m512i up = _mm512_maskz_loadu_epi8(m, upBuff1);
+    for (int y = 0; y < endY; y++)
+    {
+        __m512i signDown = addSign(_mm512_setzero_si512(), _mm512_maskz_loadu_epi8(m, rec), _mm512_maskz_loadu_epi8(m, rec + stride));
+        __m512i edgeType = _mm512_add_epi8(_mm512_add_epi8(signDown, up), _mm512_set1_epi8(2));
+        up = _mm512_sub_epi8(_mm512_setzero_si512(), signDown);
+        saoEdgeStats(edgeType, m, diff, tmpStats, tmpCount);
+
+        diff += MAX_CU_SIZE;
+        rec += stride;
+    }
+    _mm512_mask_storeu_epi8(upBuff1, m, up);
+
+    saoFinish(tmpStats, tmpCount, stats, count);
+}
+
+void saoCuStatsE2_avx512(const int16_t *diff, const pixel *rec, intptr_t stride, int8_t *upBuff1, int8_t *upBufft, int endX, int endY, int32_t *stats, int32_t *count)
+{
+    X265_CHECK(endX < MAX_CU_SIZE, "endX check failure\n");
+    X265_CHECK(endY < MAX_CU_SIZE, "endY check failure\n");
+
+    __m512i tmpStats[5];
+    int32_t tmpCount[5] = { 0 };
+    for (int i = 0; i < 5; i++)
+        tmpStats[i] = _mm512_setzero_si512();
+
+    /* the signs of the next row against its up-left neighbours span endX + 1
+     * lanes; even rows write them to upBufft and odd rows to upBuff1 */
+    __mmask64 m = firstLanes(endX);
+    __mmask64 mt = firstLanes(endX + 1);
+    __m512i up = _mm512_maskz_loadu_epi8(m, upBuff1);
+    __m512i prev = up;
+    for (int y = 0; y < endY; y++)
+    {
+        __m512i signDown = addSign(_mm512_setzero_si512(), _mm512_maskz_loadu_epi8(m, rec), _mm512_maskz_loadu_epi8(m, rec + stride + 1));
+        __m512i edgeType = _mm512_add_epi8(_mm512_add_epi8(signDown, up), _mm512_set1_epi8(2));
+        saoEdgeStats(edgeType, m, diff, tmpStats, tmpCount);
+
+        prev = up;
+        up = addSign(_mm512_setzero_si512(), _mm512_maskz_loadu_epi8(mt, rec + stride), _mm512_maskz_loadu_epi8(mt, rec - 1));
+
+        diff += MAX_CU_SIZE;
+        rec += stride;
+    }
+    if (endY > 0)
+        _mm512_mask_storeu_epi8(endY & 1 ? upBufft : upBuff1, mt, up);
+    if (endY > 1)
+        _mm512_mask_storeu_epi8(endY & 1 ? upBuff1 : upBufft, mt, prev);
+
+    saoFinish(tmpStats, tmpCount, stats, count);
+}
+
+void saoCuStatsE3_avx512(const int16_t *diff, const pixel *rec, intptr_t stride, int8_t *upBuff1, int endX, int endY, int32_t *stats, int32_t *count)
+{
+    X265_CHECK(endX < MAX_CU_SIZE, "endX check failure\n");
+    X265_CHECK(endY < MAX_CU_SIZE, "endY check failure\n");
+
+    __m512i tmpStats[5];
+    int32_t tmpCount[5] = { 0 };
+    for (int i = 0; i < 5; i++)
+        tmpStats[i] = _mm512_setzero_si512();
+
+    /* the last row leaves its negated down-left signs, endX + 1 of them, at
+     * upBuff1 - 1 */
+    __mmask64 m = firstLanes(endX);
+    __mmask64 mt = firstLanes(endX + 1);
+    __m512i up = _mm512_maskz_loadu_epi8(m, upBuff1);
+    __m512i signDown = _mm512_setzero_si512();
+    for (int y = 0; y < endY; y++)
+    {
+        signDown = addSign(_mm512_setzero_si512(), _mm512_maskz_loadu_epi8(mt, rec), _mm512_maskz_loadu_epi8(mt, rec + stride - 1));
+        __m512i edgeType = _mm512_add_epi8(_mm512_add_epi8(signDown, up), _mm512_set1_epi8(2));
+        saoEdgeStats(edgeType, m, diff, tmpStats, tmpCount);
+
+        up = addSign(_mm512_setzero_si512(), _mm512_maskz_loadu_epi8(m, rec + stride), _mm512_maskz_loadu_epi8(m, rec + 1));
+
+        diff += MAX_CU_SIZE;
+        rec += stride;
+    }
+    if (endY > 0)
+        _mm512_mask_storeu_epi8(upBuff1 - 1, mt, _mm512_sub_epi8(_mm512_setzero_si512(), signDown));
+
+    saoFinish(tmpStats, tmpCount, stats, count);
+}
+
+void saoCuStatsBO_avx512(const int16_t *diff, const pixel *rec, intptr_t stride, int endX, int endY, int32_t *stats, int32_t *count)
+{
+    X265_CHECK(endX <= MAX_CU_SIZE, "endX check failure\n");
+
+    /* 32 bands of 8 sample values */
+    enum { NUM_BANDS = 32, BAND_SHIFT = 3 };
+    __m512i tmpStats[NUM_BANDS];
+    __m512i tmpCount[NUM_BANDS]; // byte lanes, a lane counts at most one sample per row
+    for (int i = 0; i < NUM_BANDS; i++)
+        tmpStats[i] = tmpCount[i] = _mm512_setzero_si512();
+
+    /* a block of natural content spans few bands, only visit those between
+     * its darkest and brightest samples */
+    __mmask64 m = firstLanes(endX);
+    __m512i lo = _mm512_set1_epi8(-1), hi = _mm512_setzero_si512();
+    for (int y = 0; y < endY; y++)
+    {
+        __m512i r = _mm512_maskz_loadu_epi8(m, rec + y * stride);
+        lo = _mm512_mask_min_epu8(lo, m, lo, r);
+        hi = _mm512_max_epu8(hi, r);
+    }
+    lo = _mm512_cvtepu8_epi32(_mm_min_epu8(_mm_min_epu8(_mm512_castsi512_si128(lo), _mm512_extracti32x4_epi32(lo, 1)),
+                                           _mm_min_epu8(_mm512_extracti32x4_epi32(lo, 2), _mm512_extracti32x4_epi32(lo, 3))));
+    hi = _mm512_cvtepu8_epi32(_mm_max_epu8(_mm_max_epu8(_mm512_castsi512_si128(hi), _mm512_extracti32x4_epi32(hi, 1)),
+                                           _mm_max_epu8(_mm512_extracti32x4_epi32(hi, 2), _mm512_extracti32x4_epi32(hi, 3))));
+    int first = (int)_mm512_reduce_min_epu32(lo) >> BAND_SHIFT;
+    int last = (int)_mm512_reduce_max_epu32(hi) >> BAND_SHIFT;
+
+    const __m512i ones = _mm512_set1_epi16(1);
+    for (int y = 0; y < endY; y++)
+    {
+        __m512i b = _mm512_and_si512(_mm512_srli_epi16(_mm512_maskz_loadu_epi8(m, rec), BAND_SHIFT), _mm512_set1_epi8(NUM_BANDS - 1));
+        __m512i d0 = _mm512_maskz_loadu_epi16((__mmask32)m, diff);
+        __m512i d1 = _mm512_maskz_loadu_epi16((__mmask32)(m >> 32), diff + 32);
+
+        for (int i = first; i <= last; i++)
+        {
+            __mmask64 mt = _mm512_mask_cmpeq_epi8_mask(m, b, _mm512_set1_epi8((char)i));
+            __m512i d = _mm512_add_epi16(_mm512_maskz_mov_epi16((__mmask32)mt, d0), _mm512_maskz_mov_epi16((__mmask32)(mt >> 32), d1));
+            tmpStats[i] = _mm512_add_epi32(tmpStats[i], _mm512_madd_epi16(d, ones));
+            tmpCount[i] = _mm512_mask_add_epi8(tmpCount[i], mt, tmpCount[i], _mm512_set1_epi8(1));
+        }
+
+        diff += MAX_CU_SIZE;
+        rec += stride;
+    }
+
+    for (int i = 0; i < NUM_BANDS; i++)
+    {
+        stats[i] += _mm512_reduce_add_epi32(tmpStats[i]);
+        count[i] += (int32_t)_mm512_reduce_add_epi64(_mm512_sad_epu8(tmpCount[i], _mm512_setzero_si512()));
+    }
+}
+
+/* Angular prediction of a width x width block from its main reference (the
+ * above row of a vertical mode, the left column of a horizontal one) and its
+ * side reference. The block is written as predicted along the main reference
+ * when !transposed, else transposed, the orientation of a horizontal mode.
+ * Each output row is 32 words: one row of a 32 wide block or two rows of a
+ * 16 wide block. A transposed row gathers its samples from a 64 word window
+ * of the reference with constant per-lane offsets and fractions */
+template<int width>
+static void predAngular(pixel* dst, intptr_t dstStride, const pixel* main, const pixel* side, pixel topLeft,
+                        int angleOffset, int bFilter, bool transposed)
+{
+    static const int8_t angleTable[17] = { -32, -26, -21, -17, -13, -9, -5, -2, 0, 2, 5, 9, 13, 17, 21, 26, 32 };
+    static const int16_t invAngleTable[8] = { 4096, 1638, 910, 630, 482, 390, 315, 256 };
+    enum { ROWS = 32 / width };
+
+    int angle = angleTable[8 + angleOffset];
+
+    /* the reference, copied when the projected side neighbours must be put
+     * ahead of it for a negative angle or it is padded for the window loads */
+    ALIGN_VAR_32(pixel, refBuf[3 * 64]);
+    const pixel* ref = main;
+    if (angle < 0 || (angle && transposed))
+    {
+        pixel* buf = refBuf + 64;
+        memcpy(buf, main, 2 * width);
+        memset(buf + 2 * width, 0, 3 * 64 - 64 - 2 * width);
+        if (angle < 0)
+        {
+            int nbProjected = -((width * angle) >> 5) - 1;
+            int invAngle = invAngleTable[-angleOffset - 1];
+            int invAngleSum = 128;
+            buf[-1] = topLeft;
+            for (int i = 0; i < nbProjected; i++)
+            {
+                invAngleSum += invAngle;
+                buf[-2 - i] = side[(invAngleSum >> 8) - 1];
+            }
+        }
+        ref = buf;
+    }
+
+    const __m512i round = _mm512_set1_epi16(16);
+    if (!angle)
+    {
+        /* pure vertical, or horizontal with every row a single sample */
+        for (int y = 0; y < width; y++)
+        {
+            __m256i row = transposed ? _mm256_set1_epi8((char)main[y]) : _mm256_loadu_si256((const __m256i*)main);
+            if (width == 32)
+                _mm256_storeu_si256((__m256i*)(dst + y * dstStride), row);
+            else
+                _mm_storeu_si128((__m128i*)(dst + y * dstStride), _mm256_castsi256_si128(row));
+        }
+    }
+    else if (!transposed)
+    {
+        int angleSum = 0;
+        for (int y = 0; y < width; y += ROWS)
+        {
+            int offset[ROWS], fraction[ROWS];
+            for (int i = 0; i < ROWS; i++)
+            {
+                angleSum += angle;
+                offset[i] = angleSum >> 5;
+                fraction[i] = angleSum & 31;
+            }
+
+            __m256i p8;
+            if (width == 32)
+                p8 = _mm256_loadu_si256((const __m256i*)(ref + offset[0]));
+            else
+                p8 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(ref + offset[0]))),
+                                             _mm_loadu_si128((const __m128i*)(ref + offset[ROWS - 1])), 1);
+
+            /* rows without a fraction are copies, and the sample past the
+             * last one of the reference is only read with a fraction */
+            if (fraction[0] | fraction[ROWS - 1])
+            {
+                __m512i a = _mm512_cvtepu8_epi16(p8), b, f;
+                if (width == 32)
+                {
+                    b = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(ref + offset[0] + 1)));
+                    f = _mm512_set1_epi16((int16_t)fraction[0]);
+                }
+                else
+                {
+                    b = _mm512_cvtepu8_epi16(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(ref + offset[0] + 1))),
+                                                                     _mm_loadu_si128((const __m128i*)(ref + offset[ROWS - 1] + 1)), 1));
+                    f = _mm512_mask_blend_epi16(0xFFFF0000, _mm512_set1_epi16((int16_t)fraction[0]), _mm512_set1_epi16((int16_t)fraction[ROWS - 1]));
+                }
+
+                /* ((32 - f) * a + f * b + 16) >> 5 */
+                __m512i v = _mm512_add_epi16(a, _mm512_srai_epi16(_mm512_add_epi16(_mm512_mullo_epi16(_mm512_sub_epi16(b, a), f), round), 5));
+                p8 = _mm512_cvtepi16_epi8(v);
+            }
+            if (width == 32)
+                _mm256_storeu_si256((__m256i*)(dst + y * dstStride), p8);
+            else
+            {
+                _mm_storeu_si128((__m128i*)(dst + y * dstStride), _mm256_castsi256_si128(p8));
+                _mm_storeu_si128((__m128i*)(dst + (y + 1) * dstStride), _mm256_extracti128_si256(p8, 1));
+            }
+        }
+    }
+    else
+    {
+        ALIGN_VAR_32(int16_t, index[32]);
+        ALIGN_VAR_32(int16_t, fraction[32]);
+        int first = angle < 0 ? (width * angle) >> 5 : angle >> 5;
+        for (int x = 0; x < width; x++)
+        {
+            int angleSum = (x + 1) * angle;
+            for (int i = 0; i < ROWS; i++)
+            {
+                index[i * width + x] = (int16_t)((angleSum >> 5) - first + i);
+                fraction[i * width + x] = (int16_t)(angleSum & 31);
+            }
+        }
+        __m512i idx = _mm512_loadu_si512(index);
+        __m512i idx1 = _mm512_add_epi16(idx, _mm512_set1_epi16(1));
+        __m512i f = _mm512_loadu_si512(fraction);
+
+        for (int y = 0; y < width; y += ROWS)
+        {
+            const pixel* window = ref + first + y;
+            __m512i lo = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)window));
+            __m512i hi = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(window + 32)));
+            __m512i a = _mm512_permutex2var_epi16(lo, idx, hi);
+            __m512i b = _mm512_permutex2var_epi16(lo, idx1, hi);
+
+            __m512i v = _mm512_add_epi16(a, _mm512_srai_epi16(_mm512_add_epi16(_mm512_mullo_epi16(_mm512_sub_epi16(b, a), f), round), 5));
+            __m256i p8 = _mm512_cvtepi16_epi8(v);
+            if (width == 32)
+                _mm256_storeu_si256((__m256i*)(dst + y * dstStride), p8);
+            else
+            {
+                _mm_storeu_si128((__m128i*)(dst + y * dstStride), _mm256_castsi256_si128(p8));
+                _mm_storeu_si128((__m128i*)(dst + (y + 1) * dstStride), _mm256_extracti128_si256(p8, 1));
+            }
+        }
+    }
+
+    if (!angle && bFilter)
+    {
+        for (int i = 0; i < width; i++)
+            dst[transposed ? i : i * dstStride] = x265_clip((int16_t)(main[0] + ((side[i] - topLeft) >> 1)));
+    }
+}
+
+template<int width>
+void intra_pred_ang_avx512(pixel* dst, intptr_t dstStride, const pixel *srcPix, int dirMode, int bFilter)
+{
+    const pixel* above = srcPix + 1;
+    const pixel* left = srcPix + 2 * width + 1;
+
+    if (dirMode < 18)
+        predAngular<width>(dst, dstStride, left, above, srcPix[0], 10 - dirMode, bFilter, true);
+    else
+        predAngular<width>(dst, dstStride, above, left, srcPix[0], dirMode - 26, bFilter, false);
+}
+
+/* all 33 angular modes, horizontal modes left untransposed */
+template<int log2Size>
+void all_angs_pred_avx512(pixel *dest, pixel *refPix, pixel *filtPix, int bLuma)
+{
+    const int size = 1 << log2Size;
+    for (int mode = 2; mode <= 34; mode++)
+    {
+        const pixel* srcPix = g_intraFilterFlags[mode] & size ? filtPix : refPix;
+        const pixel* above = srcPix + 1;
+        const pixel* left = srcPix + 2 * size + 1;
+        pixel* out = dest + ((mode - 2) << (log2Size * 2));
+
+        if (mode < 18)
+            predAngular<size>(out, size, left, above, srcPix[0], 10 - mode, bLuma, false);
+        else
+            predAngular<size>(out, size, above, left, srcPix[0], mode - 26, bLuma, false);
+    }
+}
+
+#endif // !HIGH_BIT_DEPTH
+
+} // end anonymous namespace
+
+namespace X265_NS {
+void setupIntrinsicPixel_avx512(EncoderPrimitives &p)
+{
+#if !HIGH_BIT_DEPTH
+#define SAD_X(W, H) \
+    p.pu[LUMA_ ## W ## x ## H].sad_x3 = sad_x3_avx512<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_x4 = sad_x4_avx512<W, H>
+#define SAD(W, H) \
+    p.pu[LUMA_ ## W ## x ## H].sad = sad_avx512<W, H>; \
+    SAD_X(W, H)
+
+    /* a single 16-wide block does not fill a zmm register, the 16-wide sad
+     * stays on the 256bit path */
+    SAD_X(16, 4); SAD_X(16, 8); SAD_X(16, 12); SAD_X(16, 16); SAD_X(16, 32); SAD_X(16, 64);
+    SAD(32, 8);  SAD(32, 16); SAD(32, 24); SAD(32, 32); SAD(32, 64);
+    SAD(48, 64);
+    SAD(64, 16); SAD(64, 32); SAD(64, 48); SAD(64, 64);
+#undef SAD
+#undef SAD_X
+
+#define SATD(W, H) p.pu[LUMA_ ## W ## x ## H].satd = satd_avx512<W, H>
+    SATD(16, 8);  SATD(16, 16); SATD(16, 32); SATD(16, 64);
+    SATD(32, 8);  SATD(32, 16); SATD(32, 24); SATD(32, 32); SATD(32, 64);
+    SATD(64, 16); SATD(64, 32); SATD(64, 48); SATD(64, 64);
+#undef SATD
+
+#define LUMA_FILTERS(W, H) \
+    p.pu[LUMA_ ## W ## x ## H].luma_hpp = interp_horiz_pp_avx512<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].luma_vpp = interp_vert_pp_avx512<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].luma_hvpp = interp_hv_pp_avx512<W, H>
+
+    LUMA_FILTERS(4, 4);   LUMA_FILTERS(8, 8);   LUMA_FILTERS(16, 16); LUMA_FILTERS(32, 32); LUMA_FILTERS(64, 64);
+    LUMA_FILTERS(8, 4);   LUMA_FILTERS(4, 8);   LUMA_FILTERS(16, 8);  LUMA_FILTERS(8, 16);
+    LUMA_FILTERS(32, 16); LUMA_FILTERS(16, 32); LUMA_FILTERS(64, 32); LUMA_FILTERS(32, 64);
+    LUMA_FILTERS(16, 12); LUMA_FILTERS(12, 16); LUMA_FILTERS(16, 4);  LUMA_FILTERS(4, 16);
+    LUMA_FILTERS(32, 24); LUMA_FILTERS(24, 32); LUMA_FILTERS(32, 8);  LUMA_FILTERS(8, 32);
+    LUMA_FILTERS(64, 48); LUMA_FILTERS(48, 64); LUMA_FILTERS(64, 16); LUMA_FILTERS(16, 64);
+#undef LUMA_FILTERS
+
+    p.cu[BLOCK_16x16].sa8d = sa8d_avx512<16>;
+    p.cu[BLOCK_32x32].sa8d = sa8d_avx512<32>;
+    p.cu[BLOCK_64x64].sa8d = sa8d_avx512<64>;
+
+    for (int i = 2; i < NUM_INTRA_MODE; i++)
+    {
+        p.cu[BLOCK_16x16].intra_pred[i] = intra_pred_ang_avx512<16>;
+        p.cu[BLOCK_32x32].intra_pred[i] = intra_pred_ang_avx512<32>;
+    }
+    p.cu[BLOCK_16x16].intra_pred_allangs = all_angs_pred_avx512<4>;
+    p.cu[BLOCK_32x32].intra_pred_allangs = all_angs_pred_avx512<5>;
+
+    p.saoCuStatsE0 = saoCuStatsE0_avx512;
+    p.saoCuStatsE1 = saoCuStatsE1_avx512;
+    p.saoCuStatsE2 = saoCuStatsE2_avx512;
+    p.saoCuStatsE3 = saoCuStatsE3_avx512;
+    p.saoCuStatsBO = saoCuStatsBO_avx512;
+#else
+    (void)p;
+#endif
+}
+}
@@ -0,0 +1,738 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "primitives.h"
+#include <xmmintrin.h> // SSE
+#include <smmintrin.h> // SSE4.1
+
+using namespace X265_NS;
+
+namespace {
+// anonymous file-static namespace
+
+/* replicate the last pixel of a converted row into the padx pixels after it,
+ * without writing past them */
+static inline void padRow(pixel* dst, int width, int padx)
+{
+    pixel last = dst[width - 1];
+    int x = 0;
+#if HIGH_BIT_DEPTH
+    __m128i fill = _mm_set1_epi16((short)last);
+    for (; x + 8 <= padx; x += 8)
+        _mm_storeu_si128((__m128i*)(dst + width + x), fill);
+#else
+    __m128i fill = _mm_set1_epi8((char)last);
+    for (; x + 16 <= padx; x += 16)
+        _mm_storeu_si128((__m128i*)(dst + width + x), fill);
+#endif
+    for (; x < padx; x++)
+        dst[width + x] = last;
+}
+
+#if HIGH_BIT_DEPTH
+
+void planecopy_cp_pad_sse41(const uint8_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, int padx)
+{
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+
+    for (int r = 0; r < height; r++)
+    {
+        int c = 0;
+        for (; c + 8 <= width; c += 8)
+        {
+            __m128i s = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(src + c)));
+            _mm_storeu_si128((__m128i*)(dst + c), _mm_sll_epi16(s, vshift));
+        }
+        for (; c < width; c++)
+            dst[c] = ((pixel)src[c]) << shift;
+        padRow(dst, width, padx);
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+void planecopy_sp_pad_sse41(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask, int padx)
+{
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    __m128i vmask = _mm_set1_epi16((short)mask);
+
+    for (int r = 0; r < height; r++)
+    {
+        int c = 0;
+        for (; c + 8 <= width; c += 8)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i*)(src + c));
+            _mm_storeu_si128((__m128i*)(dst + c), _mm_and_si128(_mm_srl_epi16(s, vshift), vmask));
+        }
+        for (; c < width; c++)
+            dst[c] = (pixel)((src[c] >> shift) & mask);
+        padRow(dst, width, padx);
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+void planecopy_sp_shl_pad_sse41(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask, int padx)
+{
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    __m128i vmask = _mm_set1_epi16((short)mask);
+
+    for (int r = 0; r < height; r++)
+    {
+        int c = 0;
+        for (; c + 8 <= width; c += 8)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i*)(src + c));
+            _mm_storeu_si128((__m128i*)(dst + c), _mm_and_si128(_mm_sll_epi16(s, vshift), vmask));
+        }
+        for (; c < width; c++)
+            dst[c] = (pixel)((src[c] << shift) & mask);
+        padRow(dst, width, padx);
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+pixel planecopy_sp_clip_sse41(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int padx,
+                              uint64_t *outsum, const pixel minPix, const pixel maxPix)
+{
+    __m128i vmask = _mm_set1_epi16(PIXEL_MAX);
+    __m128i vmin = _mm_set1_epi16((short)minPix);
+    __m128i vmax = _mm_set1_epi16((short)maxPix);
+    __m128i ones = _mm_set1_epi16(1);
+    __m128i maxLevel = _mm_setzero_si128();
+    pixel maxLumaLevel = 0;
+    uint64_t sumLuma = 0;
+
+    for (int r = 0; r < height; r++)
+    {
+        /* pixels are at most 12 bits, so a row sums safely in 32bit lanes */
+        __m128i rowSum = _mm_setzero_si128();
+        int c = 0;
+        for (; c + 8 <= width; c += 8)
+        {
+            __m128i s = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + c)), vmask);
+            s = _mm_min_epu16(_mm_max_epu16(s, vmin), vmax);
+            _mm_storeu_si128((__m128i*)(dst + c), s);
+            maxLevel = _mm_max_epu16(maxLevel, s);
+            rowSum = _mm_add_epi32(rowSum, _mm_madd_epi16(s, ones));
+        }
+        for (; c < width; c++)
+        {
+            dst[c] = x265_clip3((pixel)minPix, (pixel)maxPix, (pixel)(src[c] & PIXEL_MAX));
+            maxLumaLevel = X265_MAX(dst[c], maxLumaLevel);
+            sumLuma += dst[c];
+        }
+        rowSum = _mm_add_epi32(rowSum, _mm_srli_si128(rowSum, 8));
+        rowSum = _mm_add_epi32(rowSum, _mm_srli_si128(rowSum, 4));
+        sumLuma += (uint32_t)_mm_cvtsi128_si32(rowSum);
+        padRow(dst, width, padx);
+
+        dst += dstStride;
+        src += srcStride;
+    }
+
+    /* horizontal maximum, as the minimum of the inverted levels */
+    __m128i minInv = _mm_minpos_epu16(_mm_xor_si128(maxLevel, _mm_set1_epi16(-1)));
+    pixel vecMax = (pixel)~_mm_extract_epi16(minInv, 0);
+    *outsum = sumLuma;
+    return X265_MAX(maxLumaLevel, vecMax);
+}
+
+#else // if HIGH_BIT_DEPTH
+
+void planecopy_cp_pad_sse41(const uint8_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, int padx)
+{
+    X265_CHECK(!shift, "8bit input to 8bit pixels is not shifted\n");
+    (void)shift;
+
+    for (int r = 0; r < height; r++)
+    {
+        int c = 0;
+        for (; c + 16 <= width; c += 16)
+            _mm_storeu_si128((__m128i*)(dst + c), _mm_loadu_si128((const __m128i*)(src + c)));
+        for (; c < width; c++)
+            dst[c] = src[c];
+        padRow(dst, width, padx);
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+void planecopy_sp_pad_sse41(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask, int padx)
+{
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    __m128i vmask = _mm_set1_epi16((short)(mask & 0xFF));
+
+    for (int r = 0; r < height; r++)
+    {
+        int c = 0;
+        for (; c + 16 <= width; c += 16)
+        {
+            __m128i s0 = _mm_and_si128(_mm_srl_epi16(_mm_loadu_si128((const __m128i*)(src + c)), vshift), vmask);
+            __m128i s1 = _mm_and_si128(_mm_srl_epi16(_mm_loadu_si128((const __m128i*)(src + c + 8)), vshift), vmask);
+            _mm_storeu_si128((__m128i*)(dst + c), _mm_packus_epi16(s0, s1));
+        }
+        for (; c < width; c++)
+            dst[c] = (pixel)((src[c] >> shift) & mask);
+        padRow(dst, width, padx);
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+void planecopy_sp_shl_pad_sse41(const uint16_t* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int width, int height, int shift, uint16_t mask, int padx)
+{
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    __m128i vmask = _mm_set1_epi16((short)(mask & 0xFF));
+
+    for (int r = 0; r < height; r++)
+    {
+        int c = 0;
+        for (; c + 16 <= width; c += 16)
+        {
+            __m128i s0 = _mm_and_si128(_mm_sll_epi16(_mm_loadu_si128((const __m128i*)(src + c)), vshift), vmask);
+            __m128i s1 = _mm_and_si128(_mm_sll_epi16(_mm_loadu_si128((const __m128i*)(src + c + 8)), vshift), vmask);
+            _mm_storeu_si128((__m128i*)(dst + c), _mm_packus_epi16(s0, s1));
+        }
+        for (; c < width; c++)
+            dst[c] = (pixel)((src[c] << shift) & mask);
+        padRow(dst, width, padx);
+
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+#endif // if HIGH_BIT_DEPTH
+
+/* resampling kernels, for both pixel types */
+
+static inline __m128i load8(const uint8_t* src)  { return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)src)); }
+static inline __m128i load8(const uint16_t* src) { return _mm_loadu_si128((const __m128i*)src); }
+
+static inline void store8(uint8_t* dst, __m128i v, __m128i)
+{
+    _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(v, v));
+}
+
+static inline void store8(uint16_t* dst, __m128i v, __m128i vmax)
+{
+    _mm_storeu_si128((__m128i*)dst, _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), vmax));
+}
+
+/* four outputs at a time, eight taps of each per multiply-add; samples are
+ * at most 14 bits so they multiply as signed words */
+template<typename T>
+void resample_h_sse41(const T* src, int16_t* dst, int width, const int32_t* pos, const int16_t* coef, int taps, int shift)
+{
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    __m128i offset = _mm_set1_epi32(1 << (shift - 1));
+    int x = 0;
+
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i sum[4];
+        for (int j = 0; j < 4; j++)
+        {
+            const T* s = src + pos[x + j];
+            const int16_t* c = coef + (x + j) * taps;
+            __m128i acc = _mm_setzero_si128();
+            for (int k = 0; k < taps; k += 8)
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(load8(s + k), _mm_loadu_si128((const __m128i*)(c + k))));
+            sum[j] = acc;
+        }
+        __m128i r = _mm_hadd_epi32(_mm_hadd_epi32(sum[0], sum[1]), _mm_hadd_epi32(sum[2], sum[3]));
+        r = _mm_sra_epi32(_mm_add_epi32(r, offset), vshift);
+        _mm_storel_epi64((__m128i*)(dst + x), _mm_packs_epi32(r, r));
+    }
+
+    for (; x < width; x++)
+    {
+        const T* s = src + pos[x];
+        const int16_t* c = coef + x * taps;
+        int sum = 0;
+        for (int k = 0; k < taps; k++)
+            sum += s[k] * c[k];
+        dst[x] = (int16_t)((sum + (1 << (shift - 1))) >> shift);
+    }
+}
+
+/* eight outputs at a time, interleaving pairs of intermediate rows so one
+ * multiply-add applies two taps */
+template<typename T>
+void resample_v_sse41(const int16_t* src, intptr_t srcStride, T* dst, int width, const int16_t* coef, int taps, int shift, int maxVal)
+{
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    __m128i offset = _mm_set1_epi32(1 << (shift - 1));
+    __m128i vmax = _mm_set1_epi16((short)maxVal);
+    int x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        for (int k = 0; k < taps; k += 2)
+        {
+            __m128i r0 = _mm_loadu_si128((const __m128i*)(src + k * srcStride + x));
+            __m128i r1 = _mm_loadu_si128((const __m128i*)(src + (k + 1) * srcStride + x));
+            __m128i c = _mm_set1_epi32((int)((uint32_t)(uint16_t)coef[k] | ((uint32_t)(uint16_t)coef[k + 1] << 16)));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(r0, r1), c));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(r0, r1), c));
+        }
+        lo = _mm_sra_epi32(_mm_add_epi32(lo, offset), vshift);
+        hi = _mm_sra_epi32(_mm_add_epi32(hi, offset), vshift);
+        store8(dst + x, _mm_packs_epi32(lo, hi), vmax);
+    }
+
+    for (; x < width; x++)
+    {
+        int sum = 0;
+        for (int k = 0; k < taps; k++)
+            sum += src[k * srcStride + x] * coef[k];
+        dst[x] = (T)x265_clip3(0, maxVal, (sum + (1 << (shift - 1))) >> shift);
+    }
+}
+
+#if !HIGH_BIT_DEPTH
+
+/* 4 pixels without reading past them */
+static inline int load4(const pixel* p)
+{
+    int v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* 16 pixels of a strip of width w: one row of a 16 wide strip, two rows of
+ * an 8 wide strip or four rows of a 4 wide strip */
+template<int w>
+static inline __m128i loadStrip(const pixel* p, intptr_t stride)
+{
+    if (w == 16)
+        return _mm_loadu_si128((const __m128i*)p);
+    else if (w == 8)
+        return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)p), _mm_loadl_epi64((const __m128i*)(p + stride)));
+    else
+        return _mm_setr_epi32(load4(p), load4(p + stride), load4(p + 2 * stride), load4(p + 3 * stride));
+}
+
+template<int w, int ly, int N>
+static inline void sadStrip(const pixel* fenc, intptr_t fencstride, const pixel* const* fref, int x, intptr_t frefstride, __m128i* sum)
+{
+    for (int y = 0; y < ly; y += 16 / w)
+    {
+        __m128i e = loadStrip<w>(fenc + y * fencstride + x, fencstride);
+        for (int i = 0; i < N; i++)
+            sum[i] = _mm_add_epi32(sum[i], _mm_sad_epu8(e, loadStrip<w>(fref[i] + y * frefstride + x, frefstride)));
+    }
+}
+
+/* SADs of one block against N references, the columns are covered by 16
+ * wide strips, then an 8 and a 4 wide strip */
+template<int lx, int ly, int N>
+static inline void sadBlock(const pixel* fenc, intptr_t fencstride, const pixel* const* fref, intptr_t frefstride, int32_t* res)
+{
+    __m128i sum[N];
+    for (int i = 0; i < N; i++)
+        sum[i] = _mm_setzero_si128();
+
+    for (int x = 0; x + 16 <= lx; x += 16)
+        sadStrip<16, ly, N>(fenc, fencstride, fref, x, frefstride, sum);
+    if (lx & 8)
+        sadStrip<8, ly, N>(fenc, fencstride, fref, lx & ~15, frefstride, sum);
+    if (lx & 4)
+        sadStrip<4, ly, N>(fenc, fencstride, fref, lx & ~7, frefstride, sum);
+
+    for (int i = 0; i < N; i++)
+        res[i] = _mm_cvtsi128_si32(sum[i]) + _mm_extract_epi32(sum[i], 2);
+}
+
+template<int lx, int ly>
+int sad_sse41(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    int32_t res;
+    sadBlock<lx, ly, 1>(fenc, fencstride, &fref, frefstride, &res);
+    return res;
+}
+
+template<int lx, int ly>
+void sad_x3_sse41(const pixel* fenc, const pixel* fref0, const pixel* fref1, const pixel* fref2, intptr_t frefstride, int32_t* res)
+{
+    const pixel* fref[3] = { fref0, fref1, fref2 };
+    sadBlock<lx, ly, 3>(fenc, FENC_STRIDE, fref, frefstride, res);
+}
+
+template<int lx, int ly>
+void sad_x4_sse41(const pixel* fenc, const pixel* fref0, const pixel* fref1, const pixel* fref2, const pixel* fref3, intptr_t frefstride, int32_t* res)
+{
+    const pixel* fref[4] = { fref0, fref1, fref2, fref3 };
+    sadBlock<lx, ly, 4>(fenc, FENC_STRIDE, fref, frefstride, res);
+}
+
+template<int lx, int ly>
+void sad_x8_sse41(const pixel* fenc, const pixel* const* fref, intptr_t frefstride, int32_t* res)
+{
+    sadBlock<lx, ly, 8>(fenc, FENC_STRIDE, fref, frefstride, res);
+}
+
+static inline void butterfly(__m128i& a, __m128i& b)
+{
+    __m128i t = a;
+    a = _mm_add_epi16(t, b);
+    b = _mm_sub_epi16(t, b);
+}
+
+static inline void hadamard4(__m128i* v)
+{
+    butterfly(v[0], v[1]);
+    butterfly(v[2], v[3]);
+    butterfly(v[0], v[2]);
+    butterfly(v[1], v[3]);
+}
+
+/* sum of the absolute 4x4 Hadamard coefficients of the residual of two 4x4
+ * blocks side by side, or of one when w is 4. The coefficients differ from
+ * the C reference only in order and sign */
+template<int w>
+static inline __m128i satdSum8x4(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m128i d[4], t[4];
+    for (int i = 0; i < 4; i++)
+    {
+        __m128i e = w == 8 ? _mm_loadl_epi64((const __m128i*)(fenc + i * fencstride)) : _mm_cvtsi32_si128(load4(fenc + i * fencstride));
+        __m128i r = w == 8 ? _mm_loadl_epi64((const __m128i*)(fref + i * frefstride)) : _mm_cvtsi32_si128(load4(fref + i * frefstride));
+        d[i] = _mm_sub_epi16(_mm_cvtepu8_epi16(e), _mm_cvtepu8_epi16(r));
+    }
+    hadamard4(d);
+
+    /* transpose each 4x4 block, t[k] holds column k of both blocks */
+    __m128i a0 = _mm_unpacklo_epi16(d[0], d[1]);
+    __m128i a1 = _mm_unpackhi_epi16(d[0], d[1]);
+    __m128i a2 = _mm_unpacklo_epi16(d[2], d[3]);
+    __m128i a3 = _mm_unpackhi_epi16(d[2], d[3]);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    t[0] = _mm_unpacklo_epi64(b0, b2);
+    t[1] = _mm_unpackhi_epi64(b0, b2);
+    t[2] = _mm_unpacklo_epi64(b1, b3);
+    t[3] = _mm_unpackhi_epi64(b1, b3);
+    hadamard4(t);
+
+    __m128i s = _mm_add_epi16(_mm_add_epi16(_mm_abs_epi16(t[0]), _mm_abs_epi16(t[1])),
+                              _mm_add_epi16(_mm_abs_epi16(t[2]), _mm_abs_epi16(t[3])));
+    return _mm_madd_epi16(s, _mm_set1_epi16(1));
+}
+
+static inline int horizontalSum(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_srli_si128(v, 8));
+    v = _mm_add_epi32(v, _mm_srli_si128(v, 4));
+    return _mm_cvtsi128_si32(v);
+}
+
+/* The sum of the absolute coefficients of a 4x4 Hadamard transform is always
+ * even, so halving the sum of the whole block matches the C reference which
+ * halves the sum of each 4x4 or 8x4 block */
+template<int lx, int ly>
+int satd_sse41(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m128i sum = _mm_setzero_si128();
+    for (int y = 0; y < ly; y += 4)
+    {
+        int x = 0;
+        for (; x + 8 <= lx; x += 8)
+            sum = _mm_add_epi32(sum, satdSum8x4<8>(fenc + y * fencstride + x, fencstride, fref + y * frefstride + x, frefstride));
+        if (lx & 4)
+            sum = _mm_add_epi32(sum, satdSum8x4<4>(fenc + y * fencstride + x, fencstride, fref + y * frefstride + x, frefstride));
+    }
+
+    return horizontalSum(sum) >> 1;
+}
+
+/* sum of the absolute 8x8 Hadamard coefficients of the residual of an 8x8
+ * block, _sa8d_8x8 of the C reference */
+static inline int sa8dSum8x8(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    __m128i d[8], t[8];
+    for (int i = 0; i < 8; i++)
+    {
+        __m128i e = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(fenc + i * fencstride)));
+        __m128i r = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(fref + i * frefstride)));
+        d[i] = _mm_sub_epi16(e, r);
+    }
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        hadamard4(d);
+        hadamard4(d + 4);
+        for (int i = 0; i < 4; i++)
+            butterfly(d[i], d[i + 4]);
+
+        if (pass)
+            break;
+
+        __m128i a[8], b[8];
+        for (int i = 0; i < 4; i++)
+        {
+            a[2 * i] = _mm_unpacklo_epi16(d[2 * i], d[2 * i + 1]);
+            a[2 * i + 1] = _mm_unpackhi_epi16(d[2 * i], d[2 * i + 1]);
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            b[4 * i + 0] = _mm_unpacklo_epi32(a[4 * i + 0], a[4 * i + 2]);
+            b[4 * i + 1] = _mm_unpackhi_epi32(a[4 * i + 0], a[4 * i + 2]);
+            b[4 * i + 2] = _mm_unpacklo_epi32(a[4 * i + 1], a[4 * i + 3]);
+            b[4 * i + 3] = _mm_unpackhi_epi32(a[4 * i + 1], a[4 * i + 3]);
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            t[2 * i] = _mm_unpacklo_epi64(b[i], b[i + 4]);
+            t[2 * i + 1] = _mm_unpackhi_epi64(b[i], b[i + 4]);
+        }
+        for (int i = 0; i < 8; i++)
+            d[i] = t[i];
+    }
+
+    /* the absolute coefficients reach 16320, sum them as int32 */
+    __m128i one = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < 8; i++)
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_abs_epi16(d[i]), one));
+
+    return horizontalSum(sum);
+}
+
+int sa8d_8x8_sse41(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    return (sa8dSum8x8(fenc, fencstride, fref, frefstride) + 2) >> 2;
+}
+
+/* rounded once per 16x16 block, like the C reference */
+template<int size>
+int sa8d_sse41(const pixel* fenc, intptr_t fencstride, const pixel* fref, intptr_t frefstride)
+{
+    int cost = 0;
+    for (int y = 0; y < size; y += 16)
+    {
+        for (int x = 0; x < size; x += 16)
+        {
+            const pixel* e = fenc + y * fencstride + x;
+            const pixel* r = fref + y * frefstride + x;
+            int sum = sa8dSum8x8(e, fencstride, r, frefstride) +
+                      sa8dSum8x8(e + 8, fencstride, r + 8, frefstride) +
+                      sa8dSum8x8(e + 8 * fencstride, fencstride, r + 8 * frefstride, frefstride) +
+                      sa8dSum8x8(e + 8 * fencstride + 8, fencstride, r + 8 * frefstride + 8, frefstride);
+            cost += (sum + 2) >> 2;
+        }
+    }
+
+    return cost;
+}
+
+/* Byte shuffles pairing each of 8 output positions with the source samples of
+ * one pair of filter taps, for use with maddubs */
+static const int8_t s_tapPairs[4][16] =
+{
+    { 0, 1, 1, 2, 2, 3, 3, 4, 4, 5,  5,  6,  6,  7,  7,  8 },
+    { 2, 3, 3, 4, 4, 5, 5, 6, 6, 7,  7,  8,  8,  9,  9, 10 },
+    { 4, 5, 5, 6, 6, 7, 7, 8, 8, 9,  9, 10, 10, 11, 11, 12 },
+    { 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14 },
+};
+
+static inline __m128i tapPair(const int16_t* coeff, int k)
+{
+    return _mm_set1_epi16((int16_t)((coeff[k + 1] << 8) | (uint8_t)coeff[k]));
+}
+
+/* 8-tap filter sums of 8 outputs, as int16, from the 15 source samples in the
+ * low bytes of src. The coefficients fit in int8 and no partial sum of the
+ * luma filters overflows int16 */
+static inline __m128i filterRow8(__m128i src, const __m128i shuf[4], const __m128i c[4])
+{
+    __m128i sum = _mm_maddubs_epi16(_mm_shuffle_epi8(src, shuf[0]), c[0]);
+    sum = _mm_add_epi16(sum, _mm_maddubs_epi16(_mm_shuffle_epi8(src, shuf[1]), c[1]));
+    sum = _mm_add_epi16(sum, _mm_maddubs_epi16(_mm_shuffle_epi8(src, shuf[2]), c[2]));
+    return _mm_add_epi16(sum, _mm_maddubs_epi16(_mm_shuffle_epi8(src, shuf[3]), c[3]));
+}
+
+/* Like the assembly, the 16 byte loads may read up to 5 pixels past the last
+ * source sample of the C reference, which lie in the picture margin */
+template<int width, int height>
+void interp_horiz_pp_sse41(const pixel* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int coeffIdx)
+{
+    const int16_t* coeff = g_lumaFilter[coeffIdx];
+    __m128i shuf[4], c[4];
+    for (int k = 0; k < 4; k++)
+    {
+        shuf[k] = _mm_loadu_si128((const __m128i*)s_tapPairs[k]);
+        c[k] = tapPair(coeff, 2 * k);
+    }
+    const __m128i offset = _mm_set1_epi16(1 << (IF_FILTER_PREC - 1));
+
+    src -= 3;
+    for (int y = 0; y < height; y++)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i lo = filterRow8(_mm_loadu_si128((const __m128i*)(src + x)), shuf, c);
+            __m128i hi = filterRow8(_mm_loadu_si128((const __m128i*)(src + x + 8)), shuf, c);
+            lo = _mm_srai_epi16(_mm_add_epi16(lo, offset), IF_FILTER_PREC);
+            hi = _mm_srai_epi16(_mm_add_epi16(hi, offset), IF_FILTER_PREC);
+            _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+        }
+        if (width & 8)
+        {
+            __m128i v = filterRow8(_mm_loadu_si128((const __m128i*)(src + x)), shuf, c);
+            v = _mm_srai_epi16(_mm_add_epi16(v, offset), IF_FILTER_PREC);
+            _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(v, v));
+            x += 8;
+        }
+        if (width & 4)
+        {
+            __m128i v = filterRow8(_mm_loadu_si128((const __m128i*)(src + x)), shuf, c);
+            v = _mm_srai_epi16(_mm_add_epi16(v, offset), IF_FILTER_PREC);
+            int out = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+            memcpy(dst + x, &out, 4);
+        }
+
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+/* 8-tap vertical filter sums of the w (16, 8 or 4) columns at src, as int16 */
+template<int w>
+static inline void filterColumnsV(const pixel* src, intptr_t srcStride, const __m128i c[4], __m128i& lo, __m128i& hi)
+{
+    lo = hi = _mm_setzero_si128();
+    for (int k = 0; k < 8; k += 2)
+    {
+        __m128i r0, r1;
+        if (w == 16)
+        {
+            r0 = _mm_loadu_si128((const __m128i*)(src + k * srcStride));
+            r1 = _mm_loadu_si128((const __m128i*)(src + (k + 1) * srcStride));
+            hi = _mm_add_epi16(hi, _mm_maddubs_epi16(_mm_unpackhi_epi8(r0, r1), c[k >> 1]));
+        }
+        else if (w == 8)
+        {
+            r0 = _mm_loadl_epi64((const __m128i*)(src + k * srcStride));
+            r1 = _mm_loadl_epi64((const __m128i*)(src + (k + 1) * srcStride));
+        }
+        else
+        {
+            r0 = _mm_cvtsi32_si128(load4(src + k * srcStride));
+            r1 = _mm_cvtsi32_si128(load4(src + (k + 1) * srcStride));
+        }
+        lo = _mm_add_epi16(lo, _mm_maddubs_epi16(_mm_unpacklo_epi8(r0, r1), c[k >> 1]));
+    }
+}
+
+template<int width, int height>
+void interp_vert_pp_sse41(const pixel* src, intptr_t srcStride, pixel* dst, intptr_t dstStride, int coeffIdx)
+{
+    const int16_t* coeff = g_lumaFilter[coeffIdx];
+    const __m128i c[4] = { tapPair(coeff, 0), tapPair(coeff, 2), tapPair(coeff, 4), tapPair(coeff, 6) };
+    const __m128i offset = _mm_set1_epi16(1 << (IF_FILTER_PREC - 1));
+
+    src -= 3 * srcStride;
+    for (int y = 0; y < height; y++)
+    {
+        __m128i lo, hi;
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            filterColumnsV<16>(src + x, srcStride, c, lo, hi);
+            lo = _mm_srai_epi16(_mm_add_epi16(lo, offset), IF_FILTER_PREC);
+            hi = _mm_srai_epi16(_mm_add_epi16(hi, offset), IF_FILTER_PREC);
+            _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(lo, hi));
+        }
+        if (width & 8)
+        {
+            filterColumnsV<8>(src + x, srcStride, c, lo, hi);
+            lo = _mm_srai_epi16(_mm_add_epi16(lo, offset), IF_FILTER_PREC);
+            _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(lo, lo));
+            x += 8;
+        }
+        if (width & 4)
+        {
+            filterColumnsV<4>(src + x, srcStride, c, lo, hi);
+            lo = _mm_srai_epi16(_mm_add_epi16(lo, offset), IF_FILTER_PREC);
+            int out = _mm_cvtsi128_si32(_mm_packus_epi16(lo, lo));
+            memcpy(dst + x, &out, 4);
+        }
+
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+#endif // !HIGH_BIT_DEPTH
+}
+
+namespace X265_NS {
+void setupIntrinsicPixel_sse41(EncoderPrimitives &p)
+{
+    p.planecopy_cp_pad = planecopy_cp_pad_sse41;
+    p.planecopy_sp_pad = planecopy_sp_pad_sse41;
+    p.planecopy_sp_shl_pad = planecopy_sp_shl_pad_sse41;
+    p.resample_h_cs = resample_h_sse41<uint8_t>;
+    p.resample_h_ss = resample_h_sse41<uint16_t>;
+    p.resample_v_sc = resample_v_sse41<uint8_t>;
+    p.resample_v_ss = resample_v_sse41<uint16_t>;
+#if HIGH_BIT_DEPTH
+    p.planecopy_sp_clip = planecopy_sp_clip_sse41;
+#else
+#define LUMA_PU(W, H) \
+    p.pu[LUMA_ ## W ## x ## H].sad = sad_sse41<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_x3 = sad_x3_sse41<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_x4 = sad_x4_sse41<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].sad_x8 = sad_x8_sse41<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].satd = satd_sse41<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].luma_hpp = interp_horiz_pp_sse41<W, H>; \
+    p.pu[LUMA_ ## W ## x ## H].luma_vpp = interp_vert_pp_sse41<W, H>
+
+    LUMA_PU(4, 4);   LUMA_PU(8, 8);   LUMA_PU(16, 16); LUMA_PU(32, 32); LUMA_PU(64, 64);
+    LUMA_PU(8, 4);   LUMA_PU(4, 8);   LUMA_PU(16, 8);  LUMA_PU(8, 16);
+    LUMA_PU(32, 16); LUMA_PU(16, 32); LUMA_PU(64, 32); LUMA_PU(32, 64);
+    LUMA_PU(16, 12); LUMA_PU(12, 16); LUMA_PU(16, 4);  LUMA_PU(4, 16);
+    LUMA_PU(32, 24); LUMA_PU(24, 32); LUMA_PU(32, 8);  LUMA_PU(8, 32);
+    LUMA_PU(64, 48); LUMA_PU(48, 64); LUMA_PU(64, 16); LUMA_PU(16, 64);
+#undef LUMA_PU
+
+    p.cu[BLOCK_4x4].sa8d = satd_sse41<4, 4>;
+    p.cu[BLOCK_8x8].sa8d = sa8d_8x8_sse41;
+    p.cu[BLOCK_16x16].sa8d = sa8d_sse41<16>;
+    p.cu[BLOCK_32x32].sa8d = sa8d_sse41<32>;
+    p.cu[BLOCK_64x64].sa8d = sa8d_sse41<64>;
+#endif
+}
+}
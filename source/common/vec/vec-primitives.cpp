@@ -31,6 +31,7 @@
 #define HAVE_SSSE3
 #define HAVE_SSE4
 #define HAVE_AVX2
+#define HAVE_AVX512
 #elif defined(__GNUC__)
 #define GCC_VERSION (__GNUC__ * 10000 + __GNUC_MINOR__ * 100 + __GNUC_PATCHLEVEL__)
 #if __clang__ || GCC_VERSION >= 40300 /* gcc_version >= gcc-4.3.0 */
@@ -41,6 +42,9 @@
 #if __clang__ || GCC_VERSION >= 40700 /* gcc_version >= gcc-4.7.0 */
 #define HAVE_AVX2
 #endif
+#if __clang__ || GCC_VERSION >= 50000 /* gcc_version >= gcc-5.0.0 */
+#define HAVE_AVX512
+#endif
 #elif defined(_MSC_VER)
 #define HAVE_SSE3
 #define HAVE_SSSE3
@@ -48,6 +52,9 @@
 #if _MSC_VER >= 1700 // VC11
 #define HAVE_AVX2
 #endif
+#if _MSC_VER >= 1911 // VC15.3
+#define HAVE_AVX512
+#endif
 #endif // compiler checks
 #endif // if X265_ARCH_X86
 
@@ -57,6 +64,11 @@ namespace X265_NS {
 void setupIntrinsicDCT_sse3(EncoderPrimitives&);
 void setupIntrinsicDCT_ssse3(EncoderPrimitives&);
 void setupIntrinsicDCT_sse41(EncoderPrimitives&);
+void setupIntrinsicPixel_sse41(EncoderPrimitives&);
+void setupIntrinsicDCT_avx2(EncoderPrimitives&);
+void setupIntrinsicPixel_avx2(EncoderPrimitives&);
+void setupIntrinsicDCT_avx512(EncoderPrimitives&);
+void setupIntrinsicPixel_avx512(EncoderPrimitives&);
 
 /* Use primitives for the best available vector architecture */
 void setupInstrinsicPrimitives(EncoderPrimitives &p, int cpuMask)
@@ -77,6 +89,29 @@ void setupInstrinsicPrimitives(EncoderPrimitives &p, int cpuMask)
     if (cpuMask & X265_CPU_SSE4)
     {
         setupIntrinsicDCT_sse41(p);
+        setupIntrinsicPixel_sse41(p);
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (cpuMask & X265_CPU_AVX2)
+    {
+        setupIntrinsicDCT_avx2(p);
+        setupIntrinsicPixel_avx2(p);
+    }
+#endif
+    (void)p;
+    (void)cpuMask;
+}
+
+/* Called after the assembly primitives are set up, for the primitives which
+ * have no AVX-512 assembly implementation */
+void setupInstrinsicPrimitives_avx512(EncoderPrimitives &p, int cpuMask)
+{
+#ifdef HAVE_AVX512
+    if (cpuMask & X265_CPU_AVX512)
+    {
+        setupIntrinsicDCT_avx512(p);
+        setupIntrinsicPixel_avx512(p);
     }
 #endif
     (void)p;
@@ -39,6 +39,26 @@ Yuv::Yuv()
 }
 
 bool Yuv::create(uint32_t size, int csp)
+{
+    pixel* buf;
+    CHECKED_MALLOC(buf, pixel, bufferSize(size, csp));
+    setBuffer(size, csp, buf);
+    return true;
+
+fail:
+    return false;
+}
+
+size_t Yuv::bufferSize(uint32_t size, int csp)
+{
+    size_t sizeL = size * size;
+    size_t sizeC = csp == X265_CSP_I400 ? 0 : sizeL >> (CHROMA_V_SHIFT(csp) + CHROMA_H_SHIFT(csp));
+
+    // padded for SIMD reads
+    return (sizeL + sizeC * 2 + 8 + 63) & ~(size_t)63;
+}
+
+void Yuv::setBuffer(uint32_t size, int csp, pixel* buf)
 {
     m_csp = csp;
     m_hChromaShift = CHROMA_H_SHIFT(csp);
@@ -46,13 +66,12 @@ bool Yuv::create(uint32_t size, int csp)
 
     m_size  = size;
     m_part = partitionFromSizes(size, size);
+    m_buf[0] = buf;
 
     if (csp == X265_CSP_I400)
     {
-        CHECKED_MALLOC(m_buf[0], pixel, size * size + 8);
         m_buf[1] = m_buf[2] = 0;
         m_csize = 0;
-        return true;
     }
     else
     {
@@ -63,15 +82,9 @@ bool Yuv::create(uint32_t size, int csp)
 
         X265_CHECK((sizeC & 15) == 0, "invalid size");
 
-        // memory allocation (padded for SIMD reads)
-        CHECKED_MALLOC(m_buf[0], pixel, sizeL + sizeC * 2 + 8);
         m_buf[1] = m_buf[0] + sizeL;
         m_buf[2] = m_buf[0] + sizeL + sizeC;
-        return true;
     }
-
-fail:
-    return false;
 }
 
 void Yuv::destroy()
@@ -54,6 +54,12 @@ public:
     bool   create(uint32_t size, int csp);
     void   destroy();
 
+    // Pixels allocated by create(), a multiple of 64 so Yuvs packed in one buffer stay aligned
+    static size_t bufferSize(uint32_t size, int csp);
+
+    // Use caller owned memory of bufferSize() pixels, destroy() must not be called
+    void   setBuffer(uint32_t size, int csp, pixel* buf);
+
     // Copy YUV buffer to picture buffer
     void   copyToPicYuv(PicYuv& destPicYuv, uint32_t cuAddr, uint32_t absPartIdx) const;
 
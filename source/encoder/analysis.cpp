@@ -75,6 +75,10 @@ Analysis::Analysis()
     m_reuseInterDataCTU = NULL;
     m_reuseRef = NULL;
     m_bHD = false;
+    m_modeMask = 0;
+    m_bTryRect = false;
+    for (int i = 0; i < NUM_CU_DEPTH; i++)
+        m_modeDepth[i].yuvMemBlock = NULL;
 }
 bool Analysis::create(ThreadLocalData *tld)
 {
@@ -92,24 +96,140 @@ bool Analysis::create(ThreadLocalData *tld)
 
     bool ok = true;
     for (uint32_t depth = 0; depth <= g_maxCUDepth; depth++, cuSize >>= 1)
-    {
-        ModeDepth &md = m_modeDepth[depth];
+        ok &= m_modeDepth[depth].fencYuv.create(cuSize, csp);
+    ok &= reserveModes(*m_param);
 
-        md.cuMemPool.create(depth, csp, MAX_PRED_TYPES);
-        ok &= md.fencYuv.create(cuSize, csp);
+    if (m_param->sourceHeight >= 1080)
+        m_bHD = true;
 
-        for (int j = 0; j < MAX_PRED_TYPES; j++)
+    return ok;
+}
+
+/* Only the modes the param set enables get prediction, recon and CU buffers,
+ * packed together per depth. With rect, AMP, lossless and B frames disabled
+ * this is fewer than half of MAX_PRED_TYPES. Called again at the start of each
+ * CTU row since a reconfigure may enable rect modes; buffers are never
+ * released before destroy() */
+bool Analysis::reserveModes(const x265_param& param)
+{
+    uint32_t modes = requiredModes(param, m_bTryLossless);
+    if ((m_modeMask & modes) != modes)
+    {
+        modes |= m_modeMask;
+
+        int csp = param.internalCsp;
+        uint32_t cuSize = g_maxCUSize;
+        for (uint32_t depth = 0; depth <= g_maxCUDepth; depth++, cuSize >>= 1)
         {
-            md.pred[j].cu.initialize(md.cuMemPool, depth, csp, j);
-            ok &= md.pred[j].predYuv.create(cuSize, csp);
-            ok &= md.pred[j].reconYuv.create(cuSize, csp);
-            md.pred[j].fencYuv = &md.fencYuv;
+            ModeDepth &md = m_modeDepth[depth];
+
+            uint32_t allocModes = depthModes(modes, cuSize, depth == g_maxCUDepth);
+
+            int numModes = 0;
+            for (int j = 0; j < MAX_PRED_TYPES; j++)
+                numModes += (allocModes >> j) & 1;
+
+            /* keep the current buffers of this depth until the new ones exist */
+            CUDataMemPool cuMemPool;
+            size_t yuvSize = Yuv::bufferSize(cuSize, csp);
+            pixel* yuvMemBlock = X265_MALLOC(pixel, yuvSize * 2 * numModes);
+            if (!yuvMemBlock || !cuMemPool.create(depth, csp, numModes))
+            {
+                x265_log(&param, X265_LOG_ERROR, "unable to allocate analysis mode buffers\n");
+                cuMemPool.destroy();
+                X265_FREE(yuvMemBlock);
+                m_bTryRect = param.bEnableRectInter && (m_modeMask & (1 << PRED_Nx2N));
+                return false;
+            }
+
+            md.cuMemPool.destroy();
+            X265_FREE(md.yuvMemBlock);
+            md.cuMemPool = cuMemPool;
+            md.yuvMemBlock = yuvMemBlock;
+
+            pixel* yuvBuf = yuvMemBlock;
+            int instance = 0;
+            for (int j = 0; j < MAX_PRED_TYPES; j++)
+            {
+                if (!(allocModes & (1 << j)))
+                    continue;
+
+                md.pred[j].cu.initialize(md.cuMemPool, depth, csp, instance++);
+                md.pred[j].predYuv.setBuffer(cuSize, csp, yuvBuf);
+                md.pred[j].reconYuv.setBuffer(cuSize, csp, yuvBuf + yuvSize);
+                md.pred[j].fencYuv = &md.fencYuv;
+                yuvBuf += yuvSize * 2;
+            }
         }
+
+        m_modeMask = modes;
     }
-    if (m_param->sourceHeight >= 1080)
-        m_bHD = true;
 
-    return ok;
+    m_bTryRect = !!param.bEnableRectInter;
+    return true;
+}
+
+uint32_t Analysis::requiredModes(const x265_param& param, bool bTryLossless)
+{
+    uint32_t modes = (1 << PRED_MERGE) | (1 << PRED_SKIP) | (1 << PRED_INTRA) | (1 << PRED_2Nx2N) |
+                     (1 << PRED_SPLIT) | (1 << PRED_INTRA_NxN);
+    if (param.bframes)
+        modes |= 1 << PRED_BIDIR;
+    if (param.bEnableRectInter)
+        modes |= (1 << PRED_Nx2N) | (1 << PRED_2NxN);
+    if (param.bEnableAMP)
+        modes |= (1 << PRED_2NxnU) | (1 << PRED_2NxnD) | (1 << PRED_nLx2N) | (1 << PRED_nRx2N);
+    if (bTryLossless)
+        modes |= 1 << PRED_LOSSLESS;
+    return modes;
+}
+
+uint32_t Analysis::depthModes(uint32_t modes, uint32_t cuSize, bool bLastDepth)
+{
+    /* intra NxN is only tried for 8x8 CUs and AMP never at the last depth */
+    if (cuSize != 8)
+        modes &= ~(1 << PRED_INTRA_NxN);
+    if (bLastDepth)
+        modes &= ~((1 << PRED_2NxnU) | (1 << PRED_2NxnD) | (1 << PRED_nLx2N) | (1 << PRED_nRx2N));
+    return modes;
+}
+
+/* Mirrors create(), reserveModes() and Search::initSearch(); used to plan
+ * --max-memory before any worker thread exists */
+int64_t Analysis::estimateMemory(const x265_param& param)
+{
+    int csp = param.internalCsp;
+    bool bTryLossless = param.bCULossless && !param.bLossless && param.rdLevel >= 2;
+    uint32_t modes = requiredModes(param, bTryLossless);
+    uint32_t maxDepth = g_log2Size[param.maxCUSize] - g_log2Size[param.minCUSize];
+    int chromaShift = csp == X265_CSP_I400 ? -1 : CHROMA_H_SHIFT(csp) + CHROMA_V_SHIFT(csp);
+
+    int64_t bytes = 0;
+    uint32_t cuSize = param.maxCUSize;
+    for (uint32_t depth = 0; depth <= maxDepth; depth++, cuSize >>= 1)
+    {
+        uint32_t allocModes = depthModes(modes, cuSize, depth == maxDepth);
+        int numModes = 0;
+        for (int j = 0; j < MAX_PRED_TYPES; j++)
+            numModes += (allocModes >> j) & 1;
+
+        int64_t numPartition = (int64_t)cuSize * cuSize / 16;
+        int64_t sizeL = (int64_t)cuSize * cuSize;
+        int64_t coeffs = sizeL + (chromaShift < 0 ? 0 : 2 * (sizeL >> chromaShift));
+        int64_t yuvBytes = Yuv::bufferSize(cuSize, csp) * sizeof(pixel);
+        int64_t cuBytes = numPartition * (CUData::BytesPerPartition + 4 * sizeof(MV)) + coeffs * sizeof(coeff_t);
+
+        /* pred and recon Yuv and CU data per mode, fencYuv; RQT tmpResiYuv, tmpPredYuv and bidirPredYuv */
+        bytes += numModes * (2 * yuvBytes + cuBytes) + 4 * yuvBytes + coeffs * sizeof(int16_t);
+    }
+
+    /* one RQT layer per transform size: coefficients, reconQtYuv and resiQtYuv of the max CU size */
+    int64_t maxSizeL = (int64_t)param.maxCUSize * param.maxCUSize;
+    int64_t maxCoeffs = maxSizeL + (chromaShift < 0 ? 0 : 2 * (maxSizeL >> chromaShift));
+    int64_t layerBytes = maxCoeffs * (sizeof(coeff_t) + sizeof(int16_t)) + Yuv::bufferSize(param.maxCUSize, csp) * sizeof(pixel);
+    bytes += (g_log2Size[param.maxCUSize] - 1) * layerBytes;
+
+    return bytes;
 }
 
 void Analysis::destroy()
@@ -118,12 +238,7 @@ void Analysis::destroy()
     {
         m_modeDepth[i].cuMemPool.destroy();
         m_modeDepth[i].fencYuv.destroy();
-
-        for (int j = 0; j < MAX_PRED_TYPES; j++)
-        {
-            m_modeDepth[i].pred[j].predYuv.destroy();
-            m_modeDepth[i].pred[j].reconYuv.destroy();
-        }
+        X265_FREE_ZERO(m_modeDepth[i].yuvMemBlock);
     }
     X265_FREE(cacheCost);
 }
@@ -134,6 +249,9 @@ Mode& Analysis::compressCTU(CUData& ctu, Frame& frame, const CUGeom& cuGeom, con
     m_frame = &frame;
     m_bChromaSa8d = m_param->rdLevel >= 3;
 
+    if (m_param->bEnableMECache)
+        resetMECache();
+
 #if _DEBUG || CHECKED_BUILD
     invalidateContexts(0);
 #endif
@@ -714,8 +832,9 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
             pmode.modes[pmode.m_jobTotal++] = PRED_INTRA;
         }
         md.pred[PRED_2Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2Nx2N;
-        md.pred[PRED_BIDIR].cu.initSubCU(parentCTU, cuGeom, qp);
-        if (m_param->bEnableRectInter)
+        if (m_slice->m_sliceType == B_SLICE) /* bidir buffers are only reserved with B frames */
+            md.pred[PRED_BIDIR].cu.initSubCU(parentCTU, cuGeom, qp);
+        if (m_bTryRect)
         {
             md.pred[PRED_2NxN].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_2NxN;
             md.pred[PRED_Nx2N].cu.initSubCU(parentCTU, cuGeom, qp); pmode.modes[pmode.m_jobTotal++] = PRED_Nx2N;
@@ -749,7 +868,7 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
             /* select best inter mode based on sa8d cost */
             Mode *bestInter = &md.pred[PRED_2Nx2N];
 
-            if (m_param->bEnableRectInter)
+            if (m_bTryRect)
             {
                 if (md.pred[PRED_Nx2N].sa8dCost < bestInter->sa8dCost)
                     bestInter = &md.pred[PRED_Nx2N];
@@ -832,7 +951,7 @@ uint32_t Analysis::compressInterCU_dist(const CUData& parentCTU, const CUGeom& c
             if (m_slice->m_sliceType == B_SLICE && md.pred[PRED_BIDIR].sa8dCost < MAX_INT64)
                 checkBestMode(md.pred[PRED_BIDIR], depth);
 
-            if (m_param->bEnableRectInter)
+            if (m_bTryRect)
             {
                 checkBestMode(md.pred[PRED_Nx2N], depth);
                 checkBestMode(md.pred[PRED_2NxN], depth);
@@ -1076,7 +1195,7 @@ SplitData Analysis::compressInterCU_rd0_4(const CUData& parentCTU, const CUGeom&
             Mode *bestInter = &md.pred[PRED_2Nx2N];
             if (!skipRectAmp)
             {
-                if (m_param->bEnableRectInter)
+                if (m_bTryRect)
                 {
                     uint64_t splitCost = splitData[0].sa8dCost + splitData[1].sa8dCost + splitData[2].sa8dCost + splitData[3].sa8dCost;
                     uint32_t threshold_2NxN, threshold_Nx2N;
@@ -1607,7 +1726,7 @@ SplitData Analysis::compressInterCU_rd5_6(const CUData& parentCTU, const CUGeom&
 
             if (!skipRectAmp)
             {
-                if (m_param->bEnableRectInter)
+                if (m_bTryRect)
                 {
                     uint64_t splitCost = splitData[0].sa8dCost + splitData[1].sa8dCost + splitData[2].sa8dCost + splitData[3].sa8dCost;
                     uint32_t threshold_2NxN, threshold_Nx2N;
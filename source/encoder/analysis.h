@@ -84,6 +84,7 @@ public:
         Mode*          bestMode;
         Yuv            fencYuv;
         CUDataMemPool  cuMemPool;
+        pixel*         yuvMemBlock;  /* predYuv and reconYuv of the allocated modes */
     };
 
     class PMODE : public BondedTaskGroup
@@ -106,7 +107,9 @@ public:
     void processPmode(PMODE& pmode, Analysis& slave);
 
     ModeDepth m_modeDepth[NUM_CU_DEPTH];
+    uint32_t  m_modeMask;       /* PRED_* types with buffers in m_modeDepth, one bit each */
     bool      m_bTryLossless;
+    bool      m_bTryRect;
     bool      m_bChromaSa8d;
     bool      m_bHD;
 
@@ -115,6 +118,16 @@ public:
     bool create(ThreadLocalData* tld);
     void destroy();
 
+    /* allocate buffers for every mode the param set may evaluate */
+    bool reserveModes(const x265_param& param);
+
+    /* PRED_* types evaluated for a param set, and those of them tried at one CU size */
+    static uint32_t requiredModes(const x265_param& param, bool bTryLossless);
+    static uint32_t depthModes(uint32_t modes, uint32_t cuSize, bool bLastDepth);
+
+    /* estimated bytes of the mode analysis and RQT buffers of one worker thread */
+    static int64_t estimateMemory(const x265_param& param);
+
     Mode& compressCTU(CUData& ctu, Frame& frame, const CUGeom& cuGeom, const Entropy& initialContext);
 
 protected:
@@ -24,6 +24,9 @@
 #include "common.h"
 #include "bitstream.h"
 #include "param.h"
+#include "threadpool.h"
+#include "framepool.h"
+#include "scaler.h"
 
 #include "encoder.h"
 #include "entropy.h"
@@ -128,6 +131,8 @@ x265_encoder *x265_encoder_open(x265_param *p)
     return encoder;
 
 fail:
+    if (encoder)
+        encoder->detachSharedPool();
     delete encoder;
     PARAM_NS::x265_param_free(param);
     PARAM_NS::x265_param_free(latestParam);
@@ -218,6 +223,62 @@ int x265_encoder_encode(x265_encoder *enc, x265_nal **pp_nal, uint32_t *pi_nal,
     return numEncoded;
 }
 
+int x265_encoder_submit(x265_encoder *enc, x265_picture *pic_in)
+{
+    if (!enc)
+        return -1;
+
+    Encoder *encoder = static_cast<Encoder*>(enc);
+    int ret = encoder->submit(pic_in);
+
+    // do not allow reuse of these buffers for more than one picture. The
+    // encoder now owns these analysisData buffers.
+    if (pic_in && ret > 0)
+    {
+        pic_in->analysisData.intraData = NULL;
+        pic_in->analysisData.interData = NULL;
+    }
+
+    return ret;
+}
+
+int x265_encoder_poll(x265_encoder *enc, x265_nal **pp_nal, uint32_t *pi_nal, x265_picture *pic_out)
+{
+    if (!enc)
+        return -1;
+
+    Encoder *encoder = static_cast<Encoder*>(enc);
+    int numEncoded = encoder->poll(pic_out);
+
+    if (pp_nal && numEncoded > 0)
+    {
+        *pp_nal = &encoder->m_nalList.m_nal[0];
+        if (pi_nal) *pi_nal = encoder->m_nalList.m_numNal;
+    }
+    else if (pi_nal)
+        *pi_nal = 0;
+
+    return numEncoded;
+}
+
+void x265_encoder_set_callback(x265_encoder *enc, void (*callback)(void *opaque), void *opaque)
+{
+    if (enc)
+    {
+        Encoder *encoder = static_cast<Encoder*>(enc);
+        encoder->setCallback(callback, opaque);
+    }
+}
+
+void x265_encoder_input_layout(x265_encoder *enc, int stride[3], int offset[3], int size[3])
+{
+    if (enc)
+    {
+        Encoder *encoder = static_cast<Encoder*>(enc);
+        encoder->inputLayout(stride, offset, size);
+    }
+}
+
 void x265_encoder_get_stats(x265_encoder *enc, x265_stats *outputStats, uint32_t statsSizeBytes)
 {
     if (enc && outputStats)
@@ -269,6 +330,76 @@ void x265_cleanup(void)
     }
 }
 
+x265_pool *x265_pool_create(x265_param *param, int maxEncoders)
+{
+    if (!param || maxEncoders < 1)
+        return NULL;
+
+    if (param->numaPools && !strcmp(param->numaPools, "none"))
+        return NULL;
+
+    SharedThreadPool* pool = new SharedThreadPool;
+    if (!pool->create(param, maxEncoders))
+    {
+        delete pool;
+        return NULL;
+    }
+
+    return pool;
+}
+
+void x265_pool_free(x265_pool *p)
+{
+    if (p)
+        delete static_cast<SharedThreadPool*>(p);
+}
+
+x265_frame_pool *x265_frame_pool_create()
+{
+    return new FramePool;
+}
+
+int64_t x265_frame_pool_trim(x265_frame_pool *p)
+{
+    return p ? static_cast<FramePool*>(p)->trim() : 0;
+}
+
+void x265_frame_pool_free(x265_frame_pool *p)
+{
+    if (p)
+        delete static_cast<FramePool*>(p);
+}
+
+x265_scaler *x265_scaler_create(x265_param *param, x265_pool *pool, int srcWidth, int srcHeight, int colorSpace,
+                                int bitDepth, int numOutputs, const int *widths, const int *heights)
+{
+    if (!param || !widths || !heights)
+        return NULL;
+
+    Scaler* scaler = new Scaler;
+    if (!scaler->create(param, pool, srcWidth, srcHeight, colorSpace, bitDepth, numOutputs, widths, heights))
+    {
+        delete scaler;
+        return NULL;
+    }
+
+    return scaler;
+}
+
+int x265_scaler_scale(x265_scaler *s, const x265_picture *in, x265_picture *out)
+{
+    if (!s || !in || !out)
+        return -1;
+
+    return static_cast<Scaler*>(s)->scale(*in, out);
+}
+
+void x265_scaler_free(x265_scaler *s)
+{
+    if (s)
+        delete static_cast<Scaler*>(s);
+}
+
 x265_picture *x265_picture_alloc()
 {
     return (x265_picture*)x265_malloc(sizeof(x265_picture));
@@ -336,6 +467,18 @@ static const x265_api libapi =
 
     sizeof(x265_frame_stats),
     &x265_encoder_intra_refresh,
+    &x265_encoder_submit,
+    &x265_encoder_poll,
+    &x265_encoder_set_callback,
+    &x265_pool_create,
+    &x265_pool_free,
+    &x265_frame_pool_create,
+    &x265_frame_pool_trim,
+    &x265_frame_pool_free,
+    &x265_encoder_input_layout,
+    &x265_scaler_create,
+    &x265_scaler_scale,
+    &x265_scaler_free,
 };
 
 typedef const x265_api* (*api_get_func)(int bitDepth);
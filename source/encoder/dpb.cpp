@@ -43,6 +43,17 @@ DPB::~DPB()
     while (!m_picList.empty())
     {
         Frame* curFrame = m_picList.popFront();
+        if (m_framePool)
+        {
+            /* leave the pictures to the encoders which share the pool */
+            if (curFrame->m_encData)
+                m_framePool->returnFrameData(curFrame->m_encData);
+            curFrame->releaseInput();
+            m_framePool->returnPicture(curFrame->m_fencPic);
+            curFrame->m_encData = NULL;
+            curFrame->m_reconPic = NULL;
+            curFrame->m_fencPic = NULL;
+        }
         curFrame->destroy();
         delete curFrame;
     }
@@ -73,6 +84,7 @@ void DPB::recycleUnreferenced()
         {
             curFrame->m_reconRowCount.set(0);
             curFrame->m_bChromaExtended = false;
+            curFrame->releaseInput();
 
             // Reset column counter
             X265_CHECK(curFrame->m_reconColCount != NULL, "curFrame->m_reconColCount check failure");
@@ -85,14 +97,45 @@ void DPB::recycleUnreferenced()
             iterFrame = m_picList.first();
 
             m_freeList.pushBack(*curFrame);
-            curFrame->m_encData->m_freeListNext = m_frameDataFreeList;
-            m_frameDataFreeList = curFrame->m_encData;
+            if (m_framePool)
+            {
+                m_framePool->returnFrameData(curFrame->m_encData);
+                m_framePool->returnPicture(curFrame->m_fencPic);
+                curFrame->m_fencPic = NULL;
+                m_numFrameDataReturned++;
+                m_numPicturesReturned++;
+            }
+            else
+            {
+                curFrame->m_encData->m_freeListNext = m_frameDataFreeList;
+                m_frameDataFreeList = curFrame->m_encData;
+            }
             curFrame->m_encData = NULL;
             curFrame->m_reconPic = NULL;
         }
     }
 }
 
+/* Remove a recycled FrameData from the free list. If pool is not NULL only
+ * a FrameData allocated for that thread pool is returned, so a frame keeps
+ * its CTU data and recon picture on the NUMA node(s) of the frame encoder
+ * which uses it. Returns NULL if no suitable FrameData is available */
+FrameData* DPB::takeFrameData(const ThreadPool* pool)
+{
+    FrameData** prev = &m_frameDataFreeList;
+    for (FrameData* encData = m_frameDataFreeList; encData; encData = encData->m_freeListNext)
+    {
+        if (!pool || encData->m_allocPool == pool)
+        {
+            *prev = encData->m_freeListNext;
+            return encData;
+        }
+        prev = &encData->m_freeListNext;
+    }
+
+    return NULL;
+}
+
 void DPB::prepareEncode(Frame *newFrame)
 {
     Slice* slice = newFrame->m_encData->m_slice;
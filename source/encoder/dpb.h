@@ -25,6 +25,7 @@
 #define X265_DPB_H
 
 #include "piclist.h"
+#include "framepool.h"
 
 namespace X265_NS {
 // private namespace for x265
@@ -32,6 +33,7 @@ namespace X265_NS {
 class Frame;
 class FrameData;
 class Slice;
+class ThreadPool;
 
 class DPB
 {
@@ -46,12 +48,20 @@ public:
     PicList            m_freeList;
     FrameData*         m_frameDataFreeList;
 
+    /* with a shared frame pool, recycled frames keep only their lowres data on
+     * m_freeList; their source picture and FrameData go back to the pool */
+    FramePool*         m_framePool;
+    int                m_numPicturesReturned;
+    int                m_numFrameDataReturned;
+
     DPB(x265_param *param)
     {
         m_lastIDR = 0;
         m_pocCRA = 0;
         m_bRefreshPending = false;
         m_frameDataFreeList = NULL;
+        m_framePool = static_cast<FramePool*>(param->framePool);
+        m_numPicturesReturned = m_numFrameDataReturned = 0;
         m_bOpenGOP = param->bOpenGOP;
         m_bTemporalSublayer = !!param->bEnableTemporalSubLayers;
     }
@@ -62,6 +72,8 @@ public:
 
     void recycleUnreferenced();
 
+    FrameData* takeFrameData(const ThreadPool* pool);
+
 protected:
 
     void computeRPS(int curPoc, bool isRAP, RPS * rps, unsigned int maxDecPicBuffer);
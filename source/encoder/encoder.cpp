@@ -25,6 +25,7 @@
 #include "common.h"
 #include "primitives.h"
 #include "threadpool.h"
+#include "framepool.h"
 #include "param.h"
 #include "frame.h"
 #include "framedata.h"
@@ -49,6 +50,7 @@ const char g_sliceTypeToChar[] = {'B', 'P', 'I'};
 }
 
 static const char* defaultAnalysisFileName = "x265_analysis.dat";
+static const int adaptiveThreadingWindow = 32; // output frames measured per adaptive threading decision
 
 using namespace X265_NS;
 
@@ -59,6 +61,16 @@ Encoder::Encoder()
     m_encodedFrameNum = 0;
     m_pocLast = -1;
     m_curEncoder = 0;
+    m_activeFrameEncoders = m_targetFrameEncoders = 0;
+    m_drainFrameEncoders = 0;
+    m_lookaheadSlices = 0;
+    m_frameMemory = m_pictureMemory = m_frameDataMemory = m_fixedMemory = 0;
+    m_numFramesAllocated = m_numPicturesTaken = m_numFrameDataTaken = 0;
+    m_peakPictures = m_peakFrameData = 0;
+    m_bFlushing = false;
+    m_bWarnedInputCopy = false;
+    m_notifyCallback = NULL;
+    m_notifyOpaque = NULL;
     m_numLumaWPFrames = 0;
     m_numChromaWPFrames = 0;
     m_numLumaWPBiFrames = 0;
@@ -72,6 +84,8 @@ Encoder::Encoder()
     m_param = NULL;
     m_latestParam = NULL;
     m_threadPool = NULL;
+    m_sharedPool = NULL;
+    m_framePool = NULL;
     m_analysisFile = NULL;
 	m_mrDataFile = NULL;
     m_offsetEmergency = NULL;
@@ -102,7 +116,7 @@ void Encoder::create()
         p->bEnableWavefront = 0;
     }
 
-    bool allowPools = !p->numaPools || strcmp(p->numaPools, "none");
+    bool allowPools = p->pool || !p->numaPools || strcmp(p->numaPools, "none");
 
     // Trim the thread pool if --wpp, --pme, and --pmode are disabled
     if (!p->bEnableWavefront && !p->bDistributeModeAnalysis && !p->bDistributeMotionEstimation && !p->lookaheadSlices)
@@ -127,7 +141,20 @@ void Encoder::create()
     }
 
     m_numPools = 0;
-    if (allowPools)
+    if (allowPools && p->pool)
+    {
+        SharedThreadPool* sharedPool = static_cast<SharedThreadPool*>(p->pool);
+        if (!sharedPool->attachEncoder())
+        {
+            x265_log(p, X265_LOG_ERROR, "shared thread pool is already in use by %d encoders\n", sharedPool->m_maxEncoders);
+            m_aborted = true;
+            return;
+        }
+        m_sharedPool = sharedPool;
+        m_threadPool = sharedPool->m_pools;
+        m_numPools = sharedPool->m_numPools;
+    }
+    else if (allowPools)
         m_threadPool = ThreadPool::allocThreadPools(p, m_numPools);
 
     if (!m_numPools)
@@ -146,6 +173,24 @@ void Encoder::create()
         p->bEnableWavefront = p->bDistributeModeAnalysis = p->bDistributeMotionEstimation = p->lookaheadSlices = 0;
     }
 
+#if !__linux__
+    if (p->bHugePages)
+    {
+        x265_log(p, X265_LOG_WARNING, "Huge page allocation is only supported on Linux, disabled\n");
+        p->bHugePages = 0;
+    }
+#endif
+
+    planMemory();
+    if (!m_sharedPool)
+        ThreadPool::logThreadPools(p, m_threadPool, m_numPools);
+
+    if (p->bAdaptiveThreading && (!m_numPools || m_sharedPool || p->frameNumThreads < 2))
+    {
+        x265_log(p, X265_LOG_WARNING, "Adaptive threading requires a private thread pool and more than one frame thread, disabled\n");
+        p->bAdaptiveThreading = 0;
+    }
+
     if (!p->bEnableWavefront && p->rc.vbvBufferSize)
     {
         x265_log(p, X265_LOG_ERROR, "VBV requires wavefront parallelism\n");
@@ -163,7 +208,7 @@ void Encoder::create()
     if (!len)
         strcpy(buf, "none");
 
-    x265_log(p, X265_LOG_INFO, "frame threads / pool features       : %d / %s\n", p->frameNumThreads, buf);
+    x265_log(p, X265_LOG_INFO, "frame threads / pool features       : %d%s / %s\n", p->frameNumThreads, p->bAdaptiveThreading ? " (adaptive)" : "", buf);
 
     for (int i = 0; i < m_param->frameNumThreads; i++)
     {
@@ -173,15 +218,19 @@ void Encoder::create()
 
     if (m_numPools)
     {
+        /* jpId is the frame encoder's index among this encoder's job providers
+         * in its pool; a shared pool also holds other encoders' providers */
         for (int i = 0; i < m_param->frameNumThreads; i++)
         {
-            int pool = i % m_numPools;
-            m_frameEncoder[i]->m_pool = &m_threadPool[pool];
-            m_frameEncoder[i]->m_jpId = m_threadPool[pool].m_numProviders++;
-            m_threadPool[pool].m_jpTable[m_frameEncoder[i]->m_jpId] = m_frameEncoder[i];
+            m_frameEncoder[i]->m_jpId = i / m_numPools;
+            m_frameEncoder[i]->m_poolPriority = p->poolPriority;
+            m_threadPool[i % m_numPools].addProvider(*m_frameEncoder[i]);
+        }
+        if (!m_sharedPool)
+        {
+            for (int i = 0; i < m_numPools; i++)
+                m_threadPool[i].start();
         }
-        for (int i = 0; i < m_numPools; i++)
-            m_threadPool[i].start();
     }
     else
     {
@@ -206,10 +255,16 @@ void Encoder::create()
     m_lookahead = new Lookahead(m_param, m_threadPool);
     if (m_numPools)
     {
-        m_lookahead->m_jpId = m_threadPool[0].m_numProviders++;
-        m_threadPool[0].m_jpTable[m_lookahead->m_jpId] = m_lookahead;
+        m_lookahead->m_jpId = (m_param->frameNumThreads + m_numPools - 1) / m_numPools;
+        m_lookahead->m_poolPriority = p->poolPriority;
+        m_threadPool[0].addProvider(*m_lookahead);
     }
 
+    m_activeFrameEncoders = m_targetFrameEncoders = m_param->frameNumThreads;
+    m_lookaheadSlices = m_param->lookaheadSlices;
+    resetThreadingWindow();
+
+    m_framePool = static_cast<FramePool*>(p->framePool);
     m_dpb = new DPB(m_param);
     m_rateControl = new RateControl(*m_param);
 
@@ -297,6 +352,8 @@ void Encoder::create()
     int numCols = (m_param->sourceWidth  + g_maxCUSize - 1) / g_maxCUSize;
     for (int i = 0; i < m_param->frameNumThreads; i++)
     {
+        /* the frame encoder's row and CTU state is used by the workers of its pool */
+        ScopedNumaPolicy numa(m_frameEncoder[i]->m_pool);
         if (!m_frameEncoder[i]->init(this, numRows, numCols))
         {
             x265_log(m_param, X265_LOG_ERROR, "Unable to initialize frame encoder, aborting\n");
@@ -368,13 +425,40 @@ void Encoder::stopJobs()
         }
     }
 
-    if (m_threadPool)
+    if (m_sharedPool)
+        detachSharedPool();
+    else if (m_threadPool)
     {
         for (int i = 0; i < m_numPools; i++)
             m_threadPool[i].stopWorkers();
     }
 }
 
+/* Remove this encoder's job providers from the shared pool's worker threads,
+ * once they have no more work. The other encoders using the pool are
+ * unaffected */
+void Encoder::detachSharedPool()
+{
+    if (!m_sharedPool)
+        return;
+
+    for (int i = 0; i < m_numPools; i++)
+    {
+        JobProvider* providers[X265_MAX_FRAME_THREADS + 1];
+        int count = 0;
+        for (int j = 0; j < m_param->frameNumThreads; j++)
+        {
+            if (m_frameEncoder[j] && m_frameEncoder[j]->m_pool == &m_threadPool[i])
+                providers[count++] = m_frameEncoder[j];
+        }
+        if (m_lookahead && m_lookahead->m_pool == &m_threadPool[i])
+            providers[count++] = m_lookahead;
+        m_threadPool[i].removeProviders(providers, count);
+    }
+
+    m_sharedPool->detachEncoder();
+}
+
 void Encoder::destroy()
 {
     if (m_exportedPic)
@@ -393,8 +477,9 @@ void Encoder::destroy()
     }
 
     // thread pools can be cleaned up now that all the JobProviders are
-    // known to be shutdown
-    delete [] m_threadPool;
+    // known to be shutdown. A shared pool belongs to the application
+    if (!m_sharedPool)
+        delete [] m_threadPool;
 
     if (m_lookahead)
     {
@@ -423,6 +508,7 @@ void Encoder::destroy()
         free((char*)m_param->rc.lambdaFileName);
         free((char*)m_param->rc.statFileName);
         free((char*)m_param->analysisFileName);
+        free((char*)m_param->asmAutotuneFile);
         free((char*)m_param->scalingLists);
         free((char*)m_param->numaPools);
         free((char*)m_param->masteringDisplayColorVolume);
@@ -451,6 +537,263 @@ void Encoder::updateVbvPlan(RateControl* rc)
     }
 }
 
+/* Adaptive threading: measure where the frame encoders spent their time over
+ * a window of output frames and adjust the parallelism of the next window.
+ * Lookahead stalls are addressed with more cost estimate slices; idle workers
+ * with few reference stalls with more frame encoders; frames that mostly wait
+ * on each other's reconstructed rows with fewer frame encoders. A frame encoder
+ * change drains the pipeline first, see encode() */
+void Encoder::tuneThreading(FrameEncoder* curEncoder)
+{
+    if (m_drainFrameEncoders)
+        return;
+
+    /* frames started before the window began are not measured */
+    if (++m_tuneFrames <= 0)
+    {
+        if (!m_tuneFrames)
+            m_tuneWindowStart = x265_mdate();
+        return;
+    }
+
+    m_tuneWorkerTime += curEncoder->m_totalWorkerElapsedTime;
+    m_tuneCompressTime += curEncoder->m_endCompressTime - curEncoder->m_startCompressTime;
+    m_tuneDecideWaitTime += curEncoder->m_slicetypeWaitTime;
+    if (curEncoder->m_allRowsAvailableTime)
+        m_tuneRefWaitTime += curEncoder->m_allRowsAvailableTime - curEncoder->m_startCompressTime;
+
+    if (m_tuneFrames < adaptiveThreadingWindow)
+        return;
+
+    int numWorkers = 0;
+    for (int i = 0; i < m_numPools; i++)
+        numWorkers += m_threadPool[i].m_numWorkers;
+
+    int64_t elapsed = X265_MAX(x265_mdate() - m_tuneWindowStart, 1);
+    double utilization = (double)m_tuneWorkerTime / (elapsed * X265_MAX(numWorkers, 1));
+    double refWait = (double)m_tuneRefWaitTime / X265_MAX(m_tuneCompressTime, 1);
+    double decideWait = (double)m_tuneDecideWaitTime / X265_MAX(m_tuneCompressTime + m_tuneDecideWaitTime, 1);
+
+    int frameEncoders = m_activeFrameEncoders;
+    int slices = m_lookaheadSlices;
+    int maxSlices = X265_MIN(16, m_lookahead->m_8x8Height / 10);
+
+    if (decideWait > 0.2)
+    {
+        /* more frame encoders cannot help while they are starved by the lookahead */
+        if (slices && slices < maxSlices)
+            slices++;
+    }
+    else if (utilization < 0.8 && refWait < 0.3)
+    {
+        if (frameEncoders < m_param->frameNumThreads)
+            frameEncoders++;
+    }
+    else if (refWait > 0.5 && frameEncoders > 2)
+        frameEncoders--; // never below two, frame parallel encodes remain comparable
+
+    if (decideWait < 0.02 && slices > 1)
+        slices--;
+
+    x265_log(m_param, X265_LOG_DEBUG, "adaptive threading: worker utilization %.1f%%, ref wait %.1f%%, decide wait %.1f%%\n",
+             100.0 * utilization, 100.0 * refWait, 100.0 * decideWait);
+
+    if (frameEncoders != m_activeFrameEncoders || slices != m_lookaheadSlices)
+        x265_log(m_param, X265_LOG_INFO, "adaptive threading: frame threads %d -> %d, lookahead slices %d -> %d after frame %d\n",
+                 m_activeFrameEncoders, frameEncoders, m_lookaheadSlices, slices, m_encodedFrameNum);
+
+    if (slices != m_lookaheadSlices)
+    {
+        m_lookahead->setCoopSlices(slices);
+        m_lookaheadSlices = slices;
+    }
+
+    if (frameEncoders != m_activeFrameEncoders)
+    {
+        /* this call counts as the first of the drain */
+        m_targetFrameEncoders = frameEncoders;
+        m_drainFrameEncoders = m_activeFrameEncoders;
+    }
+    else
+        resetThreadingWindow();
+}
+
+void Encoder::resetThreadingWindow()
+{
+    /* the first frames output after a change were started under the previous
+     * configuration or were held up by the drain, skip them */
+    m_tuneFrames = -m_activeFrameEncoders;
+    m_tuneWindowStart = 0;
+    m_tuneWorkerTime = m_tuneCompressTime = m_tuneRefWaitTime = m_tuneDecideWaitTime = 0;
+}
+
+/* bytes of a picture plane, rounded as x265_malloc_huge() maps it */
+static int64_t planeBytes(int64_t bytes, bool bHugePages)
+{
+    const int64_t hugePage = 2 * 1024 * 1024;
+    if (bHugePages && bytes >= hugePage / 2)
+        return (bytes + hugePage - 1) & ~(hugePage - 1);
+    return bytes;
+}
+
+/* estimated bytes of a source or recon picture, mirrors PicYuv::create() */
+static int64_t estimatePicYuv(const x265_param* p)
+{
+    bool bHuge = !!p->bHugePages;
+    int64_t width = (int64_t)((p->sourceWidth + p->maxCUSize - 1) / p->maxCUSize) * p->maxCUSize;
+    int64_t height = (int64_t)((p->sourceHeight + p->maxCUSize - 1) / p->maxCUSize) * p->maxCUSize;
+    int64_t marginX = p->maxCUSize + 32;
+    int64_t marginY = p->maxCUSize + 16;
+
+    int64_t bytes = planeBytes((width + 2 * marginX) * (height + 2 * marginY) * sizeof(pixel), bHuge);
+    if (p->internalCsp != X265_CSP_I400)
+    {
+        int hShift = CHROMA_H_SHIFT(p->internalCsp), vShift = CHROMA_V_SHIFT(p->internalCsp);
+        int64_t chroma = ((width >> hShift) + 2 * marginX) * ((height >> vShift) + 2 * (marginY >> vShift));
+        bytes += 2 * planeBytes(chroma * sizeof(pixel), bHuge);
+    }
+    return bytes;
+}
+
+/* estimated bytes of the lowres planes and lookahead data of a Frame, mirrors Lowres::create() */
+static int64_t estimateLowres(const x265_param* p)
+{
+    int64_t width = p->sourceWidth / 2;
+    int64_t lines = p->sourceHeight / 2;
+    int64_t marginX = p->maxCUSize + 32;
+    int64_t marginY = p->maxCUSize + 16;
+    int64_t stride = (width + 2 * marginX + 31) & ~31;
+    int64_t blocksInRow = (width + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS;
+    int64_t blocksInCol = (lines + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS;
+    int64_t cuCount = blocksInRow * blocksInCol;
+    int64_t planeSize = stride * (blocksInCol * X265_LOWRES_CU_SIZE + 2 * marginY);
+
+    int64_t bytes = planeBytes(4 * planeSize * sizeof(pixel), !!p->bHugePages);
+    int64_t perCU = sizeof(uint16_t) + sizeof(int32_t) + sizeof(uint8_t);
+    if (p->rc.aqMode)
+        perCU += 2 * sizeof(double) + sizeof(int) + sizeof(uint32_t);
+    perCU += (int64_t)(p->bframes + 2) * (p->bframes + 2) * sizeof(uint16_t);
+    perCU += (int64_t)(p->bframes + 1) * 2 * (sizeof(MV) + sizeof(int32_t));
+    bytes += cuCount * perCU + (int64_t)(p->bframes + 2) * (p->bframes + 2) * blocksInCol * sizeof(int32_t);
+    return bytes;
+}
+
+/* Estimate the size of the objects whose number --max-memory plans. poolWorkers
+ * is the total worker count of the thread pools, 0 without pools */
+void Encoder::estimateMemory(int poolWorkers)
+{
+    const x265_param* p = m_param;
+    int64_t numCUs = (int64_t)((p->sourceWidth + p->maxCUSize - 1) / p->maxCUSize) *
+                     ((p->sourceHeight + p->maxCUSize - 1) / p->maxCUSize);
+    int64_t numRows = (p->sourceHeight + p->maxCUSize - 1) / p->maxCUSize;
+    int64_t sizeL = (int64_t)p->maxCUSize * p->maxCUSize;
+    int64_t coeffs = sizeL;
+    if (p->internalCsp != X265_CSP_I400)
+        coeffs += 2 * (sizeL >> (CHROMA_H_SHIFT(p->internalCsp) + CHROMA_V_SHIFT(p->internalCsp)));
+    int64_t numPartition = sizeL / 16;
+
+    m_frameMemory = sizeof(Frame) + estimateLowres(p);
+    m_pictureMemory = sizeof(PicYuv) + estimatePicYuv(p);
+
+    int64_t ctuBytes = sizeof(CUData) + sizeof(FrameData::RCStatCU) + coeffs * sizeof(coeff_t) +
+                       numPartition * (CUData::BytesPerPartition + 4 * sizeof(MV));
+    m_frameDataMemory = sizeof(FrameData) + estimatePicYuv(p) + numCUs * ctuBytes +
+                        numRows * sizeof(FrameData::RCStatRow);
+    if (p->subpelPlanes) /* mirrors PicYuv::createSubpelPlanes() */
+    {
+        int64_t width = numCUs / numRows * p->maxCUSize + 2 * (p->maxCUSize + 32);
+        int64_t height = numRows * p->maxCUSize + 2 * (p->maxCUSize + 16);
+        m_frameDataMemory += planeBytes((p->subpelPlanes == 1 ? 3 : 15) * width * height * sizeof(pixel), !!p->bHugePages);
+    }
+
+    /* one set of analysis buffers per pool worker, plus one per frame encoder
+     * when it encodes rows itself */
+    int numTLD = poolWorkers + ((!poolWorkers || !p->bEnableWavefront) ? p->frameNumThreads : 0);
+    m_fixedMemory = numTLD * Analysis::estimateMemory(*p) +
+                    p->frameNumThreads * (sizeof(FrameEncoder) + numRows * sizeof(CTURow));
+}
+
+/* estimated bytes of the encoder with every picture buffer its settings allow
+ * allocated; the Frame count bounds the input queue, see submit() */
+int64_t Encoder::plannedMemory() const
+{
+    const x265_param* p = m_param;
+    int numFrames = p->frameNumThreads + p->lookaheadDepth + 2 * p->bframes + 3 + p->maxNumReferences;
+    int numFrameData = p->frameNumThreads + p->maxNumReferences + 1;
+    return m_fixedMemory + numFrames * (m_frameMemory + m_pictureMemory) + numFrameData * m_frameDataMemory;
+}
+
+/* Fit the encoder to --max-memory. Lookahead depth is reduced first since it
+ * costs the least compression while it remains 10 or more frames, then frame
+ * threads, then lookahead down to its minimum and at last the worker threads
+ * of a private pool. Called before frame encoders and lookahead are created */
+void Encoder::planMemory()
+{
+    x265_param* p = m_param;
+    int poolWorkers = 0;
+    for (int i = 0; i < m_numPools; i++)
+        poolWorkers += m_threadPool[i].m_numWorkers;
+    estimateMemory(poolWorkers);
+
+    if (!p->maxMemory)
+        return;
+
+    const int64_t budget = (int64_t)p->maxMemory * 1024 * 1024;
+    int64_t initial = plannedMemory();
+    int minLookahead = p->lookaheadDepth ? p->bframes + 1 : 0;
+
+    while (plannedMemory() > budget && p->lookaheadDepth > X265_MAX(minLookahead, 10))
+        p->lookaheadDepth--;
+    while (plannedMemory() > budget && p->frameNumThreads > 1)
+    {
+        p->frameNumThreads--;
+        estimateMemory(poolWorkers);
+    }
+    while (plannedMemory() > budget && p->lookaheadDepth > minLookahead)
+        p->lookaheadDepth--;
+
+    /* a shared pool is sized by the application, and its workers are not ours
+     * to remove. Each private pool keeps its NUMA nodes and at least one
+     * worker; workers are taken from the pool which keeps the largest share
+     * of its own, so the pools shrink in proportion */
+    int workers = poolWorkers;
+    if (m_numPools && !m_sharedPool)
+    {
+        int* keep = X265_MALLOC(int, m_numPools);
+        for (int i = 0; keep && i < m_numPools; i++)
+            keep[i] = m_threadPool[i].m_numWorkers;
+
+        while (keep && plannedMemory() > budget && workers > m_numPools)
+        {
+            int best = -1;
+            for (int i = 0; i < m_numPools; i++)
+            {
+                if (keep[i] > 1 && (best < 0 || keep[i] * m_threadPool[best].m_numWorkers > keep[best] * m_threadPool[i].m_numWorkers))
+                    best = i;
+            }
+            keep[best]--;
+            estimateMemory(--workers);
+        }
+
+        /* the pools have not been started */
+        for (int i = 0; keep && i < m_numPools; i++)
+        {
+            if (keep[i] < m_threadPool[i].m_numWorkers)
+                m_threadPool[i].removeWorkers(keep[i]);
+        }
+        X265_FREE(keep);
+    }
+
+    int64_t planned = plannedMemory();
+    if (planned > budget)
+        x265_log(p, X265_LOG_WARNING, "estimated memory use of %d MB exceeds --max-memory %d MB\n",
+                 (int)(planned >> 20), p->maxMemory);
+    x265_log(p, X265_LOG_INFO, "memory budget / estimate            : %d MB / %d MB (from %d MB)\n",
+             p->maxMemory, (int)(planned >> 20), (int)(initial >> 20));
+    x265_log(p, X265_LOG_INFO, "memory plan                         : %d frame threads, lookahead %d, %d pool threads\n",
+             p->frameNumThreads, p->lookaheadDepth, workers);
+}
+
 void Encoder::calcRefreshInterval(Frame* frameEnc)
 {
     Slice* slice = frameEnc->m_encData->m_slice;
@@ -520,6 +863,90 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
         m_dpb->recycleUnreferenced();
     }
 
+    if (addPicture(pic_in) < 0)
+        return -1;
+
+    return outputPicture(pic_out, true);
+}
+
+/**
+ * Asynchronous form of encode(), input half. Accepts pic_in unless the encoder
+ * already holds as many pictures as the lookahead and frame encoders can work
+ * on, in which case the caller must poll() before submitting it again.
+ *
+ * returns 1 if pic_in was accepted (or flushing has begun)
+ *         0 if the encoder is full
+ *         negative on malloc error or abort */
+int Encoder::submit(const x265_picture* pic_in)
+{
+    if (m_aborted)
+        return -1;
+
+    int maxDelayedPic = m_param->frameNumThreads + m_param->lookaheadDepth + 2 * m_param->bframes + 3;
+    if (pic_in && (int)m_numDelayedPic >= maxDelayedPic)
+        return 0;
+
+    return addPicture(pic_in) < 0 ? -1 : 1;
+}
+
+/**
+ * Asynchronous form of encode(), output half. Never waits for a frame encoder
+ * or for the lookahead; the round-robin only advances past a frame encoder
+ * once its frame has been output and it has been given its next frame, or
+ * there is no next frame.
+ *
+ * returns 0 if no frames are currently available for output
+ *         1 if frame was output, m_nalList contains access unit
+ *         negative on abort */
+int Encoder::poll(x265_picture* pic_out)
+{
+#if CHECKED_BUILD || _DEBUG
+    if (g_checkFailures)
+    {
+        x265_log(m_param, X265_LOG_ERROR, "encoder aborting because of internal error\n");
+        return -1;
+    }
+#endif
+    if (m_aborted)
+        return -1;
+
+    if (m_exportedPic)
+    {
+        ATOMIC_DEC(&m_exportedPic->m_countRefEncoders);
+        m_exportedPic = NULL;
+        m_dpb->recycleUnreferenced();
+    }
+
+    return outputPicture(pic_out, false);
+}
+
+void Encoder::setCallback(void (*callback)(void*), void* opaque)
+{
+    m_notifyOpaque = opaque;
+    m_notifyCallback = callback;
+    m_lookahead->m_notifyOpaque = opaque;
+    m_lookahead->m_notifyCallback = callback;
+}
+
+/* Report the plane layout, in bytes, of the source pictures this encoder
+ * allocates; input pictures with this layout are used in place */
+void Encoder::inputLayout(int stride[3], int offset[3], int size[3])
+{
+    intptr_t planeStride[3], planeOffset[3];
+    size_t planeSize[3];
+    PicYuv::planeLayout(m_param->sourceWidth, m_param->sourceHeight, m_param->internalCsp, planeStride, planeOffset, planeSize);
+    for (int i = 0; i < 3; i++)
+    {
+        stride[i] = (int)(planeStride[i] * sizeof(pixel));
+        offset[i] = (int)(planeOffset[i] * sizeof(pixel));
+        size[i] = (int)(planeSize[i] * sizeof(pixel));
+    }
+}
+
+/* Copy pic_in into a new or recycled Frame and pass it to the lookahead, or
+ * begin flushing if pic_in is NULL. returns negative on error */
+int Encoder::addPicture(const x265_picture* pic_in)
+{
     if (pic_in)
     {
         if (pic_in->bitDepth < 8 || pic_in->bitDepth > 16)
@@ -534,8 +961,20 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
         {
             inFrame = new Frame;
             x265_param* p = m_reconfigure ? m_latestParam : m_param;
-            if (inFrame->create(p, pic_in->quantOffsets))
+            if (m_framePool)
+                inFrame->m_fencPic = m_framePool->takePicture(p->sourceWidth, p->sourceHeight, p->internalCsp);
+            bool bCreated;
             {
+                /* the lowres planes are cleared here and analyzed by the lookahead's pool */
+                ScopedNumaPolicy numa(m_lookahead->m_pool);
+                bCreated = inFrame->create(p, pic_in->quantOffsets);
+            }
+            if (bCreated)
+            {
+                m_numFramesAllocated++;
+                m_numPicturesTaken++;
+                m_peakPictures = X265_MAX(m_peakPictures, m_numPicturesTaken - m_dpb->m_numPicturesReturned);
+
                 /* the first PicYuv created is asked to generate the CU and block unit offset
                  * arrays which are then shared with all subsequent PicYuv (orig and recon) 
                  * allocated by this top level encoder */
@@ -585,15 +1024,62 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
         else
         {
             inFrame = m_dpb->m_freeList.popBack();
+            if (!inFrame->m_fencPic)
+            {
+                /* the recycled frame returned its source picture to the frame pool */
+                x265_param* p = m_reconfigure ? m_latestParam : m_param;
+                PicYuv* fencPic = m_framePool->takePicture(p->sourceWidth, p->sourceHeight, p->internalCsp);
+                if (!fencPic)
+                {
+                    fencPic = new PicYuv;
+                    ScopedNumaPolicy numa(m_lookahead->m_pool);
+                    if (!fencPic->create(p->sourceWidth, p->sourceHeight, p->internalCsp, !!p->bHugePages))
+                    {
+                        m_aborted = true;
+                        x265_log(m_param, X265_LOG_ERROR, "memory allocation failure, aborting encode\n");
+                        fencPic->destroy();
+                        delete fencPic;
+                        m_dpb->m_freeList.pushBack(*inFrame);
+                        return -1;
+                    }
+                }
+                fencPic->m_cuOffsetY = m_sps.cuOffsetY;
+                fencPic->m_buOffsetY = m_sps.buOffsetY;
+                fencPic->m_cuOffsetC = m_sps.cuOffsetC;
+                fencPic->m_buOffsetC = m_sps.buOffsetC;
+                inFrame->m_fencPic = fencPic;
+                m_numPicturesTaken++;
+                m_peakPictures = X265_MAX(m_peakPictures, m_numPicturesTaken - m_dpb->m_numPicturesReturned);
+            }
             /* Set lowres scencut and satdCost here to aovid overwriting ANALYSIS_READ
                decision by lowres init*/
             inFrame->m_lowres.bScenecut = false;
             inFrame->m_lowres.satdCost = (int64_t)-1;
             inFrame->m_lowresInit = false;
+            inFrame->m_lowresInitBusy = false;
         }
 
-        /* Copy input picture into a Frame and PicYuv, send to lookahead */
-        inFrame->m_fencPic->copyFromPicture(*pic_in, *m_param, m_sps.conformanceWindow.rightOffset, m_sps.conformanceWindow.bottomOffset);
+        /* Copy input picture into a Frame and PicYuv, send to lookahead. Planes
+         * with our own layout are used in place until the frame is recycled */
+        if (pic_in->release && inFrame->m_fencPic->canReference(*pic_in))
+        {
+            inFrame->m_fencPic->referencePicture(*pic_in, *m_param, m_sps.conformanceWindow.rightOffset, m_sps.conformanceWindow.bottomOffset);
+            inFrame->m_releaseInput = pic_in->release;
+            inFrame->m_releaseOpaque = pic_in->releaseOpaque;
+        }
+        else
+        {
+            inFrame->m_fencPic->copyFromPicture(*pic_in, *m_param, m_sps.conformanceWindow.rightOffset, m_sps.conformanceWindow.bottomOffset);
+            if (pic_in->release)
+            {
+                if (!m_bWarnedInputCopy)
+                {
+                    x265_log(m_param, X265_LOG_WARNING, "input picture layout differs from x265_encoder_input_layout(), copying\n");
+                    m_bWarnedInputCopy = true;
+                }
+                pic_in->release(pic_in->releaseOpaque);
+            }
+        }
 
         inFrame->m_poc       = ++m_pocLast;
         inFrame->m_userData  = pic_in->userData;
@@ -665,25 +1151,49 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
         m_numDelayedPic++;
     }
     else
+    {
         m_lookahead->flush();
+        m_bFlushing = true;
+    }
+
+    return 0;
+}
 
-    FrameEncoder *curEncoder = m_frameEncoder[m_curEncoder];
-    m_curEncoder = (m_curEncoder + 1) % m_param->frameNumThreads;
+/* Retrieve the next frame from the frame encoder at the head of the
+ * round-robin and give that frame encoder the next decided picture. When
+ * bBlocking is false the frame encoder is left at the head of the round-robin
+ * if its frame is not finished, or if the lookahead has not yet decided the
+ * next picture; this call then returns without output or without feeding */
+int Encoder::outputPicture(x265_picture* pic_out, bool bBlocking)
+{
+    int encIdx = m_curEncoder;
+    FrameEncoder *curEncoder = m_frameEncoder[encIdx];
+    bool bZeroLatency = m_bZeroLatency && bBlocking;
+    Frame* outFrame = NULL;
+
+    if (!bBlocking && curEncoder->m_frame)
+    {
+        outFrame = curEncoder->getEncodedPicture(m_nalList, false);
+        if (!outFrame)
+            return 0;
+    }
+
+    m_curEncoder = (m_curEncoder + 1) % m_activeFrameEncoders;
     int ret = 0;
 
     /* Normal operation is to wait for the current frame encoder to complete its current frame
      * and then to give it a new frame to work on.  In zero-latency mode, we must encode this
      * input picture before returning so the order must be reversed. This do/while() loop allows
      * us to alternate the order of the calls without ugly code replication */
-    Frame* outFrame = NULL;
     Frame* frameEnc = NULL;
+    bool bPending = false;
     int pass = 0;
     do
     {
         /* getEncodedPicture() should block until the FrameEncoder has completed
          * encoding the frame.  This is how back-pressure through the API is
          * accomplished when the encoder is full */
-        if (!m_bZeroLatency || pass)
+        if (bBlocking && (!bZeroLatency || pass))
             outFrame = curEncoder->getEncodedPicture(m_nalList);
         if (outFrame)
         {
@@ -796,6 +1306,9 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
 
             finishFrameStats(outFrame, curEncoder, frameData, m_pocLast);
 
+            if (m_param->bAdaptiveThreading && !m_bFlushing)
+                tuneThreading(curEncoder);
+
             /* Write RateControl Frame level stats in multipass encodes */
             if (m_param->rc.bStatWrite)
                 if (m_rateControl->writeRateControlFrameStats(outFrame, &curEncoder->m_rce))
@@ -835,10 +1348,25 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
             ret = 1;
         }
 
+        /* While draining for an adaptive threading change no new frames are
+         * started and the round-robin moves on, so each call counts one more
+         * idle frame encoder. Once every frame encoder is idle, rate control
+         * restarts with the new number of frame encoders and the round-robin
+         * resumes from the first frame encoder */
+        if (m_drainFrameEncoders && !pass && !--m_drainFrameEncoders)
+        {
+            m_rateControl->resetFrameWindow(m_encodedFrameNum, m_targetFrameEncoders);
+            m_activeFrameEncoders = m_targetFrameEncoders;
+            encIdx = 0;
+            curEncoder = m_frameEncoder[0];
+            m_curEncoder = 1 % m_activeFrameEncoders;
+            resetThreadingWindow();
+        }
+
         /* pop a single frame from decided list, then provide to frame encoder
          * curEncoder is guaranteed to be idle at this point */
-        if (!pass)
-            frameEnc = m_lookahead->getDecidedPicture();
+        if (!pass && !m_drainFrameEncoders)
+            frameEnc = bBlocking ? m_lookahead->getDecidedPicture() : m_lookahead->pollDecidedPicture(bPending);
         if (frameEnc && !pass)
         {
             if (curEncoder->m_reconfigure)
@@ -855,24 +1383,54 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
             curEncoder->m_param = m_reconfigure ? m_latestParam : m_param;
             curEncoder->m_reconfigure = m_reconfigure;
 
-            /* give this frame a FrameData instance before encoding */
-            if (m_dpb->m_frameDataFreeList)
+            /* give this frame a FrameData instance before encoding. With several
+             * pools, reuse only one which was allocated on this frame encoder's
+             * NUMA node(s). A shared frame pool has no such preference, and its
+             * FrameData may have last been used by another encoder */
+            FrameData* encData;
+            if (m_framePool)
+                encData = m_framePool->takeFrameData(m_param->sourceWidth, m_param->sourceHeight, m_param->internalCsp);
+            else
+                encData = m_dpb->takeFrameData(m_numPools > 1 ? curEncoder->m_pool : NULL);
+            if (encData)
             {
-                frameEnc->m_encData = m_dpb->m_frameDataFreeList;
-                m_dpb->m_frameDataFreeList = m_dpb->m_frameDataFreeList->m_freeListNext;
+                frameEnc->m_encData = encData;
                 frameEnc->reinit(m_sps);
+                if (IS_REFERENCED(frameEnc))
+                    frameEnc->m_reconPic->createSubpelPlanes(m_param->subpelPlanes);
                 frameEnc->m_param = m_reconfigure ? m_latestParam : m_param;
                 frameEnc->m_encData->m_param = m_reconfigure ? m_latestParam : m_param;
+                if (m_framePool)
+                {
+                    PicYuv* reconPic = encData->m_reconPic;
+                    reconPic->m_cuOffsetY = m_sps.cuOffsetY;
+                    reconPic->m_buOffsetY = m_sps.buOffsetY;
+                    reconPic->m_cuOffsetC = m_sps.cuOffsetC;
+                    reconPic->m_buOffsetC = m_sps.buOffsetC;
+                    Slice* slice = encData->m_slice;
+                    slice->m_sps = &m_sps;
+                    slice->m_pps = &m_pps;
+                    slice->m_maxNumMergeCand = m_param->maxNumMergeCand;
+                    slice->m_endCUAddr = slice->realEndAddress(m_sps.numCUsInFrame * NUM_4x4_PARTITIONS);
+                    encData->m_allocPool = curEncoder->m_pool;
+                    m_numFrameDataTaken++;
+                }
             }
             else
             {
-                frameEnc->allocEncodeData(m_reconfigure ? m_latestParam : m_param, m_sps);
+                {
+                    ScopedNumaPolicy numa(curEncoder->m_pool);
+                    frameEnc->allocEncodeData(m_reconfigure ? m_latestParam : m_param, m_sps);
+                }
+                frameEnc->m_encData->m_allocPool = curEncoder->m_pool;
+                m_numFrameDataTaken++;
                 Slice* slice = frameEnc->m_encData->m_slice;
                 slice->m_sps = &m_sps;
                 slice->m_pps = &m_pps;
                 slice->m_maxNumMergeCand = m_param->maxNumMergeCand;
                 slice->m_endCUAddr = slice->realEndAddress(m_sps.numCUsInFrame * NUM_4x4_PARTITIONS);
             }
+            m_peakFrameData = X265_MAX(m_peakFrameData, m_numFrameDataTaken - m_dpb->m_numFrameDataReturned);
 
             curEncoder->m_rce.encodeOrder = frameEnc->m_encodeOrder = m_encodedFrameNum++;
             if (m_bframeDelay)
@@ -913,10 +1471,12 @@ int Encoder::encode(const x265_picture* pic_in, x265_picture* pic_out)
             if (!curEncoder->startCompressFrame(frameEnc))
                 m_aborted = true;
         }
+        else if (!bBlocking && !m_drainFrameEncoders && (bPending || !m_bFlushing))
+            m_curEncoder = encIdx; /* feed this frame encoder once the lookahead has a decided picture */
         else if (m_encodedFrameNum)
             m_rateControl->setFinalFrameCount(m_encodedFrameNum);
     }
-    while (m_bZeroLatency && ++pass < 2);
+    while (bZeroLatency && ++pass < 2);
 
     return ret;
 }
@@ -1028,6 +1588,14 @@ void Encoder::printSummary()
 
         x265_log(m_param, X265_LOG_INFO, "consecutive B-frames: %s\n", buffer);
     }
+    if (m_param->bHugePages)
+    {
+        /* totals are for the whole process, other encoders may contribute */
+        int32_t kbytes[HUGE_PAGE_BACKINGS];
+        x265_huge_page_usage(kbytes);
+        x265_log(m_param, X265_LOG_INFO, "picture memory: %.1f MB reserved huge pages, %.1f MB transparent huge pages, %.1f MB 4KB pages\n",
+                 kbytes[HUGE_PAGES_EXPLICIT] / 1024.0, kbytes[HUGE_PAGES_TRANSPARENT] / 1024.0, kbytes[HUGE_PAGES_NONE] / 1024.0);
+    }
     if (m_param->bLossless)
     {
         float frameSize = (float)(m_param->sourceWidth - m_sps.conformanceWindow.rightOffset) *
@@ -1268,6 +1836,25 @@ void Encoder::fetchStats(x265_stats *stats, size_t statsSizeBytes)
         stats->maxFALL        = (uint16_t)(m_analyzeAll.m_maxFALL / m_analyzeAll.m_numPics);
     }
 
+    if (statsSizeBytes >= sizeof(x265_stats))
+    {
+        /* pictures on the DPB free lists are allocated but not in use. With a
+         * frame pool, recycled frames have returned their pictures to it */
+        int freeFrames = m_dpb->m_freeList.size();
+        int freeFrameData = 0;
+        for (FrameData* encData = m_dpb->m_frameDataFreeList; encData; encData = encData->m_freeListNext)
+            freeFrameData++;
+        int pictures = m_numPicturesTaken - m_dpb->m_numPicturesReturned - (m_framePool ? 0 : freeFrames);
+        int frameData = m_numFrameDataTaken - m_dpb->m_numFrameDataReturned - freeFrameData;
+
+        int64_t peak = m_fixedMemory + m_numFramesAllocated * m_frameMemory +
+                       m_peakPictures * m_pictureMemory + m_peakFrameData * m_frameDataMemory;
+        int64_t used = m_fixedMemory + (m_numFramesAllocated - freeFrames) * m_frameMemory +
+                       pictures * m_pictureMemory + frameData * m_frameDataMemory;
+        stats->memoryUsed = (uint64_t)used;
+        stats->memoryPeak = (uint64_t)peak;
+    }
+
     /* If new statistics are added to x265_stats, we must check here whether the
      * structure provided by the user is the new structure or an older one (for
      * future safety) */
@@ -1689,6 +2276,13 @@ void Encoder::configure(x265_param *p)
     if (!p->bEnableRectInter)          /* not useful */
         p->bEnableAMP = false;
 
+    if (p->bEnableMECache && (p->bDistributeModeAnalysis || p->bDistributeMotionEstimation))
+    {
+        /* the searches of a CTU are spread over worker threads in no fixed order */
+        x265_log(p, X265_LOG_WARNING, "--me-cache disabled, not compatible with --pmode or --pme\n");
+        p->bEnableMECache = 0;
+    }
+
     /* In 444, chroma gets twice as much resolution, so halve quality when psy-rd is enabled */
     if (p->internalCsp == X265_CSP_I444 && p->psyRd)
     {
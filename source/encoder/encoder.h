@@ -74,6 +74,8 @@ class DPB;
 class Lookahead;
 class RateControl;
 class ThreadPool;
+class SharedThreadPool;
+class FramePool;
 class FrameData;
 
 class Encoder : public x265_encoder
@@ -96,6 +98,29 @@ public:
     int                m_numPools;
     int                m_curEncoder;
 
+    // adaptive threading, see tuneThreading()
+    int                m_activeFrameEncoders;  // frame encoders in the round-robin
+    int                m_targetFrameEncoders;  // frame encoders to use once the current ones have drained
+    int                m_drainFrameEncoders;   // API calls remaining until every frame encoder is idle
+    int                m_lookaheadSlices;      // lookahead cost estimate slices last requested
+    int                m_tuneFrames;           // frames measured in the current window, negative while refilling
+    int64_t            m_tuneWindowStart;
+    int64_t            m_tuneWorkerTime;       // sum of CTU processing time of all frames in the window
+    int64_t            m_tuneCompressTime;     // sum of compressFrame() wall times
+    int64_t            m_tuneRefWaitTime;      // sum of time spent waiting for reference rows
+    int64_t            m_tuneDecideWaitTime;   // sum of time frame encoders waited for slicetype decisions
+
+    // memory accounting, see planMemory()
+    int64_t            m_frameMemory;          // estimated bytes of one Frame without its source picture: lowres data
+    int64_t            m_pictureMemory;        // estimated bytes of one source picture
+    int64_t            m_frameDataMemory;      // estimated bytes of one FrameData: recon picture and CTU data
+    int64_t            m_fixedMemory;          // estimated bytes of frame encoders and worker analysis buffers
+    int                m_numFramesAllocated;
+    int                m_numPicturesTaken;     // source pictures allocated or taken from the frame pool
+    int                m_numFrameDataTaken;    // FrameData allocated or taken from the frame pool
+    int                m_peakPictures;         // most source pictures held at once
+    int                m_peakFrameData;        // most FrameData held at once
+
     // weighted prediction
     int                m_numLumaWPFrames;    // number of P frames with weighted luma reference
     int                m_numChromaWPFrames;  // number of P frames with weighted chroma reference
@@ -106,6 +131,8 @@ public:
     uint32_t           m_numDelayedPic;
 
     ThreadPool*        m_threadPool;
+    SharedThreadPool*  m_sharedPool;      // owner of m_threadPool if it was given by param->pool
+    FramePool*         m_framePool;       // picture buffers shared with other encoders, param->framePool
     FrameEncoder*      m_frameEncoder[X265_MAX_FRAME_THREADS];
     DPB*               m_dpb;
     Frame*             m_exportedPic;
@@ -133,6 +160,13 @@ public:
     bool               m_bZeroLatency;     // x265_encoder_encode() returns NALs for the input picture, zero lag
     bool               m_aborted;          // fatal error detected
     bool               m_reconfigure;      // Encoder reconfigure in progress
+    bool               m_bFlushing;        // a NULL input picture has been received
+    bool               m_bWarnedInputCopy; // a zero-copy input picture had to be copied
+
+    /* asynchronous API, called by frame encoder and lookahead threads when
+     * poll() may be able to make progress */
+    void               (*m_notifyCallback)(void* opaque);
+    void*              m_notifyOpaque;
 
     /* Begin intra refresh when one not in progress or else begin one as soon as the current 
      * one is done. Requires bIntraRefresh to be set.*/
@@ -143,10 +177,19 @@ public:
 
     void create();
     void stopJobs();
+    void detachSharedPool();
     void destroy();
 
     int encode(const x265_picture* pic, x265_picture *pic_out);
 
+    int submit(const x265_picture* pic);
+
+    int poll(x265_picture *pic_out);
+
+    void setCallback(void (*callback)(void*), void* opaque);
+
+    void inputLayout(int stride[3], int offset[3], int size[3]);
+
     int reconfigureParam(x265_param* encParam, x265_param* param);
 
     void getStreamHeaders(NALList& list, Entropy& sbacCoder, Bitstream& bs);
@@ -175,8 +218,22 @@ public:
 
     void calcRefreshInterval(Frame* frameEnc);
 
+    void tuneThreading(FrameEncoder* curEncoder);
+
+    void resetThreadingWindow();
+
+    void estimateMemory(int numWorkers);
+
+    int64_t plannedMemory() const;
+
+    void planMemory();
+
 protected:
 
+    int addPicture(const x265_picture* pic);
+
+    int outputPicture(x265_picture* pic_out, bool bBlocking);
+
     void initVPS(VPS *vps);
     void initSPS(SPS *sps);
     void initPPS(PPS *pps);
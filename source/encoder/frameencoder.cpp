@@ -60,6 +60,7 @@ FrameEncoder::FrameEncoder()
     m_cuGeoms = NULL;
     m_ctuGeomMap = NULL;
     m_localTldIdx = 0;
+    m_numTLD = 0;
     memset(&m_rce, 0, sizeof(RateControlEntry));
 }
 
@@ -69,10 +70,7 @@ void FrameEncoder::destroy()
     {
         if (!m_jpId)
         {
-            int numTLD = m_pool->m_numWorkers;
-            if (!m_param->bEnableWavefront)
-                numTLD += m_pool->m_numProviders;
-            for (int i = 0; i < numTLD; i++)
+            for (int i = 0; i < m_numTLD; i++)
                 m_tld[i].destroy();
             delete [] m_tld;
         }
@@ -248,9 +246,15 @@ void FrameEncoder::threadMain()
          * each FE also needs a TLD instance */
         if (!m_jpId)
         {
+            /* the pool may be shared with other encoders, so the peers are
+             * found among this encoder's frame encoders */
+            int numPeers = 0;
+            for (int i = 0; i < m_param->frameNumThreads; i++)
+                numPeers += m_top->m_frameEncoder[i]->m_pool == m_pool;
+
             int numTLD = m_pool->m_numWorkers;
             if (!m_param->bEnableWavefront)
-                numTLD += m_pool->m_numProviders;
+                numTLD += numPeers;
 
             m_tld = new ThreadLocalData[numTLD];
             for (int i = 0; i < numTLD; i++)
@@ -259,12 +263,13 @@ void FrameEncoder::threadMain()
                 m_tld[i].analysis.create(m_tld);
             }
 
-            for (int i = 0; i < m_pool->m_numProviders; i++)
+            for (int i = 0; i < m_param->frameNumThreads; i++)
             {
-                if (m_pool->m_jpTable[i]->m_isFrameEncoder) /* ugh; over-allocation and other issues here */
+                FrameEncoder *peer = m_top->m_frameEncoder[i];
+                if (peer->m_pool == m_pool)
                 {
-                    FrameEncoder *peer = dynamic_cast<FrameEncoder*>(m_pool->m_jpTable[i]);
                     peer->m_tld = m_tld;
+                    peer->m_numTLD = numTLD;
                 }
             }
         }
@@ -289,6 +294,8 @@ void FrameEncoder::threadMain()
     {
         compressFrame();
         m_done.trigger(); /* FrameEncoder::getEncodedPicture() blocks for this event */
+        if (m_top->m_notifyCallback)
+            m_top->m_notifyCallback(m_top->m_notifyOpaque);
         m_enable.wait();
     }
 }
@@ -397,11 +404,7 @@ void FrameEncoder::compressFrame()
 
     }
 
-    int numTLD;
-    if (m_pool)
-        numTLD = m_param->bEnableWavefront ? m_pool->m_numWorkers : m_pool->m_numWorkers + m_pool->m_numProviders;
-    else
-        numTLD = 1;
+    int numTLD = m_pool ? m_numTLD : 1;
 
     /* Get the QP for this frame from rate control. This call may block until
      * frames ahead of it in encode order have called rateControlEnd() */
@@ -553,7 +556,7 @@ void FrameEncoder::compressFrame()
     {
         m_top->m_rateControl->m_startEndOrder.incr();
 
-        if (m_rce.encodeOrder < m_param->frameNumThreads - 1)
+        if (m_rce.encodeOrder - m_top->m_rateControl->m_windowStart < m_top->m_rateControl->m_frameThreads - 1)
             m_top->m_rateControl->m_startEndOrder.incr(); // faked rateControlEnd calls for negative frames
     }
 
@@ -914,6 +917,7 @@ void FrameEncoder::processRowEncoder(int intRow, ThreadLocalData& tld)
     CTURow& curRow = m_rows[row];
 
     tld.analysis.m_param = m_param;
+    tld.analysis.reserveModes(*m_param); /* a reconfigure may have enabled more modes */
     if (m_param->bEnableWavefront)
     {
         ScopedLock self(curRow.lock);
@@ -1461,12 +1465,19 @@ void FrameEncoder::noiseReductionUpdate()
     }
 }
 
-Frame *FrameEncoder::getEncodedPicture(NALList& output)
+Frame *FrameEncoder::getEncodedPicture(NALList& output, bool bBlocking)
 {
     if (m_frame)
     {
-        /* block here until worker thread completes */
-        m_done.wait();
+        /* block here until worker thread completes, or return NULL if the
+         * caller may not block and the frame is not finished */
+        if (!bBlocking)
+        {
+            if (m_done.timedWait(0))
+                return NULL;
+        }
+        else
+            m_done.wait();
 
         Frame *ret = m_frame;
         m_frame = NULL;
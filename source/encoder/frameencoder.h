@@ -123,12 +123,13 @@ public:
     bool startCompressFrame(Frame* curFrame);
 
     /* blocks until worker thread is done, returns access unit */
-    Frame *getEncodedPicture(NALList& list);
+    Frame *getEncodedPicture(NALList& list, bool bBlocking = true);
 
     Event                    m_enable;
     Event                    m_done;
     Event                    m_completionEvent;
     int                      m_localTldIdx;
+    int                      m_numTLD;      /* size of the m_tld array shared with peers in m_pool */
     bool                     m_reconfigure; /* reconfigure in progress */
     volatile bool            m_threadActive;
     volatile bool            m_bAllRowsStop;
@@ -519,6 +519,16 @@ void FrameFilter::processPostRow(int row)
     const uint32_t numCols = m_frame->m_encData->m_slice->m_sps->numCuInWidth;
     const uint32_t lineStartCUAddr = row * numCols;
 
+    // Interpolate the sub-pel planes up to the last rows the 8-tap filter can
+    // reach within this row; the first and last rows also cover the margins.
+    // A reused FrameData may keep planes in a non-referenced frame, skip them
+    if (reconPic->m_subpelBuf && IS_REFERENCED(m_frame))
+    {
+        int startY = row ? row * g_maxCUSize - 4 : -(int)reconPic->m_lumaMarginY + 4;
+        int endY = row < m_numRows - 1 ? (row + 1) * g_maxCUSize - 4 : m_numRows * g_maxCUSize + reconPic->m_lumaMarginY - 4;
+        reconPic->interpSubpelRows(startY, endY);
+    }
+
     // Notify other FrameEncoders that this row of reconstructed pixels is available
     m_frame->m_reconRowCount.incr();
 
@@ -108,6 +108,11 @@ MotionEstimate::MotionEstimate()
     blockwidth = blockheight = 0;
     blockOffset = 0;
     bChromaSATD = false;
+    bCandidateStart = false;
+    bRefineCandidate = false;
+    tzRaster = 3;
+    tzStarDist = 48;
+    tzEarlyExit = 4;
     chromaSatd = NULL;
 }
 
@@ -168,6 +173,7 @@ void MotionEstimate::setSourcePU(pixel *fencY, intptr_t stride, intptr_t offset,
     satd = primitives.pu[partEnum].satd;
     sad_x3 = primitives.pu[partEnum].sad_x3;
     sad_x4 = primitives.pu[partEnum].sad_x4;
+    sad_x8 = primitives.pu[partEnum].sad_x8;
 
     blockwidth = pwidth;
     blockOffset = offset;
@@ -191,6 +197,7 @@ void MotionEstimate::setSourcePU(const Yuv& srcFencYuv, int _ctuAddr, int cuPart
     satd = primitives.pu[partEnum].satd;
     sad_x3 = primitives.pu[partEnum].sad_x3;
     sad_x4 = primitives.pu[partEnum].sad_x4;
+    sad_x8 = primitives.pu[partEnum].sad_x8;
 
     chromaSatd = primitives.chroma[fencPUYuv.m_csp].pu[partEnum].satd;
 
@@ -602,26 +609,65 @@ int MotionEstimate::motionEstimate(ReferencePlanes *ref,
      * on video distortion cost (SSE/PSNR) plus lambda times all signaling bits
      * (mode + MVD bits). */
 
-    // measure SAD cost at clipped QPEL MVP
+    /* The MVP, the full pel rounded MVP and MV(0) search start points and the
+     * QPEL motion vector candidates are measured together, so the full pel
+     * ones share the multi-reference SAD primitives */
     MV pmv = qmvp.clipped(qmvmin, qmvmax);
-    MV bestpre = pmv;
-    int bprecost;
+    MV bmv = pmv.roundToFPel();
+    MV pred[MAX_PREDICTORS];
+    ALIGN_VAR_16(int32_t, predCost[MAX_PREDICTORS]);
+    int numPred = 0;
+
+    pred[numPred++] = pmv;
+    int fpelIdx = 0;
+    if (pmv.isSubpel())
+    {
+        fpelIdx = numPred;
+        pred[numPred++] = bmv << 2;
+    }
+    int zeroIdx = 0;
+    if (pmv.notZero())
+    {
+        zeroIdx = numPred;
+        pred[numPred++] = 0;
+    }
 
+    X265_CHECK(!(ref->isLowres && numCandidates), "lowres motion candidates not allowed\n")
+    X265_CHECK(numPred + numCandidates <= MAX_PREDICTORS, "too many motion candidates\n");
+    int firstCand = numPred;
+    for (int i = 0; i < numCandidates; i++)
+    {
+        MV m = mvc[i].clipped(qmvmin, qmvmax);
+        bool bMeasured = !m.notZero() || m == pmv;
+        for (int j = firstCand; j < numPred && !bMeasured; j++)
+            bMeasured = m == pred[j];
+        if (!bMeasured)
+            pred[numPred++] = m;
+    }
+
+    // measure SAD cost at clipped QPEL MVP
     if (ref->isLowres)
-        bprecost = ref->lowresQPelCost(fenc, blockOffset, pmv, sad);
+    {
+        predCost[0] = ref->lowresQPelCost(fenc, blockOffset, pmv, sad);
+        predictorCosts(ref, pred + 1, numPred - 1, predCost + 1);
+    }
     else
-        bprecost = subpelCompare(ref, pmv, sad);
+        predictorCosts(ref, pred, numPred, predCost);
 
-    /* re-measure full pel rounded MVP with SAD as search start point */
-    MV bmv = pmv.roundToFPel();
+    MV bestpre = pmv;
+    int bprecost = predCost[0];
+    if (bChromaSATD)
+        bprecost += subpelChromaCost(ref, pmv);
+
+    /* full pel rounded MVP with SAD as search start point */
     int bcost = bprecost;
-    if (pmv.isSubpel())
-        bcost = sad(fenc, FENC_STRIDE, fref + bmv.x + bmv.y * stride, stride) + mvcost(bmv << 2);
+    if (fpelIdx)
+        bcost = predCost[fpelIdx] + mvcost(bmv << 2);
 
-    // measure SAD cost at MV(0) if MVP is not zero
-    if (pmv.notZero())
+    // SAD cost at MV(0) if MVP is not zero
+    if (zeroIdx)
     {
-        int cost = sad(fenc, FENC_STRIDE, fref, stride) + mvcost(MV(0, 0));
+        int cost = predCost[zeroIdx] + mvcost(MV(0, 0));
         if (cost < bcost)
         {
             bcost = cost;
@@ -629,26 +675,29 @@ int MotionEstimate::motionEstimate(ReferencePlanes *ref,
         }
     }
 
-    X265_CHECK(!(ref->isLowres && numCandidates), "lowres motion candidates not allowed\n")
-    // measure SAD cost at each QPEL motion vector candidate
-    for (int i = 0; i < numCandidates; i++)
+    // SAD cost at each distinct QPEL motion vector candidate
+    for (int i = firstCand; i < numPred; i++)
     {
-        MV m = mvc[i].clipped(qmvmin, qmvmax);
-        if (m.notZero() & (m != pmv ? 1 : 0) & (m != bestpre ? 1 : 0)) // check already measured
+        int cost = predCost[i] + mvcost(pred[i]);
+        if (bChromaSATD)
+            cost += subpelChromaCost(ref, pred[i]);
+        if (cost < bprecost)
         {
-            int cost = subpelCompare(ref, m, sad) + mvcost(m);
-            if (cost < bprecost)
-            {
-                bprecost = cost;
-                bestpre = m;
-            }
+            bprecost = cost;
+            bestpre = pred[i];
         }
     }
 
+    if ((bCandidateStart || bRefineCandidate) && bestpre != pmv)
+    {
+        MV fmv = bestpre.roundToFPel();
+        COST_MV(fmv.x, fmv.y);
+    }
+
     pmv = pmv.roundToFPel();
     MV omv = bmv;  // current search origin or starting point
 
-    switch (searchMethod)
+    switch (bRefineCandidate ? X265_DIA_SEARCH : searchMethod)
     {
     case X265_DIA_SEARCH:
     {
@@ -1042,6 +1091,95 @@ me_hex2:
         break;
     }
 
+    case X265_TZ_SEARCH: // Test zone search, adapted from HM ME
+    {
+        /* a star search of growing distance around the start point, which
+         * gives up after tzEarlyExit distances without improvement; a raster
+         * scan of the zone when the best point is further than a raster
+         * step; then star searches around the best point until it holds */
+        int starDist = X265_MIN(merange, tzStarDist);
+        int bPointNr = 0;
+        int bDistance = 0;
+
+        /* start at the best motion candidate if it beats the MVP */
+        MV fmv = bestpre.roundToFPel();
+        if (fmv != bmv)
+            COST_MV(fmv.x, fmv.y);
+        const MV start = bmv;
+
+        StarPatternSearch(ref, mvmin, mvmax, bmv, bcost, bPointNr, bDistance, tzEarlyExit, starDist);
+        if (bDistance == 1)
+        {
+            if (!bPointNr)
+                break;
+
+            /* check the two outer points nearest to the best direction, see
+             * X265_STAR_SEARCH. If none is better, the search is done */
+            int saved = bcost;
+            const MV mv1 = bmv + offsets[(bPointNr - 1) * 2];
+            const MV mv2 = bmv + offsets[(bPointNr - 1) * 2 + 1];
+            if (mv1.checkRange(mvmin, mvmax))
+                COST_MV(mv1.x, mv1.y);
+            if (mv2.checkRange(mvmin, mvmax))
+                COST_MV(mv2.x, mv2.y);
+            if (bcost == saved)
+                break;
+        }
+
+        if (tzRaster && bDistance > tzRaster)
+        {
+            /* raster scan of the zone around the start point, measured in
+             * batches of a row with the multi-reference SAD primitives */
+            MV rmin = (start - MV((int16_t)starDist, (int16_t)starDist)).mvmax(mvmin);
+            MV rmax = (start + MV((int16_t)starDist, (int16_t)starDist)).mvmin(mvmax);
+            const pixel* refs[16];
+            ALIGN_VAR_16(int32_t, rcosts[16]);
+            MV tmv;
+            for (tmv.y = rmin.y; tmv.y <= rmax.y; tmv.y += (int16_t)tzRaster)
+            {
+                for (int x = rmin.x; x <= rmax.x;)
+                {
+                    int num = 0;
+                    for (; num < 16 && x + num * tzRaster <= rmax.x; num++)
+                        refs[num] = fref + tmv.y * stride + x + num * tzRaster;
+
+                    batchSAD(refs, num, stride, rcosts);
+                    for (int i = 0; i < num; i++)
+                    {
+                        tmv.x = (int16_t)(x + i * tzRaster);
+                        int cost = rcosts[i] + mvcost(tmv << 2);
+                        COPY2_IF_LT(bcost, cost, bmv, tmv);
+                    }
+                    x += num * tzRaster;
+                }
+            }
+        }
+
+        while (bDistance > 0)
+        {
+            // center a new search around current best
+            bDistance = 0;
+            bPointNr = 0;
+            StarPatternSearch(ref, mvmin, mvmax, bmv, bcost, bPointNr, bDistance, tzEarlyExit, starDist);
+
+            if (bDistance == 1)
+            {
+                if (bPointNr)
+                {
+                    const MV mv1 = bmv + offsets[(bPointNr - 1) * 2];
+                    const MV mv2 = bmv + offsets[(bPointNr - 1) * 2 + 1];
+                    if (mv1.checkRange(mvmin, mvmax))
+                        COST_MV(mv1.x, mv1.y);
+                    if (mv2.checkRange(mvmin, mvmax))
+                        COST_MV(mv2.x, mv2.y);
+                }
+                break;
+            }
+        }
+
+        break;
+    }
+
     case X265_FULL_SEARCH:
     {
         // dead slow exhaustive search, but at least it uses sad_x4()
@@ -1177,6 +1315,105 @@ me_hex2:
     return bcost;
 }
 
+/* we are taking a short-cut here if the reference is weighted. To be
+ * accurate we should be interpolating unweighted pixels and weighting
+ * the final 16bit values prior to rounding and down shifting. Instead we
+ * are simply interpolating the weighted full-pel pixels. Not 100%
+ * accurate but good enough for fast qpel ME */
+static inline void interpLuma(int partEnum, const pixel* fref, intptr_t refStride, pixel* dst, intptr_t dstStride, int xFrac, int yFrac)
+{
+    if (!yFrac)
+        primitives.pu[partEnum].luma_hpp(fref, refStride, dst, dstStride, xFrac);
+    else if (!xFrac)
+        primitives.pu[partEnum].luma_vpp(fref, refStride, dst, dstStride, yFrac);
+    else
+        primitives.pu[partEnum].luma_hvpp(fref, refStride, dst, dstStride, xFrac, yFrac);
+}
+
+/* SADs of the PU against count references with a common stride, eight or
+ * four at a time where possible */
+void MotionEstimate::batchSAD(const pixel* const* fref, int count, intptr_t stride, int32_t* costs)
+{
+    const pixel* fenc = fencPUYuv.m_buf[0];
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+        sad_x8(fenc, fref + i, stride, costs + i);
+    if (i + 4 <= count)
+    {
+        sad_x4(fenc, fref[i], fref[i + 1], fref[i + 2], fref[i + 3], stride, costs + i);
+        i += 4;
+    }
+    if (i + 3 <= count)
+    {
+        sad_x3(fenc, fref[i], fref[i + 1], fref[i + 2], stride, costs + i);
+        i += 3;
+    }
+    for (; i < count; i++)
+        costs[i] = sad(fenc, FENC_STRIDE, fref[i], stride);
+}
+
+/* Luma SAD costs of a set of QPEL motion vectors, without MV costs. The full
+ * pel vectors, and the sub-pel vectors of phases with a precomputed plane,
+ * are measured in place in one batch, the other sub-pel vectors are
+ * interpolated in order of their filter phase and measured four at a time */
+void MotionEstimate::predictorCosts(ReferencePlanes *ref, const MV* qmvs, int count, int32_t* costs)
+{
+    X265_CHECK(count <= MAX_PREDICTORS, "too many predictors\n");
+    intptr_t refStride = ref->lumaStride;
+    const pixel* fref = ref->fpelPlane[0] + blockOffset;
+
+    const pixel* refs[MAX_PREDICTORS];
+    ALIGN_VAR_16(int32_t, res[MAX_PREDICTORS]);
+    int idx[MAX_PREDICTORS];
+    int numFpel = 0, numSubpel = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        int phase = ((qmvs[i].y & 3) << 2) | (qmvs[i].x & 3);
+        if (phase && !ref->subpelPlane[phase])
+        {
+            /* insertion sort by phase */
+            int j = count - 1 - numSubpel++;
+            for (; j < count - 1; j++)
+            {
+                const MV& next = qmvs[idx[j + 1]];
+                if ((((next.y & 3) << 2) | (next.x & 3)) >= phase)
+                    break;
+                idx[j] = idx[j + 1];
+            }
+            idx[j] = i;
+        }
+        else
+        {
+            const pixel* plane = phase ? ref->subpelPlane[phase] + blockOffset : fref;
+            refs[numFpel] = plane + (qmvs[i].x >> 2) + (qmvs[i].y >> 2) * refStride;
+            idx[numFpel++] = i;
+        }
+    }
+
+    batchSAD(refs, numFpel, refStride, res);
+    for (int i = 0; i < numFpel; i++)
+        costs[idx[i]] = res[i];
+
+    /* the sub-pel indices fill idx[] from the end */
+    ALIGN_VAR_32(pixel, subpelbuf[4][MAX_CU_SIZE * MAX_CU_SIZE]);
+    for (int i = count - numSubpel; i < count; i += 4)
+    {
+        int num = X265_MIN(count - i, 4);
+        for (int j = 0; j < num; j++)
+        {
+            const MV& qmv = qmvs[idx[i + j]];
+            interpLuma(partEnum, fref + (qmv.x >> 2) + (qmv.y >> 2) * refStride, refStride, subpelbuf[j], blockwidth, qmv.x & 3, qmv.y & 3);
+            refs[j] = subpelbuf[j];
+        }
+
+        batchSAD(refs, num, blockwidth, res);
+        for (int j = 0; j < num; j++)
+            costs[idx[i + j]] = res[j];
+    }
+}
+
 int MotionEstimate::subpelCompare(ReferencePlanes *ref, const MV& qmv, pixelcmp_t cmp)
 {
     intptr_t refStride = ref->lumaStride;
@@ -1191,81 +1428,81 @@ int MotionEstimate::subpelCompare(ReferencePlanes *ref, const MV& qmv, pixelcmp_
     
     if (!(yFrac | xFrac))
         cost = cmp(fencPUYuv.m_buf[0], fencStride, fref, refStride);
+    else if (const pixel* plane = ref->subpelPlane[(yFrac << 2) | xFrac])
+        cost = cmp(fencPUYuv.m_buf[0], fencStride, plane + blockOffset + (qmv.x >> 2) + (qmv.y >> 2) * refStride, refStride);
     else
     {
-        /* we are taking a short-cut here if the reference is weighted. To be
-         * accurate we should be interpolating unweighted pixels and weighting
-         * the final 16bit values prior to rounding and down shifting. Instead we
-         * are simply interpolating the weighted full-pel pixels. Not 100%
-         * accurate but good enough for fast qpel ME */
-        if (!yFrac)
-            primitives.pu[partEnum].luma_hpp(fref, refStride, subpelbuf, blockwidth, xFrac);
-        else if (!xFrac)
-            primitives.pu[partEnum].luma_vpp(fref, refStride, subpelbuf, blockwidth, yFrac);
-        else
-            primitives.pu[partEnum].luma_hvpp(fref, refStride, subpelbuf, blockwidth, xFrac, yFrac);
+        interpLuma(partEnum, fref, refStride, subpelbuf, blockwidth, xFrac, yFrac);
         cost = cmp(fencPUYuv.m_buf[0], fencStride, subpelbuf, blockwidth);
     }
 
     if (bChromaSATD)
-    {
-        int csp    = fencPUYuv.m_csp;
-        int hshift = fencPUYuv.m_hChromaShift;
-        int vshift = fencPUYuv.m_vChromaShift;
-        int mvx = qmv.x << (1 - hshift);
-        int mvy = qmv.y << (1 - vshift);
-        intptr_t fencStrideC = fencPUYuv.m_csize;
+        cost += subpelChromaCost(ref, qmv);
+
+    return cost;
+}
 
-        intptr_t refStrideC = ref->reconPic->m_strideC;
-        intptr_t refOffset = (mvx >> 3) + (mvy >> 3) * refStrideC;
+/* chroma SATD cost at a QPEL motion vector, used with bChromaSATD */
+int MotionEstimate::subpelChromaCost(ReferencePlanes *ref, const MV& qmv)
+{
+    ALIGN_VAR_32(pixel, subpelbuf[MAX_CU_SIZE * MAX_CU_SIZE]);
+    int csp    = fencPUYuv.m_csp;
+    int hshift = fencPUYuv.m_hChromaShift;
+    int vshift = fencPUYuv.m_vChromaShift;
+    int mvx = qmv.x << (1 - hshift);
+    int mvy = qmv.y << (1 - vshift);
+    intptr_t fencStrideC = fencPUYuv.m_csize;
 
-        const pixel* refCb = ref->getCbAddr(ctuAddr, absPartIdx) + refOffset;
-        const pixel* refCr = ref->getCrAddr(ctuAddr, absPartIdx) + refOffset;
+    intptr_t refStrideC = ref->reconPic->m_strideC;
+    intptr_t refOffset = (mvx >> 3) + (mvy >> 3) * refStrideC;
 
-        X265_CHECK((hshift == 0) || (hshift == 1), "hshift must be 0 or 1\n");
-        X265_CHECK((vshift == 0) || (vshift == 1), "vshift must be 0 or 1\n");
+    const pixel* refCb = ref->getCbAddr(ctuAddr, absPartIdx) + refOffset;
+    const pixel* refCr = ref->getCrAddr(ctuAddr, absPartIdx) + refOffset;
 
-        xFrac = mvx & 7;
-        yFrac = mvy & 7;
+    X265_CHECK((hshift == 0) || (hshift == 1), "hshift must be 0 or 1\n");
+    X265_CHECK((vshift == 0) || (vshift == 1), "vshift must be 0 or 1\n");
 
-        if (!(yFrac | xFrac))
+    int xFrac = mvx & 7;
+    int yFrac = mvy & 7;
+    int cost;
+
+    if (!(yFrac | xFrac))
+    {
+        cost  = chromaSatd(fencPUYuv.m_buf[1], fencStrideC, refCb, refStrideC);
+        cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, refCr, refStrideC);
+    }
+    else
+    {
+        int blockwidthC = blockwidth >> hshift;
+
+        if (!yFrac)
         {
-            cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, refCb, refStrideC);
-            cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, refCr, refStrideC);
+            primitives.chroma[csp].pu[partEnum].filter_hpp(refCb, refStrideC, subpelbuf, blockwidthC, xFrac);
+            cost  = chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
+
+            primitives.chroma[csp].pu[partEnum].filter_hpp(refCr, refStrideC, subpelbuf, blockwidthC, xFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
         }
-        else
+        else if (!xFrac)
         {
-            int blockwidthC = blockwidth >> hshift;
+            primitives.chroma[csp].pu[partEnum].filter_vpp(refCb, refStrideC, subpelbuf, blockwidthC, yFrac);
+            cost  = chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
 
-            if (!yFrac)
-            {
-                primitives.chroma[csp].pu[partEnum].filter_hpp(refCb, refStrideC, subpelbuf, blockwidthC, xFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
-
-                primitives.chroma[csp].pu[partEnum].filter_hpp(refCr, refStrideC, subpelbuf, blockwidthC, xFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
-            }
-            else if (!xFrac)
-            {
-                primitives.chroma[csp].pu[partEnum].filter_vpp(refCb, refStrideC, subpelbuf, blockwidthC, yFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
-
-                primitives.chroma[csp].pu[partEnum].filter_vpp(refCr, refStrideC, subpelbuf, blockwidthC, yFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
-            }
-            else
-            {
-                ALIGN_VAR_32(int16_t, immed[MAX_CU_SIZE * (MAX_CU_SIZE + NTAPS_LUMA - 1)]);
-                const int halfFilterSize = (NTAPS_CHROMA >> 1);
+            primitives.chroma[csp].pu[partEnum].filter_vpp(refCr, refStrideC, subpelbuf, blockwidthC, yFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
+        }
+        else
+        {
+            ALIGN_VAR_32(int16_t, immed[MAX_CU_SIZE * (MAX_CU_SIZE + NTAPS_LUMA - 1)]);
+            const int halfFilterSize = (NTAPS_CHROMA >> 1);
 
-                primitives.chroma[csp].pu[partEnum].filter_hps(refCb, refStrideC, immed, blockwidthC, xFrac, 1);
-                primitives.chroma[csp].pu[partEnum].filter_vsp(immed + (halfFilterSize - 1) * blockwidthC, blockwidthC, subpelbuf, blockwidthC, yFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
+            primitives.chroma[csp].pu[partEnum].filter_hps(refCb, refStrideC, immed, blockwidthC, xFrac, 1);
+            primitives.chroma[csp].pu[partEnum].filter_vsp(immed + (halfFilterSize - 1) * blockwidthC, blockwidthC, subpelbuf, blockwidthC, yFrac);
+            cost  = chromaSatd(fencPUYuv.m_buf[1], fencStrideC, subpelbuf, blockwidthC);
 
-                primitives.chroma[csp].pu[partEnum].filter_hps(refCr, refStrideC, immed, blockwidthC, xFrac, 1);
-                primitives.chroma[csp].pu[partEnum].filter_vsp(immed + (halfFilterSize - 1) * blockwidthC, blockwidthC, subpelbuf, blockwidthC, yFrac);
-                cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
-            }
+            primitives.chroma[csp].pu[partEnum].filter_hps(refCr, refStrideC, immed, blockwidthC, xFrac, 1);
+            primitives.chroma[csp].pu[partEnum].filter_vsp(immed + (halfFilterSize - 1) * blockwidthC, blockwidthC, subpelbuf, blockwidthC, yFrac);
+            cost += chromaSatd(fencPUYuv.m_buf[2], fencStrideC, subpelbuf, blockwidthC);
         }
     }
 
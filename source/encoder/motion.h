@@ -52,6 +52,7 @@ protected:
     pixelcmp_t sad;
     pixelcmp_x3_t sad_x3;
     pixelcmp_x4_t sad_x4;
+    pixelcmp_x8_t sad_x8;
     pixelcmp_t satd;
     pixelcmp_t chromaSatd;
 
@@ -61,9 +62,20 @@ public:
 
     static const int COST_MAX = 1 << 28;
 
+    /* the MVP, two search start points, the AMVP and neighbour candidates,
+     * the lowres seeds and the ME cache seeds */
+    static const int MAX_PREDICTORS = 24;
+
     Yuv fencPUYuv;
     int partEnum;
     bool bChromaSATD;
+    bool bCandidateStart; // start the full pel search at the best candidate if it beats the MVP
+    bool bRefineCandidate; // like bCandidateStart, but only refine the start with a diamond search
+
+    /* X265_TZ_SEARCH settings, see param->tzRaster, tzStarDist and tzEarlyExit */
+    int tzRaster;
+    int tzStarDist;
+    int tzEarlyExit;
 
     MotionEstimate();
     ~MotionEstimate();
@@ -96,6 +108,10 @@ public:
 
 protected:
 
+    void batchSAD(const pixel* const* fref, int count, intptr_t stride, int32_t* costs);
+    void predictorCosts(ReferencePlanes* ref, const MV* qmvs, int count, int32_t* costs);
+    int  subpelChromaCost(ReferencePlanes* ref, const MV& qmv);
+
     inline void StarPatternSearch(ReferencePlanes *ref,
                                   const MV &       mvmin,
                                   const MV &       mvmax,
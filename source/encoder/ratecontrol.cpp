@@ -167,6 +167,8 @@ RateControl::RateControl(x265_param& p)
     m_rateFactorMaxDecrement = 0;
     m_fps = (double)m_param->fpsNum / m_param->fpsDenom;
     m_startEndOrder.set(0);
+    m_frameThreads = m_param->frameNumThreads;
+    m_windowStart = 0;
     m_bTerminated = false;
     m_finalFrameCount = 0;
     m_numEntries = 0;
@@ -1131,7 +1133,7 @@ int RateControl::rateControlStart(Frame* curFrame, RateControlEntry* rce, Encode
     else if (m_sliceType != B_SLICE && !isRefFrameScenecut)
         m_isSceneTransition = false;
 
-    if (rce->encodeOrder < m_lastPredictorReset + m_param->frameNumThreads)
+    if (rce->encodeOrder < m_lastPredictorReset + m_frameThreads)
     {
         rce->rowPreds[0][0].count = 0;
     }
@@ -1465,7 +1467,7 @@ double RateControl::tuneAbrQScaleFromFeedback(double qScale)
     double abrBuffer = 2 * m_rateTolerance * m_bitrate;
         /* use framesDone instead of POC as poc count is not serial with bframes enabled */
         double overflow = 1.0;
-        double timeDone = (double)(m_framesDone - m_param->frameNumThreads + 1) * m_frameDuration;
+        double timeDone = (double)(m_framesDone - m_frameThreads + 1) * m_frameDuration;
         double wantedBits = timeDone * m_bitrate;
         int64_t encodedBits = m_totalBits;
         if (m_param->totalFrames && m_param->totalFrames <= 2 * m_fps)
@@ -1665,10 +1667,10 @@ double RateControl::rateEstimateQscale(Frame* curFrame, RateControlEntry *rce)
             if (!m_isVbv)
             {
                 m_predictedBits = m_totalBits;
-                if (rce->encodeOrder < m_param->frameNumThreads)
+                if (rce->encodeOrder < m_frameThreads)
                     m_predictedBits += (int64_t)(rce->encodeOrder * m_bitrate / m_fps);
                 else
-                    m_predictedBits += (int64_t)(m_param->frameNumThreads * m_bitrate / m_fps);
+                    m_predictedBits += (int64_t)(m_frameThreads * m_bitrate / m_fps);
             }
             /* Adjust ABR buffer based on distance to the end of the video. */
             if (m_numEntries > rce->encodeOrder)
@@ -1915,7 +1917,7 @@ void RateControl::rateControlUpdateStats(RateControlEntry* rce)
     {
         m_startEndOrder.incr();
 
-        if (rce->encodeOrder < m_param->frameNumThreads - 1)
+        if (rce->encodeOrder - m_windowStart < m_frameThreads - 1)
             m_startEndOrder.incr(); // faked rateControlEnd calls for negative frames
     }
 }
@@ -1930,7 +1932,7 @@ void RateControl::checkAndResetABR(RateControlEntry* rce, bool isFrameDone)
         if (!m_isAbrReset && rce->movingAvgSum > 0
             && (m_isPatternPresent || !m_param->bframes))
         {
-            int pos = X265_MAX(m_sliderPos - m_param->frameNumThreads, 0);
+            int pos = X265_MAX(m_sliderPos - m_frameThreads, 0);
             int64_t shrtTermWantedBits = (int64_t) (X265_MIN(pos, s_slidingWindowFrames) * m_bitrate * m_frameDuration);
             int64_t shrtTermTotalBitsSum = 0;
             // Reset ABR if prev frames are blank to prevent further sudden overflows/ high bit rate spikes.
@@ -2251,7 +2253,7 @@ int RateControl::rowDiagonalVbvRateControl(Frame* curFrame, uint32_t row, RateCo
     if (row < sps.numCuInHeight - 1)
     {
         /* More threads means we have to be more cautious in letting ratecontrol use up extra bits. */
-        double rcTol = bufferLeftPlanned / m_param->frameNumThreads * m_rateTolerance;
+        double rcTol = bufferLeftPlanned / m_frameThreads * m_rateTolerance;
         int32_t encodedBitsSoFar = 0;
         double accFrameBits = predictRowsSizeSum(curFrame, rce, qpVbv, encodedBitsSoFar);
 
@@ -2427,7 +2429,7 @@ void RateControl::updateVbv(int64_t bits, RateControlEntry* rce)
 int RateControl::rateControlEnd(Frame* curFrame, int64_t bits, RateControlEntry* rce)
 {
     int orderValue = m_startEndOrder.get();
-    int endOrdinal = (rce->encodeOrder + m_param->frameNumThreads) * 2 - 1;
+    int endOrdinal = (rce->encodeOrder + m_frameThreads) * 2 - 1;
     while (orderValue < endOrdinal && !m_bTerminated)
     {
         /* no more frames are being encoded, so fake the start event if we would
@@ -2537,7 +2539,7 @@ int RateControl::rateControlEnd(Frame* curFrame, int64_t bits, RateControlEntry*
         m_wantedBitsWindow += m_frameDuration * m_bitrate;
         m_totalBits += bits - rce->rowTotalBits;
         m_encodedBits += actualBits;
-        int pos = m_sliderPos - m_param->frameNumThreads;
+        int pos = m_sliderPos - m_frameThreads;
         if (pos >= 0)
             m_encodedBitsWindow[pos % s_slidingWindowFrames] = actualBits;
         if(rce->sliceType != I_SLICE)
@@ -2637,6 +2639,18 @@ void RateControl::setFinalFrameCount(int count)
     m_startEndOrder.poke();
 }
 
+/* called by the API thread once every frame encoder has drained (all frames
+ * before startOrder have passed rateControlEnd) to begin a new frame-parallel
+ * window of frameThreads concurrent frames, starting at encode order startOrder.
+ * The start/end ordering restarts as if startOrder were the first frame */
+void RateControl::resetFrameWindow(int startOrder, int frameThreads)
+{
+    m_frameThreads = frameThreads;
+    m_windowStart = startOrder;
+    m_finalFrameCount = 0;
+    m_startEndOrder.set(startOrder * 2);
+}
+
 /* called when the encoder is closing, and no more frames will be output.
  * all blocked functions must finish so the frame encoder threads can be
  * closed */
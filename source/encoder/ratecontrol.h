@@ -197,6 +197,8 @@ public:
      * rceUpdate 12
      * rceEnd    11 */
     ThreadSafeInteger m_startEndOrder;
+    int     m_frameThreads;      /* frames encoded concurrently in the current window */
+    int     m_windowStart;       /* encode order of the first frame of the current window */
     int     m_finalFrameCount;   /* set when encoder begins flushing */
     bool    m_bTerminated;       /* set true when encoder is closing */
 
@@ -232,6 +234,7 @@ public:
     void initHRD(SPS& sps);
 
     void setFinalFrameCount(int count);
+    void resetFrameWindow(int startOrder, int frameThreads);
     void terminate();          /* un-block all waiting functions so encoder may close */
     void destroy();
 
@@ -36,13 +36,14 @@ MotionReference::MotionReference()
     weightBuffer[0] = NULL;
     weightBuffer[1] = NULL;
     weightBuffer[2] = NULL;
+    bHugePages = false;
 }
 
 MotionReference::~MotionReference()
 {
-    X265_FREE(weightBuffer[0]);
-    X265_FREE(weightBuffer[1]);
-    X265_FREE(weightBuffer[2]);
+    X265_FREE_HUGE(weightBuffer[0], bHugePages);
+    X265_FREE_HUGE(weightBuffer[1], bHugePages);
+    X265_FREE_HUGE(weightBuffer[2], bHugePages);
 }
 
 int MotionReference::init(PicYuv* recPic, WeightParam *wp, const x265_param& p)
@@ -83,7 +84,9 @@ int MotionReference::init(PicYuv* recPic, WeightParam *wp, const x265_param& p)
                 if (!weightBuffer[c])
                 {
                     size_t padheight = (numCUinHeight * cuHeight) + marginY * 2;
-                    weightBuffer[c] = X265_MALLOC(pixel, stride * padheight);
+                    bHugePages = !!p.bHugePages;
+                    weightBuffer[c] = (pixel*)(bHugePages ? x265_malloc_huge(sizeof(pixel) * stride * padheight)
+                                                          : x265_malloc(sizeof(pixel) * stride * padheight));
                     if (!weightBuffer[c])
                         return -1;
                 }
@@ -102,6 +105,11 @@ int MotionReference::init(PicYuv* recPic, WeightParam *wp, const x265_param& p)
         isWeighted = true;
     }
 
+    /* the sub-pel planes of the recon picture are interpolated from its
+     * unweighted pixels */
+    for (int i = 0; i < 16; i++)
+        subpelPlane[i] = fpelPlane[0] == recPic->m_picOrg[0] ? recPic->m_subpelOrg[i] : NULL;
+
     return 0;
 }
 
@@ -44,6 +44,7 @@ public:
     void applyWeight(int rows, int numRows);
 
     pixel*  weightBuffer[3];
+    bool    bHugePages;      // weightBuffer allocated by x265_malloc_huge()
     int     numInterpPlanes;
     int     numWeightedRows;
 
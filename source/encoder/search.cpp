@@ -67,6 +67,7 @@ Search::Search()
     m_param = NULL;
     m_slice = NULL;
     m_frame = NULL;
+    resetMECache();
 }
 
 bool Search::initSearch(const x265_param& param, ScalingList& scalingList)
@@ -78,6 +79,10 @@ bool Search::initSearch(const x265_param& param, ScalingList& scalingList)
 
     m_rdCost.setPsyRdScale(param.psyRd);
     m_me.init(param.internalCsp);
+    m_me.bCandidateStart = !!param.bLowresMvSeed;
+    m_me.tzRaster = param.tzRaster;
+    m_me.tzStarDist = param.tzStarDist;
+    m_me.tzEarlyExit = param.tzEarlyExit;
 
     bool ok = m_quant.init(param.psyRdoq, scalingList, m_entropyCoder);
     if (m_param->noiseReductionIntra || m_param->noiseReductionInter || m_param->rc.vbvBufferSize)
@@ -1910,6 +1915,171 @@ MV Search::getLowresMV(const CUData& cu, const PredictionUnit& pu, int list, int
     return mvs[idx] << 1; /* scale up lowres mv */
 }
 
+/* find the distinct non-zero lowres motion vectors from lookahead in the
+ * middle and under the corners of the current PU, and reduce merange when
+ * the lowres vectors around the PU agree */
+int Search::getLowresMVs(const CUData& cu, const PredictionUnit& pu, int list, int ref, MV* lmvs, int& merange)
+{
+    int diffPoc = abs(m_slice->m_poc - m_slice->m_refPOCList[list][ref]);
+    if (diffPoc > m_param->bframes + 1)
+        /* poc difference is out of range for lookahead */
+        return 0;
+
+    const Lowres& lowres = m_frame->m_lowres;
+    const MV* mvs = lowres.lowresMvs[list][diffPoc - 1];
+    if (mvs[0].x == 0x7FFF)
+        /* this motion search was not estimated by lookahead */
+        return 0;
+
+    int pelX = cu.m_cuPelX + g_zscanToPelX[pu.puAbsPartIdx];
+    int pelY = cu.m_cuPelY + g_zscanToPelY[pu.puAbsPartIdx];
+    int maxX = lowres.maxBlocksInRow - 1;
+    int maxY = lowres.maxBlocksInCol - 1;
+    int x0 = X265_MIN(pelX >> 4, maxX), x1 = X265_MIN((pelX + pu.width - 1) >> 4, maxX);
+    int y0 = X265_MIN(pelY >> 4, maxY), y1 = X265_MIN((pelY + pu.height - 1) >> 4, maxY);
+
+    const int blocks[5][2] =
+    {
+        { X265_MIN((pelX + pu.width / 2) >> 4, maxX), X265_MIN((pelY + pu.height / 2) >> 4, maxY) },
+        { x0, y0 }, { x1, y0 }, { x0, y1 }, { x1, y1 }
+    };
+
+    int numLmv = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        MV lmv = mvs[blocks[i][1] * lowres.maxBlocksInRow + blocks[i][0]] << 1; /* scale up lowres mv */
+        bool bDup = !lmv.notZero();
+        for (int j = 0; j < numLmv && !bDup; j++)
+            bDup = lmv == lmvs[j];
+        if (!bDup)
+            lmvs[numLmv++] = lmv;
+    }
+
+    /* spread of the lowres vectors of the covered blocks and their neighbours,
+     * in full resolution pels */
+    MV vmin = mvs[y0 * lowres.maxBlocksInRow + x0], vmax = vmin;
+    for (int y = X265_MAX(y0 - 1, 0); y <= X265_MIN(y1 + 1, maxY); y++)
+    {
+        for (int x = X265_MAX(x0 - 1, 0); x <= X265_MIN(x1 + 1, maxX); x++)
+        {
+            const MV& mv = mvs[y * lowres.maxBlocksInRow + x];
+            vmin = vmin.mvmin(mv);
+            vmax = vmax.mvmax(mv);
+        }
+    }
+    int spread = X265_MAX(vmax.x - vmin.x, vmax.y - vmin.y) >> 1;
+    if (4 * spread < merange)
+        merange = X265_MAX(4 * spread, X265_MIN(merange, 16));
+
+    return numLmv;
+}
+
+/* append the lowres motion vectors to the motion candidates of the PU, see
+ * --lowres-mv-seed. Returns their count; merange and the lowres vector the
+ * search range must also cover (or NULL) are updated when they agree */
+int Search::addLowresCandidates(const CUData& cu, const PredictionUnit& pu, int list, int ref, MV* mvc, int& merange, const MV*& seed)
+{
+    merange = m_param->searchRange;
+    seed = NULL;
+
+    if (m_param->analysisMode) /* Prevents load/save outputs from diverging if lowresMV is not available */
+        return 0;
+
+    if (!m_param->bLowresMvSeed)
+    {
+        MV lmv = getLowresMV(cu, pu, list, ref);
+        if (lmv.notZero())
+        {
+            mvc[0] = lmv;
+            return 1;
+        }
+        return 0;
+    }
+
+    int numLmv = getLowresMVs(cu, pu, list, ref, mvc, merange);
+    if (numLmv && merange < m_param->searchRange)
+        seed = mvc;
+    return numLmv;
+}
+
+/* append the distinct vectors of the ME cache cells under the middle and the
+ * corners of the PU to its motion candidates, see --me-cache. bAgree is set
+ * when every cell it covers holds the same vector, found by searches of
+ * smaller PUs, which is then first */
+int Search::addCachedCandidates(const PredictionUnit& pu, int list, int ref, MV* mvc, bool& bAgree) const
+{
+    int pelX = g_zscanToPelX[pu.cuAbsPartIdx + pu.puAbsPartIdx];
+    int pelY = g_zscanToPelY[pu.cuAbsPartIdx + pu.puAbsPartIdx];
+    int x0 = pelX >> 3, x1 = (pelX + pu.width - 1) >> 3;
+    int y0 = pelY >> 3, y1 = (pelY + pu.height - 1) >> 3;
+
+    const MECacheCell* cells = m_meCache[list][ref];
+    uint64_t valid = m_meCacheValid[list][ref];
+
+    bAgree = !!(valid & (1ULL << (y0 * ME_CACHE_STRIDE + x0)));
+    for (int y = y0; y <= y1 && bAgree; y++)
+    {
+        for (int x = x0; x <= x1 && bAgree; x++)
+        {
+            int idx = y * ME_CACHE_STRIDE + x;
+            bAgree = (valid & (1ULL << idx)) && cells[idx].mv == cells[y0 * ME_CACHE_STRIDE + x0].mv &&
+                     cells[idx].area < (uint32_t)(pu.width * pu.height);
+        }
+    }
+
+    const int samples[5] =
+    {
+        y0 * ME_CACHE_STRIDE + x0, y0 * ME_CACHE_STRIDE + x1,
+        y1 * ME_CACHE_STRIDE + x0, y1 * ME_CACHE_STRIDE + x1,
+        ((pelY + pu.height / 2) >> 3) * ME_CACHE_STRIDE + ((pelX + pu.width / 2) >> 3)
+    };
+
+    int numCached = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        if (!(valid & (1ULL << samples[i])))
+            continue;
+        const MV& mv = cells[samples[i]].mv;
+        bool bDup = false;
+        for (int j = 0; j < numCached && !bDup; j++)
+            bDup = mv == mvc[j];
+        if (!bDup)
+            mvc[numCached++] = mv;
+    }
+
+    return numCached;
+}
+
+/* keep the vector found for a PU in the ME cache cells it covers, unless
+ * they hold one of lower scaled distortion. PUs which cover parts of cells
+ * are not kept */
+void Search::updateMECache(const PredictionUnit& pu, int list, int ref, const MV& mv, uint32_t distortion)
+{
+    int pelX = g_zscanToPelX[pu.cuAbsPartIdx + pu.puAbsPartIdx];
+    int pelY = g_zscanToPelY[pu.cuAbsPartIdx + pu.puAbsPartIdx];
+    if ((pelX | pelY | pu.width | pu.height) & 7)
+        return;
+
+    uint32_t cost = (uint32_t)(((uint64_t)distortion << 6) / (pu.width * pu.height));
+
+    MECacheCell* cells = m_meCache[list][ref];
+    uint64_t& valid = m_meCacheValid[list][ref];
+    for (int y = pelY >> 3; y < (pelY + pu.height) >> 3; y++)
+    {
+        for (int x = pelX >> 3; x < (pelX + pu.width) >> 3; x++)
+        {
+            int idx = y * ME_CACHE_STRIDE + x;
+            if (!(valid & (1ULL << idx)) || cost < cells[idx].cost)
+            {
+                cells[idx].mv = mv;
+                cells[idx].cost = cost;
+                cells[idx].area = pu.width * pu.height;
+                valid |= 1ULL << idx;
+            }
+        }
+    }
+}
+
 /* Pick between the two AMVP candidates which is the best one to use as
  * MVP for the motion search, based on SAD cost */
 int Search::selectMVP(const CUData& cu, const PredictionUnit& pu, const MV amvp[AMVP_NUM_CANDS], int list, int ref)
@@ -2006,24 +2176,21 @@ void Search::singleMotionEstimation(Search& master, Mode& interMode, const Predi
 
     MotionData* bestME = interMode.bestME[part];
 
-    // 12 mv candidates including lowresMV
-    MV  mvc[(MD_ABOVE_LEFT + 1) * 2 + 2];
+    // 16 mv candidates including lowresMVs
+    MV  mvc[MAX_MVC];
     int numMvc = interMode.cu.getPMV(interMode.interNeighbours, list, ref, interMode.amvpCand[list][ref], mvc);
 
     const MV* amvp = interMode.amvpCand[list][ref];
     int mvpIdx = selectMVP(interMode.cu, pu, amvp, list, ref);
     MV mvmin, mvmax, outmv, mvp = amvp[mvpIdx];
 
-    if (!m_param->analysisMode) /* Prevents load/save outputs from diverging if lowresMV is not available */
-    {
-        MV lmv = getLowresMV(interMode.cu, pu, list, ref);
-        if (lmv.notZero())
-            mvc[numMvc++] = lmv;
-    }
+    int merange;
+    const MV* seed;
+    numMvc += addLowresCandidates(interMode.cu, pu, list, ref, mvc + numMvc, merange, seed);
 
-    setSearchRange(interMode.cu, mvp, m_param->searchRange, mvmin, mvmax);
+    setSearchRange(interMode.cu, mvp, merange, mvmin, mvmax, seed);
 
-    int satdCost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, m_param->searchRange, outmv);
+    int satdCost = m_me.motionEstimate(&m_slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, merange, outmv);
 
     /* Get total cost of partition, but only include MV bit cost once */
     bits += m_me.bitcost(outmv);
@@ -2056,8 +2223,8 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
     CUData& cu = interMode.cu;
     Yuv* predYuv = &interMode.predYuv;
 
-    // 12 mv candidates including lowresMV
-    MV mvc[(MD_ABOVE_LEFT + 1) * 2 + 2];
+    // 16 mv candidates including lowresMVs
+    MV mvc[MAX_MVC];
 
     const Slice *slice = m_slice;
     int numPart     = cu.getNumPartInter(0);
@@ -2198,21 +2365,36 @@ void Search::predInterSearch(Mode& interMode, const CUGeom& cuGeom, bool bChroma
                     int mvpIdx = selectMVP(cu, pu, amvp, list, ref);
                     MV mvmin, mvmax, outmv, mvp = amvp[mvpIdx];
 
-                    if (!m_param->analysisMode) /* Prevents load/save outputs from diverging when lowresMV is not available */
+                    int merange;
+                    const MV* seed;
+                    numMvc += addLowresCandidates(cu, pu, list, ref, mvc + numMvc, merange, seed);
+
+                    bool bCached = false;
+                    if (m_param->bEnableMECache)
                     {
-                        MV lmv = getLowresMV(cu, pu, list, ref);
-                        if (lmv.notZero())
-                            mvc[numMvc++] = lmv;
+                        int numCached = addCachedCandidates(pu, list, ref, mvc + numMvc, bCached);
+                        if (bCached)
+                        {
+                            /* the searches covering this PU agree, refine their vector */
+                            seed = mvc + numMvc;
+                            merange = X265_MIN(merange, (int)ME_CACHE_RANGE);
+                        }
+                        numMvc += numCached;
                     }
 
-                    setSearchRange(cu, mvp, m_param->searchRange, mvmin, mvmax);
-                    int satdCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, m_param->searchRange, outmv);
+                    setSearchRange(cu, mvp, merange, mvmin, mvmax, seed);
+                    m_me.bRefineCandidate = bCached;
+                    int satdCost = m_me.motionEstimate(&slice->m_mref[list][ref], mvmin, mvmax, mvp, numMvc, mvc, merange, outmv);
+                    m_me.bRefineCandidate = false;
 
                     /* Get total cost of partition, but only include MV bit cost once */
                     bits += m_me.bitcost(outmv);
                     uint32_t mvCost = m_me.mvcost(outmv);
                     uint32_t cost = (satdCost - mvCost) + m_rdCost.getCost(bits);
 
+                    if (m_param->bEnableMECache)
+                        updateMECache(pu, list, ref, outmv, satdCost - mvCost);
+
                     /* Refine MVP selection, updates: mvpIdx, bits, cost */
                     mvp = checkBestMVP(amvp, outmv, mvpIdx, bits, cost);
 
@@ -2477,12 +2659,19 @@ const MV& Search::checkBestMVP(const MV* amvpCand, const MV& mv, int& mvpIdx, ui
     return amvpCand[mvpIdx];
 }
 
-void Search::setSearchRange(const CUData& cu, const MV& mvp, int merange, MV& mvmin, MV& mvmax) const
+void Search::setSearchRange(const CUData& cu, const MV& mvp, int merange, MV& mvmin, MV& mvmax, const MV* seed) const
 {
     MV dist((int16_t)merange << 2, (int16_t)merange << 2);
     mvmin = mvp - dist;
     mvmax = mvp + dist;
 
+    /* also cover the range around a lowres seed vector */
+    if (seed)
+    {
+        mvmin = mvmin.mvmin(*seed - dist);
+        mvmax = mvmax.mvmax(*seed + dist);
+    }
+
     cu.clipMv(mvmin);
     cu.clipMv(mvmax);
 
@@ -317,6 +317,7 @@ public:
     void checkDQPForSplitPred(Mode& mode, const CUGeom& cuGeom);
 
     MV getLowresMV(const CUData& cu, const PredictionUnit& pu, int list, int ref);
+    int  getLowresMVs(const CUData& cu, const PredictionUnit& pu, int list, int ref, MV* lmvs, int& merange);
 
     class PME : public BondedTaskGroup
     {
@@ -353,6 +354,19 @@ protected:
     uint32_t      m_listSelBits[3];
     Lock          m_meLock;
 
+    /* motion search results of the current CTU per reference on its 8x8 grid,
+     * raster order, see --me-cache */
+    struct MECacheCell
+    {
+        MV       mv;
+        uint32_t cost;  // distortion scaled to an 8x8 block, without MV bits
+        uint32_t area;  // of the PU whose search found mv
+    };
+
+    enum { ME_CACHE_STRIDE = MAX_CU_SIZE / 8 };
+    MECacheCell   m_meCache[2][MAX_NUM_REF][ME_CACHE_STRIDE * ME_CACHE_STRIDE];
+    uint64_t      m_meCacheValid[2][MAX_NUM_REF];
+
     void     saveResidualQTData(CUData& cu, ShortYuv& resiYuv, uint32_t absPartIdx, uint32_t tuDepth);
 
     // RDO search of luma intra modes; result is fully encoded luma. luma distortion is returned
@@ -400,9 +414,15 @@ protected:
     };
 
     /* inter/ME helper functions */
+    enum { MAX_MVC = (MD_ABOVE_LEFT + 1) * 2 + 1 + 5 + 5 }; // neighbours, collocated, lowres and ME cache
+    enum { ME_CACHE_RANGE = 4 }; // diamond steps refining a vector all covered cells agree on
     int       selectMVP(const CUData& cu, const PredictionUnit& pu, const MV amvp[AMVP_NUM_CANDS], int list, int ref);
     const MV& checkBestMVP(const MV amvpCand[2], const MV& mv, int& mvpIdx, uint32_t& outBits, uint32_t& outCost) const;
-    void     setSearchRange(const CUData& cu, const MV& mvp, int merange, MV& mvmin, MV& mvmax) const;
+    void     setSearchRange(const CUData& cu, const MV& mvp, int merange, MV& mvmin, MV& mvmax, const MV* seed = NULL) const;
+    int      addLowresCandidates(const CUData& cu, const PredictionUnit& pu, int list, int ref, MV* mvc, int& merange, const MV*& seed);
+    void     resetMECache() { memset(m_meCacheValid, 0, sizeof(m_meCacheValid)); }
+    int      addCachedCandidates(const PredictionUnit& pu, int list, int ref, MV* mvc, bool& bAgree) const;
+    void     updateMECache(const PredictionUnit& pu, int list, int ref, const MV& mv, uint32_t distortion);
     uint32_t mergeEstimation(CUData& cu, const CUGeom& cuGeom, const PredictionUnit& pu, int puIdx, MergeData& m);
     static void getBlkBits(PartSize cuMode, bool bPSlice, int puIdx, uint32_t lastMode, uint32_t blockBit[3]);
 
@@ -499,8 +499,11 @@ Lookahead::Lookahead(x265_param *param, ThreadPool* pool)
     m_isSceneTransition = false;
     m_scratch  = NULL;
     m_tld      = NULL;
+    m_notifyCallback = NULL;
+    m_notifyOpaque = NULL;
     m_filled   = false;
     m_outputSignalRequired = false;
+    m_preLookaheadSignalRequired = false;
     m_isActive = true;
 
     m_8x8Height = ((m_param->sourceHeight / 2) + X265_LOWRES_CU_SIZE - 1) >> X265_LOWRES_CU_BITS;
@@ -546,19 +549,10 @@ Lookahead::Lookahead(x265_param *param, ThreadPool* pool)
         m_param->lookaheadSlices = 0;
     }
 
+    initCoopSlices(m_param->lookaheadSlices);
     if (m_param->lookaheadSlices > 1)
-    {
-        m_numRowsPerSlice = m_8x8Height / m_param->lookaheadSlices;
-        m_numRowsPerSlice = X265_MAX(m_numRowsPerSlice, 10);            // at least 10 rows per slice
-        m_numRowsPerSlice = X265_MIN(m_numRowsPerSlice, m_8x8Height);   // but no more than the full picture
-        m_numCoopSlices = m_8x8Height / m_numRowsPerSlice;
         m_param->lookaheadSlices = m_numCoopSlices;                     // report actual final slice count
-    }
-    else
-    {
-        m_numRowsPerSlice = m_8x8Height;
-        m_numCoopSlices = 1;
-    }
+    m_coopSlicesRequest = 0;
 
 #if DETAILED_CU_STATS
     m_slicetypeDecideElapsedTime = 0;
@@ -586,6 +580,32 @@ void Lookahead::getWorkerStats(int64_t& batchElapsedTime, uint64_t& batchCount,
 }
 #endif
 
+void Lookahead::initCoopSlices(int numSlices)
+{
+    if (numSlices > 1)
+    {
+        m_numRowsPerSlice = m_8x8Height / numSlices;
+        m_numRowsPerSlice = X265_MAX(m_numRowsPerSlice, 10);            // at least 10 rows per slice
+        m_numRowsPerSlice = X265_MIN(m_numRowsPerSlice, m_8x8Height);   // but no more than the full picture
+        m_numCoopSlices = m_8x8Height / m_numRowsPerSlice;
+    }
+    else
+    {
+        m_numRowsPerSlice = m_8x8Height;
+        m_numCoopSlices = 1;
+    }
+}
+
+/* Called by the API thread. The slice layout is only read by the thread
+ * running slicetypeDecide(), so the request is deferred until findJob() next
+ * claims the decision */
+void Lookahead::setCoopSlices(int numSlices)
+{
+    m_inputLock.acquire();
+    m_coopSlicesRequest = numSlices;
+    m_inputLock.release();
+}
+
 bool Lookahead::create()
 {
     int numTLD = 1 + (m_pool ? m_pool->m_numWorkers : 0);
@@ -646,7 +666,15 @@ void Lookahead::destroy()
  * still require a blocking wait, but after this slicetypeDecide() will maintain
  * its lead over the encoder (because one picture is added to the input queue
  * each time one is removed from the output) and decides slice types of pictures
- * just ahead of when the encoder needs them */
+ * just ahead of when the encoder needs them.
+ *
+ * When a thread pool is available the lookahead is pipelined. Each picture
+ * added to the input queue wakes a worker which performs the pre-lookahead
+ * (lowres init, adaptive quant, intra estimate) of that picture while another
+ * worker may still be running slicetypeDecide() for the previous mini-GOP. The
+ * pre-lookahead of one picture does not depend on any other picture, so the
+ * decisions are identical to the serial order; slicetypeDecide() simply
+ * claims any pictures nobody has started yet and waits for the ones in flight */
 
 /* Called by API thread */
 void Lookahead::addPicture(Frame& curFrame, int sliceType)
@@ -665,8 +693,8 @@ void Lookahead::addPicture(Frame& curFrame, int sliceType)
 
     m_inputLock.acquire();
     m_inputQueue.pushBack(curFrame);
-    if (m_pool && m_inputQueue.size() >= m_fullQueueSize)
-        tryWakeOne();
+    if (m_pool)
+        tryWakeOne(); /* for slicetypeDecide() if the queue is full, else pre-lookahead */
     m_inputLock.release();
 }
 
@@ -678,17 +706,81 @@ void Lookahead::flush()
     m_filled = true;
 }
 
-void Lookahead::findJob(int /*workerThreadID*/)
+/* Called with m_inputLock held. Claims the oldest input picture which has not
+ * begun pre-lookahead, or returns NULL if there are none */
+Frame* Lookahead::acquirePreLookahead()
+{
+    if (!m_isActive)
+        return NULL;
+
+    for (Frame* curFrame = m_inputQueue.first(); curFrame; curFrame = curFrame->m_next)
+    {
+        if (!curFrame->m_lowresInit && !curFrame->m_lowresInitBusy)
+        {
+            curFrame->m_lowresInitBusy = true;
+            return curFrame;
+        }
+    }
+
+    return NULL;
+}
+
+void Lookahead::preLookahead(LookaheadTLD& tld, Frame* preFrame)
+{
+    ProfileLookaheadTime(m_preLookaheadElapsedTime, m_countPreLookahead);
+    ProfileScopeEvent(prelookahead);
+
+    preFrame->m_lowres.init(preFrame->m_fencPic, preFrame->m_poc);
+    if (m_param->rc.bStatRead && m_param->rc.cuTree && IS_REFERENCED(preFrame))
+        /* cu-tree offsets were read from stats file */;
+    else if (m_bAdaptiveQuant)
+        tld.calcAdaptiveQuantFrame(preFrame, m_param);
+    tld.lowresIntraEstimate(preFrame->m_lowres);
+}
+
+void Lookahead::findJob(int workerThreadID)
 {
     bool doDecide;
+    Frame* preFrame = NULL;
 
     m_inputLock.acquire();
     if (m_inputQueue.size() >= m_fullQueueSize && !m_sliceTypeBusy && m_isActive)
+    {
         doDecide = m_sliceTypeBusy = true;
+        if (m_coopSlicesRequest)
+        {
+            initCoopSlices(m_coopSlicesRequest);
+            m_coopSlicesRequest = 0;
+        }
+    }
     else
-        doDecide = m_helpWanted = false;
+    {
+        doDecide = false;
+
+        /* the API thread shares its TLD with the thread running slicetypeDecide(),
+         * so only worker threads perform pre-lookahead outside of it */
+        if (workerThreadID >= 0)
+            preFrame = acquirePreLookahead();
+        if (!preFrame)
+            m_helpWanted = false;
+    }
     m_inputLock.release();
 
+    while (preFrame)
+    {
+        preLookahead(m_tld[workerThreadID], preFrame);
+
+        m_inputLock.acquire();
+        preFrame->m_lowresInit = true;
+        if (m_preLookaheadSignalRequired)
+        {
+            m_preLookaheadSignal.trigger();
+            m_preLookaheadSignalRequired = false;
+        }
+        preFrame = acquirePreLookahead();
+        m_inputLock.release();
+    }
+
     if (!doDecide)
         return;
 
@@ -705,6 +797,9 @@ void Lookahead::findJob(int /*workerThreadID*/)
     }
     m_sliceTypeBusy = false;
     m_inputLock.release();
+
+    if (m_notifyCallback)
+        m_notifyCallback(m_notifyOpaque);
 }
 
 /* Called by API thread */
@@ -734,6 +829,50 @@ Frame* Lookahead::getDecidedPicture()
         return NULL;
 }
 
+/* Called by API thread. Non-blocking form of getDecidedPicture(); if no
+ * picture is available, bPending reports whether slicetypeDecide() is running
+ * or can run without further input. Without a thread pool the decision is
+ * made here, by the calling thread */
+Frame* Lookahead::pollDecidedPicture(bool& bPending)
+{
+    bPending = false;
+    if (!m_filled)
+        return NULL;
+
+    if (!m_pool)
+    {
+        Frame *out = m_outputQueue.popFront();
+        if (!out)
+        {
+            findJob(-1); /* run slicetypeDecide() if necessary */
+            out = m_outputQueue.popFront();
+        }
+        return out;
+    }
+
+    m_inputLock.acquire();
+    bPending = m_sliceTypeBusy || m_inputQueue.size() >= m_fullQueueSize;
+    if (bPending && !m_sliceTypeBusy)
+        tryWakeOne();
+    m_inputLock.release();
+
+    /* slicetypeDecide() holds the output lock while it analyses the next
+     * keyframe; its pictures become available when it finishes. Pictures are
+     * output before m_sliceTypeBusy is released, so if no decision was pending
+     * above, the queue is complete */
+    if (!m_outputLock.tryAcquire())
+    {
+        bPending = true;
+        return NULL;
+    }
+    Frame *out = m_outputQueue.popFront();
+    m_outputLock.release();
+
+    if (out)
+        bPending = false;
+    return out;
+}
+
 /* Called by rate-control to calculate the estimated SATD cost for a given
  * picture.  It assumes dpb->prepareEncode() has already been called for the
  * picture and all the references are established */
@@ -841,16 +980,9 @@ void PreLookaheadGroup::processTasks(int workerThreadID)
     while (m_jobAcquired < m_jobTotal)
     {
         Frame* preFrame = m_preframes[m_jobAcquired++];
-        ProfileLookaheadTime(m_lookahead.m_preLookaheadElapsedTime, m_lookahead.m_countPreLookahead);
-        ProfileScopeEvent(prelookahead);
         m_lock.release();
 
-        preFrame->m_lowres.init(preFrame->m_fencPic, preFrame->m_poc);
-        if (m_lookahead.m_param->rc.bStatRead && m_lookahead.m_param->rc.cuTree && IS_REFERENCED(preFrame))
-            /* cu-tree offsets were read from stats file */;
-        else if (m_lookahead.m_bAdaptiveQuant)
-            tld.calcAdaptiveQuantFrame(preFrame, m_lookahead.m_param);
-        tld.lowresIntraEstimate(preFrame->m_lowres);
+        m_lookahead.preLookahead(tld, preFrame);
         preFrame->m_lowresInit = true;
 
         m_lock.acquire();
@@ -889,8 +1021,11 @@ void Lookahead::slicetypeDecide()
             if (!curFrame) break;
             frames[j + 1] = &curFrame->m_lowres;
 
-            if (!curFrame->m_lowresInit)
+            if (!curFrame->m_lowresInit && !curFrame->m_lowresInitBusy)
+            {
+                curFrame->m_lowresInitBusy = true;
                 pre.m_preframes[pre.m_jobTotal++] = curFrame;
+            }
 
             curFrame = curFrame->m_next;
         }
@@ -907,6 +1042,22 @@ void Lookahead::slicetypeDecide()
         pre.waitForExit();
     }
 
+    /* wait for pictures whose pre-lookahead was started by other worker threads */
+    for (;;)
+    {
+        m_inputLock.acquire();
+        bool wait = false;
+        Frame *curFrame = m_inputQueue.first();
+        for (int j = 0; j < maxSearch && curFrame; j++, curFrame = curFrame->m_next)
+            wait |= !curFrame->m_lowresInit;
+        m_preLookaheadSignalRequired = wait;
+        m_inputLock.release();
+
+        if (!wait)
+            break;
+        m_preLookaheadSignal.wait();
+    }
+
     if (m_lastNonB && !m_param->rc.bStatRead &&
         ((m_param->bFrameAdaptive && m_param->bframes) ||
          m_param->rc.cuTree || m_param->scenecutThreshold ||
@@ -104,11 +104,15 @@ public:
     Lock          m_inputLock;
     Lock          m_outputLock;
     Event         m_outputSignal;
+    Event         m_preLookaheadSignal;
     LookaheadTLD* m_tld;
     x265_param*   m_param;
     Lowres*       m_lastNonB;
     int*          m_scratch;         // temp buffer for cutree propagate
 
+    void          (*m_notifyCallback)(void* opaque); // asynchronous API, called after each slicetypeDecide()
+    void*         m_notifyOpaque;
+
     /* pre-lookahead */
     int           m_fullQueueSize;
     int           m_histogram[X265_BFRAME_MAX + 1];
@@ -119,12 +123,14 @@ public:
     int           m_cuCount;
     int           m_numCoopSlices;
     int           m_numRowsPerSlice;
+    int           m_coopSlicesRequest; // slice count to apply before the next slicetypeDecide(), or 0
     double        m_cuTreeStrength;
 
     bool          m_isActive;
     bool          m_sliceTypeBusy;
     bool          m_bAdaptiveQuant;
     bool          m_outputSignalRequired;
+    bool          m_preLookaheadSignalRequired;
     bool          m_bBatchMotionSearch;
     bool          m_bBatchFrameCosts;
     bool          m_filled;
@@ -146,13 +152,22 @@ public:
     void    addPicture(Frame&, int sliceType);
     void    flush();
     Frame*  getDecidedPicture();
+    Frame*  pollDecidedPicture(bool& bPending);
 
     void    getEstimatedPictureCost(Frame *pic);
 
+    /* lowres init, adaptive quant and intra estimate of one input picture */
+    void    preLookahead(LookaheadTLD& tld, Frame* preFrame);
+
+    /* change the number of cooperative cost estimate slices, applied by the
+     * thread running the next slicetypeDecide() */
+    void    setCoopSlices(int numSlices);
 
 protected:
 
     void    findJob(int workerThreadID);
+    Frame*  acquirePreLookahead();
+    void    initCoopSlices(int numSlices);
     void    slicetypeDecide();
     void    slicetypeAnalyse(Lowres **frames, bool bKeyframe);
 
@@ -25,6 +25,15 @@
 #include "yuv.h"
 #include "y4m.h"
 
+#if _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace X265_NS;
 
 InputFile* InputFile::open(InputFileInfo& info, bool bForceY4m)
@@ -36,3 +45,118 @@ InputFile* InputFile::open(InputFileInfo& info, bool bForceY4m)
     else
         return new YUVInput(info);
 }
+
+MappedFile::MappedFile()
+{
+    base = NULL;
+    fileSize = 0;
+#if _WIN32
+    mapHandle = NULL;
+#endif
+}
+
+/* returns false if the file is not a regular file or cannot be mapped whole,
+ * in which case the caller should read it as a stream */
+bool MappedFile::map(const char* filename)
+{
+#if _WIN32
+    HANDLE hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (GetFileType(hFile) != FILE_TYPE_DISK || !GetFileSizeEx(hFile, &size) ||
+        !size.QuadPart || (uint64_t)size.QuadPart > (uint64_t)(size_t)-1)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    /* a copy-on-write view, since some callers convert pictures in place */
+    mapHandle = CreateFileMappingA(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(hFile);
+    if (!mapHandle)
+        return false;
+
+    base = (uint8_t*)MapViewOfFile(mapHandle, FILE_MAP_COPY, 0, 0, 0);
+    if (!base)
+    {
+        CloseHandle(mapHandle);
+        mapHandle = NULL;
+        return false;
+    }
+    fileSize = size.QuadPart;
+    return true;
+#else
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (uint64_t)st.st_size > (uint64_t)(size_t)-1)
+    {
+        close(fd);
+        return false;
+    }
+
+    /* a copy-on-write mapping, since some callers convert pictures in place */
+    void* ptr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return false;
+
+    base = (uint8_t*)ptr;
+    fileSize = st.st_size;
+    madvise(base, (size_t)fileSize, MADV_SEQUENTIAL);
+    return true;
+#endif
+}
+
+void MappedFile::unmap()
+{
+    if (!base)
+        return;
+#if _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(mapHandle);
+    mapHandle = NULL;
+#else
+    munmap(base, (size_t)fileSize);
+#endif
+    base = NULL;
+    fileSize = 0;
+}
+
+/* start reading a range of the file ahead of its use */
+void MappedFile::prefetch(uint64_t offset, uint64_t length)
+{
+#if _WIN32
+    (void)offset;
+    (void)length;
+#else
+    if (offset >= fileSize)
+        return;
+    length = X265_MIN(length, fileSize - offset);
+    uint64_t start = offset & ~(uint64_t)(sysconf(_SC_PAGESIZE) - 1);
+    madvise(base + start, (size_t)(offset + length - start), MADV_WILLNEED);
+#endif
+}
+
+/* release the pages of a range which has been consumed, so long inputs do
+ * not stay resident; the data is read from the file again if it is used */
+void MappedFile::discard(uint64_t offset, uint64_t length)
+{
+#if _WIN32
+    (void)offset;
+    (void)length;
+#else
+    /* only whole pages inside the range */
+    uint64_t pageMask = (uint64_t)sysconf(_SC_PAGESIZE) - 1;
+    uint64_t start = (offset + pageMask) & ~pageMask;
+    uint64_t end = X265_MIN(offset + length, fileSize) & ~pageMask;
+    if (end > start)
+        madvise(base + start, (size_t)(end - start), MADV_DONTNEED);
+#endif
+}
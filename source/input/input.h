@@ -53,9 +53,44 @@ struct InputFileInfo
 
     /* user supplied */
     int skipFrames;
+    bool bMapFile;          // read regular files through a memory mapping
     const char *filename;
 };
 
+/* A private (copy-on-write) memory mapping of a whole input file, so readers
+ * can hand out pictures which point into the file data instead of copying
+ * them into buffers */
+class MappedFile
+{
+public:
+
+    MappedFile();
+
+    ~MappedFile()                 { unmap(); }
+
+    bool map(const char* filename);
+
+    void unmap();
+
+    void prefetch(uint64_t offset, uint64_t length);
+
+    void discard(uint64_t offset, uint64_t length);
+
+    uint8_t* data() const         { return base; }
+
+    uint64_t size() const         { return fileSize; }
+
+protected:
+
+    uint8_t* base;
+
+    uint64_t fileSize;
+
+#if _WIN32
+    void*    mapHandle;
+#endif
+};
+
 class InputFile
 {
 protected:
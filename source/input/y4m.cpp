@@ -56,6 +56,7 @@ Y4MInput::Y4MInput(InputFileInfo& info)
     rateDenom = info.fpsDenom;
     depth = info.depth;
     framesize = 0;
+    mappedPos = mappedPrev = mappedKeep = 0;
 
     ifs = NULL;
     if (!strcmp(info.filename, "-"))
@@ -77,19 +78,31 @@ Y4MInput::Y4MInput(InputFileInfo& info)
             framesize += (stride * (height >> x265_cli_csps[colorSpace].height[i]));
         }
 
-        threadActive = true;
-        for (int q = 0; q < QUEUE_SIZE; q++)
+        istream::pos_type cur = ifs->tellg();
+        if (info.bMapFile && ifs != &cin && cur >= 0 && mapped.map(info.filename))
+        {
+            /* the stream was only needed for the stream header, pictures
+             * are handed out straight from the mapping */
+            mappedPos = (uint64_t)cur;
+            delete ifs;
+            ifs = NULL;
+        }
+        else
         {
-            buf[q] = X265_MALLOC(char, framesize);
-            if (!buf[q])
+            threadActive = true;
+            for (int q = 0; q < QUEUE_SIZE; q++)
             {
-                x265_log(NULL, X265_LOG_ERROR, "y4m: buffer allocation failure, aborting");
-                threadActive = false;
-                break;
+                buf[q] = X265_MALLOC(char, framesize);
+                if (!buf[q])
+                {
+                    x265_log(NULL, X265_LOG_ERROR, "y4m: buffer allocation failure, aborting");
+                    threadActive = false;
+                    break;
+                }
             }
         }
     }
-    if (!threadActive)
+    if (!threadActive && !mapped.data())
     {
         if (ifs && ifs != &cin)
             delete ifs;
@@ -109,6 +122,20 @@ Y4MInput::Y4MInput(InputFileInfo& info)
 
     size_t estFrameSize = framesize + strlen(header) + 1; /* assume basic FRAME\n headers */
 
+    if (mapped.data())
+    {
+        info.frameCount = (int)((mapped.size() - mappedPos) / estFrameSize);
+
+        /* frame headers are walked, so seeking is exact and costs no I/O */
+        for (int i = 0; i < info.skipFrames; i++)
+            if (!nextMappedFrame())
+                break;
+
+        mappedPrev = mappedKeep = mappedPos;
+        mapped.prefetch(mappedPos, (uint64_t)estFrameSize * QUEUE_SIZE);
+        return;
+    }
+
     /* try to estimate frame count, if this is not stdin */
     if (ifs != &cin)
     {
@@ -396,40 +423,85 @@ bool Y4MInput::populateFrameQueue()
         return false;
 }
 
+/* locate the picture data of the frame at mappedPos and step past it,
+ * returns NULL at the end of the file */
+char* Y4MInput::nextMappedFrame()
+{
+    const char* base = (const char*)mapped.data();
+    uint64_t size = mapped.size();
+    size_t hlen = strlen(header);
+
+    if (mappedPos + hlen > size)
+        return NULL;
+
+    if (memcmp(base + mappedPos, header, hlen))
+    {
+        x265_log(NULL, X265_LOG_ERROR, "y4m: frame header missing\n");
+        return NULL;
+    }
+
+    /* skip frame parameters up to the line feed */
+    const char* eol = (const char*)memchr(base + mappedPos + hlen, '\n', (size_t)(size - mappedPos - hlen));
+    if (!eol || (uint64_t)(eol + 1 - base) + framesize > size)
+        return NULL;
+
+    mappedPos = (uint64_t)(eol + 1 - base) + framesize;
+    return (char*)eol + 1;
+}
+
 bool Y4MInput::readPicture(x265_picture& pic)
 {
-    int read = readCount.get();
-    int written = writeCount.get();
+    char* frame;
+
+    if (mapped.data())
+    {
+        uint64_t start = mappedPos;
+        frame = nextMappedFrame();
+        if (!frame)
+            return false;
+
+        /* read ahead as the reader thread would, and drop the frame before
+         * the previous one, which the caller has finished with */
+        mapped.prefetch(mappedPos, (mappedPos - start) * (QUEUE_SIZE - 1));
+        mapped.discard(mappedKeep, mappedPrev - mappedKeep);
+        mappedKeep = mappedPrev;
+        mappedPrev = start;
+    }
+    else
+    {
+        int read = readCount.get();
+        int written = writeCount.get();
 
 #if ENABLE_THREADING
 
-    /* only wait if the read thread is still active */
-    while (threadActive && read == written)
-        written = writeCount.waitForChange(written);
+        /* only wait if the read thread is still active */
+        while (threadActive && read == written)
+            written = writeCount.waitForChange(written);
 
 #else
 
-    populateFrameQueue();
+        populateFrameQueue();
 
 #endif // if ENABLE_THREADING
 
-    if (read < written)
-    {
-        int pixelbytes = depth > 8 ? 2 : 1;
-        pic.bitDepth = depth;
-        pic.framesize = framesize;
-        pic.height = height;
-        pic.colorSpace = colorSpace;
-        pic.stride[0] = width * pixelbytes;
-        pic.stride[1] = pic.stride[0] >> x265_cli_csps[colorSpace].width[1];
-        pic.stride[2] = pic.stride[0] >> x265_cli_csps[colorSpace].width[2];
-        pic.planes[0] = buf[read % QUEUE_SIZE];
-        pic.planes[1] = (char*)pic.planes[0] + pic.stride[0] * height;
-        pic.planes[2] = (char*)pic.planes[1] + pic.stride[1] * (height >> x265_cli_csps[colorSpace].height[1]);
-        readCount.incr();
-        return true;
+        if (read >= written)
+            return false;
+
+        frame = buf[read % QUEUE_SIZE];
     }
-    else
-        return false;
-}
 
+    int pixelbytes = depth > 8 ? 2 : 1;
+    pic.bitDepth = depth;
+    pic.framesize = framesize;
+    pic.height = height;
+    pic.colorSpace = colorSpace;
+    pic.stride[0] = width * pixelbytes;
+    pic.stride[1] = pic.stride[0] >> x265_cli_csps[colorSpace].width[1];
+    pic.stride[2] = pic.stride[0] >> x265_cli_csps[colorSpace].width[2];
+    pic.planes[0] = frame;
+    pic.planes[1] = (char*)pic.planes[0] + pic.stride[0] * height;
+    pic.planes[2] = (char*)pic.planes[1] + pic.stride[1] * (height >> x265_cli_csps[colorSpace].height[1]);
+    if (!mapped.data())
+        readCount.incr();
+    return true;
+}
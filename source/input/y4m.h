@@ -65,8 +65,18 @@ protected:
 
     std::istream *ifs;
 
+    MappedFile mapped;
+
+    uint64_t mappedPos;   // offset of the next FRAME header
+
+    uint64_t mappedPrev;  // offset of the frame last handed out
+
+    uint64_t mappedKeep;  // offset before which the mapping has been discarded
+
     bool parseHeader();
 
+    char* nextMappedFrame();
+
     void threadMain();
 
     bool populateFrameQueue();
@@ -79,9 +89,9 @@ public:
 
     void release();
 
-    bool isEof() const            { return ifs && ifs->eof();  }
+    bool isEof() const            { return mapped.data() ? mappedPos >= mapped.size() : ifs && ifs->eof(); }
 
-    bool isFail()                 { return !(ifs && !ifs->fail() && threadActive); }
+    bool isFail()                 { return !mapped.data() && !(ifs && !ifs->fail() && threadActive); }
 
     void startReader();
 
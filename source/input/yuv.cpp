@@ -50,6 +50,7 @@ YUVInput::YUVInput(InputFileInfo& info)
     colorSpace = info.csp;
     threadActive = false;
     ifs = NULL;
+    mappedPos = 0;
 
     uint32_t pixelbytes = depth > 8 ? 2 : 1;
     framesize = 0;
@@ -66,6 +67,15 @@ YUVInput::YUVInput(InputFileInfo& info)
         return;
     }
 
+    if (info.bMapFile && strcmp(info.filename, "-") && mapped.map(info.filename))
+    {
+        /* pictures point into the mapped file, no reader thread or buffers */
+        info.frameCount = (int)(mapped.size() / framesize);
+        mappedPos = (uint64_t)framesize * info.skipFrames;
+        mapped.prefetch(mappedPos, (uint64_t)framesize * QUEUE_SIZE);
+        return;
+    }
+
     if (!strcmp(info.filename, "-"))
     {
         ifs = &cin;
@@ -205,37 +215,56 @@ bool YUVInput::populateFrameQueue()
 
 bool YUVInput::readPicture(x265_picture& pic)
 {
-    int read = readCount.get();
-    int written = writeCount.get();
+    char* frame;
+
+    if (mapped.data())
+    {
+        if (mappedPos + framesize > mapped.size())
+            return false;
+
+        /* read ahead as the reader thread would, and drop the frame before
+         * the previous one, which the caller has finished with */
+        frame = (char*)mapped.data() + mappedPos;
+        mapped.prefetch(mappedPos + framesize, (uint64_t)framesize * (QUEUE_SIZE - 1));
+        if (mappedPos >= 2 * (uint64_t)framesize)
+            mapped.discard(mappedPos - 2 * (uint64_t)framesize, framesize);
+        mappedPos += framesize;
+    }
+    else
+    {
+        int read = readCount.get();
+        int written = writeCount.get();
 
 #if ENABLE_THREADING
 
-    /* only wait if the read thread is still active */
-    while (threadActive && read == written)
-        written = writeCount.waitForChange(written);
+        /* only wait if the read thread is still active */
+        while (threadActive && read == written)
+            written = writeCount.waitForChange(written);
 
 #else
 
-    populateFrameQueue();
+        populateFrameQueue();
 
 #endif // if ENABLE_THREADING
 
-    if (read < written)
-    {
-        uint32_t pixelbytes = depth > 8 ? 2 : 1;
-        pic.colorSpace = colorSpace;
-        pic.bitDepth = depth;
-        pic.framesize = framesize;
-        pic.height = height;
-        pic.stride[0] = width * pixelbytes;
-        pic.stride[1] = pic.stride[0] >> x265_cli_csps[colorSpace].width[1];
-        pic.stride[2] = pic.stride[0] >> x265_cli_csps[colorSpace].width[2];
-        pic.planes[0] = buf[read % QUEUE_SIZE];
-        pic.planes[1] = (char*)pic.planes[0] + pic.stride[0] * height;
-        pic.planes[2] = (char*)pic.planes[1] + pic.stride[1] * (height >> x265_cli_csps[colorSpace].height[1]);
-        readCount.incr();
-        return true;
+        if (read >= written)
+            return false;
+
+        frame = buf[read % QUEUE_SIZE];
     }
-    else
-        return false;
+
+    uint32_t pixelbytes = depth > 8 ? 2 : 1;
+    pic.colorSpace = colorSpace;
+    pic.bitDepth = depth;
+    pic.framesize = framesize;
+    pic.height = height;
+    pic.stride[0] = width * pixelbytes;
+    pic.stride[1] = pic.stride[0] >> x265_cli_csps[colorSpace].width[1];
+    pic.stride[2] = pic.stride[0] >> x265_cli_csps[colorSpace].width[2];
+    pic.planes[0] = frame;
+    pic.planes[1] = (char*)pic.planes[0] + pic.stride[0] * height;
+    pic.planes[2] = (char*)pic.planes[1] + pic.stride[1] * (height >> x265_cli_csps[colorSpace].height[1]);
+    if (!mapped.data())
+        readCount.incr();
+    return true;
 }
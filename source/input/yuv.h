@@ -57,6 +57,10 @@ protected:
 
     std::istream *ifs;
 
+    MappedFile mapped;
+
+    uint64_t mappedPos;
+
     int guessFrameCount();
 
     void threadMain();
@@ -71,9 +75,9 @@ public:
 
     void release();
 
-    bool isEof() const                            { return ifs && ifs->eof();  }
+    bool isEof() const                            { return mapped.data() ? mappedPos + framesize > mapped.size() : ifs && ifs->eof(); }
 
-    bool isFail()                                 { return !(ifs && !ifs->fail() && threadActive); }
+    bool isFail()                                 { return !mapped.data() && !(ifs && !ifs->fail() && threadActive); }
 
     void startReader();
 
@@ -0,0 +1,279 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#include "common.h"
+#include "asyncwriter.h"
+
+using namespace X265_NS;
+
+AsyncWriter::AsyncWriter(int depth)
+{
+    queueDepth = depth;
+    threadActive = false;
+}
+
+void AsyncWriter::startWriter()
+{
+    threadActive = start();
+}
+
+/* wait for all queued writes to complete, then end the writer thread */
+void AsyncWriter::stopWriter()
+{
+    if (threadActive)
+    {
+        flush();
+        threadActive = false;
+        writeCount.incr();
+        stop();
+    }
+}
+
+/* returns the ring slot for the next write, blocking while the ring is full */
+int AsyncWriter::acquireSlot()
+{
+    int written = writeCount.get();
+    int read = readCount.get();
+
+    while (written - read >= queueDepth)
+        read = readCount.waitForChange(read);
+
+    return written % queueDepth;
+}
+
+void AsyncWriter::commitSlot(int slot)
+{
+    if (threadActive)
+        writeCount.incr();
+    else
+    {
+        writeSlot(slot);
+        writeCount.incr();
+        readCount.incr();
+    }
+}
+
+void AsyncWriter::flush()
+{
+    int written = writeCount.get();
+    int read = readCount.get();
+
+    while (read != written)
+        read = readCount.waitForChange(read);
+}
+
+void AsyncWriter::threadMain()
+{
+    THREAD_NAME("AsyncWriter", 0);
+
+    int read = readCount.get();
+    for (;;)
+    {
+        int written = writeCount.get();
+        while (written == read)
+            written = writeCount.waitForChange(written);
+
+        /* stopWriter() flushes the ring, then wakes us with an empty write */
+        if (!threadActive)
+            break;
+
+        writeSlot(read % queueDepth);
+        readCount.incr();
+        read++;
+    }
+}
+
+AsyncOutputFile::AsyncOutputFile(OutputFile* output)
+    : AsyncWriter(QUEUE_SIZE)
+    , file(output)
+{
+    memset(packets, 0, sizeof(packets));
+    startWriter();
+}
+
+AsyncOutputFile::~AsyncOutputFile()
+{
+    for (int i = 0; i < QUEUE_SIZE; i++)
+    {
+        X265_FREE(packets[i].payload);
+        X265_FREE(packets[i].nal);
+    }
+}
+
+int AsyncOutputFile::queue(const x265_nal* nal, uint32_t nalcount, const x265_picture* pic)
+{
+    uint32_t bytes = 0;
+    for (uint32_t i = 0; i < nalcount; i++)
+        bytes += nal[i].sizeBytes;
+
+    int slot = acquireSlot();
+    Packet& pkt = packets[slot];
+
+    if (bytes > pkt.payloadSize)
+    {
+        X265_FREE(pkt.payload);
+        pkt.payloadSize = bytes + (bytes >> 2);
+        pkt.payload = X265_MALLOC(uint8_t, pkt.payloadSize);
+    }
+    if (nalcount > pkt.nalSize)
+    {
+        X265_FREE(pkt.nal);
+        pkt.nalSize = nalcount;
+        pkt.nal = X265_MALLOC(x265_nal, pkt.nalSize);
+    }
+    if (!pkt.payload || !pkt.nal)
+    {
+        /* out of memory, write this packet synchronously */
+        X265_FREE(pkt.payload);
+        X265_FREE(pkt.nal);
+        pkt.payload = NULL;
+        pkt.nal = NULL;
+        pkt.payloadSize = pkt.nalSize = 0;
+        flush();
+        if (pic)
+            return file->writeFrame(nal, nalcount, *(x265_picture*)pic);
+        else
+            return file->writeHeaders(nal, nalcount);
+    }
+
+    uint8_t* payload = pkt.payload;
+    for (uint32_t i = 0; i < nalcount; i++)
+    {
+        pkt.nal[i] = nal[i];
+        pkt.nal[i].payload = payload;
+        memcpy(payload, nal[i].payload, nal[i].sizeBytes);
+        payload += nal[i].sizeBytes;
+    }
+    pkt.nalcount = nalcount;
+    pkt.bHeaders = !pic;
+    if (pic)
+        pkt.pic = *pic;
+
+    commitSlot(slot);
+    return bytes;
+}
+
+void AsyncOutputFile::writeSlot(int slot)
+{
+    Packet& pkt = packets[slot];
+
+    if (pkt.bHeaders)
+        file->writeHeaders(pkt.nal, pkt.nalcount);
+    else
+        file->writeFrame(pkt.nal, pkt.nalcount, pkt.pic);
+}
+
+int AsyncOutputFile::writeHeaders(const x265_nal* nal, uint32_t nalcount)
+{
+    return queue(nal, nalcount, NULL);
+}
+
+int AsyncOutputFile::writeFrame(const x265_nal* nal, uint32_t nalcount, x265_picture& pic)
+{
+    return queue(nal, nalcount, &pic);
+}
+
+void AsyncOutputFile::closeFile(int64_t largest_pts, int64_t second_largest_pts)
+{
+    stopWriter();
+    file->closeFile(largest_pts, second_largest_pts);
+}
+
+void AsyncOutputFile::release()
+{
+    stopWriter();
+    file->release();
+    delete this;
+}
+
+AsyncReconFile::AsyncReconFile(ReconFile* recon, int w, int h, int csp)
+    : AsyncWriter(QUEUE_SIZE)
+    , file(recon)
+    , width(w)
+    , height(h)
+    , colorSpace(csp)
+    , frameSize(0)
+    , bFail(false)
+{
+    for (int i = 0; i < x265_cli_csps[colorSpace].planes; i++)
+        frameSize += (size_t)(width >> x265_cli_csps[colorSpace].width[i]) * (height >> x265_cli_csps[colorSpace].height[i]);
+
+    memset(pictures, 0, sizeof(pictures));
+    startWriter();
+}
+
+AsyncReconFile::~AsyncReconFile()
+{
+    for (int i = 0; i < QUEUE_SIZE; i++)
+        X265_FREE(pictures[i].buf);
+}
+
+bool AsyncReconFile::writePicture(const x265_picture& pic)
+{
+    int slot = acquireSlot();
+    Picture& p = pictures[slot];
+
+    if (!p.buf)
+    {
+        p.buf = X265_MALLOC(pixel, frameSize);
+        if (!p.buf)
+        {
+            flush();
+            return file->writePicture(pic);
+        }
+    }
+
+    /* the reconstructed picture is only valid until the next encoder call,
+     * keep a packed copy of the visible area */
+    p.pic = pic;
+    pixel* buf = p.buf;
+    for (int i = 0; i < x265_cli_csps[colorSpace].planes; i++)
+    {
+        const char* src = (const char*)pic.planes[i];
+        int pwidth = width >> x265_cli_csps[colorSpace].width[i];
+        int pheight = height >> x265_cli_csps[colorSpace].height[i];
+
+        p.pic.planes[i] = buf;
+        p.pic.stride[i] = pwidth * sizeof(pixel);
+        for (int y = 0; y < pheight; y++)
+        {
+            memcpy(buf, src, pwidth * sizeof(pixel));
+            src += pic.stride[i];
+            buf += pwidth;
+        }
+    }
+
+    commitSlot(slot);
+    return !bFail;
+}
+
+void AsyncReconFile::writeSlot(int slot)
+{
+    if (!file->writePicture(pictures[slot].pic))
+        bFail = true;
+}
+
+void AsyncReconFile::release()
+{
+    stopWriter();
+    file->release();
+    delete this;
+}
@@ -0,0 +1,151 @@
+/*****************************************************************************
+ * Copyright (C) 2016 x265 project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ *
+ * This program is also available under a commercial proprietary license.
+ * For more information, contact us at license @ x265.com.
+ *****************************************************************************/
+
+#ifndef X265_ASYNCWRITER_H
+#define X265_ASYNCWRITER_H
+
+#include "output.h"
+#include "threading.h"
+
+namespace X265_NS {
+// private x265 namespace
+
+/* A bounded ring of queued writes drained by a dedicated thread, so the API
+ * thread does not block on slow storage. Only the API thread queues writes;
+ * it blocks when the ring is full. If the thread cannot be started, every
+ * write is performed synchronously */
+class AsyncWriter : public Thread
+{
+public:
+
+    AsyncWriter(int depth);
+
+protected:
+
+    int               queueDepth;
+    bool              threadActive;  /* writer thread is running */
+
+    /* the counters are only ever incremented, slot n of the ring holds the
+     * write numbered n modulo queueDepth */
+    ThreadSafeInteger readCount;
+    ThreadSafeInteger writeCount;
+
+    void startWriter();
+    void stopWriter();
+    int  acquireSlot();
+    void commitSlot(int slot);
+    void flush();
+
+    void threadMain();
+
+    virtual void writeSlot(int slot) = 0;
+};
+
+/* Bitstream writer: the NAL payloads are copied into the queue, the number of
+ * payload bytes is returned immediately. The queue is flushed before the file
+ * is closed */
+class AsyncOutputFile : public OutputFile, public AsyncWriter
+{
+protected:
+
+    enum { QUEUE_SIZE = 64 };
+
+    struct Packet
+    {
+        uint8_t*     payload;
+        uint32_t     payloadSize;   /* allocated bytes */
+        x265_nal*    nal;
+        uint32_t     nalSize;       /* allocated NALs */
+        uint32_t     nalcount;
+        bool         bHeaders;
+        x265_picture pic;
+    };
+
+    OutputFile* file;
+    Packet      packets[QUEUE_SIZE];
+
+    virtual ~AsyncOutputFile();
+
+    int  queue(const x265_nal* nal, uint32_t nalcount, const x265_picture* pic);
+    void writeSlot(int slot);
+
+public:
+
+    AsyncOutputFile(OutputFile* output);
+
+    bool isFail() const                { return file->isFail(); }
+
+    bool needPTS() const               { return file->needPTS(); }
+
+    void release();
+
+    const char* getName() const        { return file->getName(); }
+
+    void setParam(x265_param* param)   { file->setParam(param); }
+
+    int writeHeaders(const x265_nal* nal, uint32_t nalcount);
+
+    int writeFrame(const x265_nal* nal, uint32_t nalcount, x265_picture& pic);
+
+    void closeFile(int64_t largest_pts, int64_t second_largest_pts);
+};
+
+/* Reconstructed picture writer: each picture is copied into a packed frame
+ * buffer of the queue. The queue is flushed before the file is released */
+class AsyncReconFile : public ReconFile, public AsyncWriter
+{
+protected:
+
+    enum { QUEUE_SIZE = 4 };
+
+    struct Picture
+    {
+        pixel*       buf;
+        x265_picture pic;
+    };
+
+    ReconFile* file;
+    int        width;
+    int        height;
+    int        colorSpace;
+    size_t     frameSize;       /* pixels in one packed frame */
+    bool       bFail;           /* a queued picture could not be written */
+    Picture    pictures[QUEUE_SIZE];
+
+    virtual ~AsyncReconFile();
+
+    void writeSlot(int slot);
+
+public:
+
+    AsyncReconFile(ReconFile* recon, int width, int height, int csp);
+
+    bool isFail() const                { return file->isFail(); }
+
+    void release();
+
+    bool writePicture(const x265_picture& pic);
+
+    const char *getName() const        { return file->getName(); }
+};
+}
+
+#endif // ifndef X265_ASYNCWRITER_H
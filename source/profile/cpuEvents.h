@@ -9,3 +9,4 @@ CPU_EVENT(estCostSingle)
 CPU_EVENT(estCostCoop)
 CPU_EVENT(pmode)
 CPU_EVENT(pme)
+CPU_EVENT(scaleBand)
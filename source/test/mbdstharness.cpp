@@ -203,6 +203,85 @@ bool MBDstHarness::check_dequant_primitive(dequant_scaling_t ref, dequant_scalin
     return true;
 }
 
+bool MBDstHarness::check_dct_quant_primitive(dct_quant_t ref, dct_quant_t opt, int log2TrSize)
+{
+    int j = 0;
+    int width = 1 << log2TrSize;
+    int numCoeff = width * width;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        intptr_t stride = width + (rand() % 2) * (rand() % 32);
+        int sliceType = rand() % 2;
+        int qp = rand() % (QP_MAX_SPEC + QP_BD_OFFSET + 1);
+        int per = qp / 6;
+        int transformShift = MAX_TR_DYNAMIC_RANGE - X265_DEPTH - log2TrSize;
+
+        int bits = QUANT_SHIFT + per + transformShift;
+        int valueToAdd = (sliceType == 1 ? 171 : 85) << (bits - 9);
+
+        int index = rand() % TEST_CASES;
+        int16_t* residual = short_test_buff[index] + j;
+        int32_t* quantCoeff = int_test_buff[0] + rand() % INCR;
+
+        ALIGN_VAR_32(int16_t, refQCoef[MAX_TU_SIZE]);
+        ALIGN_VAR_32(int16_t, optQCoef[MAX_TU_SIZE]);
+
+        uint32_t refReturnValue = ref(residual, stride, mshortbuf2, quantCoeff, mintbuf1, refQCoef, bits, valueToAdd);
+        uint32_t optReturnValue = (uint32_t)checked(opt, residual, stride, mshortbuf3, quantCoeff, mintbuf3, optQCoef, bits, valueToAdd);
+
+        if (memcmp(mshortbuf2, mshortbuf3, sizeof(int16_t) * numCoeff))
+            return false;
+
+        if (memcmp(mintbuf1, mintbuf3, sizeof(int) * numCoeff))
+            return false;
+
+        if (memcmp(refQCoef, optQCoef, sizeof(int16_t) * numCoeff))
+            return false;
+
+        if (optReturnValue != refReturnValue)
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool MBDstHarness::check_dequant_idct_primitive(dequant_idct_t ref, dequant_idct_t opt, int log2TrSize)
+{
+    int j = 0;
+    int width = 1 << log2TrSize;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        intptr_t stride = width + (rand() % 2) * (rand() % 32);
+        int qp = rand() % (QP_MAX_SPEC + QP_BD_OFFSET + 1);
+        int per = qp / 6;
+        int rem = qp % 6;
+        static const int invQuantScales[6] = { 40, 45, 51, 57, 64, 72 };
+        int scale = invQuantScales[rem] << per;
+        int transformShift = MAX_TR_DYNAMIC_RANGE - X265_DEPTH - log2TrSize;
+        int shift = QUANT_IQUANT_SHIFT - QUANT_SHIFT - transformShift;
+
+        int index = rand() % TEST_CASES;
+
+        memset(mintbuf1, 0xCD, sizeof(mintbuf1));
+        memset(mintbuf3, 0xCD, sizeof(mintbuf3));
+        ref(short_test_buff[index] + j, (int16_t*)mintbuf1, stride, scale, shift);
+        checked(opt, short_test_buff[index] + j, (int16_t*)mintbuf3, stride, scale, shift);
+
+        if (memcmp(mintbuf1, mintbuf3, sizeof(int16_t) * stride * width))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool MBDstHarness::check_quant_primitive(quant_t ref, quant_t opt)
 {
     int j = 0;
@@ -449,6 +528,27 @@ bool MBDstHarness::testCorrectness(const EncoderPrimitives& ref, const EncoderPr
         }
     }
 
+    for (int i = 0; i < NUM_TR_SIZE; i++)
+    {
+        if (opt.cu[i].dct_quant)
+        {
+            if (!check_dct_quant_primitive(ref.cu[i].dct_quant, opt.cu[i].dct_quant, i + 2))
+            {
+                printf("dct_quant[%dx%d] Failed!\n", 4 << i, 4 << i);
+                return false;
+            }
+        }
+
+        if (opt.cu[i].dequant_idct)
+        {
+            if (!check_dequant_idct_primitive(ref.cu[i].dequant_idct, opt.cu[i].dequant_idct, i + 2))
+            {
+                printf("dequant_idct[%dx%d] Failed!\n", 4 << i, 4 << i);
+                return false;
+            }
+        }
+    }
+
     return true;
 }
 
@@ -520,4 +620,19 @@ void MBDstHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderPrimi
         printf("denoiseDct\t");
         REPORT_SPEEDUP(opt.denoiseDct, ref.denoiseDct, short_denoise_test_buff1[0], mubuf1, mushortbuf1, 32 * 32);
     }
+
+    for (int value = 0; value < NUM_TR_SIZE; value++)
+    {
+        if (opt.cu[value].dct_quant)
+        {
+            printf("dct_quant[%dx%d]", 4 << value, 4 << value);
+            REPORT_SPEEDUP(opt.cu[value].dct_quant, ref.cu[value].dct_quant, short_test_buff[0], 4 << value, mshortbuf2, int_test_buff[0], mintbuf3, mshortbuf3, 23, 23785);
+        }
+
+        if (opt.cu[value].dequant_idct)
+        {
+            printf("dequant_idct[%dx%d]", 4 << value, 4 << value);
+            REPORT_SPEEDUP(opt.cu[value].dequant_idct, ref.cu[value].dequant_idct, short_test_buff[0], mshortbuf2, 4 << value, 70, 1);
+        }
+    }
 }
@@ -71,6 +71,8 @@ protected:
     bool check_idct_primitive(idct_t ref, idct_t opt, intptr_t width);
     bool check_count_nonzero_primitive(count_nonzero_t ref, count_nonzero_t opt);
     bool check_denoise_dct_primitive(denoiseDct_t ref, denoiseDct_t opt);
+    bool check_dct_quant_primitive(dct_quant_t ref, dct_quant_t opt, int log2TrSize);
+    bool check_dequant_idct_primitive(dequant_idct_t ref, dequant_idct_t opt, int log2TrSize);
 
 public:
 
@@ -25,6 +25,7 @@
 #include "pixelharness.h"
 #include "primitives.h"
 #include "entropy.h"
+#include "scaler.h"
 
 using namespace X265_NS;
 
@@ -202,6 +203,33 @@ bool PixelHarness::check_pixelcmp_x4(pixelcmp_x4_t ref, pixelcmp_x4_t opt)
     return true;
 }
 
+bool PixelHarness::check_pixelcmp_x8(pixelcmp_x8_t ref, pixelcmp_x8_t opt)
+{
+    ALIGN_VAR_16(int, cres[16]);
+    ALIGN_VAR_16(int, vres[16]);
+    int j = 0;
+    intptr_t stride = FENC_STRIDE - 5;
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index1 = rand() % TEST_CASES;
+        int index2 = rand() % TEST_CASES;
+        const pixel* fref[8];
+        for (int k = 0; k < 8; k++)
+            fref[k] = pixel_test_buff[index2] + j + k;
+
+        checked(opt, pixel_test_buff[index1], fref, stride, &vres[0]);
+        ref(pixel_test_buff[index1], fref, stride, &cres[0]);
+
+        if (memcmp(vres, cres, 8 * sizeof(int)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_calresidual(calcresidual_t ref, calcresidual_t opt)
 {
     ALIGN_VAR_16(int16_t, ref_dest[64 * 64]);
@@ -1372,6 +1400,234 @@ bool PixelHarness::check_planecopy_cp(planecopy_cp_t ref, planecopy_cp_t opt)
     return true;
 }
 
+bool PixelHarness::check_planecopy_cp_pad(planecopy_cp_pad_t ref, planecopy_cp_pad_t opt)
+{
+    ALIGN_VAR_16(pixel, ref_dest[64 * 128]);
+    ALIGN_VAR_16(pixel, opt_dest[64 * 128]);
+
+    memset(ref_dest, 0xCD, sizeof(ref_dest));
+    memset(opt_dest, 0xCD, sizeof(opt_dest));
+
+    intptr_t srcStride = 64;
+    intptr_t dstStride = 128;
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = i % TEST_CASES;
+        int width = 1 + rand() % 64;
+        int height = 1 + rand() % 64;
+        int padx = rand() % 33;
+
+        checked(opt, uchar_test_buff[index] + j, srcStride, opt_dest, dstStride, width, height, X265_DEPTH - 8, padx);
+        ref(uchar_test_buff[index] + j, srcStride, ref_dest, dstStride, width, height, X265_DEPTH - 8, padx);
+
+        /* also catches writes past the padding */
+        if (memcmp(ref_dest, opt_dest, sizeof(ref_dest)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_planecopy_sp_pad(planecopy_sp_pad_t ref, planecopy_sp_pad_t opt)
+{
+    ALIGN_VAR_16(pixel, ref_dest[64 * 128]);
+    ALIGN_VAR_16(pixel, opt_dest[64 * 128]);
+
+    memset(ref_dest, 0xCD, sizeof(ref_dest));
+    memset(opt_dest, 0xCD, sizeof(opt_dest));
+
+    intptr_t srcStride = 64;
+    intptr_t dstStride = 128;
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = i % TEST_CASES;
+        int width = 1 + rand() % 64;
+        int height = 1 + rand() % 64;
+        int padx = rand() % 33;
+        int shift = rand() % 9;
+
+        checked(opt, ushort_test_buff[index] + j, srcStride, opt_dest, dstStride, width, height, shift, (uint16_t)((1 << X265_DEPTH) - 1), padx);
+        ref(ushort_test_buff[index] + j, srcStride, ref_dest, dstStride, width, height, shift, (uint16_t)((1 << X265_DEPTH) - 1), padx);
+
+        if (memcmp(ref_dest, opt_dest, sizeof(ref_dest)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_planecopy_sp_clip(planecopy_sp_clip_t ref, planecopy_sp_clip_t opt)
+{
+    ALIGN_VAR_16(pixel, ref_dest[64 * 128]);
+    ALIGN_VAR_16(pixel, opt_dest[64 * 128]);
+
+    memset(ref_dest, 0xCD, sizeof(ref_dest));
+    memset(opt_dest, 0xCD, sizeof(opt_dest));
+
+    intptr_t srcStride = 64;
+    intptr_t dstStride = 128;
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = i % TEST_CASES;
+        int width = 1 + rand() % 64;
+        int height = 1 + rand() % 64;
+        int padx = rand() % 33;
+        pixel minPix = (pixel)(rand() % 128);
+        pixel maxPix = (pixel)(PIXEL_MAX - rand() % 128);
+        uint64_t ref_sum, opt_sum;
+
+        pixel opt_max = (pixel)checked(opt, ushort_test_buff[index] + j, srcStride, opt_dest, dstStride, width, height, padx, &opt_sum, minPix, maxPix);
+        pixel ref_max = ref(ushort_test_buff[index] + j, srcStride, ref_dest, dstStride, width, height, padx, &ref_sum, minPix, maxPix);
+
+        if (ref_max != opt_max || ref_sum != opt_sum || memcmp(ref_dest, opt_dest, sizeof(ref_dest)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_resample_h_cs(resample_h_cs_t ref, resample_h_cs_t opt)
+{
+    ALIGN_VAR_16(int16_t, ref_dest[256]);
+    ALIGN_VAR_16(int16_t, opt_dest[256]);
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = i % TEST_CASES;
+        int srcWidth = 32 + rand() % 480;
+        int dstWidth = 1 + rand() % 256;
+        ScaleFilter filter;
+        if (!filter.init(srcWidth, dstWidth))
+            continue;
+
+        memset(ref_dest, 0xCD, sizeof(ref_dest));
+        memset(opt_dest, 0xCD, sizeof(opt_dest));
+
+        checked(opt, uchar_test_buff[index], opt_dest, dstWidth, filter.pos, filter.coef, filter.taps, 8);
+        ref(uchar_test_buff[index], ref_dest, dstWidth, filter.pos, filter.coef, filter.taps, 8);
+
+        if (memcmp(ref_dest, opt_dest, sizeof(ref_dest)))
+            return false;
+
+        reportfail();
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_resample_h_ss(resample_h_ss_t ref, resample_h_ss_t opt)
+{
+    ALIGN_VAR_16(int16_t, ref_dest[256]);
+    ALIGN_VAR_16(int16_t, opt_dest[256]);
+    ALIGN_VAR_16(uint16_t, src[512]);
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = i % TEST_CASES;
+        int bitDepth = 8 + rand() % 7;
+        int srcWidth = 32 + rand() % 480;
+        int dstWidth = 1 + rand() % 256;
+        ScaleFilter filter;
+        if (!filter.init(srcWidth, dstWidth))
+            continue;
+
+        for (int x = 0; x < srcWidth; x++)
+            src[x] = ushort_test_buff[index][x] & ((1 << bitDepth) - 1);
+        memset(ref_dest, 0xCD, sizeof(ref_dest));
+        memset(opt_dest, 0xCD, sizeof(opt_dest));
+
+        checked(opt, src, opt_dest, dstWidth, filter.pos, filter.coef, filter.taps, bitDepth);
+        ref(src, ref_dest, dstWidth, filter.pos, filter.coef, filter.taps, bitDepth);
+
+        if (memcmp(ref_dest, opt_dest, sizeof(ref_dest)))
+            return false;
+
+        reportfail();
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_resample_v_sc(resample_v_sc_t ref, resample_v_sc_t opt)
+{
+    ALIGN_VAR_16(uint8_t, ref_dest[128]);
+    ALIGN_VAR_16(uint8_t, opt_dest[128]);
+
+    intptr_t srcStride = 128;
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = i % TEST_CASES;
+        int width = 1 + rand() % 128;
+        ScaleFilter filter;
+        if (!filter.init(32 + rand() % 32, 1 + rand() % 64))
+            continue;
+
+        memset(ref_dest, 0xCD, sizeof(ref_dest));
+        memset(opt_dest, 0xCD, sizeof(opt_dest));
+
+        checked(opt, short_test_buff2[index] + j, srcStride, opt_dest, width, filter.coef, filter.taps, 20, 255);
+        ref(short_test_buff2[index] + j, srcStride, ref_dest, width, filter.coef, filter.taps, 20, 255);
+
+        if (memcmp(ref_dest, opt_dest, sizeof(ref_dest)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
+bool PixelHarness::check_resample_v_ss(resample_v_ss_t ref, resample_v_ss_t opt)
+{
+    ALIGN_VAR_16(uint16_t, ref_dest[128]);
+    ALIGN_VAR_16(uint16_t, opt_dest[128]);
+
+    intptr_t srcStride = 128;
+    int j = 0;
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = i % TEST_CASES;
+        int bitDepth = 8 + rand() % 7;
+        int width = 1 + rand() % 128;
+        ScaleFilter filter;
+        if (!filter.init(32 + rand() % 32, 1 + rand() % 64))
+            continue;
+
+        memset(ref_dest, 0xCD, sizeof(ref_dest));
+        memset(opt_dest, 0xCD, sizeof(opt_dest));
+
+        checked(opt, short_test_buff2[index] + j, srcStride, opt_dest, width, filter.coef, filter.taps, 28 - bitDepth, (1 << bitDepth) - 1);
+        ref(short_test_buff2[index] + j, srcStride, ref_dest, width, filter.coef, filter.taps, 28 - bitDepth, (1 << bitDepth) - 1);
+
+        if (memcmp(ref_dest, opt_dest, sizeof(ref_dest)))
+            return false;
+
+        reportfail();
+        j += INCR;
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_cutree_propagate_cost(cutree_propagate_cost ref, cutree_propagate_cost opt)
 {
     ALIGN_VAR_16(int, ref_dest[64 * 64]);
@@ -1821,6 +2077,37 @@ bool PixelHarness::check_costCoeffRemain(costCoeffRemain_t ref, costCoeffRemain_
     return true;
 }
 
+bool PixelHarness::check_rdoq_cg_cost(rdoqCgCost_t ref, rdoqCgCost_t opt)
+{
+    ALIGN_VAR_32(int64_t, ref_dest[32 * 32]);
+    ALIGN_VAR_32(int64_t, opt_dest[32 * 32]);
+
+    for (int i = 0; i < ITERS; i++)
+    {
+        int index = rand() % TEST_CASES;
+        intptr_t trSize = (intptr_t)4 << (rand() % 4);
+        int transformShift = rand() % 6;
+        int scaleBits = SCALE_BITS - 2 * transformShift;
+        int psyShift = 2 * transformShift + 1;
+
+        /* psy-rdoq strength [0, 50] * 256 times a FIX8 lambda, zero disables psy */
+        int64_t psyScale = (rand() & 1) ? (int64_t)(rand() % (50 * 256 + 1)) * (rand() % (1 << 20)) : 0;
+
+        memset(ref_dest, 0xCD, sizeof(ref_dest));
+        memset(opt_dest, 0xCD, sizeof(opt_dest));
+
+        int64_t ref_sum = ref(short_test_buff[index] + i, sbuf1 + i, ref_dest, trSize, scaleBits, psyScale, psyShift);
+        int64_t opt_sum = (int64_t)checked(opt, short_test_buff[index] + i, sbuf1 + i, opt_dest, trSize, scaleBits, psyScale, psyShift);
+
+        if (ref_sum != opt_sum || memcmp(ref_dest, opt_dest, sizeof(ref_dest)))
+            return false;
+
+        reportfail();
+    }
+
+    return true;
+}
+
 bool PixelHarness::check_costC1C2Flag(costC1C2Flag_t ref, costC1C2Flag_t opt)
 {
     ALIGN_VAR_32(uint16_t, absCoeff[(1 << MLS_CG_SIZE)]);
@@ -2041,6 +2328,15 @@ bool PixelHarness::testPU(int part, const EncoderPrimitives& ref, const EncoderP
         }
     }
 
+    if (opt.pu[part].sad_x8)
+    {
+        if (!check_pixelcmp_x8(ref.pu[part].sad_x8, opt.pu[part].sad_x8))
+        {
+            printf("sad_x8[%s]: failed!\n", lumaPartStr[part]);
+            return false;
+        }
+    }
+
     if (opt.pu[part].pixelavg_pp)
     {
         if (!check_pixelavg_pp(ref.pu[part].pixelavg_pp, opt.pu[part].pixelavg_pp))
@@ -2579,6 +2875,78 @@ bool PixelHarness::testCorrectness(const EncoderPrimitives& ref, const EncoderPr
         }
     }
 
+    if (opt.planecopy_cp_pad)
+    {
+        if (!check_planecopy_cp_pad(ref.planecopy_cp_pad, opt.planecopy_cp_pad))
+        {
+            printf("planecopy_cp_pad failed\n");
+            return false;
+        }
+    }
+
+    if (opt.planecopy_sp_pad)
+    {
+        if (!check_planecopy_sp_pad(ref.planecopy_sp_pad, opt.planecopy_sp_pad))
+        {
+            printf("planecopy_sp_pad failed\n");
+            return false;
+        }
+    }
+
+    if (opt.planecopy_sp_shl_pad)
+    {
+        if (!check_planecopy_sp_pad(ref.planecopy_sp_shl_pad, opt.planecopy_sp_shl_pad))
+        {
+            printf("planecopy_sp_shl_pad failed\n");
+            return false;
+        }
+    }
+
+    if (opt.planecopy_sp_clip)
+    {
+        if (!check_planecopy_sp_clip(ref.planecopy_sp_clip, opt.planecopy_sp_clip))
+        {
+            printf("planecopy_sp_clip failed\n");
+            return false;
+        }
+    }
+
+    if (opt.resample_h_cs)
+    {
+        if (!check_resample_h_cs(ref.resample_h_cs, opt.resample_h_cs))
+        {
+            printf("resample_h_cs failed\n");
+            return false;
+        }
+    }
+
+    if (opt.resample_h_ss)
+    {
+        if (!check_resample_h_ss(ref.resample_h_ss, opt.resample_h_ss))
+        {
+            printf("resample_h_ss failed\n");
+            return false;
+        }
+    }
+
+    if (opt.resample_v_sc)
+    {
+        if (!check_resample_v_sc(ref.resample_v_sc, opt.resample_v_sc))
+        {
+            printf("resample_v_sc failed\n");
+            return false;
+        }
+    }
+
+    if (opt.resample_v_ss)
+    {
+        if (!check_resample_v_ss(ref.resample_v_ss, opt.resample_v_ss))
+        {
+            printf("resample_v_ss failed\n");
+            return false;
+        }
+    }
+
     if (opt.propagateCost)
     {
         if (!check_cutree_propagate_cost(ref.propagateCost, opt.propagateCost))
@@ -2650,6 +3018,15 @@ bool PixelHarness::testCorrectness(const EncoderPrimitives& ref, const EncoderPr
             return false;
         }
     }
+
+    if (opt.rdoq_cg_cost)
+    {
+        if (!check_rdoq_cg_cost(ref.rdoq_cg_cost, opt.rdoq_cg_cost))
+        {
+            printf("rdoq_cg_cost failed!\n");
+            return false;
+        }
+    }
     
 
     if (opt.pelFilterLumaStrong[0])
@@ -2728,6 +3105,13 @@ void PixelHarness::measurePartition(int part, const EncoderPrimitives& ref, cons
         REPORT_SPEEDUP(opt.pu[part].sad_x4, ref.pu[part].sad_x4, pbuf1, fref, fref + 1, fref - 1, fref - INCR, FENC_STRIDE + 5, &cres[0]);
     }
 
+    if (opt.pu[part].sad_x8)
+    {
+        const pixel* frefs[8] = { fref, fref + 1, fref - 1, fref - INCR, fref + INCR, fref + 2, fref - 2, fref + INCR + 1 };
+        HEADER("sad_x8[%s]", lumaPartStr[part]);
+        REPORT_SPEEDUP(opt.pu[part].sad_x8, ref.pu[part].sad_x8, pbuf1, frefs, FENC_STRIDE + 5, &cres[0]);
+    }
+
     if (opt.pu[part].copy_pp)
     {
         HEADER("copy_pp[%s]", lumaPartStr[part]);
@@ -3099,6 +3483,60 @@ void PixelHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderPrimi
         REPORT_SPEEDUP(opt.planecopy_cp, ref.planecopy_cp, uchar_test_buff[0], 64, pbuf1, 64, 64, 64, 2);
     }
 
+    if (opt.planecopy_cp_pad)
+    {
+        HEADER0("planecopy_cp_pad");
+        REPORT_SPEEDUP(opt.planecopy_cp_pad, ref.planecopy_cp_pad, uchar_test_buff[0], 64, pbuf1, 128, 64, 64, X265_DEPTH - 8, 17);
+    }
+
+    if (opt.planecopy_sp_pad)
+    {
+        HEADER0("planecopy_sp_pad");
+        REPORT_SPEEDUP(opt.planecopy_sp_pad, ref.planecopy_sp_pad, ushort_test_buff[0], 64, pbuf1, 128, 64, 64, 2, (uint16_t)((1 << X265_DEPTH) - 1), 17);
+    }
+
+    if (opt.planecopy_sp_shl_pad)
+    {
+        HEADER0("planecopy_sp_shl_pad");
+        REPORT_SPEEDUP(opt.planecopy_sp_shl_pad, ref.planecopy_sp_shl_pad, ushort_test_buff[0], 64, pbuf1, 128, 64, 64, 2, (uint16_t)((1 << X265_DEPTH) - 1), 17);
+    }
+
+    if (opt.planecopy_sp_clip)
+    {
+        uint64_t sum;
+        HEADER0("planecopy_sp_clip");
+        REPORT_SPEEDUP(opt.planecopy_sp_clip, ref.planecopy_sp_clip, ushort_test_buff[0], 64, pbuf1, 128, 64, 64, 17, &sum, (pixel)64, (pixel)(PIXEL_MAX - 64));
+    }
+
+    if (opt.resample_h_cs || opt.resample_v_sc)
+    {
+        ScaleFilter hfilter, vfilter;
+        if (hfilter.init(480, 256) && vfilter.init(64, 32))
+        {
+            int16_t* tmp = (int16_t*)ibuf1;
+            if (opt.resample_h_cs)
+            {
+                HEADER0("resample_h_cs");
+                REPORT_SPEEDUP(opt.resample_h_cs, ref.resample_h_cs, uchar_test_buff[0], tmp, 256, hfilter.pos, hfilter.coef, hfilter.taps, 8);
+            }
+            if (opt.resample_h_ss)
+            {
+                HEADER0("resample_h_ss");
+                REPORT_SPEEDUP(opt.resample_h_ss, ref.resample_h_ss, (uint16_t*)short_test_buff1[0], tmp, 256, hfilter.pos, hfilter.coef, hfilter.taps, X265_DEPTH);
+            }
+            if (opt.resample_v_sc)
+            {
+                HEADER0("resample_v_sc");
+                REPORT_SPEEDUP(opt.resample_v_sc, ref.resample_v_sc, short_test_buff2[0], 256, (uint8_t*)pbuf1, 256, vfilter.coef, vfilter.taps, 20, 255);
+            }
+            if (opt.resample_v_ss)
+            {
+                HEADER0("resample_v_ss");
+                REPORT_SPEEDUP(opt.resample_v_ss, ref.resample_v_ss, short_test_buff2[0], 256, (uint16_t*)pbuf1, 256, vfilter.coef, vfilter.taps, 28 - X265_DEPTH, PIXEL_MAX);
+            }
+        }
+    }
+
     if (opt.propagateCost)
     {
         HEADER0("propagateCost");
@@ -3177,6 +3615,13 @@ void PixelHarness::measureSpeed(const EncoderPrimitives& ref, const EncoderPrimi
         REPORT_SPEEDUP(opt.costC1C2Flag, ref.costC1C2Flag, abscoefBuf, C1FLAG_NUMBER, (uint8_t*)psbuf1, 1);
     }
 
+    if (opt.rdoq_cg_cost)
+    {
+        HEADER0("rdoq_cg_cost");
+        ALIGN_VAR_32(int64_t, costBuf[32 * 32]);
+        REPORT_SPEEDUP(opt.rdoq_cg_cost, ref.rdoq_cg_cost, short_test_buff[0], sbuf1, costBuf, 32, SCALE_BITS - 4, (int64_t)256 * 1000, 5);
+    }
+
     if (opt.pelFilterLumaStrong[0])
     {
         int32_t tcP = (rand() % PIXEL_MAX) - 1;
@@ -74,6 +74,7 @@ protected:
     bool check_pixel_sse_ss(pixel_sse_ss_t ref, pixel_sse_ss_t opt);
     bool check_pixelcmp_x3(pixelcmp_x3_t ref, pixelcmp_x3_t opt);
     bool check_pixelcmp_x4(pixelcmp_x4_t ref, pixelcmp_x4_t opt);
+    bool check_pixelcmp_x8(pixelcmp_x8_t ref, pixelcmp_x8_t opt);
     bool check_copy_pp(copy_pp_t ref, copy_pp_t opt);
     bool check_copy_sp(copy_sp_t ref, copy_sp_t opt);
     bool check_copy_ps(copy_ps_t ref, copy_ps_t opt);
@@ -112,6 +113,13 @@ protected:
     bool check_saoCuStatsE3_t(saoCuStatsE3_t ref, saoCuStatsE3_t opt);
     bool check_planecopy_sp(planecopy_sp_t ref, planecopy_sp_t opt);
     bool check_planecopy_cp(planecopy_cp_t ref, planecopy_cp_t opt);
+    bool check_planecopy_cp_pad(planecopy_cp_pad_t ref, planecopy_cp_pad_t opt);
+    bool check_planecopy_sp_pad(planecopy_sp_pad_t ref, planecopy_sp_pad_t opt);
+    bool check_planecopy_sp_clip(planecopy_sp_clip_t ref, planecopy_sp_clip_t opt);
+    bool check_resample_h_cs(resample_h_cs_t ref, resample_h_cs_t opt);
+    bool check_resample_h_ss(resample_h_ss_t ref, resample_h_ss_t opt);
+    bool check_resample_v_sc(resample_v_sc_t ref, resample_v_sc_t opt);
+    bool check_resample_v_ss(resample_v_ss_t ref, resample_v_ss_t opt);
     bool check_cutree_propagate_cost(cutree_propagate_cost ref, cutree_propagate_cost opt);
     bool check_cutree_fix8_pack(cutree_fix8_pack ref, cutree_fix8_pack opt);
     bool check_cutree_fix8_unpack(cutree_fix8_unpack ref, cutree_fix8_unpack opt);
@@ -122,6 +130,7 @@ protected:
     bool check_costCoeffNxN(costCoeffNxN_t ref, costCoeffNxN_t opt);
     bool check_costCoeffRemain(costCoeffRemain_t ref, costCoeffRemain_t opt);
     bool check_costC1C2Flag(costC1C2Flag_t ref, costC1C2Flag_t opt);
+    bool check_rdoq_cg_cost(rdoqCgCost_t ref, rdoqCgCost_t opt);
     bool check_pelFilterLumaStrong_V(pelFilterLumaStrong_t ref, pelFilterLumaStrong_t opt);
     bool check_pelFilterLumaStrong_H(pelFilterLumaStrong_t ref, pelFilterLumaStrong_t opt);
     bool check_pelFilterChroma_V(pelFilterChroma_t ref, pelFilterChroma_t opt);
@@ -169,6 +169,7 @@ int main(int argc, char *argv[])
         { "XOP", X265_CPU_XOP },
         { "AVX2", X265_CPU_AVX2 },
         { "BMI2", X265_CPU_AVX2 | X265_CPU_BMI1 | X265_CPU_BMI2 },
+        { "AVX512", X265_CPU_AVX2 | X265_CPU_AVX512 },
         { "ARMv6", X265_CPU_ARMV6 },
         { "NEON", X265_CPU_NEON },
         { "FastNeonMRC", X265_CPU_FAST_NEON_MRC },
@@ -189,6 +190,7 @@ int main(int argc, char *argv[])
         EncoderPrimitives vecprim;
         memset(&vecprim, 0, sizeof(vecprim));
         setupInstrinsicPrimitives(vecprim, test_arch[i].flag);
+        setupInstrinsicPrimitives_avx512(vecprim, test_arch[i].flag);
         setupAliasPrimitives(vecprim);
         for (size_t h = 0; h < sizeof(harness) / sizeof(TestHarness*); h++)
         {
@@ -229,6 +231,9 @@ int main(int argc, char *argv[])
     setupInstrinsicPrimitives(optprim, cpuid);
 #endif
     setupAssemblyPrimitives(optprim, cpuid);
+#if X265_ARCH_X86
+    setupInstrinsicPrimitives_avx512(optprim, cpuid);
+#endif
 
     /* Note that we do not setup aliases for performance tests, that would be
      * redundant. The testbench only verifies they are correctly aliased */
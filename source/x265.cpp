@@ -32,6 +32,7 @@
 #include "input/input.h"
 #include "output/output.h"
 #include "output/reconplay.h"
+#include "output/asyncwriter.h"
 
 #if HAVE_VLD
 /* Visual Leak Detector */
@@ -66,6 +67,22 @@ static void sigint_handler(int)
     b_ctrl_c = 1;
 }
 
+#define MAX_RENDITIONS 8
+
+/* an additional encode of the source pictures at another resolution, see --rendition */
+struct Rendition
+{
+    const char*   arg;        // WxH,filename[,name=value...]
+    x265_param*   param;
+    x265_encoder* encoder;
+    OutputFile*   output;
+    x265_picture  pic_out;
+    int16_t*      errorBuf;
+    uint64_t      totalbytes;
+    int           width;
+    int           height;
+};
+
 struct CLIOptions
 {
     InputFile* input;
@@ -80,6 +97,7 @@ struct CLIOptions
     bool bProgress;
     bool bForceY4m;
     bool bDither;
+    bool bInputMmap;
     int csvLogLevel;
     uint32_t seek;              // number of frames to skip from the beginning
     uint32_t framesToBeEncoded; // number of frames to encode
@@ -87,6 +105,12 @@ struct CLIOptions
     int64_t startTime;
     int64_t prevUpdateTime;
 
+    Rendition rendition[MAX_RENDITIONS];
+    x265_picture renditionPic[MAX_RENDITIONS]; // source pictures of each rendition, from the scaler
+    int numRenditions;
+    x265_pool* pool;          // worker threads shared by all encoders and the scaler
+    x265_scaler* scaler;
+
     /* in microseconds */
     static const int UPDATE_INTERVAL = 250000;
 
@@ -108,13 +132,23 @@ struct CLIOptions
         startTime = x265_mdate();
         prevUpdateTime = 0;
         bDither = false;
+        bInputMmap = true;
         csvLogLevel = 0;
+        numRenditions = 0;
+        memset(rendition, 0, sizeof(rendition));
+        pool = NULL;
+        scaler = NULL;
     }
 
     void destroy();
     void printStatus(uint32_t frameNum);
     bool parse(int argc, char **argv);
     bool parseQPFile(x265_picture &pic_org);
+    bool parseRenditions(InputFileInfo& info, int inputDepth);
+    bool openRenditions();
+    bool scaleRenditions(x265_picture& pic);
+    bool encodeRenditions(bool bFlush);
+    void closeRenditions();
 };
 
 void CLIOptions::destroy()
@@ -134,6 +168,24 @@ void CLIOptions::destroy()
     if (output)
         output->release();
     output = NULL;
+    for (int i = 0; i < numRenditions; i++)
+    {
+        Rendition& r = rendition[i];
+        if (r.output)
+            r.output->release();
+        r.output = NULL;
+        X265_FREE(r.errorBuf);
+        r.errorBuf = NULL;
+        if (r.param)
+            api->param_free(r.param);
+        r.param = NULL;
+    }
+    if (scaler)
+        api->scaler_free(scaler);
+    scaler = NULL;
+    if (pool)
+        api->pool_free(pool);
+    pool = NULL;
 }
 
 void CLIOptions::printStatus(uint32_t frameNum)
@@ -299,6 +351,17 @@ bool CLIOptions::parse(int argc, char **argv)
             OPT("recon") reconfn = optarg;
             OPT("input-depth") inputBitDepth = (uint32_t)x265_atoi(optarg, bError);
             OPT("dither") this->bDither = true;
+            OPT("input-mmap") this->bInputMmap = true;
+            OPT("no-input-mmap") this->bInputMmap = false;
+            OPT("rendition")
+            {
+                if (numRenditions == MAX_RENDITIONS)
+                {
+                    x265_log(NULL, X265_LOG_ERROR, "at most %d renditions are supported\n", MAX_RENDITIONS);
+                    return true;
+                }
+                rendition[numRenditions++].arg = optarg;
+            }
             OPT("recon-depth") reconFileBitDepth = (uint32_t)x265_atoi(optarg, bError);
             OPT("y4m") this->bForceY4m = true;
             OPT("profile") /* handled above */;
@@ -365,6 +428,7 @@ bool CLIOptions::parse(int argc, char **argv)
     info.sarWidth = param->vui.sarWidth;
     info.sarHeight = param->vui.sarHeight;
     info.skipFrames = seek;
+    info.bMapFile = bInputMmap;
     info.frameCount = 0;
     getParamAspectRatio(param, info.sarWidth, info.sarHeight);
 
@@ -439,10 +503,13 @@ bool CLIOptions::parse(int argc, char **argv)
             this->recon = 0;
         }
         else
+        {
             general_log(param, this->recon->getName(), X265_LOG_INFO,
                     "reconstructed images %dx%d fps %d/%d %s\n",
                     param->sourceWidth, param->sourceHeight, param->fpsNum, param->fpsDenom,
                     x265_source_csp_names[param->internalCsp]);
+            this->recon = new AsyncReconFile(this->recon, param->sourceWidth, param->sourceHeight, param->internalCsp);
+        }
     }
 
     this->output = OutputFile::open(outputfn, info);
@@ -452,9 +519,197 @@ bool CLIOptions::parse(int argc, char **argv)
         return true;
     }
     general_log_file(param, this->output->getName(), X265_LOG_INFO, "output file: %s\n", outputfn);
+    this->output = new AsyncOutputFile(this->output);
+    return numRenditions && parseRenditions(info, info.depth);
+}
+
+/* Configure the rendition encoders and open their output files. Each one
+ * inherits the parameters of the main encode, apart from the source size and
+ * the options given after its output file name. The shared thread pool and
+ * the scaler are created here, before any encoder is opened */
+bool CLIOptions::parseRenditions(InputFileInfo& info, int inputDepth)
+{
+    int widths[MAX_RENDITIONS], heights[MAX_RENDITIONS];
+
+    for (int i = 0; i < numRenditions; i++)
+    {
+        Rendition& r = rendition[i];
+        char* buf = strdup(r.arg);
+        char* tok = strtok(buf, ",");
+        char* fname = strtok(NULL, ",");
+        if (!tok || sscanf(tok, "%dx%d", &widths[i], &heights[i]) != 2 || !fname)
+        {
+            x265_log(param, X265_LOG_ERROR, "invalid rendition <%s>, expected WxH,filename[,name=value...]\n", r.arg);
+            free(buf);
+            return true;
+        }
+
+        r.param = api->param_alloc();
+        if (!r.param)
+        {
+            free(buf);
+            return true;
+        }
+        memcpy(r.param, param, sizeof(x265_param));
+        r.param->sourceWidth = r.width = widths[i];
+        r.param->sourceHeight = r.height = heights[i];
+
+        /* the encoder releases its string arguments when it is closed, so
+         * each rendition needs its own copies. Analysis files are per
+         * resolution, and the multi-pass stats file must not be shared */
+        r.param->analysisMode = 0;
+        r.param->mrMode = 0;
+        r.param->analysisFileName = NULL;
+        r.param->rc.lambdaFileName = param->rc.lambdaFileName ? strdup(param->rc.lambdaFileName) : NULL;
+        r.param->scalingLists = param->scalingLists ? strdup(param->scalingLists) : NULL;
+        r.param->asmAutotuneFile = param->asmAutotuneFile ? strdup(param->asmAutotuneFile) : NULL;
+        r.param->numaPools = param->numaPools ? strdup(param->numaPools) : NULL;
+        r.param->masteringDisplayColorVolume = param->masteringDisplayColorVolume ? strdup(param->masteringDisplayColorVolume) : NULL;
+        const char* statBase = param->rc.statFileName ? param->rc.statFileName : "x265_2pass.log";
+        char* statFileName = (char*)malloc(strlen(statBase) + 32);
+        if (statFileName)
+            sprintf(statFileName, "%s.%dx%d", statBase, widths[i], heights[i]);
+        r.param->rc.statFileName = statFileName;
+
+        for (char* opt = strtok(NULL, ","); opt; opt = strtok(NULL, ","))
+        {
+            char* value = strchr(opt, '=');
+            if (value)
+                *value++ = 0;
+            if (api->param_parse(r.param, opt, value))
+            {
+                x265_log(param, X265_LOG_ERROR, "invalid rendition option %s in <%s>\n", opt, r.arg);
+                free(buf);
+                return true;
+            }
+        }
+
+        if (bDither && inputDepth > param->internalBitDepth)
+        {
+            r.errorBuf = X265_MALLOC(int16_t, widths[i] + 1);
+            if (r.errorBuf)
+                memset(r.errorBuf, 0, (widths[i] + 1) * sizeof(int16_t));
+        }
+
+        InputFileInfo rinfo = info;
+        rinfo.width = widths[i];
+        rinfo.height = heights[i];
+        r.output = OutputFile::open(fname, rinfo);
+        if (r.output->isFail())
+        {
+            x265_log_file(param, X265_LOG_ERROR, "failed to open output file <%s> for writing\n", fname);
+            free(buf);
+            return true;
+        }
+        r.output->setParam(r.param);
+        general_log_file(param, r.output->getName(), X265_LOG_INFO, "rendition %dx%d output file: %s\n", widths[i], heights[i], fname);
+        r.output = new AsyncOutputFile(r.output);
+        free(buf);
+    }
+
+    /* one set of worker threads for every encoder and the scaler */
+    pool = api->pool_create(param, numRenditions + 1);
+    param->pool = pool;
+    for (int i = 0; i < numRenditions; i++)
+        rendition[i].param->pool = pool;
+
+    scaler = api->scaler_create(param, pool, param->sourceWidth, param->sourceHeight, param->internalCsp,
+                                inputDepth, numRenditions, widths, heights);
+    if (!scaler)
+    {
+        x265_log(param, X265_LOG_ERROR, "unable to create the rendition scaler\n");
+        return true;
+    }
+    return false;
+}
+
+bool CLIOptions::openRenditions()
+{
+    for (int i = 0; i < numRenditions; i++)
+    {
+        Rendition& r = rendition[i];
+        r.encoder = api->encoder_open(r.param);
+        if (!r.encoder)
+        {
+            x265_log(param, X265_LOG_ERROR, "failed to open encoder of rendition <%s>\n", r.arg);
+            return true;
+        }
+        api->encoder_parameters(r.encoder, r.param);
+        api->picture_init(r.param, &renditionPic[i]);
+
+        if (!r.param->bRepeatHeaders)
+        {
+            x265_nal* p_nal;
+            uint32_t nal;
+            if (api->encoder_headers(r.encoder, &p_nal, &nal) < 0)
+            {
+                x265_log(param, X265_LOG_ERROR, "Failure generating stream headers of rendition <%s>\n", r.arg);
+                return true;
+            }
+            r.totalbytes += r.output->writeHeaders(p_nal, nal);
+        }
+    }
+    return false;
+}
+
+/* resample a source picture for every rendition, dithering each separately
+ * so the renditions are made from the full precision source */
+bool CLIOptions::scaleRenditions(x265_picture& pic)
+{
+    if (api->scaler_scale(scaler, &pic, renditionPic) < 0)
+        return true;
+
+    for (int i = 0; i < numRenditions; i++)
+    {
+        Rendition& r = rendition[i];
+        if (r.errorBuf)
+        {
+            x265_dither_image(*api, renditionPic[i], r.width, r.height, r.errorBuf, param->internalBitDepth);
+            renditionPic[i].bitDepth = param->internalBitDepth;
+        }
+    }
     return false;
 }
 
+/* encode the pictures given by the last scaleRenditions(), or drain the
+ * rendition encoders when bFlush is set */
+bool CLIOptions::encodeRenditions(bool bFlush)
+{
+    for (int i = 0; i < numRenditions; i++)
+    {
+        Rendition& r = rendition[i];
+        int numEncoded;
+        do
+        {
+            x265_nal* p_nal;
+            uint32_t nal;
+            numEncoded = api->encoder_encode(r.encoder, &p_nal, &nal, bFlush ? NULL : &renditionPic[i], &r.pic_out);
+            if (numEncoded < 0)
+                return true;
+            if (nal)
+                r.totalbytes += r.output->writeFrame(p_nal, nal, r.pic_out);
+        }
+        while (bFlush && numEncoded);
+    }
+    return false;
+}
+
+void CLIOptions::closeRenditions()
+{
+    for (int i = 0; i < numRenditions; i++)
+    {
+        Rendition& r = rendition[i];
+        if (!r.encoder)
+            continue;
+
+        /* the encoder logs its summary as it closes */
+        general_log(param, NULL, X265_LOG_INFO, "rendition %dx%d:\n", r.width, r.height);
+        api->encoder_close(r.encoder);
+        r.encoder = NULL;
+        r.output->closeFile(0, 0);
+    }
+}
+
 bool CLIOptions::parseQPFile(x265_picture &pic_org)
 {
     int32_t num = -1, qp, ret;
@@ -585,6 +840,16 @@ int main(int argc, char **argv)
     /* get the encoder parameters post-initialization */
     api->encoder_parameters(encoder, param);
 
+    if (cliopt.numRenditions && cliopt.openRenditions())
+    {
+        api->encoder_close(encoder);
+        cliopt.closeRenditions();
+        cliopt.destroy();
+        api->param_free(param);
+        api->cleanup();
+        exit(2);
+    }
+
     if (cliopt.csvfn)
     {
         cliopt.csvfpt = x265_csvlog_open(*api, *param, cliopt.csvfn, cliopt.csvLogLevel);
@@ -661,13 +926,21 @@ int main(int argc, char **argv)
 
         if (pic_in)
         {
+            /* Overwrite PTS */
+            pic_in->pts = pic_in->poc;
+
+            /* the renditions are resampled from the source before it is dithered */
+            if (cliopt.scaler && cliopt.scaleRenditions(*pic_in))
+            {
+                b_ctrl_c = 1;
+                ret = 4;
+                break;
+            }
             if (pic_in->bitDepth > param->internalBitDepth && cliopt.bDither)
             {
                 x265_dither_image(*api, *pic_in, cliopt.input->getWidth(), cliopt.input->getHeight(), errorBuf, param->internalBitDepth);
                 pic_in->bitDepth = param->internalBitDepth;
             }
-            /* Overwrite PTS */
-            pic_in->pts = pic_in->poc;
         }
 
         int numEncoded = api->encoder_encode(encoder, &p_nal, &nal, pic_in, pic_recon);
@@ -678,6 +951,13 @@ int main(int argc, char **argv)
             break;
         }
 
+        if (pic_in && cliopt.numRenditions && cliopt.encodeRenditions(false))
+        {
+            b_ctrl_c = 1;
+            ret = 4;
+            break;
+        }
+
         if (reconPlay && numEncoded)
             reconPlay->writePicture(*pic_recon);
 
@@ -736,6 +1016,9 @@ int main(int argc, char **argv)
             break;
     }
 
+    if (!b_ctrl_c && cliopt.numRenditions && cliopt.encodeRenditions(true))
+        ret = 4;
+
     /* clear progress report */
     if (cliopt.bProgress)
         fprintf(stderr, "%*s\r", 80, " ");
@@ -748,6 +1031,7 @@ fail:
     if (cliopt.csvfpt && !b_ctrl_c)
         x265_csvlog_encode(cliopt.csvfpt, *api, *param, stats, cliopt.csvLogLevel, argc, argv);
     api->encoder_close(encoder);
+    cliopt.closeRenditions();
 
     int64_t second_largest_pts = 0;
     int64_t largest_pts = 0;
@@ -36,6 +36,18 @@ extern "C" {
  *      opaque handler for encoder */
 typedef struct x265_encoder x265_encoder;
 
+/* x265_pool:
+ *      opaque handler for a thread pool which may be shared by encoders */
+typedef struct x265_pool x265_pool;
+
+/* x265_frame_pool:
+ *      opaque handler for a picture buffer pool which may be shared by encoders */
+typedef struct x265_frame_pool x265_frame_pool;
+
+/* x265_scaler:
+ *      opaque handler for a multi-resolution input stage */
+typedef struct x265_scaler x265_scaler;
+
 /* Application developers planning to link against a shared library version of
  * libx265 from a Microsoft Visual Studio or similar development environment
  * will need to define X265_API_IMPORTS before including this header.
@@ -80,8 +92,8 @@ typedef enum
 /* The data within the payload is already NAL-encapsulated; the type is merely
  * in the struct for easy access by the calling application.  All data returned
  * in an x265_nal, including the data in payload, is no longer valid after the
- * next call to x265_encoder_encode.  Thus it must be used or copied before
- * calling x265_encoder_encode again. */
+ * next call to x265_encoder_encode (or x265_encoder_poll).  Thus it must be
+ * used or copied before calling x265_encoder_encode again. */
 typedef struct x265_nal
 {
     uint32_t type;        /* NalUnitType */
@@ -281,6 +293,21 @@ typedef struct x265_picture
     uint64_t framesize;
 
     int    height;
+
+    /* Zero-copy input. When release is not NULL and the planes have the
+     * layout reported by x265_encoder_input_layout(), the encoder reads the
+     * caller's planes in place instead of copying them, and calls
+     * release(releaseOpaque) once it no longer needs them, which may be many
+     * pictures later. The encoder writes to the padding and margins of such
+     * planes, and the samples must already be within the internal bit depth.
+     * Pictures without a compatible layout are copied as usual and release is
+     * called before the encode or submit call returns. It is not called for
+     * a picture which was not accepted. release is always called from within
+     * x265_encoder_encode(), x265_encoder_submit(), x265_encoder_poll() or
+     * x265_encoder_close() */
+    void   (*release)(void* releaseOpaque);
+
+    void*  releaseOpaque;
 } x265_picture;
 
 typedef enum
@@ -289,7 +316,8 @@ typedef enum
     X265_HEX_SEARCH,
     X265_UMH_SEARCH,
     X265_STAR_SEARCH,
-    X265_FULL_SEARCH
+    X265_FULL_SEARCH,
+    X265_TZ_SEARCH
 } X265_ME_METHODS;
 
 /* CPU flags */
@@ -328,6 +356,7 @@ typedef enum
                                              * new SLOW flags. */
 #define X265_CPU_SLOW_PSHUFB     0x2000000  /* such as on the Intel Atom */
 #define X265_CPU_SLOW_PALIGNR    0x4000000  /* such as on the AMD Bobcat */
+#define X265_CPU_AVX512          0x8000000  /* AVX-512 F, CD, BW, DQ and VL */
 
 /* ARM */
 #define X265_CPU_ARMV6           0x0000001
@@ -453,10 +482,12 @@ typedef struct x265_stats
     x265_sliceType_stats  statsB;               /* statistics of B slice */
     uint16_t              maxCLL;               /* maximum content light level */
     uint16_t              maxFALL;              /* maximum frame average light level */
+    uint64_t              memoryUsed;           /* estimated bytes of encoder memory currently in use */
+    uint64_t              memoryPeak;           /* estimated bytes of encoder memory at its peak thus far */
 } x265_stats;
 
 /* String values accepted by x265_param_parse() (and CLI) for various parameters */
-static const char * const x265_motion_est_names[] = { "dia", "hex", "umh", "star", "full", 0 };
+static const char * const x265_motion_est_names[] = { "dia", "hex", "umh", "star", "full", "tz", 0 };
 static const char * const x265_source_csp_names[] = { "i400", "i420", "i422", "i444", "nv12", "nv16", 0 };
 static const char * const x265_video_format_names[] = { "component", "pal", "ntsc", "secam", "mac", "undef", 0 };
 static const char * const x265_fullrange_names[] = { "limited", "full", 0 };
@@ -1297,6 +1328,112 @@ typedef struct x265_param
      * value to that value. */
     uint16_t maxLuma;
 
+    /* Enable runtime tuning of the encoder's parallelism. When enabled,
+     * frameNumThreads becomes the maximum number of frame encoders and the
+     * encoder periodically raises or lowers the number of active frame
+     * encoders (and, if lookaheadSlices is in use, the number of lookahead
+     * cost-estimate slices) based on measured worker idle time, reference row
+     * wait time and lookahead wait time. Each change drains the frame encoders
+     * so rate control restarts cleanly; output is deterministic within each
+     * configuration window. Requires a thread pool and frameNumThreads > 1.
+     * Default disabled */
+    int       bAdaptiveThreading;
+
+    /* Thread pool created by x265_pool_create() which this encoder shares with
+     * other encoders in the process, in place of allocating its own worker
+     * threads. When set, numaPools is ignored. The pool must have been created
+     * by the same build of libx265 and must outlive the encoder. Default NULL */
+    x265_pool* pool;
+
+    /* Scheduling priority of this encoder's work relative to the other encoders
+     * attached to the same shared thread pool. Idle worker threads always help
+     * the encoder with the highest priority which needs help; within one
+     * priority level the most important slice types are served first. Valid
+     * range is -8 to 8. Default 0 */
+    int       poolPriority;
+
+    /* Back the source, reconstructed, lowres and weighted reference picture
+     * planes with 2MB pages to reduce TLB misses during motion search. Reserved
+     * huge pages (MAP_HUGETLB) are used when available, else transparent huge
+     * pages are requested with madvise(). The page backing which was achieved
+     * is logged in the encode summary. Planes of 1MB or more are rounded up to
+     * a multiple of 2MB. Linux only, ignored elsewhere. Default disabled */
+    int       bHugePages;
+
+    /* Memory budget of the encoder in megabytes. When non-zero the encoder
+     * estimates its footprint when it is opened and reduces lookahead depth,
+     * frame threads and finally private pool threads until the estimate fits
+     * within the budget. The resulting plan is logged, and current and peak
+     * usage are reported in x265_stats. Default 0 (unlimited) */
+    int       maxMemory;
+
+    /* Picture buffer pool created by x265_frame_pool_create() which this
+     * encoder shares with other encoders in the process. Source pictures and
+     * reconstructed pictures (with their CTU data) which the encoder no longer
+     * needs are returned to the pool instead of being kept for its own reuse,
+     * and idle buffers of the same picture size and color space are taken from
+     * the pool before new ones are allocated. The pool must have been created
+     * by the same build of libx265 and must outlive the encoder. Default NULL */
+    x265_frame_pool* framePool;
+
+    /* Time the implementations of the most used primitives (SAD, SATD,
+     * interpolation filters, transforms and quantization) available at each
+     * SIMD level enabled by cpuid, and use the fastest of each instead of the
+     * one of the highest level. The choices which differ from the default
+     * table are logged. Primitives are set up once per process, so only the
+     * first encoder opened applies this. Default disabled */
+    int       bAsmAutotune;
+
+    /* Cache file for bAsmAutotune. If it exists and matches this build, bit
+     * depth and cpuid, its choices are used without timing, otherwise the
+     * primitives are timed and the choices are written to it. Default NULL */
+    const char* asmAutotuneFile;
+
+    /* Interpolate the luma sub-pel positions of each reconstructed reference
+     * picture once, row by row as it is filtered, so sub-pel refinement reads
+     * them instead of interpolating every candidate. 0 disables, 1 keeps the
+     * three half-pel planes, 2 all fifteen quarter-pel planes at the cost of
+     * one luma plane of memory each. The output is not changed. Weighted
+     * references are still interpolated per candidate. Default 0 */
+    int       subpelPlanes;
+
+    /* Seed the motion search of each PU with the lookahead's lowres motion
+     * vectors of the blocks it covers, and start the full-pel search from the
+     * best candidate when it beats the MVP. Where the lowres vector field
+     * around the PU is coherent, the search range is reduced to a few times
+     * its spread, and widened to cover the lowres vector. Not used with
+     * analysisMode. Default disabled */
+    int       bLowresMvSeed;
+
+    /* Settings of X265_TZ_SEARCH. The step in pixels of the raster scan which
+     * follows the first star search when its best point is further away than
+     * one step, 0 disables the raster scan. Default 3 */
+    int       tzRaster;
+
+    /* The largest distance of the star searches of X265_TZ_SEARCH, and the
+     * half width of its raster scan, capped by searchRange. Default 48 */
+    int       tzStarDist;
+
+    /* The number of successive star distances without improvement after
+     * which a star search of X265_TZ_SEARCH stops. Default 4 */
+    int       tzEarlyExit;
+
+    /* Keep the motion vectors found by the searches of each CTU per reference
+     * on its 8x8 grid, and seed the later searches of the partitions which
+     * overlap them (rectangular and asymmetric shapes, parent CUs) with the
+     * vectors of the cells they cover. When all of the covered cells hold the
+     * same vector, found by searches of smaller partitions, only a small
+     * diamond search around it is done. Not used with bDistributeModeAnalysis
+     * or bDistributeMotionEstimation. Default disabled */
+    int       bEnableMECache;
+
+    /* On Linux, group the worker threads of each thread pool by last level
+     * cache and bind each worker to the CPUs of its cache domain; job
+     * providers prefer the workers of one domain. Binding overrides the CPU
+     * placement of the OS and of any process affinity, so it is opt-in.
+     * Default disabled */
+    int       bCacheAffinity;
+
 } x265_param;
 
 /* x265_param_alloc:
@@ -1445,6 +1582,109 @@ int x265_encoder_headers(x265_encoder *, x265_nal **pp_nal, uint32_t *pi_nal);
  *      Once flushing has begun, all subsequent calls must pass pic_in as NULL. */
 int x265_encoder_encode(x265_encoder *encoder, x265_nal **pp_nal, uint32_t *pi_nal, x265_picture *pic_in, x265_picture *pic_out);
 
+/* x265_encoder_submit:
+ *      asynchronous alternative to x265_encoder_encode(). Copies pic_in into
+ *      the encoder and returns without waiting for any frame to be encoded.
+ *      Completed access units are retrieved with x265_encoder_poll().
+ *      returns 1 if the picture was accepted, 0 if the encoder is full (poll
+ *      for output and submit the picture again), negative on error.
+ *      To flush the encoder pass pic_in as NULL; once flushing has begun, no
+ *      more pictures may be submitted. An encoder driven by submit/poll must
+ *      not also be driven by x265_encoder_encode(). */
+int x265_encoder_submit(x265_encoder *encoder, x265_picture *pic_in);
+
+/* x265_encoder_poll:
+ *      retrieve the next completed access unit, in encode order, without
+ *      blocking. *pi_nal is the number of NAL units outputted in pp_nal and
+ *      pic_out (if not NULL) receives the reconstructed picture and its
+ *      x265_frame_stats, as from x265_encoder_encode().
+ *      returns negative on error, 1 if a picture and access unit were output,
+ *      or zero if none is ready yet. After flushing, the stream is complete
+ *      once every submitted picture has been output.
+ *      The NALs and pic_out planes are valid until the next call to
+ *      x265_encoder_poll(). Without a thread pool, poll may run the lookahead
+ *      slice type decisions in the calling thread.
+ *      x265_encoder_submit() and x265_encoder_poll() are not thread safe with
+ *      respect to each other; one thread may drive any number of encoders. */
+int x265_encoder_poll(x265_encoder *encoder, x265_nal **pp_nal, uint32_t *pi_nal, x265_picture *pic_out);
+
+/* x265_encoder_input_layout:
+ *      report the plane layout an input picture needs for the encoder to use
+ *      it in place (see x265_picture.release). For each plane, stride is the
+ *      row stride in bytes, offset is the byte offset of the first sample from
+ *      the start of the plane's buffer, and size is the size of the buffer in
+ *      bytes, including the margins around the picture. Buffers must be 32
+ *      byte aligned; planes[i] is the buffer start plus offset[i]. The samples
+ *      are of the encoder's internal bit depth and color space */
+void x265_encoder_input_layout(x265_encoder *encoder, int stride[3], int offset[3], int size[3]);
+
+/* x265_encoder_set_callback:
+ *      register a function which is called by an internal encoder thread each
+ *      time a frame finishes encoding or the lookahead finishes a slice type
+ *      decision, i.e. whenever x265_encoder_poll() may be able to make
+ *      progress. The callback must return quickly and must not call back into
+ *      the encoder; it is intended to wake the thread which polls. Register it
+ *      before the first x265_encoder_submit(). Pass NULL to remove it. */
+void x265_encoder_set_callback(x265_encoder *encoder, void (*callback)(void *opaque), void *opaque);
+
+/* x265_pool_create:
+ *      create worker threads which may be shared by up to maxEncoders encoders
+ *      (through x265_param.pool) so that several encoders in one process do
+ *      not each start a thread per CPU core. The number and placement of the
+ *      threads is determined by param->numaPools exactly as for a single
+ *      encoder; only the logging and numaPools fields of param are used.
+ *      returns NULL on failure or if param->numaPools disables the pool */
+x265_pool* x265_pool_create(x265_param *param, int maxEncoders);
+
+/* x265_pool_free:
+ *      stop and release the worker threads of a shared pool. All encoders
+ *      using the pool must have been closed */
+void x265_pool_free(x265_pool *pool);
+
+/* x265_frame_pool_create:
+ *      create an empty picture buffer pool which encoders of the same process
+ *      may share (through x265_param.framePool). Buffers are kept per picture
+ *      size and color space, so encoders of different resolutions may share
+ *      one pool. returns NULL on failure */
+x265_frame_pool* x265_frame_pool_create(void);
+
+/* x265_frame_pool_trim:
+ *      release the buffers which no encoder is currently using; encoders
+ *      allocate new ones as they need them. May be called at any time from
+ *      any thread. returns the number of bytes of picture planes released */
+int64_t x265_frame_pool_trim(x265_frame_pool *pool);
+
+/* x265_frame_pool_free:
+ *      release a picture buffer pool and all of its idle buffers. All encoders
+ *      using the pool must have been closed */
+void x265_frame_pool_free(x265_frame_pool *pool);
+
+/* x265_scaler_create:
+ *      create an input stage which resamples each source picture of srcWidth x
+ *      srcHeight to numOutputs other sizes, so the renditions of a resolution
+ *      ladder can be encoded by separate encoders from one read of the source.
+ *      Pictures given to it must be of the color space (i400 to i444) and bit
+ *      depth (8 to 14) given here, and the outputs are of the same format. The
+ *      output sizes must be multiples of the chroma subsampling. Pictures are
+ *      resampled with bicubic polyphase filters in bands of rows, which idle
+ *      worker threads of pool help with; pool may be NULL. Only the cpuid and
+ *      logging fields of param are used. returns NULL on failure */
+x265_scaler* x265_scaler_create(x265_param *param, x265_pool *pool, int srcWidth, int srcHeight, int colorSpace,
+                                int bitDepth, int numOutputs, const int *widths, const int *heights);
+
+/* x265_scaler_scale:
+ *      resample one source picture to every output size. out is an array of
+ *      numOutputs pictures initialized by x265_picture_init(). Their planes are
+ *      set to buffers owned by the scaler, which remain valid until the next
+ *      call, and pts, poc, sliceType, forceqp and userData are copied from in.
+ *      Not thread safe for one scaler. returns 0 on success, -1 if the format
+ *      of in does not match the scaler */
+int x265_scaler_scale(x265_scaler *scaler, const x265_picture *in, x265_picture *out);
+
+/* x265_scaler_free:
+ *      release a scaler and its output buffers */
+void x265_scaler_free(x265_scaler *scaler);
+
 /* x265_encoder_reconfig:
  *      various parameters from x265_param are copied.
  *      this takes effect immediately, on whichever frame is encoded next;
@@ -1536,6 +1776,18 @@ typedef struct x265_api
 
     int           sizeof_frame_stats;   /* sizeof(x265_frame_stats) */
     int           (*encoder_intra_refresh)(x265_encoder*);
+    int           (*encoder_submit)(x265_encoder*, x265_picture*);
+    int           (*encoder_poll)(x265_encoder*, x265_nal**, uint32_t*, x265_picture*);
+    void          (*encoder_set_callback)(x265_encoder*, void (*)(void*), void*);
+    x265_pool*    (*pool_create)(x265_param*, int);
+    void          (*pool_free)(x265_pool*);
+    x265_frame_pool* (*frame_pool_create)(void);
+    int64_t       (*frame_pool_trim)(x265_frame_pool*);
+    void          (*frame_pool_free)(x265_frame_pool*);
+    void          (*encoder_input_layout)(x265_encoder*, int*, int*, int*);
+    x265_scaler*  (*scaler_create)(x265_param*, x265_pool*, int, int, int, int, int, const int*, const int*);
+    int           (*scaler_scale)(x265_scaler*, const x265_picture*, x265_picture*);
+    void          (*scaler_free)(x265_scaler*);
     /* add new pointers to the end, or increment X265_MAJOR_VERSION */
 } x265_api;
 
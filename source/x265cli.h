@@ -40,6 +40,9 @@ static const struct option long_options[] =
     { "version",              no_argument, NULL, 'V' },
     { "asm",            required_argument, NULL, 0 },
     { "no-asm",               no_argument, NULL, 0 },
+    { "asm-autotune",         no_argument, NULL, 0 },
+    { "no-asm-autotune",      no_argument, NULL, 0 },
+    { "asm-autotune-file", required_argument, NULL, 0 },
     { "pools",          required_argument, NULL, 0 },
     { "numa-pools",     required_argument, NULL, 0 },
     { "preset",         required_argument, NULL, 'p' },
@@ -49,6 +52,13 @@ static const struct option long_options[] =
     { "pmode",                no_argument, NULL, 0 },
     { "no-pme",               no_argument, NULL, 0 },
     { "pme",                  no_argument, NULL, 0 },
+    { "no-adaptive-threading", no_argument, NULL, 0 },
+    { "adaptive-threading",   no_argument, NULL, 0 },
+    { "no-huge-pages",        no_argument, NULL, 0 },
+    { "huge-pages",           no_argument, NULL, 0 },
+    { "no-cache-affinity",    no_argument, NULL, 0 },
+    { "cache-affinity",       no_argument, NULL, 0 },
+    { "max-memory",     required_argument, NULL, 0 },
     { "log-level",      required_argument, NULL, 0 },
     { "profile",        required_argument, NULL, 'P' },
     { "level-idc",      required_argument, NULL, 0 },
@@ -65,6 +75,7 @@ static const struct option long_options[] =
     { "no-progress",          no_argument, NULL, 0 },
     { "output",         required_argument, NULL, 'o' },
     { "output-depth",   required_argument, NULL, 'D' },
+    { "rendition",      required_argument, NULL, 0 },
     { "input",          required_argument, NULL, 0 },
     { "input-depth",    required_argument, NULL, 0 },
     { "input-res",      required_argument, NULL, 0 },
@@ -87,6 +98,14 @@ static const struct option long_options[] =
     { "me",             required_argument, NULL, 0 },
     { "subme",          required_argument, NULL, 'm' },
     { "merange",        required_argument, NULL, 0 },
+    { "subpel-planes",  required_argument, NULL, 0 },
+    { "lowres-mv-seed",       no_argument, NULL, 0 },
+    { "no-lowres-mv-seed",    no_argument, NULL, 0 },
+    { "tz-raster",      required_argument, NULL, 0 },
+    { "tz-star-dist",   required_argument, NULL, 0 },
+    { "tz-early-exit",  required_argument, NULL, 0 },
+    { "me-cache",             no_argument, NULL, 0 },
+    { "no-me-cache",          no_argument, NULL, 0 },
     { "max-merge",      required_argument, NULL, 0 },
     { "no-temporal-mvp",      no_argument, NULL, 0 },
     { "temporal-mvp",         no_argument, NULL, 0 },
@@ -208,6 +227,8 @@ static const struct option long_options[] =
     { "max-luma",       required_argument, NULL, 0 },
     { "no-dither",            no_argument, NULL, 0 },
     { "dither",               no_argument, NULL, 0 },
+    { "no-input-mmap",        no_argument, NULL, 0 },
+    { "input-mmap",           no_argument, NULL, 0 },
     { "no-repeat-headers",    no_argument, NULL, 0 },
     { "repeat-headers",       no_argument, NULL, 0 },
     { "aud",                  no_argument, NULL, 0 },
@@ -263,6 +284,7 @@ static void showHelp(x265_param *param)
     H0("\nOutput Options:\n");
     H0("-o/--output <filename>           Bitstream output file name\n");
     H0("-D/--output-depth 8|10|12        Output bit depth (also internal bit depth). Default %d\n", param->internalBitDepth);
+    H0("   --rendition <WxH,file,...>    Also encode the source resized to WxH into file, name=value items override options. Repeatable\n");
     H0("   --log-level <string>          Logging level: none error warning info debug full. Default %s\n", X265_NS::logLevelNames[param->logLevel + 1]);
     H0("   --no-progress                 Disable CLI progress reports\n");
     H0("   --csv <filename>              Comma separated log file, if csv-log-level > 0 frame level statistics, else one line per run\n");
@@ -282,6 +304,7 @@ static void showHelp(x265_param *param)
     H0("   --seek <integer>              First frame to encode\n");
     H1("   --[no-]interlace <bff|tff>    Indicate input pictures are interlace fields in temporal order. Default progressive\n");
     H1("   --dither                      Enable dither if downscaling to 8 bit pixels. Default disabled\n");
+    H1("   --[no-]input-mmap             Read regular input files through a memory mapping. Default enabled\n");
     H0("\nQuality reporting metrics:\n");
     H0("   --[no-]ssim                   Enable reporting SSIM metric scores. Default %s\n", OPT(param->bEnableSsim));
     H0("   --[no-]psnr                   Enable reporting PSNR metric scores. Default %s\n", OPT(param->bEnablePsnr));
@@ -298,7 +321,13 @@ static void showHelp(x265_param *param)
     H0("   --[no-]wpp                    Enable Wavefront Parallel Processing. Default %s\n", OPT(param->bEnableWavefront));
     H0("   --[no-]pmode                  Parallel mode analysis. Default %s\n", OPT(param->bDistributeModeAnalysis));
     H0("   --[no-]pme                    Parallel motion estimation. Default %s\n", OPT(param->bDistributeMotionEstimation));
+    H1("   --[no-]adaptive-threading     Tune active frame threads and lookahead slices from runtime stalls. Default %s\n", OPT(param->bAdaptiveThreading));
+    H1("   --[no-]huge-pages             Back picture planes with 2MB pages. Default %s\n", OPT(param->bHugePages));
+    H1("   --[no-]cache-affinity         Bind pool threads to last level cache domains (Linux). Default %s\n", OPT(param->bCacheAffinity));
+    H1("   --max-memory <integer>        Memory budget in MB, met by reducing lookahead, frame threads and pool threads. Default %d (unlimited)\n", param->maxMemory);
     H0("   --[no-]asm <bool|int|string>  Override CPU detection. Default: auto\n");
+    H1("   --[no-]asm-autotune           Time the primitives of each detected SIMD level and use the fastest. Default %s\n", OPT(param->bAsmAutotune));
+    H1("   --asm-autotune-file <filename> Load the autotune choices from, or save them to, this file. Implies --asm-autotune\n");
     H0("\nPresets:\n");
     H0("-p/--preset <string>             Trade off performance for compression efficiency. Default medium\n");
     H0("                                 ultrafast, superfast, veryfast, faster, fast, medium, slow, slower, veryslow, or placebo\n");
@@ -331,9 +360,15 @@ static void showHelp(x265_param *param)
     H0("   --max-merge <1..5>            Maximum number of merge candidates. Default %d\n", param->maxNumMergeCand);
     H0("   --ref <integer>               max number of L0 references to be allowed (1 .. 16) Default %d\n", param->maxNumReferences);
     H0("   --limit-refs <0|1|2|3>        Limit references per depth (1) or CU (2) or both (3). Default %d\n", param->limitReferences);
-    H0("   --me <string>                 Motion search method dia hex umh star full. Default %d\n", param->searchMethod);
+    H0("   --me <string>                 Motion search method dia hex umh star full tz. Default %d\n", param->searchMethod);
     H0("-m/--subme <integer>             Amount of subpel refinement to perform (0:least .. 7:most). Default %d \n", param->subpelRefine);
     H0("   --merange <integer>           Motion search range. Default %d\n", param->searchRange);
+    H1("   --subpel-planes <0..2>        Precompute the half-pel (1) or all quarter-pel (2) planes of references. Default %d\n", param->subpelPlanes);
+    H1("   --[no-]lowres-mv-seed         Seed motion search with lookahead vectors, reduce the range where they agree. Default %s\n", OPT(param->bLowresMvSeed));
+    H1("   --tz-raster <integer>         Raster scan step of --me tz, 0 disables the scan. Default %d\n", param->tzRaster);
+    H1("   --tz-star-dist <integer>      Largest star search distance of --me tz. Default %d\n", param->tzStarDist);
+    H1("   --tz-early-exit <integer>     Star distances without improvement before --me tz stops a star search. Default %d\n", param->tzEarlyExit);
+    H1("   --[no-]me-cache               Seed motion searches with the vectors of overlapping partitions of the CTU. Default %s\n", OPT(param->bEnableMECache));
     H0("   --[no-]rect                   Enable rectangular motion partitions Nx2N and 2NxN. Default %s\n", OPT(param->bEnableRectInter));
     H0("   --[no-]amp                    Enable asymmetric motion partitions, requires --rect. Default %s\n", OPT(param->bEnableAMP));
     H0("   --[no-]limit-modes            Limit rectangular and asymmetric motion predictions. Default %d\n", param->limitModes);